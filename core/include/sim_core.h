@@ -75,8 +75,21 @@ typedef struct {
   /* bearing loss model */
   double bearing_c0; /* 0.091 */
   double bearing_c1; /* 0.0087 */
+
+  /* Optional precomputed terms, each valid only when its SIM_ENV_* bit is
+   * set in `baked`.  A caller that reads them from a course bake (course.h)
+   * spares the step its per-call libm work; with the bit clear the step
+   * derives the term from slope / altitude itself.  Zero-initialised envs
+   * therefore behave exactly as before. */
+  int baked;
+  double grav_sin;   /* sin(atan(slope)) */
+  double alt_factor; /* altitude_ftp_factor(altitude, oxy_p50) of the rider
+                        this env is stepped with */
 } EnvState;
 
+#define SIM_ENV_GRAV_SIN 0x1
+#define SIM_ENV_ALT_FACTOR 0x2
+
 /* ================================
  * Rider physics state
  * ================================ */
@@ -180,6 +193,141 @@ void sim_step_rider(RiderState* r, const EnvState* env, double dt,
                     StepDiagnostics* diag /* may be NULL */
 );
 
+/* ================================
+ * Batched stepping (structure of arrays)
+ * ================================ */
+
+/* N riders' longitudinal state as parallel, contiguous columns: column[i]
+ * is rider i.  One allocation backs every column (rider_batch_init).  Only
+ * the fields the step reads or writes live here; static identity (masses,
+ * wheel, CdA parts) is folded at load time into the same derived terms the
+ * scalar solver computes per call, so the arithmetic is unchanged.
+ *
+ * The batch always integrates with SIM_SOLVER_ACCEL_FORCE — the engine's
+ * only production solver; the other two stay scalar regression references
+ * (tests/core/test_solver_compare.c). */
+typedef struct {
+  int count;    /* riders loaded, slots [0, count) */
+  int capacity; /* allocated slots */
+
+  /* kinematics */
+  double* pos;
+  double* speed;
+
+  /* control */
+  double* target_effort;
+  double* effort;
+  double* power;
+  double* ftp; /* current (degraded) FTP, written by the step */
+  double* max_drive_force;
+
+  /* altitude model */
+  double* oxy_p50;
+  double* sealevel_sat; /* lazily cached, same sentinel as RiderState */
+
+  /* derived static terms */
+  double* mass_total; /* mass_rider + mass_bike */
+  double* mass_eq;    /* mass_total + wheel_i / wheel_r^2 */
+  double* cda_base;   /* cda_rider + cda_wheel_drag */
+  double* crr;
+  double* drivetrain_loss;
+
+  /* drafting / yaw multiplier; the caller refreshes it between steps */
+  double* cda_factor;
+
+  /* energy system (EnergyState, column-wise) */
+  double* ftp_base;
+  double* w_prime;
+  double* w_expended;
+  double* ftp_degrade_threshold;
+  double* ftp_degrade_rate;
+  double* max_effort_base;
+  double* tau_base;
+  double* tau_slope;
+  double* tau_offset;
+  double* fatigue_I;
+  double* effort_limit;
+
+  /* per-step scratch: gravity force term, filled by the step itself */
+  double* grav;
+
+  void* storage_; /* backing allocation — owned, released by _free */
+} RiderBatch;
+
+/* Per-rider environment columns for a batch.  rho, g and the bearing model
+ * are shared by every rider (constants in the engine); slope, headwind,
+ * crr and altitude vary along the course.  The baked terms work as in
+ * EnvState, with `baked` shared too: each SIM_ENV_* bit set says that
+ * column is valid for every slot stepped. */
+typedef struct {
+  int capacity;
+
+  double rho;
+  double g;
+  double bearing_c0;
+  double bearing_c1;
+  int baked;
+
+  double* slope;
+  double* headwind;
+  double* crr;
+  double* altitude;
+  double* grav_sin;   /* valid with SIM_ENV_GRAV_SIN */
+  double* alt_factor; /* valid with SIM_ENV_ALT_FACTOR */
+
+  void* storage_;
+} EnvBatch;
+
+/* Allocate `capacity` slots (count starts at 0).  Returns 1 on success, 0
+ * on allocation failure (the batch is then empty with capacity 0). */
+int rider_batch_init(RiderBatch* b, int capacity);
+void rider_batch_free(RiderBatch* b);
+
+/* Append r as slot `count`.  Returns the slot index, or -1 when full. */
+int rider_batch_push(RiderBatch* b, const RiderState* r);
+
+/* Overwrite slot i from r (any solver setting is ignored, see above). */
+void rider_batch_load(RiderBatch* b, int i, const RiderState* r);
+
+/* Refresh only slot i's step inputs from r: pos, speed, target_effort,
+ * cda_factor and sealevel_sat — what a caller changes between steps (a
+ * placement, a contact's speed penalty, a new effort, the draft, the lazy
+ * sea-level cache).  The static terms and the state the step writes itself
+ * stay as they are: for a slot kept resident across steps, loaded once
+ * with rider_batch_load() and stored back after every step. */
+void rider_batch_load_inputs(RiderBatch* b, int i, const RiderState* r);
+
+/* Write slot i's mutable state (pos, speed, effort, power, ftp,
+ * sealevel_sat, energy state) back into r; static fields are untouched. */
+void rider_batch_store(const RiderBatch* b, int i, RiderState* r);
+
+int env_batch_init(EnvBatch* e, int capacity);
+void env_batch_free(EnvBatch* e);
+
+/* Slot i's per-rider fields from a scalar env, baked terms included; the
+ * shared fields (rho, g, bearings, baked) are copied too — last writer
+ * wins. */
+void env_batch_set(EnvBatch* e, int i, const EnvState* env);
+
+/* Slot i's per-rider fields only.  Safe for different slots from several
+ * threads at once; the caller sets the shared fields itself. */
+void env_batch_set_slot(EnvBatch* e, int i, const EnvState* env);
+
+/* Batched core step: advances every loaded rider by dt.  Bit-identical to
+ * calling sim_step_rider with SIM_SOLVER_ACCEL_FORCE on each rider in turn
+ * with the env env_batch_set() was given, baked terms included
+ * (tests/core/test_batch_parity.c).  Organised as passes over the columns —
+ * FTP/effort, then the force integration (branch-free arithmetic the
+ * compiler vectorises), then W' balance — so the libm calls (pow, exp,
+ * sin/atan, where not baked) stay out of the hot arithmetic loop.  env must
+ * hold at least b->count slots. */
+void sim_step_riders(RiderBatch* b, const EnvBatch* env, double dt);
+
+/* The same over slots [begin, end) only: disjoint ranges may be stepped
+ * from different threads at once. */
+void sim_step_riders_range(RiderBatch* b, const EnvBatch* env, int begin,
+                           int end, double dt);
+
 /* Steady-state (cruise) crank power required to hold speed v: resistive
  * forces at v — aero (incl. cda_factor), rolling, gravity, bearings —
  * times v, inflated by drivetrain loss.  Shares resistive_force() with the
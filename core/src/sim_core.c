@@ -4,6 +4,7 @@
 #include <math.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static const double O_PART = 0.2095;  /* O2 fraction of dry air */
@@ -204,6 +205,13 @@ void rider_reset(RiderState* r) {
   energy_reset(&r->energy);
 }
 
+/* Gravity's share of the slope, from the bake when the caller has one. */
+static double env_grav_sin(const EnvState* env) {
+  if (env->baked & SIM_ENV_GRAV_SIN)
+    return env->grav_sin;
+  return sin(atan(env->slope));
+}
+
 static double pow_speed(double v_new, double v_old, double dt,
                         const RiderState* r, const EnvState* env) {
   double v_air = v_new + env->headwind;
@@ -219,7 +227,7 @@ static double pow_speed(double v_new, double v_old, double dt,
   double P_aero = drag_coeff * v_air * fabs(v_air) * v_new;
   double P_roll = r->crr * total_mass * env->g * v_new;
   double P_bear = (env->bearing_c0 + env->bearing_c1 * v_new) * v_new;
-  double P_grav = total_mass * env->g * sin(atan(env->slope)) * v_new;
+  double P_grav = total_mass * env->g * env_grav_sin(env) * v_new;
 
   double P_inertia = 0.5 * mass_ir * (v_new * v_new - v_old * v_old) / dt;
 
@@ -242,7 +250,7 @@ static double pow_speed_prime(double v, double dt, const RiderState* r,
   double dP = drag_coeff * (2.0 * fabs(v_air) * v + v_air * fabs(v_air)) +
               r->crr * total_mass * env->g + env->bearing_c0 +
               2.0 * env->bearing_c1 * v +
-              total_mass * env->g * sin(atan(env->slope)) + mass_ir * v / dt;
+              total_mass * env->g * env_grav_sin(env) + mass_ir * v / dt;
 
   return dP / (1.0 - r->drivetrain_loss);
 }
@@ -258,7 +266,7 @@ static double resistive_force(double v, const RiderState* r,
   double total_mass = r->mass_rider + r->mass_bike;
   double roll = (r->crr + env->crr) * total_mass * env->g;
 
-  double grav = total_mass * env->g * sin(atan(env->slope));
+  double grav = total_mass * env->g * env_grav_sin(env);
 
   double bear = env->bearing_c0 + env->bearing_c1 * v;
 
@@ -283,7 +291,7 @@ static double cruise_power_prime(const RiderState* r, const EnvState* env,
 
   double d = drag_coeff * (2.0 * fabs(v_air) * v + v_air * fabs(v_air)) +
              (r->crr + env->crr) * total_mass * env->g +
-             total_mass * env->g * sin(atan(env->slope)) + env->bearing_c0 +
+             total_mass * env->g * env_grav_sin(env) + env->bearing_c0 +
              2.0 * env->bearing_c1 * v;
   return d / (1.0 - r->drivetrain_loss);
 }
@@ -414,23 +422,32 @@ double altitude_ftp_factor(double alt, double p50, RiderState* r) {
   return saturation(alt, p50) / r->sealevel_sat;
 }
 
-double fatigue_ftp_factor(EnergyState* e) {
-  double factor = e->ftp_base * 3600;
-  double thresh = e->ftp_degrade_threshold * factor;
-  if (e->w_expended > thresh) {
-    double f = 1.0 - (e->w_expended - thresh) / factor * e->ftp_degrade_rate;
+/* Shared by fatigue_ftp_factor and the batched step, field by field. */
+static double fatigue_factor(double ftp_base, double degrade_threshold,
+                             double degrade_rate, double w_expended) {
+  double factor = ftp_base * 3600;
+  double thresh = degrade_threshold * factor;
+  if (w_expended > thresh) {
+    double f = 1.0 - (w_expended - thresh) / factor * degrade_rate;
     return fmax(SIM_FTP_FATIGUE_FLOOR, f);
   }
   return 1.0;
 }
 
+double fatigue_ftp_factor(EnergyState* e) {
+  return fatigue_factor(e->ftp_base, e->ftp_degrade_threshold,
+                        e->ftp_degrade_rate, e->w_expended);
+}
+
 void sim_step_rider(RiderState* r, const EnvState* env, double dt,
                     StepDiagnostics* diag) {
   if (!r || !env || dt <= 0.0)
     return;
 
   /* FTP degradation */
-  double alt_f = altitude_ftp_factor(env->altitude, r->oxy_p50, r);
+  double alt_f = (env->baked & SIM_ENV_ALT_FACTOR)
+                     ? env->alt_factor
+                     : altitude_ftp_factor(env->altitude, r->oxy_p50, r);
   double fatigue_f = fatigue_ftp_factor(&r->energy);
   r->energy.ftp = r->energy.ftp_base * alt_f * fatigue_f;
   r->ftp = r->energy.ftp;
@@ -463,3 +480,326 @@ void sim_step_rider(RiderState* r, const EnvState* env, double dt,
   /* 4. Energy update */
   energy_update(&r->energy, r->power, dt);
 }
+
+/* ================================
+ * Batched stepping
+ * ================================ */
+
+/* Column pointers of a RiderBatch, in storage order. */
+#define RIDER_BATCH_COLUMNS 27
+
+static void rider_batch_columns(RiderBatch* b,
+                                double** cols[RIDER_BATCH_COLUMNS]) {
+  double** c[RIDER_BATCH_COLUMNS] = {
+      &b->pos,
+      &b->speed,
+      &b->target_effort,
+      &b->effort,
+      &b->power,
+      &b->ftp,
+      &b->max_drive_force,
+      &b->oxy_p50,
+      &b->sealevel_sat,
+      &b->mass_total,
+      &b->mass_eq,
+      &b->cda_base,
+      &b->crr,
+      &b->drivetrain_loss,
+      &b->cda_factor,
+      &b->ftp_base,
+      &b->w_prime,
+      &b->w_expended,
+      &b->ftp_degrade_threshold,
+      &b->ftp_degrade_rate,
+      &b->max_effort_base,
+      &b->tau_base,
+      &b->tau_slope,
+      &b->tau_offset,
+      &b->fatigue_I,
+      &b->effort_limit,
+      &b->grav,
+  };
+  memcpy(cols, c, sizeof(c));
+}
+
+int rider_batch_init(RiderBatch* b, int capacity) {
+  if (!b)
+    return 0;
+
+  memset(b, 0, sizeof(*b));
+  if (capacity <= 0)
+    return capacity == 0;
+
+  double* storage = (double*)calloc((size_t)capacity * RIDER_BATCH_COLUMNS,
+                                    sizeof(double));
+  if (!storage)
+    return 0;
+
+  double** cols[RIDER_BATCH_COLUMNS];
+  rider_batch_columns(b, cols);
+  for (int c = 0; c < RIDER_BATCH_COLUMNS; ++c)
+    *cols[c] = storage + (size_t)c * (size_t)capacity;
+
+  b->storage_ = storage;
+  b->capacity = capacity;
+  return 1;
+}
+
+void rider_batch_free(RiderBatch* b) {
+  if (!b)
+    return;
+  free(b->storage_);
+  memset(b, 0, sizeof(*b));
+}
+
+void rider_batch_load(RiderBatch* b, int i, const RiderState* r) {
+  if (!b || !r || i < 0 || i >= b->capacity)
+    return;
+
+  b->pos[i] = r->pos;
+  b->speed[i] = r->speed;
+
+  b->target_effort[i] = r->target_effort;
+  b->effort[i] = r->effort;
+  b->power[i] = r->power;
+  b->ftp[i] = r->ftp;
+  b->max_drive_force[i] = r->max_drive_force;
+
+  b->oxy_p50[i] = r->oxy_p50;
+  b->sealevel_sat[i] = r->sealevel_sat;
+
+  /* same expressions as resistive_force / equivalent_mass */
+  b->mass_total[i] = r->mass_rider + r->mass_bike;
+  b->mass_eq[i] = equivalent_mass(r);
+  b->cda_base[i] = r->cda_rider + r->cda_wheel_drag;
+  b->crr[i] = r->crr;
+  b->drivetrain_loss[i] = r->drivetrain_loss;
+  b->cda_factor[i] = r->cda_factor;
+
+  const EnergyState* e = &r->energy;
+  b->ftp_base[i] = e->ftp_base;
+  b->w_prime[i] = e->w_prime;
+  b->w_expended[i] = e->w_expended;
+  b->ftp_degrade_threshold[i] = e->ftp_degrade_threshold;
+  b->ftp_degrade_rate[i] = e->ftp_degrade_rate;
+  b->max_effort_base[i] = e->max_effort_base;
+  b->tau_base[i] = e->tau_base;
+  b->tau_slope[i] = e->tau_slope;
+  b->tau_offset[i] = e->tau_offset;
+  b->fatigue_I[i] = e->fatigue_I;
+  b->effort_limit[i] = e->effort_limit;
+
+  b->grav[i] = 0.0;
+}
+
+void rider_batch_load_inputs(RiderBatch* b, int i, const RiderState* r) {
+  if (!b || !r || i < 0 || i >= b->capacity)
+    return;
+
+  b->pos[i] = r->pos;
+  b->speed[i] = r->speed;
+  b->target_effort[i] = r->target_effort;
+  b->cda_factor[i] = r->cda_factor;
+  b->sealevel_sat[i] = r->sealevel_sat;
+}
+
+int rider_batch_push(RiderBatch* b, const RiderState* r) {
+  if (!b || !r || b->count >= b->capacity)
+    return -1;
+  int i = b->count++;
+  rider_batch_load(b, i, r);
+  return i;
+}
+
+void rider_batch_store(const RiderBatch* b, int i, RiderState* r) {
+  if (!b || !r || i < 0 || i >= b->count)
+    return;
+
+  r->pos = b->pos[i];
+  r->speed = b->speed[i];
+  r->effort = b->effort[i];
+  r->power = b->power[i];
+  r->ftp = b->ftp[i];
+  r->sealevel_sat = b->sealevel_sat[i];
+
+  r->energy.ftp = b->ftp[i];
+  r->energy.w_expended = b->w_expended[i];
+  r->energy.fatigue_I = b->fatigue_I[i];
+  r->energy.effort_limit = b->effort_limit[i];
+}
+
+#define ENV_BATCH_COLUMNS 6
+
+int env_batch_init(EnvBatch* e, int capacity) {
+  if (!e)
+    return 0;
+
+  memset(e, 0, sizeof(*e));
+  if (capacity <= 0)
+    return capacity == 0;
+
+  double* storage =
+      (double*)calloc((size_t)capacity * ENV_BATCH_COLUMNS, sizeof(double));
+  if (!storage)
+    return 0;
+
+  e->slope = storage;
+  e->headwind = storage + (size_t)capacity;
+  e->crr = storage + 2 * (size_t)capacity;
+  e->altitude = storage + 3 * (size_t)capacity;
+  e->grav_sin = storage + 4 * (size_t)capacity;
+  e->alt_factor = storage + 5 * (size_t)capacity;
+
+  e->storage_ = storage;
+  e->capacity = capacity;
+  return 1;
+}
+
+void env_batch_free(EnvBatch* e) {
+  if (!e)
+    return;
+  free(e->storage_);
+  memset(e, 0, sizeof(*e));
+}
+
+void env_batch_set_slot(EnvBatch* e, int i, const EnvState* env) {
+  if (!e || !env || i < 0 || i >= e->capacity)
+    return;
+
+  e->slope[i] = env->slope;
+  e->headwind[i] = env->headwind;
+  e->crr[i] = env->crr;
+  e->altitude[i] = env->altitude;
+  e->grav_sin[i] = env->grav_sin;
+  e->alt_factor[i] = env->alt_factor;
+}
+
+void env_batch_set(EnvBatch* e, int i, const EnvState* env) {
+  if (!e || !env || i < 0 || i >= e->capacity)
+    return;
+
+  e->rho = env->rho;
+  e->g = env->g;
+  e->bearing_c0 = env->bearing_c0;
+  e->bearing_c1 = env->bearing_c1;
+  e->baked = env->baked;
+
+  env_batch_set_slot(e, i, env);
+}
+
+void sim_step_riders(RiderBatch* b, const EnvBatch* env, double dt) {
+  if (!b)
+    return;
+  sim_step_riders_range(b, env, 0, b->count, dt);
+}
+
+void sim_step_riders_range(RiderBatch* b, const EnvBatch* env, int begin,
+                           int end, double dt) {
+  if (!b || !env || dt <= 0.0)
+    return;
+  if (begin < 0)
+    begin = 0;
+  if (end > b->count)
+    end = b->count;
+
+  const double rho = env->rho;
+  const double g = env->g;
+  const double c0 = env->bearing_c0;
+  const double c1 = env->bearing_c1;
+  const int baked_grav = env->baked & SIM_ENV_GRAV_SIN;
+  const int baked_alt = env->baked & SIM_ENV_ALT_FACTOR;
+
+  /* Pass 1: FTP degradation, effort limiting, gravity term (libm-bound
+   * unless baked). */
+  for (int i = begin; i < end; ++i) {
+    double alt_f;
+    if (baked_alt) {
+      alt_f = env->alt_factor[i];
+    } else {
+      if (b->sealevel_sat[i] == 1)
+        b->sealevel_sat[i] = saturation(0, b->oxy_p50[i]);
+      alt_f = saturation(env->altitude[i], b->oxy_p50[i]) / b->sealevel_sat[i];
+    }
+    double fatigue_f =
+        fatigue_factor(b->ftp_base[i], b->ftp_degrade_threshold[i],
+                       b->ftp_degrade_rate[i], b->w_expended[i]);
+    b->ftp[i] = b->ftp_base[i] * alt_f * fatigue_f;
+
+    double effort = b->target_effort[i];
+    if (effort > b->effort_limit[i])
+      effort = b->effort_limit[i];
+    if (effort < 0.0)
+      effort = 0.0;
+
+    b->effort[i] = effort;
+    b->power[i] = effort * b->ftp[i];
+
+    b->grav[i] = b->mass_total[i] * g *
+                 (baked_grav ? env->grav_sin[i] : sin(atan(env->slope[i])));
+  }
+
+  /* Pass 2: ACCEL_FORCE integration.  Straight-line arithmetic over the
+   * columns — selects instead of branches, and the stand-still divide goes
+   * through a safe denominator so no lane traps.  Term order matches
+   * step_acceleration / resistive_force exactly. */
+  double* restrict pos = b->pos;
+  double* restrict speed = b->speed;
+  const double* restrict power = b->power;
+  const double* restrict loss = b->drivetrain_loss;
+  const double* restrict max_force = b->max_drive_force;
+  const double* restrict cda_base = b->cda_base;
+  const double* restrict cda_factor = b->cda_factor;
+  const double* restrict crr = b->crr;
+  const double* restrict mass_total = b->mass_total;
+  const double* restrict mass_eq = b->mass_eq;
+  const double* restrict grav = b->grav;
+  const double* restrict headwind = env->headwind;
+  const double* restrict env_crr = env->crr;
+
+  for (int i = begin; i < end; ++i) {
+    double v = speed[i];
+
+    double P_eff = power[i] * (1.0 - loss[i]);
+    double F_power = (v > 0.0) ? P_eff / ((v > 0.0) ? v : 1.0) : HUGE_VAL;
+    double F_cap = (F_power < max_force[i]) ? F_power : max_force[i];
+    double F_prop = (P_eff > 0.0) ? F_cap : 0.0;
+
+    double v_air = v + headwind[i];
+    double cda = cda_base[i] * cda_factor[i];
+    double drag = 0.5 * rho * cda * v_air * fabs(v_air);
+    double roll = (crr[i] + env_crr[i]) * mass_total[i] * g;
+    double bear = c0 + c1 * v;
+    double F_res = drag + roll + grav[i] + bear;
+
+    double a = (F_prop - F_res) / mass_eq[i];
+
+    double v_new = v + a * dt;
+    v_new = (v_new < 0.0) ? 0.0 : v_new;
+    speed[i] = v_new;
+    pos[i] += v_new * dt;
+  }
+
+  /* Pass 3: W' balance — the scalar energy_update on a gathered copy, so
+   * the recovery model has a single definition. */
+  for (int i = begin; i < end; ++i) {
+    EnergyState e;
+    e.ftp_base = b->ftp_base[i];
+    e.ftp = b->ftp[i];
+    e.w_prime = b->w_prime[i];
+    e.w_expended = b->w_expended[i];
+    e.ftp_degrade_threshold = b->ftp_degrade_threshold[i];
+    e.ftp_degrade_rate = b->ftp_degrade_rate[i];
+    e.max_effort_base = b->max_effort_base[i];
+    e.tau_base = b->tau_base[i];
+    e.tau_slope = b->tau_slope[i];
+    e.tau_offset = b->tau_offset[i];
+    e.fatigue_I = b->fatigue_I[i];
+    e.effort_limit = b->effort_limit[i];
+
+    energy_update(&e, b->power[i], dt);
+
+    b->w_expended[i] = e.w_expended;
+    b->fatigue_I[i] = e.fatigue_I;
+    b->effort_limit[i] = e.effort_limit;
+  }
+}
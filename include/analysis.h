@@ -1,7 +1,10 @@
 #ifndef ANALYSIS_H
 #define ANALYSIS_H
 
+#include "metric_summary.h"
 #include "rider.h"
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <map>
 #include <memory>
@@ -31,13 +34,19 @@ class OfflineSimulationRunner {
 
   void add_observer(SimulationObserver* obs);
   void set_end_condition(std::unique_ptr<SimulationEndCondition> cond);
+  // Checked every step: once set, run() stops there (observers still get
+  // on_finish) and cancelled() is true.  Null: never cancelled.
+  void set_cancel_flag(const std::atomic<bool>* flag) { cancel = flag; }
 
   void run();
+  bool cancelled() const { return was_cancelled; }
 
 private:
   std::unique_ptr<Simulation> sim;
   std::vector<SimulationObserver*> observers;
   std::unique_ptr<SimulationEndCondition> end_condition;
+  const std::atomic<bool>* cancel = nullptr;
+  bool was_cancelled = false;
 };
 
 struct PlotSample {
@@ -47,7 +56,7 @@ struct PlotSample {
 
 struct PlotSeries {
   std::string label;
-  std::vector<PlotSample> samples;
+  MetricSummary summary;
   int y_axis = 0; // 0 = left, 1 = right
 };
 
@@ -66,6 +75,50 @@ class MetricObserver : public SimulationObserver {
   std::vector<PlotSample> samples;
 };
 
+// MetricObserver in fixed memory (metric_summary.h): one summary sample,
+// x = sim time, per step, for runs too long to keep every sample.
+class MetricSummaryObserver : public SimulationObserver {
+public:
+  explicit MetricSummaryObserver(MetricFn fn, std::size_t capacity = 4096)
+      : metric(std::move(fn)), summary_(capacity) {}
+
+  void on_step(const Simulation& sim) override;
+
+  const MetricSummary& summary() const { return summary_; }
+
+private:
+  MetricFn metric;
+  MetricSummary summary_;
+};
+
+// Calls `fn` every `interval` seconds of wall time (the first after one
+// interval) with the run's progress so far: sim time over the expected
+// time, the latest finish estimated over the field.  A rider's finish is
+// extrapolated at their average speed since their start (start_offsets,
+// 0 when missing); one not yet started is given the field's average speed
+// from their start.  Add it after the observers whose data `fn` publishes,
+// so a partial includes the step.
+class ProgressObserver : public SimulationObserver {
+public:
+  using ProgressFn = std::function<void(const Simulation&, double progress)>;
+
+  ProgressObserver(ProgressFn fn, std::map<RiderId, double> start_offsets = {},
+                   double interval = 0.25);
+
+  void on_start(const Simulation& sim) override;
+  void on_step(const Simulation& sim) override;
+
+  // Sim time when the last rider is expected to finish.
+  double expected_time(const Simulation& sim) const;
+
+private:
+  ProgressFn fn;
+  std::map<RiderId, double> start_offsets;
+  std::map<RiderId, double> start_pos;
+  std::chrono::steady_clock::duration interval;
+  std::chrono::steady_clock::time_point next;
+};
+
 struct PlotResult {
   std::string title = "";
   std::vector<PlotSeries> series;
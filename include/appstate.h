@@ -6,6 +6,7 @@
 #include "realtime_runner.h"
 #include "sim.h"
 #include "texturemanager.h" // For GameResources
+#include "trace_replay.h"
 #include <SDL3/SDL.h>
 #include <chrono>
 
@@ -34,12 +35,22 @@ class AppState {
   // Declared after sim: the runner's thread must be stopped and destroyed
   // before the Simulation it drives.
   std::unique_ptr<RealtimeSimRunner> runner;
+  // A recorded race shown instead of the live one (open_replay); the
+  // screens hold it, so it is destroyed after them.
+  std::unique_ptr<TraceReplay> replay;
   // View State
   std::unique_ptr<ScreenManager> screens;
 
   // this can be done more elegantly
   void start_realtime_tt(double gap_seconds = 10.0);
 
+  // Shows the trace at `path` (recorded on this course) on the simulation
+  // screen, playing; the live runner is paused meanwhile and the time
+  // controls drive the replay.  False (logged) if it does not open.
+  bool open_replay(const std::string& path);
+  // Back to the live race, resumed unless it was paused before.
+  void close_replay();
+
   AppState();
   ~AppState();
 
@@ -51,6 +62,9 @@ class AppState {
     SDL_GetWindowSize(window, &w, &h);
     return Vector2d(w, h);
   }
+
+private:
+  bool live_was_paused = false; // when the replay opened
 };
 
 #endif
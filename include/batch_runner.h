@@ -0,0 +1,144 @@
+// batch_runner.h — parallel Monte Carlo batches over OfflineSimulationRunner.
+//
+// A batch is one scenario run many times under different draws.  The
+// caller supplies a base course and roster plus a ScenarioFactory that
+// builds a Simulation from them (teams, add_riders, schedules, policies),
+// and one RunPerturbation per run: per-rider FTP / CdA / W′ spreads drawn
+// from the run's seed, an optional wind override, race plans.  Each run is
+// an OfflineSimulationRunner on its own Simulation, to the finish (or the
+// time limit), on a bounded set of worker threads.
+//
+// Runs complete out of order but are folded in run order: every finished
+// run is reduced to a RunSummary (finish order, gaps to the winner, W′
+// minima), handed to the optional callback and merged into BatchStats,
+// then dropped.  At most `window` summaries wait for a slow predecessor —
+// a worker does not start run i until run i - window has been folded — so
+// memory is bounded by the window, not by the batch, and the statistics
+// are bit-identical for every thread count.
+//
+// Runs share nothing mutable: the base course is read-only (a wind override
+// runs on a private copy) and the factory is called concurrently, so it
+// must only read shared state.
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include "course.h"
+#include "decision.h" // RacePlan
+#include "mytypes.h"
+#include "rider.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+class Simulation;
+
+struct RunPerturbation {
+  std::uint64_t seed = 0;
+
+  // Relative standard deviations of independent per-rider normal draws
+  // (0.03 = 3 %); each factor is clamped to [0.5, 1.5].
+  double ftp_sd = 0.0;
+  double cda_sd = 0.0;
+  double w_prime_sd = 0.0;
+
+  // Replaces the course's wind for this run.
+  std::optional<Wind> wind;
+
+  // Set after the factory, before the first step.
+  std::vector<std::pair<TeamId, RacePlan>> race_plans;
+};
+
+struct RiderRunResult {
+  RiderId id = -1;
+  double finish_time = -1.0; // s, exact finish-line crossing; -1 = DNF
+  double gap = -1.0;         // s behind the winner; -1 = DNF
+  double w_prime_min = 0.0;  // J, lowest W′ balance over the run
+  // s at each course checkpoint (RaceClock order, the finish last), on the
+  // same clock as finish_time; -1 = not reached.
+  std::vector<double> splits;
+};
+
+struct RunSummary {
+  size_t index = 0; // position in the batch
+  std::uint64_t seed = 0;
+  double sim_seconds = 0.0;
+  std::vector<RiderRunResult> riders; // finish order; DNFs last, by id
+};
+
+// Streaming mean / variance (Welford) with min and max.
+struct RunningStat {
+  std::uint64_t n = 0;
+  double mean = 0.0;
+  double m2 = 0.0;
+  double min = 0.0;
+  double max = 0.0;
+
+  void add(double x);
+  double variance() const; // sample variance; 0 below two values
+  double sd() const;
+};
+
+struct RiderBatchStats {
+  RiderId id = -1;
+  int finishes = 0;
+  int wins = 0;
+  RunningStat position;    // 1-based finish position (finishers only)
+  RunningStat finish_time; // s (finishers only)
+  RunningStat gap;         // s behind the winner (finishers only)
+  RunningStat w_prime_min; // J (every run)
+};
+
+struct BatchStats {
+  size_t runs = 0;
+  std::vector<RiderBatchStats> riders; // by id
+  RunningStat winning_time;            // s
+  double wall_seconds = 0.0;
+};
+
+struct BatchParams {
+  int threads = 0;   // 0 = std::thread::hardware_concurrency()
+  size_t window = 0; // 0 = 4 x threads
+  double dt = 0.1;   // s, fixed step of every run
+  double time_limit = 7200.0; // s of sim time; riders not in by then: DNF
+  // Per-rider start times (time trials: build_start_offsets), subtracted
+  // from every crossing so finish times and splits are ride times.
+  std::map<RiderId, double> start_offsets;
+};
+
+class BatchRunner {
+public:
+  // Builds one run's Simulation on `course` from the run's perturbed
+  // roster.  Called on worker threads, concurrently.
+  using ScenarioFactory = std::function<std::unique_ptr<Simulation>(
+      const Course& course, const std::vector<RiderConfig>& riders)>;
+  // Called once per run, in run order, from whichever worker folds it;
+  // keep it short — folding waits on it.
+  using RunCallback = std::function<void(const RunSummary&)>;
+
+  BatchRunner(const Course& course, std::vector<RiderConfig> riders,
+              ScenarioFactory factory, BatchParams params = {});
+
+  BatchStats run(const std::vector<RunPerturbation>& runs,
+                 const RunCallback& on_run = {}) const;
+
+  // One run, on the calling thread (what every worker does per index).
+  RunSummary run_one(size_t index, const RunPerturbation& p) const;
+
+  // The run's roster: the base configs with FTP / CdA / W′ scaled by draws
+  // from p.seed.  Deterministic per seed.
+  std::vector<RiderConfig> perturb_riders(const RunPerturbation& p) const;
+
+private:
+  const Course& course_;
+  std::vector<RiderConfig> riders_;
+  ScenarioFactory factory_;
+  BatchParams params_;
+};
+
+#endif
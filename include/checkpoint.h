@@ -0,0 +1,192 @@
+// checkpoint.h — binary simulation checkpoints (Simulation::save_checkpoint
+// / load_checkpoint).
+//
+// A checkpoint is the run's *state*: rider physics and energy, lateral and
+// follow state, rotation state machines, the group snapshot, the multi-rate
+// schedule's position, race-clock traces, the decision layer's per-run
+// bookkeeping and the sim clock.  It is not the scenario: the course,
+// rider configs, teams, policies, schedules, behaviors and race plans are
+// set up by the caller exactly as for the run that was saved, and the
+// checkpoint is loaded on top.  What configuration it can check (course
+// length, roster in slot order, who holds which policy / schedule /
+// behavior) it checks, and refuses a mismatch.  Policies with per-run state
+// carry it through IRiderPolicy::save_state / load_state.
+//
+// The format is a flat byte stream in host byte order: a header (magic,
+// format version, the sizes of the core's POD structs, which are written
+// raw, and the payload's length and hash), then the payload — every
+// owner's setup record, then every owner's state, in a fixed order.  A
+// load verifies the hash and the setup before it changes anything.
+// Restoring continues the run bit-identically — with the same build; a
+// checkpoint is not an exchange format.
+//
+// CheckpointWriter appends to a byte vector; CheckpointReader reads one
+// back with bounds checks and a sticky failure flag, so a load can read
+// straight through and test ok() once per section.
+//
+// Header-only (same precedent as team.h).
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+inline constexpr char kCheckpointMagic[8] = {'C', 'S', 'I', 'M',
+                                             'C', 'K', 'P', 'T'};
+// 2: group members written field by field, struct padding zeroed.
+inline constexpr std::uint32_t kCheckpointVersion = 2;
+
+// FNV-1a over 8-byte words (the tail zero-padded): an integrity check
+// against truncation and corruption, not a cryptographic one.
+inline std::uint64_t checkpoint_hash(const char* data, std::size_t n) {
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    h = (h ^ word) * 0x100000001b3ull;
+  }
+  if (i < n) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, data + i, n - i);
+    h = (h ^ word) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+class CheckpointWriter {
+public:
+  template <class T> void pod(const T& v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const char* p = reinterpret_cast<const char*>(&v);
+    bytes_.insert(bytes_.end(), p, p + sizeof(T));
+  }
+
+  template <class T> void pods(const T* data, std::size_t n) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    pod(static_cast<std::uint64_t>(n));
+    const char* p = reinterpret_cast<const char*>(data);
+    bytes_.insert(bytes_.end(), p, p + n * sizeof(T));
+  }
+  template <class T> void pods(const std::vector<T>& v) {
+    pods(v.data(), v.size());
+  }
+
+  // A raw struct whose padding bytes [pad_from, pad_to) go out as zeros:
+  // padding holds whatever the last copy left there, and a checkpoint must
+  // be a function of the state alone (a fork or a restore re-saves to the
+  // same bytes).
+  template <class T>
+  void pod_padded(const T& v, std::size_t pad_from, std::size_t pad_to) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const std::size_t at = bytes_.size();
+    pod(v);
+    std::memset(bytes_.data() + at + pad_from, 0, pad_to - pad_from);
+  }
+
+  void str(const std::string& s) {
+    pod(static_cast<std::uint64_t>(s.size()));
+    bytes_.insert(bytes_.end(), s.begin(), s.end());
+  }
+
+  // Overwrites a pod written earlier at byte offset `at` (header fields
+  // known only once the payload is out).
+  template <class T> void patch(std::size_t at, const T& v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::memcpy(bytes_.data() + at, &v, sizeof(T));
+  }
+
+  std::size_t size() const { return bytes_.size(); }
+  std::vector<char>& bytes() { return bytes_; }
+
+private:
+  std::vector<char> bytes_;
+};
+
+class CheckpointReader {
+public:
+  CheckpointReader(const char* data, std::size_t size)
+      : p_(data), end_(data + size) {}
+
+  template <class T> bool pod(T& v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (!take(sizeof(T)))
+      return false;
+    std::memcpy(&v, p_ - sizeof(T), sizeof(T));
+    return true;
+  }
+
+  template <class T> bool pods(std::vector<T>& v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::uint64_t n = 0;
+    if (!pod(n) || n > remaining() / sizeof(T))
+      return fail("truncated array");
+    v.resize(n);
+    if (n > 0)
+      std::memcpy(v.data(), p_, n * sizeof(T));
+    p_ += n * sizeof(T);
+    return true;
+  }
+
+  bool str(std::string& s) {
+    std::uint64_t n = 0;
+    if (!pod(n) || n > remaining())
+      return fail("truncated string");
+    s.assign(p_, n);
+    p_ += n;
+    return true;
+  }
+
+  // Reads an element count for a hand-written array whose elements take at
+  // least min_bytes each; fails if the rest of the stream can't hold them.
+  bool count(std::uint64_t& n, std::size_t min_bytes) {
+    if (!pod(n))
+      return false;
+    if (n > remaining() / min_bytes)
+      return fail("truncated array");
+    return true;
+  }
+
+  // Reads a count and fails unless it equals `expected` — for sections
+  // whose size the scenario already fixes.
+  bool expect_count(std::uint64_t expected, const char* what) {
+    std::uint64_t n = 0;
+    if (pod(n) && n != expected)
+      return fail(what);
+    return ok();
+  }
+
+  // Marks the read failed (first reason wins); always returns false.
+  bool fail(const char* why) {
+    if (ok_)
+      error_ = why;
+    ok_ = false;
+    return false;
+  }
+
+  bool ok() const { return ok_; }
+  bool at_end() const { return p_ == end_; }
+  // The unread rest of the stream.
+  const char* data() const { return p_; }
+  std::size_t remaining() const { return static_cast<std::size_t>(end_ - p_); }
+  const char* error() const { return error_; }
+
+private:
+  bool take(std::size_t n) {
+    if (!ok_ || n > remaining())
+      return fail("truncated checkpoint");
+    p_ += n;
+    return true;
+  }
+
+  const char* p_;
+  const char* end_;
+  bool ok_ = true;
+  const char* error_ = "";
+};
+
+#endif
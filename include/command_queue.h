@@ -0,0 +1,177 @@
+// command_queue.h — UI -> physics command funnel for Simulation.
+//
+// Mutators on any thread push a typed SimCommand record into a bounded
+// multi-producer / single-consumer ring; step_fixed pops them on the
+// physics thread.  The ring is an array of cells, each with a sequence
+// number (the Vyukov bounded queue): a producer claims a position with one
+// CAS on the tail, moves its record into the cell and publishes it by
+// bumping the cell's sequence; the consumer takes cells in order while
+// their sequence says "full".  No lock, and no allocation per command —
+// a record is a std::variant of plain structs, built in place.  Commands
+// that carry owned data (a schedule, a policy, a roster, a race plan) move
+// it in; nothing is copied.
+//
+// A full ring drops the push (counted in dropped()) rather than block the
+// UI.  A producer that has claimed a cell but not yet published it holds
+// back the commands behind it until the next drain — order is always
+// claim order.
+//
+// Header-only (same precedent as team.h).
+
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include "decision.h"
+#include "effortschedule.h"
+#include "mytypes.h"
+#include "rotation.h"
+#include "rotation_params.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <variant>
+#include <vector>
+
+// --- command records (one per Simulation mutator) ---
+
+struct SetEffortScheduleCmd {
+  RiderId rider;
+  std::shared_ptr<EffortSchedule> schedule;
+};
+struct ClearEffortScheduleCmd {
+  RiderId rider;
+};
+struct SetRiderPolicyCmd {
+  RiderId rider;
+  std::shared_ptr<IRiderPolicy> policy;
+};
+struct ClearRiderPolicyCmd {
+  RiderId rider;
+};
+struct SetRacePlanCmd {
+  TeamId team;
+  RacePlan plan;
+};
+struct SetRiderEffortCmd {
+  RiderId rider;
+  double effort;
+};
+struct SetFollowTargetCmd {
+  RiderId rider;
+  RiderId target;
+  FollowRelation relation;
+};
+struct ClearFollowTargetCmd {
+  RiderId rider;
+};
+struct SetPacelineRotationCmd {
+  std::vector<RotationMember> roster;
+  RotationParams params;
+};
+struct ClearPacelineRotationCmd {};
+struct PromoteSitterCmd {
+  RiderId rider;
+};
+struct RequestPacelineJoinCmd {
+  RiderId rider;
+  bool sits_in;
+};
+
+// monostate = empty cell / a command coalesced away.
+using SimCommand =
+    std::variant<std::monostate, SetEffortScheduleCmd, ClearEffortScheduleCmd,
+                 SetRiderPolicyCmd, ClearRiderPolicyCmd, SetRacePlanCmd,
+                 SetRiderEffortCmd, SetFollowTargetCmd, ClearFollowTargetCmd,
+                 SetPacelineRotationCmd, ClearPacelineRotationCmd,
+                 PromoteSitterCmd, RequestPacelineJoinCmd>;
+
+// --- the ring ---
+
+// The capacity is rounded up to a power of two, at least 2: slots are
+// indexed by mask.  push() from any thread; pop() from one consumer thread
+// only.
+template <typename T> class MpscRing {
+public:
+  explicit MpscRing(std::size_t capacity)
+      : mask_(round_capacity(capacity) - 1) {
+    cells_.reset(new Cell[mask_ + 1]);
+    for (std::size_t i = 0; i <= mask_; ++i)
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  MpscRing(const MpscRing&) = delete;
+  MpscRing& operator=(const MpscRing&) = delete;
+
+  // False (and counted) when the ring is full; v is left untouched then.
+  bool push(T&& v) {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& c = cells_[pos & mask_];
+      const std::size_t seq = c.seq.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          c.value = std::move(v);
+          c.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Moves the oldest published record into out; false when there is none.
+  bool pop(T& out) {
+    const std::size_t pos = head_.load(std::memory_order_relaxed);
+    Cell& c = cells_[pos & mask_];
+    if (c.seq.load(std::memory_order_acquire) != pos + 1)
+      return false;
+    out = std::move(c.value);
+    c.value = T{}; // owned payloads go now, not when the cell comes round
+    c.seq.store(pos + mask_ + 1, std::memory_order_release);
+    head_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Claimed but not yet popped.  A diagnostic: racy by nature.
+  std::size_t size() const {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+  std::size_t capacity() const { return mask_ + 1; }
+  std::uint64_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Cell {
+    std::atomic<std::size_t> seq{0};
+    T value{};
+  };
+
+  static std::size_t round_capacity(std::size_t n) {
+    std::size_t c = 2;
+    while (c < n)
+      c <<= 1;
+    return c;
+  }
+
+  const std::size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  // Producers hammer the tail, the consumer the head: keep them apart.
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  alignas(64) std::atomic<std::size_t> head_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+#endif
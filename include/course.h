@@ -44,6 +44,48 @@ struct Checkpoint {
 
 std::ostream& operator<<(std::ostream& os, const Segment& seg);
 
+// Everything a rider's tick reads from the course at one position, from a
+// single ICourseView::sample() call.
+struct CourseSample {
+  double slope;
+  double crr;
+  double heading;
+  double road_width;
+  double altitude;
+  Wind wind;
+
+  // Derived terms that depend on position only.  Course bakes them per
+  // segment (SegmentEnv); the default sample() evaluates them in place.
+  double grav_sin;  // sin(atan(slope))
+  double headwind;  // wind.speed * cos(wind.heading - heading)
+  double crosswind; // wind.speed * sin(wind.heading - heading)
+
+  // The segment holding pos and its altitude at either end (altitude is
+  // linear in between), for per-segment caches keyed on it.  segment is -1
+  // when the view has no segment table.
+  int segment;
+  double seg_alt0;
+  double seg_alt1;
+};
+
+// Course::bake's per-segment record: the transcendental terms of
+// CourseSample, computed once per segment (and again on set_wind) instead
+// of once per rider per tick.
+struct SegmentEnv {
+  double grav_sin;
+  double headwind;
+  double crosswind;
+};
+
+// Per-caller lookup hint: the segment the last sample fell in.  A rider
+// moves forward by far less than a segment per tick, so sample() checks
+// this segment and the next few before falling back to a binary search —
+// O(1) amortised, however many segments a GPX course has.  Any cursor is
+// valid for any position; a stale one only costs the search.
+struct SegmentCursor {
+  int seg = 0;
+};
+
 class ICourseView {
 public:
   virtual double get_slope(double pos) const = 0;
@@ -52,6 +94,13 @@ class ICourseView {
   virtual double get_road_width(double pos) const = 0;
   virtual double get_heading(double pos) const = 0;
   virtual Wind get_wind(double pos) const = 0;
+  // The full record at pos in one dispatch; advances `cursor`.  The default
+  // composes the getters above (and ignores the cursor).
+  virtual CourseSample sample(double pos, SegmentCursor& cursor) const;
+  CourseSample sample(double pos) const {
+    SegmentCursor cursor;
+    return sample(pos, cursor);
+  }
   // virtual bool isCheckpoint(double pos) const = 0;
   virtual ~ICourseView() = default;
 
@@ -65,6 +114,8 @@ class Course : public ICourseView {
 private:
   std::vector<Segment> segments;
   Wind wind_{0.0, 0.0};
+  // Parallel to segments; rebuilt by bake().
+  std::vector<SegmentEnv> env_;
   // Sorted by pos; the finish (at total_length) is implicit — every course
   // ends with it.
   std::vector<Checkpoint> checkpoints_;
@@ -85,8 +136,17 @@ class Course : public ICourseView {
   double get_road_width(double pos) const override;
   double get_heading(double pos) const override;
   Wind get_wind(double pos) const override;
+  using ICourseView::sample;
+  CourseSample sample(double pos, SegmentCursor& cursor) const override;
+  // Rebakes the wind projections.
   void set_wind(Wind w);
 
+  // Fills env_ from the segments and the wind.  The constructor and
+  // set_wind call it; values are bit-identical to evaluating the same
+  // expressions at sample time.
+  void bake();
+  const std::vector<SegmentEnv>& get_segment_env() const { return env_; }
+
   // Inserts sorted by pos (ahead of the implicit finish).
   void add_checkpoint(double pos, std::string label);
   const std::vector<Checkpoint>& get_checkpoints() const {
@@ -97,6 +157,8 @@ class Course : public ICourseView {
   const std::vector<Segment>& get_segments() const { return segments; }
 
   int find_segment(double pos) const;
+  // Same result, starting from (and updating) the cursor's segment.
+  int find_segment(double pos, SegmentCursor& cursor) const;
 
   MatrixX2d get_points(double x_min, double x_max) const;
 
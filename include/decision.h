@@ -31,6 +31,8 @@
 #include <unordered_map>
 #include <vector>
 
+class CheckpointReader;
+class CheckpointWriter;
 class PhysicsEngine;
 class Rider;
 class Simulation;
@@ -166,6 +168,17 @@ class IRiderPolicy {
   virtual ~IRiderPolicy() = default;
   virtual PolicyOutput decide(const DecisionContext& ctx) = 0;
   virtual const char* name() const = 0;
+
+  // Checkpoints (checkpoint.h).  A policy with per-run state writes it here
+  // and reads it back into the instance the restoring scenario installed
+  // (matched by rider and name()).  The default is a stateless policy.
+  virtual void save_state(CheckpointWriter&) const {}
+  virtual bool load_state(CheckpointReader&) { return true; }
+
+  // A fresh instance in the same state, for Simulation::fork.  nullptr (the
+  // default) lets the fork share this one — right only for a policy whose
+  // decide() keeps no state, since a fork may step on another thread.
+  virtual std::shared_ptr<IRiderPolicy> clone() const { return nullptr; }
 };
 
 // --- C3: W′-budgeted pacing policy ---
@@ -205,6 +218,9 @@ class WPrimePacingPolicy : public IRiderPolicy {
   explicit WPrimePacingPolicy(WPrimePacingParams params = {});
   PolicyOutput decide(const DecisionContext& ctx) override;
   const char* name() const override { return "wp-pace"; }
+  std::shared_ptr<IRiderPolicy> clone() const override {
+    return std::make_shared<WPrimePacingPolicy>(*this);
+  }
 
 private:
   // The C3 baseline: W′-budgeted pace toward the current horizon.
@@ -261,6 +277,12 @@ class DecisionSystem {
 public:
   explicit DecisionSystem(const Course* course, DecisionParams params = {});
 
+  // Deep copy for Simulation::fork: per-run state and race plans copied,
+  // policies cloned (IRiderPolicy::clone; one clone per shared instance),
+  // CourseIntel shared — it is immutable.
+  DecisionSystem(const DecisionSystem& o);
+  DecisionSystem& operator=(const DecisionSystem&) = delete;
+
   // Perception feed — call every physics step, after the engine stepped, with
   // the post-step sim time.  Per rider this is one gridline-index comparison
   // unless a gridline/checkpoint was actually crossed.
@@ -303,12 +325,33 @@ class DecisionSystem {
   double decision_period() const { return params_.decision_period; }
 
   const RaceClock& race_clock() const { return clock_; }
-  const CourseIntel& course_intel() const { return intel_; }
+  const CourseIntel& course_intel() const { return *intel_; }
+
+  // Checkpoints (checkpoint.h).  Policies and race plans are scenario
+  // setup: save_setup records who holds which (policy by name), and
+  // check_setup fails unless this system matches — it changes nothing.
+  // The state is the race-clock traces, policy-installed follow targets,
+  // the last directives and each policy's own save_state.
+  void save_setup(CheckpointWriter& w) const;
+  bool check_setup(CheckpointReader& r) const;
+  void save_state(CheckpointWriter& w) const;
+  bool load_state(CheckpointReader& r);
+
+  // That setup itself, for rewinding (keyframes.h): copy_setup clones the
+  // policies as the copy constructor does; restore_setup replaces the
+  // current policies and race plans with another clone of a copy, so a
+  // checkpoint saved under it loads.  Per-run state is left to that load.
+  struct Setup {
+    std::unordered_map<RiderId, std::shared_ptr<IRiderPolicy>> policies;
+    std::unordered_map<TeamId, TeamDirector> directors;
+  };
+  Setup copy_setup() const;
+  void restore_setup(const Setup& setup);
 
 private:
   DecisionParams params_;
   RaceClock clock_;
-  CourseIntel intel_;
+  std::shared_ptr<const CourseIntel> intel_; // immutable; forks share it
 
   std::unordered_map<RiderId, std::shared_ptr<IRiderPolicy>> policies_;
   // Follow targets this layer installed (vs. rotation/UI ones): only these
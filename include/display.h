@@ -16,6 +16,26 @@
 // determines px offset per meter of lateral offset
 static constexpr double kLatPxPerM = 0.5;
 
+// Halo / legend colour per group ordinal (kNoGroup gray).  Render-side, so
+// group.h stays SDL-free.
+inline SDL_FColor group_colour(GroupId ordinal) {
+  if (ordinal < 0)
+    return {0.55f, 0.55f, 0.55f, 1.0f}; // kNoGroup → gray
+
+  static constexpr SDL_FColor palette[] = {
+      {0.20f, 0.65f, 1.00f, 1.0f}, // 0 — blue   (front group / breakaway)
+      {0.20f, 0.85f, 0.45f, 1.0f}, // 1 — green  (first chase)
+      {1.00f, 0.70f, 0.10f, 1.0f}, // 2 — amber
+      {0.90f, 0.30f, 0.30f, 1.0f}, // 3 — red
+      {0.75f, 0.40f, 1.00f, 1.0f}, // 4 — purple
+      {1.00f, 0.50f, 0.20f, 1.0f}, // 5 — orange
+      {0.20f, 0.90f, 0.90f, 1.0f}, // 6 — cyan
+      {1.00f, 0.40f, 0.80f, 1.0f}, // 7 — pink
+  };
+  constexpr int N = static_cast<int>(sizeof(palette) / sizeof(palette[0]));
+  return palette[ordinal % N];
+}
+
 struct RenderContext {
   SDL_Renderer* renderer;
   std::weak_ptr<Camera> camera_weak;
@@ -27,7 +47,15 @@ struct RenderContext {
   double interp_sim_time = 0.0; // for animation sim timing
                                 //
   std::unordered_map<int, RiderRenderState> riders;
-  GroupSnapshot groups;
+  // The current frame's groups, and its string table for their labels:
+  // valid for the render pass, like the riders' names.
+  std::vector<FrameGroup> groups;
+  const StringTable* strings = nullptr;
+
+  std::string_view group_label(const FrameGroup& g) const {
+    return strings ? std::string_view(strings->at(g.label))
+                   : std::string_view();
+  }
 };
 
 enum class RenderLayer : int { Course = 0, Riders = 1, UI = 2, COUNT };
@@ -45,6 +45,7 @@
 #include "drafting_params.h"
 #include "group.h"
 #include "mytypes.h"
+#include <unordered_map>
 #include <vector>
 
 // Flat per-rider input, built by the engine each tick from one-tick-stale
@@ -85,4 +86,30 @@ std::vector<double>
 compute_draft_factors(const std::vector<DraftRiderState>& riders,
                       const DraftingParams& p);
 
+// Same, with the front-to-back processing order supplied by the caller
+// (indices into `riders`, lon_pos descending — the engine's LonOrder, see
+// lon_order.h) instead of sorted here.
+std::vector<double>
+compute_draft_factors(const std::vector<DraftRiderState>& riders,
+                      const std::vector<int>& front_to_back,
+                      const DraftingParams& p);
+
+// Working buffers for the output-parameter variant below.  Sized on each
+// call and never shrunk, so a caller that keeps one per solve (the engine:
+// one per group run) allocates nothing once it has seen its largest group.
+struct DraftScratch {
+  std::vector<int> leader_of;
+  std::vector<double> link_s;
+  std::vector<double> depth;
+  std::vector<double> follower_s;
+  std::vector<int> body_ahead;
+  std::unordered_map<GroupId, int> in_window; // zeroed, not cleared
+};
+
+// Same, writing the factors into `factors` (resized to riders.size()).
+void compute_draft_factors(const std::vector<DraftRiderState>& riders,
+                           const std::vector<int>& front_to_back,
+                           const DraftingParams& p, DraftScratch& scratch,
+                           std::vector<double>& factors);
+
 #endif
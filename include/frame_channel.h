@@ -0,0 +1,122 @@
+// frame_channel.h — lock-free hand-off of FrameSnapshots from the physics
+// thread to readers (the renderer, tests).
+//
+// A fixed pool of frame slots, each with a reader count.  The physics
+// thread builds the next frame in a slot no reader holds (begin()) and
+// publish() makes it the current frame — the old current becomes the
+// previous one — with a single atomic store of the packed (curr, prev,
+// sequence) word.  Readers acquire() the published pair by bumping both
+// slots' reader counts: no copy, no lock.  The FramePair handle releases
+// them when it goes away; a published frame is immutable until then.
+//
+// Neither side ever waits for the other.  acquire() retries only if a
+// publish lands between its load and its pin; if readers pin every spare
+// slot, begin() returns nullptr and the caller drops that frame (counted
+// in dropped()).  Slots are reused in place, so once their containers have
+// grown to a frame's size, building and publishing allocate nothing.
+//
+// One writer thread; any number of readers.
+
+#ifndef FRAME_CHANNEL_H
+#define FRAME_CHANNEL_H
+
+#include "snapshot.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+class FrameChannel;
+
+// A reader's pinned (prev, curr) pair.  Move-only; empty (false) when
+// nothing was published.  An empty side reads as a default FrameSnapshot
+// (sim_time -1), like the buffers before the first publish.
+class FramePair {
+public:
+  FramePair() = default;
+  FramePair(FramePair&& o) noexcept;
+  FramePair& operator=(FramePair&& o) noexcept;
+  FramePair(const FramePair&) = delete;
+  FramePair& operator=(const FramePair&) = delete;
+  ~FramePair() { release(); }
+
+  explicit operator bool() const { return curr_ >= 0; }
+
+  const FrameSnapshot& prev() const;
+  const FrameSnapshot& curr() const;
+
+private:
+  friend class FrameChannel;
+  void release();
+
+  const FrameChannel* ch_ = nullptr;
+  int prev_ = -1;
+  int curr_ = -1;
+};
+
+class FrameChannel {
+public:
+  // Published pair + one frame in build + spares for readers to pin.
+  static constexpr int kSlots = 8;
+
+  FrameChannel() = default;
+  FrameChannel(const FrameChannel&) = delete;
+  FrameChannel& operator=(const FrameChannel&) = delete;
+
+  // --- writer (physics thread) ---
+
+  // A slot to build the next frame in, or nullptr if readers hold every
+  // spare.  Its previous contents are stale; overwrite every field.
+  FrameSnapshot* begin();
+  // Publishes the frame from begin() as current.
+  void publish();
+  // Gives the begin() slot back unpublished.
+  void abandon();
+  // The current frame as last published, nullptr if none.  Writer-side
+  // only (readers use acquire()).
+  const FrameSnapshot* published() const;
+  // Back to "nothing published"; readers' pinned pairs stay valid.
+  void clear();
+
+  // Frames begin() could not find a slot for.
+  std::uint64_t dropped() const { return dropped_; }
+
+  // --- readers (any thread) ---
+
+  FramePair acquire() const;
+
+private:
+  friend class FramePair;
+
+  struct Slot {
+    FrameSnapshot frame;
+    mutable std::atomic<int> readers{0};
+  };
+
+  static constexpr std::uint64_t kNone = 0xFF;
+
+  // Packed published state: curr in bits 0-7, prev in 8-15 (kNone = no
+  // frame), a publish sequence above — so a word never repeats and a
+  // reader can tell whether it changed under its pin.
+  static std::uint64_t pack(std::uint64_t curr, std::uint64_t prev,
+                            std::uint64_t seq) {
+    return curr | (prev << 8) | (seq << 16);
+  }
+  static int curr_of(std::uint64_t w) { return slot_of(w & 0xFF); }
+  static int prev_of(std::uint64_t w) { return slot_of((w >> 8) & 0xFF); }
+  static std::uint64_t seq_of(std::uint64_t w) { return w >> 16; }
+  static int slot_of(std::uint64_t v) {
+    return v == kNone ? -1 : static_cast<int>(v);
+  }
+
+  void unpin(int slot) const;
+
+  std::array<Slot, kSlots> slots_;
+  std::atomic<std::uint64_t> state_{pack(kNone, kNone, 0)};
+
+  // writer-only
+  int building_ = -1;
+  std::uint64_t dropped_ = 0;
+};
+
+#endif
@@ -3,11 +3,14 @@
 
 #include "grouping_params.h"
 #include "mytypes.h"
-#include <SDL3/SDL.h>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+class CheckpointWriter;
+class CheckpointReader;
+
 typedef enum { Unassigned = 0, Paceline = 1, Body = 2 } GroupRole;
 
 typedef struct GroupMember {
@@ -58,6 +61,12 @@ class GroupTracker {
   // All members start in group.body; paceline is empty after this call.
   void update(const std::vector<GroupMember>& members);
 
+  // Same, with the front-to-back order supplied by the caller (indices into
+  // members, lon_pos descending — the engine's LonOrder, lon_order.h), so
+  // nothing is sorted here.
+  void update(const std::vector<GroupMember>& members,
+              const std::vector<int>& front_to_back);
+
   // Distribute members into paceline / body according to their declarations.
   // Must be called after update() and before reading the snapshot.
   // Riders absent from decls, or with role == Unassigned, go into body.
@@ -76,32 +85,30 @@ class GroupTracker {
   // Ordered front-to-back: index 0 is the leading group.
   const GroupSnapshot& get_snapshot() const;
 
+  // Bumped whenever the snapshot may have changed, so a per-tick reader can
+  // keep its own copy and redo the id lookups only at the group rate.
+  std::uint64_t revision() const { return revision_; }
+
+  // Checkpoints (checkpoint.h): the snapshot as of the last group tick —
+  // at a slow group rate it outlives several physics ticks.  The lookup
+  // maps are rebuilt from it.
+  void save_state(CheckpointWriter& w) const;
+  bool load_state(CheckpointReader& r);
+
 private:
   GroupingParams params_;
 
-  // Rebuilt from scratch each tick.
+  // Rebuilt each tick, in place: groups, member vectors and map nodes are
+  // reused, so a tick with an unchanged roster allocates nothing.
   GroupSnapshot snapshot_;
+  std::uint64_t revision_ = 0;
   std::unordered_map<RiderId, GroupId> rider_to_group_;
   std::unordered_map<RiderId, GroupRole> rider_to_role_;
-};
 
-inline SDL_FColor group_colour(GroupId ordinal) {
-  if (ordinal < 0)
-    return {0.55f, 0.55f, 0.55f, 1.0f}; // kNoGroup → gray
-
-  static constexpr SDL_FColor palette[] = {
-      {0.20f, 0.65f, 1.00f, 1.0f}, // 0 — blue   (front group / breakaway)
-      {0.20f, 0.85f, 0.45f, 1.0f}, // 1 — green  (first chase)
-      {1.00f, 0.70f, 0.10f, 1.0f}, // 2 — amber
-      {0.90f, 0.30f, 0.30f, 1.0f}, // 3 — red
-      {0.75f, 0.40f, 1.00f, 1.0f}, // 4 — purple
-      {1.00f, 0.50f, 0.20f, 1.0f}, // 5 — orange
-      {0.20f, 0.90f, 0.90f, 1.0f}, // 6 — cyan
-      {1.00f, 0.40f, 0.80f, 1.0f}, // 7 — pink
-  };
-  constexpr int N = static_cast<int>(sizeof(palette) / sizeof(palette[0]));
-  return palette[ordinal % N];
-}
+  // Scratch: update()'s ordered copy, apply_role_declarations()' members.
+  std::vector<GroupMember> sorted_;
+  std::vector<GroupMember> all_;
+};
 
 struct GroupContext {
   // --- own identity within the group ---
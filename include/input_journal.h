@@ -0,0 +1,77 @@
+// input_journal.h — record a live session's commands, re-run it offline.
+//
+// A realtime session is not reproducible by itself: UI commands reach
+// Simulation::drain_commands() at whatever step the physics thread happens
+// to be on.  An InputJournal attached to the Simulation (start_journal())
+// fixes that: it takes a checkpoint of the state at the start, then
+// records every command drain_commands() applies (after effort coalescing)
+// with the index of the step it was applied at, and counts the steps.
+// Those three things are the whole session's input.
+//
+// replay_journal() re-executes it through OfflineSimulationRunner at full
+// speed: it loads the start checkpoint into a Simulation set up as the live
+// one was when the journal started (checkpoint.h: same scenario), queues
+// each command just before the step it was applied at, and stops after the
+// journaled step count — bit-identical to the live run, with any observers
+// (a TelemetryRecorder, for a trace) attached.
+//
+// Commands are copied as recorded; a policy is cloned (IRiderPolicy::clone,
+// or shared when it has no state), at record time and again for each
+// replay, so neither the live run nor an earlier replay leaves its state
+// in it.  Schedules are immutable and shared.  A journal lives in memory —
+// policies and schedules are code, with no serialised form.
+//
+// The physics thread writes the journal; read it once the driver stopped.
+// reset() and load_checkpoint() end journaling (the start state no longer
+// leads to the live one).
+
+#ifndef INPUT_JOURNAL_H
+#define INPUT_JOURNAL_H
+
+#include "command_queue.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Simulation;
+class SimulationObserver;
+
+struct JournalEntry {
+  std::uint64_t step; // steps since the journal started, before this one
+  SimCommand cmd;
+};
+
+class InputJournal {
+public:
+  const std::vector<char>& start_state() const { return start_; }
+  double dt() const { return dt_; }
+  const std::vector<JournalEntry>& entries() const { return entries_; }
+  // Steps taken while journaling.
+  std::uint64_t steps() const { return steps_; }
+
+  // --- Simulation's side (physics thread) ---
+
+  void begin(std::vector<char> start_state, double dt);
+  void record(const SimCommand& cmd);
+  void end_step() { ++steps_; }
+
+private:
+  std::vector<char> start_;
+  double dt_ = 0.0;
+  std::vector<JournalEntry> entries_;
+  std::uint64_t steps_ = 0;
+};
+
+// The copy a journal keeps, or a replay queues: policies cloned.
+SimCommand copy_journaled_command(const SimCommand& cmd);
+
+// Re-runs the journaled session on `sim`, which must be set up as the live
+// Simulation was when the journal started.  Observers see on_start, every
+// step and on_finish as with OfflineSimulationRunner.  False (logged) if
+// the start checkpoint does not load.
+bool replay_journal(const InputJournal& journal,
+                    std::unique_ptr<Simulation> sim,
+                    const std::vector<SimulationObserver*>& observers);
+
+#endif
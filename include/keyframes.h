@@ -0,0 +1,80 @@
+// keyframes.h — rewind a live session to an earlier moment.
+//
+// Today's only way back is Simulation::reset() and riding the race again.
+// KeyframeRing keeps, on the physics thread, a bounded ring of full-state
+// keyframes, one every `interval` seconds of sim time.  A keyframe is a
+// checkpoint (checkpoint.h), the setup it was saved under (policies, race
+// plans, schedules: Simulation::Setup) and an input journal
+// (input_journal.h) of every command applied since.  rewind(T) restores
+// the latest keyframe at or before T and re-simulates to T at full speed,
+// feeding the journaled commands back at their steps — so T is where the
+// session was, bit for bit — and the session carries on from there: the
+// keyframes past T belong to the abandoned future and are dropped.
+//
+// Memory is capped at max_bytes (checkpoints plus journals); beyond it the
+// oldest keyframes go, so the reachable past is about max_bytes over one
+// checkpoint's size, times the interval.  A capture is one
+// save_checkpoint() — a millisecond or so for a couple of hundred riders —
+// once per interval, against a 10 ms step budget at 100 Hz.
+//
+// Keyframes hold the Simulation's input journal (there is one), and start
+// over when anything else takes or ends it: reset(), a load_checkpoint()
+// of its own, another start_journal().
+//
+// Physics thread only, but earliest() and bytes() are readable anywhere.
+
+#ifndef KEYFRAMES_H
+#define KEYFRAMES_H
+
+#include "input_journal.h"
+#include "sim.h"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+
+struct KeyframeParams {
+  double interval = 10.0;           // s of sim time between keyframes
+  std::size_t max_bytes = 64 << 20; // checkpoints + journals
+};
+
+class KeyframeRing {
+public:
+  explicit KeyframeRing(KeyframeParams params = {}) : params_(params) {}
+
+  // After every step: takes a keyframe once the interval has passed since
+  // the last one (the first at once).
+  void on_step(Simulation& sim);
+
+  // Back to sim time t, clamped to [earliest(), now].  False (logged) with
+  // no keyframes; then the simulation is untouched.
+  bool rewind(Simulation& sim, double t);
+
+  // Drops every keyframe and stops journaling.
+  void clear(Simulation& sim);
+
+  std::size_t size() const { return frames_.size(); }
+  // Earliest reachable sim time; -1 with no keyframes.
+  double earliest() const { return earliest_; }
+  std::size_t bytes() const { return bytes_; }
+
+private:
+  struct Keyframe {
+    double time;
+    Simulation::Setup setup;
+    InputJournal journal; // start state = the keyframe's checkpoint
+  };
+
+  void capture(Simulation& sim);
+  void trim(); // to max_bytes, then publishes earliest_ / bytes_
+  bool ours(const Simulation& sim) const {
+    return !frames_.empty() && sim.get_journal() == &frames_.back().journal;
+  }
+
+  KeyframeParams params_;
+  std::deque<Keyframe> frames_; // oldest first; stable addresses
+  std::atomic<double> earliest_{-1.0};
+  std::atomic<std::size_t> bytes_{0};
+};
+
+#endif
@@ -122,6 +122,21 @@ class LateralSolver {
   std::vector<LateralUpdate> solve(const std::vector<LateralRiderState>& riders,
                                    double dt) const;
 
+  // Same, with the longitudinal order supplied by the caller: front_to_back
+  // holds indices into riders, lon_pos descending (the engine's LonOrder,
+  // lon_order.h).  Nothing is sorted inside.
+  std::vector<LateralUpdate> solve(const std::vector<LateralRiderState>& riders,
+                                   const std::vector<int>& front_to_back,
+                                   double dt) const;
+
+  // Same, writing into `updates` (resized to riders.size()) and working in
+  // caller-owned buffers that keep their capacity between calls: a caller
+  // holding one Scratch per solve allocates nothing in steady state.
+  struct Scratch;
+  void solve(const std::vector<LateralRiderState>& riders,
+             const std::vector<int>& front_to_back, double dt,
+             Scratch& scratch, std::vector<LateralUpdate>& updates) const;
+
 private:
   CollisionParams params_;
   // --- 3.1: single-rider free integration ---
@@ -137,6 +152,12 @@ class LateralSolver {
   };
   std::vector<ContactPair>
   find_proximity_pairs(const std::vector<LateralRiderState>& riders) const;
+  std::vector<ContactPair>
+  find_proximity_pairs(const std::vector<LateralRiderState>& riders,
+                       const std::vector<int>& front_to_back) const;
+  void find_proximity_pairs(const std::vector<LateralRiderState>& riders,
+                            const std::vector<int>& front_to_back,
+                            std::vector<ContactPair>& pairs) const;
 
   // --- 3.3: blockade detection ---
   // Returns true if every lateral gap ahead of riders[rider_idx] within the
@@ -145,6 +166,19 @@ class LateralSolver {
   bool is_blocked(int rider_idx,
                   const std::vector<LateralRiderState>& riders) const;
 
+  // Same, scanning only the riders just ahead in the shared order: rank is
+  // rider_idx's position in front_to_back, and max_bike_len bounds the window
+  // (no rider further ahead than the longest bike can count).  ahead_lat is
+  // caller scratch, reused across the sweep in solve().
+  bool is_blocked(int rider_idx, const std::vector<LateralRiderState>& riders,
+                  const std::vector<int>& front_to_back, int rank,
+                  double max_bike_len, std::vector<double>& ahead_lat) const;
+
+  // Shared tail of both is_blocked variants: lateral positions of the riders
+  // ahead -> is there a passable gap?
+  bool lanes_blocked(const LateralRiderState& own,
+                     std::vector<double>& ahead_lat) const;
+
   // --- 3.4: shove model ---
   // Applied to one contact pair.  Both riders push each other away
   // symmetrically; the stronger/fresher rider displaces the other more.
@@ -156,7 +190,8 @@ class LateralSolver {
   // speed penalty, and only when it is actually squeezing: the penalty ramps
   // with lon_sep (side-by-side jostling is free) and applies only when
   // a_blocked (no passable lane ahead of A; a clean overtake costs nothing).
-  // The caller computes a_blocked via is_blocked().
+  // The caller computes a_blocked via is_blocked() (once per rider in
+  // solve()).
   struct ShoveOutcome {
     double a_lat_rate;     // m/s — signed separation rate for rider A
     double b_lat_rate;     // m/s — signed separation rate for rider B
@@ -174,4 +209,16 @@ class LateralSolver {
                          const LateralRiderState& b) const;
 };
 
+// solve()'s per-call working set (contact pairs, blockade flags, the
+// blockade scan's lane buffer, shove accumulators).  Contents are
+// meaningless between calls.
+struct LateralSolver::Scratch {
+  std::vector<ContactPair> pairs;
+  std::vector<char> blocked;
+  std::vector<char> needs_blocked;
+  std::vector<double> ahead_lat;
+  std::vector<double> delta_acc;
+  std::vector<double> penalty_acc;
+};
+
 #endif
@@ -0,0 +1,107 @@
+// lon_order.h — persistent front-to-back rider order.
+//
+// Drafting, GroupTracker and LateralSolver all walk riders in longitudinal
+// order.  Rather than each re-sorting from scratch every tick, the engine
+// keeps one LonOrder over its rider slots and repairs it in place: riders
+// barely reorder between 10 ms ticks, so an insertion-sort pass over the
+// previous order is ~N comparisons plus one shift per actual overtake.
+//
+// The order is total — lon_pos descending, ties by slot ascending — so the
+// result of repair() depends only on the current positions, never on the
+// history of earlier repairs: a rebuild from scratch lands on the same order
+// as any chain of repairs (determinism, kb/07).
+//
+// Pure and engine-free, header-only (same precedent as team.h).
+
+#ifndef LON_ORDER_H
+#define LON_ORDER_H
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+class LonOrder {
+public:
+  // [begin, end) into front_to_back().
+  struct Run {
+    int begin, end;
+  };
+
+  // Bring the order up to date with pos(slot) for slots [0, n).  A change in
+  // n (riders added, first call) rebuilds from a full sort; otherwise the
+  // previous order is repaired by insertion.
+  template <class PosFn> void repair(int n, PosFn&& pos) {
+    key_.resize(n);
+    for (int i = 0; i < n; ++i)
+      key_[i] = pos(i);
+
+    moves_ = 0;
+    if (static_cast<int>(order_.size()) != n) {
+      order_.resize(n);
+      std::iota(order_.begin(), order_.end(), 0);
+      std::sort(order_.begin(), order_.end(),
+                [this](int a, int b) { return ahead(a, b); });
+    } else {
+      for (int k = 1; k < n; ++k) {
+        const int s = order_[k];
+        int j = k;
+        while (j > 0 && ahead(s, order_[j - 1])) {
+          order_[j] = order_[j - 1];
+          --j;
+        }
+        moves_ += k - j;
+        order_[j] = s;
+      }
+    }
+
+    rank_.resize(n);
+    for (int k = 0; k < n; ++k)
+      rank_[order_[k]] = k;
+  }
+
+  // Slots, front of the race first.
+  const std::vector<int>& front_to_back() const { return order_; }
+
+  // Position of `slot` in front_to_back().
+  int rank_of(int slot) const { return rank_[slot]; }
+
+  int size() const { return static_cast<int>(order_.size()); }
+
+  // Split the order wherever consecutive riders are more than `cut` metres
+  // apart at the positions of the last repair() — GroupTracker's rule, so
+  // with cut = gap_threshold the runs are exactly its groups.  out is
+  // cleared and refilled (capacity reused); empty for an empty order.
+  void split(double cut, std::vector<Run>& out) const {
+    out.clear();
+    const int n = size();
+    int begin = 0;
+    for (int k = 1; k <= n; ++k) {
+      if (k == n || key_[order_[k - 1]] - key_[order_[k]] > cut) {
+        out.push_back(Run{begin, k});
+        begin = k;
+      }
+    }
+  }
+
+  // Element shifts done by the last repair() (0 when nothing overtook).
+  // Diagnostic only.
+  int last_repair_moves() const { return moves_; }
+
+  void clear() {
+    order_.clear();
+    rank_.clear();
+    key_.clear();
+  }
+
+private:
+  bool ahead(int a, int b) const {
+    return key_[a] > key_[b] || (key_[a] == key_[b] && a < b);
+  }
+
+  std::vector<int> order_;
+  std::vector<int> rank_;
+  std::vector<double> key_;
+  int moves_ = 0;
+};
+
+#endif
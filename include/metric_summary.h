@@ -0,0 +1,84 @@
+// metric_summary.h — a bounded-memory, multi-resolution summary of one
+// metric series, for plotting long runs.
+//
+// MetricObserver keeps every sample: hours at physics rate are hundreds of
+// thousands of samples per series, and a plot copies them all each frame.
+// MetricSummary keeps buckets instead — each with the samples' count,
+// first and last x, centroid (mean x, mean y), min and max with where they
+// were seen, and an LTTB-style representative: whichever of the min or max
+// point spans the larger triangle with the previous bucket's
+// representative and this bucket's centroid, so lone spikes survive any
+// amount of decimation.
+//
+// Level 0 covers the whole series in at most `capacity` buckets of
+// bucket_width() samples each.  It starts at one sample per bucket; when
+// it fills, neighbouring buckets merge pairwise and the width doubles, so
+// memory is fixed however long the run.  Levels 1, 2, ... are level 0
+// merged 2, 4, ... at a time, built as pairs complete (a coarse level
+// trails the newest samples by at most one of its buckets); all levels
+// together hold at most 2 x capacity buckets — about 0.7 MB per series at
+// the default 4096, for any run length.
+//
+// view() picks, for an x range and a pixel budget, the finest level with
+// no more buckets in range than the budget, and returns a span into it:
+// plotted straight from the buckets with a stride (ImPlot's offset /
+// stride arguments), no copy per frame.  Samples must come in
+// nondecreasing x; concatenate runs by offsetting x.
+
+#ifndef METRIC_SUMMARY_H
+#define METRIC_SUMMARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MetricBucket {
+  double x;            // centroid: mean x of the samples
+  double mean;         // mean y
+  double min, max;     // y extremes
+  double x_min, x_max; // where they were seen (first, on ties)
+  double rep_x, rep_y; // LTTB-style representative: the min or max point
+  double x0, x1;       // first and last sample x
+  std::uint64_t n;     // samples
+};
+
+class MetricSummary {
+public:
+  // `capacity` level-0 buckets, rounded up to an even number >= 4.
+  explicit MetricSummary(std::size_t capacity = 4096);
+
+  void add(double x, double y);
+
+  // Buckets in [x0, x1] at the finest level with at most max_points of
+  // them, plus one either side for continuity; the coarsest level when
+  // none is that sparse.  Valid until the next add().
+  struct View {
+    const MetricBucket* data = nullptr;
+    int count = 0;
+    int level = 0;
+  };
+  View view(double x0, double x1, int max_points) const;
+
+  std::uint64_t count() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  // Samples per level-0 bucket.
+  std::uint64_t bucket_width() const { return width_; }
+  int levels() const { return static_cast<int>(levels_.size()); }
+  const std::vector<MetricBucket>& level(int k) const { return levels_[k]; }
+  double min_x() const;
+  double max_x() const;
+  std::size_t memory_bytes() const;
+
+private:
+  void closed(int k); // levels_[k].back() just took its last sample
+  void compact();     // level 0 full: level 1 takes its place
+  std::vector<MetricBucket>& level_at(int k);
+
+  std::size_t capacity_;
+  std::uint64_t width_ = 1;
+  std::uint64_t count_ = 0;
+  bool open_ = false; // levels_[0].back() still takes samples
+  std::vector<std::vector<MetricBucket>> levels_;
+};
+
+#endif
@@ -0,0 +1,53 @@
+// phase_schedule.h — per-phase update rates for PhysicsEngine::update().
+//
+// Longitudinal integration, follow, rotation and the lateral phases run
+// every tick.  Group classification and draft links change on second
+// timescales, so they run at their own rate: a phase with rate hz runs on
+// the ticks where (tick - offset) is a multiple of its period,
+// round(1 / (hz * dt)) ticks.  Offsets stagger the slow phases so they
+// don't all land on the same tick; update() keeps its fixed phase order
+// whichever subset is due.
+//
+// Draft factors are interpolated between refreshes (see
+// PhysicsEngine::step_draft_apply) so a slower draft rate never steps CdA.
+//
+// A rate of 0 — or anything at or above the physics rate — runs the phase
+// every tick, which is exactly the single-rate engine.  That is the
+// default: slower rates change results (slightly) and are opted into with
+// PhysicsEngine::set_phase_rates().
+//
+// Pure and engine-free, header-only (same precedent as team.h).
+
+#ifndef PHASE_SCHEDULE_H
+#define PHASE_SCHEDULE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+struct PhaseRates {
+  double group_hz = 0.0; // group classify + role apply; e.g. 10
+  double draft_hz = 0.0; // draft links, interpolated in between; e.g. 20
+
+  // Tick offsets within each period (taken modulo the period).
+  int group_offset = 0;
+  int draft_offset = 1;
+};
+
+// Ticks between runs of a phase at `hz` with physics step dt; >= 1.
+inline int phase_period(double hz, double dt) {
+  if (hz <= 0.0 || dt <= 0.0)
+    return 1;
+  const double ticks = std::round(1.0 / (hz * dt));
+  return ticks < 1.0 ? 1 : static_cast<int>(std::min(ticks, 1e6));
+}
+
+// Is a phase with this period and offset due on `tick`?
+inline bool phase_due(std::int64_t tick, int period, int offset) {
+  if (period <= 1)
+    return true;
+  const std::int64_t k = (tick - offset) % period;
+  return k == 0;
+}
+
+#endif
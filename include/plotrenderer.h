@@ -14,11 +14,16 @@ class PlotRenderer : public CoreRenderer {
   bool handle_event(const SDL_Event* e);
 
   void set_data(PlotResult result);
+  // While the data is partial: the run's progress in [0, 1], shown as a bar,
+  // and the time axis follows the data.  Negative once it is complete.
+  void set_progress(double p);
 
 private:
   void render_plot_imgui();
   std::string plot_title;
   std::vector<PlotSeries> plot_data;
+  double progress = -1.0;
+  bool refit = false; // the complete data's range, once
 };
 
 #endif
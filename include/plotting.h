@@ -3,7 +3,11 @@
 class Course;
 class PlotResult;
 struct RiderConfig;
+template <typename Result> class ResultsChannel;
 
+// With a channel (results_channel.h), the series so far are published as
+// the run goes, and cancelling it stops the run where it is.
 PlotResult run_plot_simulation(const Course& course,
                                const std::vector<RiderConfig>& riders,
-                               int target_id);
+                               int target_id,
+                               ResultsChannel<PlotResult>* channel = nullptr);
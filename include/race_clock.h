@@ -35,6 +35,9 @@
 #include <unordered_map>
 #include <vector>
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class RaceClock {
 public:
   RaceClock(double course_length, std::vector<Checkpoint> checkpoints,
@@ -63,19 +66,42 @@ class RaceClock {
   // until crossed.
   std::optional<double> checkpoint_time(RiderId id, size_t k) const;
 
+  // Checkpoints (checkpoint.h): every trace, in id order.  Course length,
+  // spacing and checkpoints are the constructor's.
+  void save_state(CheckpointWriter& w) const;
+  bool load_state(CheckpointReader& r);
+
 private:
+  // A trace's crossing times live in row `row` of the flat grid_t_ /
+  // cp_t_ tables, so copying a clock (Simulation::fork) is two buffer
+  // copies plus the small per-rider records — no per-rider vectors.
   struct Trace {
     double anchor_pos = 0.0, anchor_t = 0.0; // first sample
     double latest_pos = 0.0, latest_t = 0.0; // most recent sample
-    std::vector<double> grid_t;              // NaN = gridline not crossed
-    std::vector<double> cp_t;                // NaN = checkpoint not crossed
+    size_t row = 0;
     size_t next_cp = 0; // checkpoints are sorted: next one ahead
   };
 
+  size_t grid_n() const { return static_cast<size_t>(course_len_ / spacing_) + 2; }
+  double* grid_row(const Trace& tr) { return &grid_t_[tr.row * grid_n()]; }
+  const double* grid_row(const Trace& tr) const {
+    return &grid_t_[tr.row * grid_n()];
+  }
+  double* cp_row(const Trace& tr) {
+    return cp_t_.data() + tr.row * checkpoints_.size();
+  }
+  const double* cp_row(const Trace& tr) const {
+    return cp_t_.data() + tr.row * checkpoints_.size();
+  }
+  // Appends a fresh (all-unset) row; returns its index.
+  size_t add_row();
+
   double spacing_;
   double course_len_;
   std::vector<Checkpoint> checkpoints_; // sorted by pos
   std::unordered_map<RiderId, Trace> traces_;
+  std::vector<double> grid_t_; // rows of grid_n(); NaN = gridline not crossed
+  std::vector<double> cp_t_; // rows of checkpoints_.size(); NaN = not crossed
 };
 
 #endif
@@ -2,8 +2,11 @@
 #ifndef REALTIME_RUNNER_H
 #define REALTIME_RUNNER_H
 
+#include "keyframes.h"
 #include "simcontrol.h"
 #include <atomic>
+#include <limits>
+#include <memory>
 #include <string>
 #include <thread>
 
@@ -34,8 +37,16 @@ class RealtimeSimRunner : public ISimControl {
   void pause() override;
   void resume() override;
   bool is_paused() const override;
+  void rewind_to(double sim_time) override;
   void toggle_pause();
 
+  // Keyframes for rewind_to() (keyframes.h), off until enabled: the ring
+  // takes the Simulation's input journal.  Call while stopped.  The
+  // physics thread serves a rewind before its next step, paused or not.
+  void enable_keyframes(const KeyframeParams& params);
+  // Earliest sim time rewind_to() reaches; -1 without keyframes.
+  double get_rewind_limit() const;
+
   // Written by the physics thread (message first, then flag), read by the
   // render loop.
   std::atomic<bool> physics_error{false};
@@ -48,6 +59,11 @@ class RealtimeSimRunner : public ISimControl {
   std::thread thread_;
   std::atomic<bool> running{false};
   std::atomic<bool> paused{false};
+
+  std::unique_ptr<KeyframeRing> keyframes_; // physics thread once started
+  // Pending rewind_to() target; NaN when none.
+  std::atomic<double> rewind_target_{
+      std::numeric_limits<double>::quiet_NaN()};
 };
 
 #endif
@@ -0,0 +1,86 @@
+// results_channel.h — hand-off of partial offline results from a worker
+// thread to the screen showing them.
+//
+// The offline screens run a whole race on a worker (std::async) and had
+// nothing to show until it returned.  A ResultsChannel carries what the
+// worker has so far: it publish()es a partial result — series, splits, a
+// leaderboard — every so often with the run's progress, and the screen
+// take()s the latest one, if there is a newer one, each frame.  Only the
+// latest is kept: a partial the screen never took is replaced, not queued.
+// The final result still comes back through the future.  The worker
+// publishes every publish_interval() real seconds: often enough for a
+// screen, rarely enough that building partials costs the run nothing.
+//
+// It is also the run's cancellation token: cancel() from the screen (going
+// back, or being destroyed) and the worker's OfflineSimulationRunner stops
+// at its next step (set_cancel_flag(cancel_flag())).
+//
+// One worker publishing; any thread taking, cancelling, reading progress.
+
+#ifndef RESULTS_CHANNEL_H
+#define RESULTS_CHANNEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+template <typename Result> class ResultsChannel {
+public:
+  explicit ResultsChannel(double publish_interval = 0.25)
+      : publish_interval_(publish_interval) {}
+  ResultsChannel(const ResultsChannel&) = delete;
+  ResultsChannel& operator=(const ResultsChannel&) = delete;
+
+  // --- worker ---
+
+  // Real seconds between publishes (ProgressObserver's interval).
+  double publish_interval() const { return publish_interval_; }
+
+  // Replaces the pending partial.  `progress` in [0, 1]: sim time over
+  // expected time; progress() never goes back.
+  void publish(Result partial, double progress) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ = std::move(partial);
+      ++published_;
+    }
+    // One writer: no compare-and-swap needed.
+    progress = std::min(progress, 1.0);
+    if (progress > progress_.load(std::memory_order_relaxed))
+      progress_.store(progress, std::memory_order_relaxed);
+  }
+
+  // --- screen ---
+
+  // The latest partial published since the last take(): false if none.
+  bool take(Result& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_)
+      return false;
+    out = std::move(*pending_);
+    pending_.reset();
+    return true;
+  }
+
+  double progress() const { return progress_.load(std::memory_order_relaxed); }
+  int published() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return published_;
+  }
+
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+  const std::atomic<bool>* cancel_flag() const { return &cancelled_; }
+
+private:
+  const double publish_interval_;
+  mutable std::mutex mutex_;
+  std::optional<Result> pending_;
+  int published_ = 0;
+  std::atomic<double> progress_{0.0};
+  std::atomic<bool> cancelled_{false};
+};
+
+#endif
@@ -8,13 +8,13 @@
 #include "pch.hpp"
 #include "sim_core.h"
 #include "snapshot.h"
-#include "texturemanager.h"
 #include "visualmodel.h"
-#include <SDL3/SDL.h>
+#include <cstdint>
 #include <iostream>
 #include <optional>
 
-struct SDL_Texture;
+class CheckpointWriter;
+class CheckpointReader;
 
 class Bike {
 public:
@@ -74,29 +74,82 @@ class Rider {
 
   Bike bike;
   const ICourseView* course = nullptr;
+  // Follows the rider along the course (course.h).  mutable: sampling from
+  // a const Rider (the engine's per-rider builds) still advances it, and
+  // only this rider's own slot ever touches it.
+  mutable SegmentCursor course_cursor_;
+
+  // The core's altitude FTP factor at both ends of the segment last
+  // stepped on, for this rider's oxy_p50 (sim_core.h).  Altitude is linear
+  // along a segment, so update() interpolates instead of evaluating the
+  // saturation curve's pow()s every tick.
+  struct AltitudeFactorCache {
+    int segment = -1;
+    double alt0 = 0.0, alt1 = 0.0;
+    double f0 = 1.0, f1 = 1.0;
+  };
+  AltitudeFactorCache alt_cache_;
+  double altitude_factor(const CourseSample& cs);
+  // This tick's env (and cda_factor, heading) from the course at state.pos.
+  void prepare_env();
 
   // C core.  env is value-initialised so pre-first-update queries
   // (cruise_power from the rotation phase) read zeros, not garbage.
   RiderState state;
   EnvState env{};
+  // Bumped whenever state is replaced wholesale (reset(), load_state()):
+  // a batch slot loaded at another epoch is reloaded (load_batch()).
+  std::uint32_t state_epoch_ = 1;
+
+  // `name` interned in the engine's StringInterner (string_table.h); what
+  // snapshot() reports.  kNoString until the engine assigns it.
+  StringId name_id_ = kNoString;
 
 public:
   std::string name;
-  const SDL_Texture* image;
 
   explicit Rider(RiderConfig config_);
   static std::unique_ptr<Rider> create_generic(TeamId team_id);
   static RiderConfig default_config(TeamId team_id);
 
   void set_course(const ICourseView* cv);
+  // Course environment at the rider's current position — one cursor lookup
+  // (course.h).  Requires a course.
+  CourseSample sample_course() const {
+    return course->sample(state.pos, course_cursor_);
+  }
 
   RiderSnapshot snapshot() const;
+  void set_name_id(StringId id) { name_id_ = id; }
 
   void change_bike(Bike bike_);
 
   void reset();
   void update(double dt);
 
+  // Batched stepping (sim_core.h): the engine steps its ACCEL_FORCE riders
+  // through a RiderBatch slot-parallel with its table, the same arithmetic
+  // as update().  The slot stays resident between ticks: load_batch()
+  // prepares this tick's env as update() does, writes it into `slot` and
+  // refreshes only the slot's step inputs — unless `loaded_epoch` says the
+  // slot holds another state (new slot, reset(), load_state()), when it
+  // loads the whole state and records the epoch.  False, with nothing
+  // loaded and `loaded_epoch` cleared, for a rider that must go through
+  // update() (no course, another solver).  store_batch() takes the
+  // stepped state back.  set_batch_env() fills in the env fields every
+  // rider shares.
+  bool load_batch(RiderBatch* b, EnvBatch* e, int slot,
+                  std::uint32_t& loaded_epoch);
+  void store_batch(const RiderBatch* b, int slot);
+  static void set_batch_env(EnvBatch* e);
+
+  // Checkpoints (checkpoint.h): the run state — core state and env, draft
+  // and yaw factors, lateral state, heading, group role.  Config and course
+  // are the scenario's; the course cursor and altitude cache restart (they
+  // only ever speed up the same answers).
+  void save_state(CheckpointWriter& w) const;
+  bool load_state(CheckpointReader& r);
+
   bool finished() { return course && state.pos >= course->get_total_length(); }
 
   RiderId get_id() const { return id; }
@@ -113,6 +166,7 @@ class Rider {
   double get_energy() const;
   double get_energy_fraction() const;
   double get_effort_limit() const { return energy_effort_limit(&state.energy); }
+  double get_effort() const { return state.effort; } // actual, after limits
   double get_target_effort() const { return state.target_effort; }
   double get_ftp() const { return state.ftp; } // current (degradable) FTP
   TeamId get_team_id() const { return config.team_id; }
@@ -141,6 +195,7 @@ class Rider {
   // (drafting callers unchanged — the yaw factor is Rider-internal).
   double get_cda_factor() const { return draft_factor_ * yaw_factor_; }
   void set_cda_factor(double f) { draft_factor_ = f; }
+  double get_draft_factor() const { return draft_factor_; }
   double get_yaw_factor() const { return yaw_factor_; }
 
   Vector2d get_pos2d() const;
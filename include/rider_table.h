@@ -0,0 +1,105 @@
+// rider_table.h — dense rider storage for PhysicsEngine.
+//
+// Riders live contiguously in one vector, addressed by slot (insertion
+// order, stable: riders are only ever added at setup).  A side map gives
+// id -> slot for the callers that start from a RiderId.  The engine's phases
+// walk slots directly and keep their flat per-phase buffers slot-parallel,
+// so write-back is an index, never a hash lookup.
+//
+// Iteration yields (RiderId, Rider*) pairs, so the `for (const auto& [id, r]
+// : get_riders())` / `get_riders().at(id)->...` call sites read exactly as
+// they did against the old unordered_map<RiderId, unique_ptr<Rider>>.  Like
+// that map, a const table hands out mutable riders (the pointer was never
+// const); the table's own shape is what const protects.
+//
+// Pointers and references to riders are invalidated by add() — setup time
+// only, same rule as before the first update.  Header-only, same precedent
+// as team.h.
+
+#ifndef RIDER_TABLE_H
+#define RIDER_TABLE_H
+
+#include "mytypes.h"
+#include "rider.h"
+#include <cstddef>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class RiderTable {
+public:
+  class iterator {
+  public:
+    iterator(const RiderTable* t, int slot) : t_(t), slot_(slot) {}
+    std::pair<RiderId, Rider*> operator*() const {
+      return {t_->ids_[slot_], &t_->riders_[slot_]};
+    }
+    iterator& operator++() {
+      ++slot_;
+      return *this;
+    }
+    bool operator==(const iterator& o) const { return slot_ == o.slot_; }
+    bool operator!=(const iterator& o) const { return slot_ != o.slot_; }
+
+  private:
+    const RiderTable* t_;
+    int slot_;
+  };
+
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, size()); }
+
+  int size() const { return static_cast<int>(riders_.size()); }
+  bool empty() const { return riders_.empty(); }
+  void reserve(std::size_t n) {
+    riders_.reserve(n);
+    ids_.reserve(n);
+  }
+
+  // False (table unchanged) when the id is already present.
+  bool add(Rider&& r) {
+    const RiderId id = r.get_id();
+    if (slot_.count(id) > 0)
+      return false;
+    slot_.emplace(id, size());
+    ids_.push_back(id);
+    riders_.push_back(std::move(r));
+    return true;
+  }
+
+  // -1 for unknown ids.
+  int slot_of(RiderId id) const {
+    auto it = slot_.find(id);
+    return it == slot_.end() ? -1 : it->second;
+  }
+
+  std::size_t count(RiderId id) const { return slot_.count(id); }
+
+  // nullptr for unknown ids.
+  Rider* find(RiderId id) const {
+    const int s = slot_of(id);
+    return s < 0 ? nullptr : &riders_[s];
+  }
+
+  // Throws std::out_of_range for unknown ids, like unordered_map::at.
+  Rider* at(RiderId id) const {
+    Rider* r = find(id);
+    if (!r)
+      throw std::out_of_range("RiderTable::at: unknown rider id");
+    return r;
+  }
+
+  // Slot access — the engine's phase loops.
+  Rider& operator[](int slot) const { return riders_[slot]; }
+  RiderId id_at(int slot) const { return ids_[slot]; }
+
+private:
+  // mutable: see the header comment — constness is the table's, not the
+  // riders'.
+  mutable std::vector<Rider> riders_;
+  std::vector<RiderId> ids_; // slot -> id, parallel to riders_
+  std::unordered_map<RiderId, int> slot_;
+};
+
+#endif
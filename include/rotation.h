@@ -32,6 +32,9 @@
 #include <optional>
 #include <vector>
 
+class CheckpointWriter;
+class CheckpointReader;
+
 struct RotationMember {
   RiderId id = -1;
   bool sits_in = false;
@@ -71,6 +74,10 @@ class PacelineRotation {
   // silently dropped from the roster.
   std::vector<RotationDirective> tick(double dt,
                                       const std::vector<RotationInput>& in);
+  // Same, writing the directives into `out` (cleared first) so a caller
+  // that keeps the vector across ticks allocates nothing.
+  void tick(double dt, const std::vector<RotationInput>& in,
+            std::vector<RotationDirective>& out);
 
   // Members removed by the detach rule this tick — the engine clears their
   // follow targets (they revert to plain riders).
@@ -128,6 +135,11 @@ class PacelineRotation {
   }
   bool is_member(RiderId id) const;
 
+  // Checkpoints (checkpoint.h): params, every queue, detach timers and the
+  // pull timer — the whole state machine.  Loads over any instance.
+  void save_state(CheckpointWriter& w) const;
+  bool load_state(CheckpointReader& r);
+
 private:
   RotationParams params_;
 
@@ -146,6 +158,9 @@ class PacelineRotation {
 
   double pull_timer_ = 0.0;
   std::vector<RiderId> removed_;
+
+  // tick() scratch: (member, rider ahead) pairs checked by the detach rule.
+  std::vector<std::pair<RiderId, RiderId>> detach_pairs_;
 };
 
 #endif
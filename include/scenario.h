@@ -0,0 +1,80 @@
+// scenario.h — race scenarios as data, for the headless tools.
+//
+// The app builds its demo race in code (AppState); a batch tool needs the
+// same thing from a file.  A scenario is plain text, one directive per
+// line, `#` starts a comment:
+//
+//   course endulating            # flat | flat_short | endulating
+//   segment 5000 0.02 0 0 8      # length slope crr heading width (appends;
+//                                #   any segment replaces the named course)
+//   altitude 1000                # start altitude of a segment course, m
+//   wind 1.047 3.5               # heading (rad), speed (m/s)
+//   checkpoint 12000 Time check  # position (m), label (rest of the line);
+//                                #   must be short of the finish
+//   team Team1                   # one word; ids in order of appearance
+//   rider 1 Pedro ftp=320 mass=90 cda=0.5 w_prime=24000 team=Team1
+//   tt_gap 60                    # time trial: riders start 60 s apart
+//   time_limit 7200              # s of sim time before the field is DNF
+//
+// Rider keys (all optional, app defaults otherwise): ftp, mass, cda,
+// w_prime, max_effort, degrade_threshold, degrade_rate, max_drive_force,
+// oxy_p50, bike (road | tt), team, effort (steady target, default 1.0),
+// start (m).  Ids must be unique; a team must be declared before use.
+//
+// ScenarioSpec::build is a BatchRunner::ScenarioFactory: it only reads the
+// spec, so it may run on worker threads concurrently.
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "course.h"
+#include "rider.h"
+
+#include <array>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Simulation;
+
+struct ScenarioSpec {
+  std::string name;
+
+  std::string course = "endulating";
+  std::vector<std::array<double, 5>> segments; // non-empty: replaces course
+  double altitude = 0.0;
+  Wind wind{0.0, 0.0};
+  std::vector<Checkpoint> checkpoints; // course data; the finish is implicit
+
+  std::vector<std::string> teams; // TeamId = index
+  std::vector<RiderConfig> riders;
+  std::map<RiderId, double> efforts;
+  std::map<RiderId, double> starts;
+  double tt_gap = 0.0; // s; 0 = mass start
+  double time_limit = 7200.0;
+
+  // The course, wind and checkpoints applied; a checkpoint at or past the
+  // finish (a spec built in code) is logged and left out.
+  Course make_course() const;
+
+  // Teams, riders, start positions and efforts (or TT schedules) on
+  // `course`; `riders` is the roster to add (the spec's, or a perturbed
+  // copy of it).
+  std::unique_ptr<Simulation>
+  build(const Course& course, const std::vector<RiderConfig>& riders) const;
+};
+
+// Parses a scenario; logs `source:line: problem` and returns false on the
+// first bad line (out is left partially filled).
+bool parse_scenario(std::istream& in, const std::string& source,
+                    ScenarioSpec& out);
+bool load_scenario_file(const std::string& path, ScenarioSpec& out);
+
+// Built-in scenarios by name: "demo" (the app's race: eight riders on the
+// endulating course in a quartering wind) and "tt" (the same riders in a
+// 30 km flat time trial, 60 s apart, on TT bikes).
+bool builtin_scenario(const std::string& name, ScenarioSpec& out);
+
+#endif
@@ -4,6 +4,8 @@
 
 #include "SDL3/SDL_events.h"
 #include "plotrenderer.h"
+#include "results_channel.h"
+#include "simcontrol.h"
 #include "timetrial.h"
 #include "widget.h"
 #include <future>
@@ -13,6 +15,7 @@ class AppState;
 class TTF_Font;
 class PlotRenderer;
 class SimulationRenderer;
+class TraceReplay;
 
 enum class ScreenType { Menu, Simulation, Result, Plot, TimeTrial };
 
@@ -74,8 +77,14 @@ class SimulationScreen : public IScreen {
 
   void select_rider(RiderId id);
 
+  // Shows `replay` instead of the live race and points the time controls
+  // at it; nullptr goes back to live.  Not owned.
+  void set_replay(TraceReplay* replay);
+
 private:
   AppState* state;
+  // What the widgets control: the live runner, or the replay.
+  SimControlSwitch controls;
   std::unique_ptr<SimulationRenderer> sim_renderer;
 
   RiderId selected_rider = -1;
@@ -101,6 +110,9 @@ class PlotScreen : public IScreen {
 
 private:
   AppState* state;
+  // Partial series while the run goes; outlives the future (which waits
+  // for the worker using it).
+  ResultsChannel<PlotResult> channel;
   std::future<PlotResult> future;
   std::optional<PlotResult> result;
   bool running = false;
@@ -113,15 +125,21 @@ class PlotScreen : public IScreen {
 class TimeTrialScreen : public IScreen {
 public:
   TimeTrialScreen(AppState* s);
+  ~TimeTrialScreen();
 
   void update() override;
   void render() override;
   bool handle_event(const SDL_Event* e) override;
 
 private:
+  void render_leaderboard_imgui();
+
   AppState* state;
+  // Splits and leaderboard while the race runs; outlives the future.
+  ResultsChannel<TimeTrialResult> channel;
   std::future<TimeTrialResult> future;
   std::optional<TimeTrialResult> result;
+  TimeTrialResult partial; // the latest published while running
   bool running = false;
 };
 
@@ -3,6 +3,7 @@
 #define SIM_H
 
 #include "collision_params.h"
+#include "command_queue.h"
 #include "course.h"
 #include "decision.h"
 #include "drafting.h"
@@ -14,27 +15,119 @@
 #include "grouping_params.h"
 #include "lateral_behavior.h"
 #include "lateral_solver.h"
+#include "lon_order.h"
+#include "phase_schedule.h"
 #include "rider.h"
+#include "rider_table.h"
 #include "rotation.h"
 #include "rotation_params.h"
+#include "sim_log.h"
+#include "frame_channel.h"
 #include "snapshot.h"
+#include "string_table.h"
 #include "team.h"
+#include "tick_arena.h"
+#include "worker_pool.h"
 #include <functional>
 #include <memory>
 #include <mutex>
 
 #include <atomic>
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 
+class InputJournal;
+
 class PhysicsEngine {
 private:
   const Course* course;
   mutable std::mutex frame_mtx;
-  std::unordered_map<RiderId, std::unique_ptr<Rider>> riders;
+  // Dense, slot-addressed (rider_table.h).  The per-phase flat buffers
+  // below (draft_states_, lat_states_, lat_updates_, group_input_) are
+  // slot-parallel to it: entry i is riders[i].
+  RiderTable riders;
+
+  // Shared front-to-back slot order (lon_order.h), repaired in place rather
+  // than re-sorted: at the top of update() for the group and draft phases,
+  // and after step_longitudinal() for the lateral phase.  Slot indices, so it
+  // indexes the slot-parallel buffers below directly.
+  LonOrder lon_order_;
+  void repair_lon_order();
+
+  // Runs the per-rider phases that touch only their own slot: rider
+  // integration in step_longitudinal() and the draft_states_ / lat_states_
+  // builds.  One thread (the default) is the plain serial loop; any count
+  // gives bit-identical results (worker_pool.h).
+  std::unique_ptr<WorkerPool> pool_ = std::make_unique<WorkerPool>(1);
+  static constexpr int kPoolGrain = 32; // riders per chunk
+
+  // step_longitudinal()'s batch (sim_core.h), slot-parallel to riders.
+  // Each ACCEL_FORCE rider's slot stays resident across ticks: the static
+  // terms and the state the step writes are loaded once (again after the
+  // rider's state is replaced: epochs, Rider::load_batch()), and each tick
+  // a chunk refreshes only its riders' step inputs and env, steps its runs
+  // of batched slots with sim_step_riders_range() and stores them back.
+  // Slots whose rider goes through Rider::update() instead (batched_ 0)
+  // are skipped.  Grown to the roster once; not copied (a copy starts with
+  // every slot stale).
+  struct LonBatch {
+    RiderBatch riders{};
+    EnvBatch env{};
+    std::vector<std::uint32_t> epochs; // per slot; 0 = nothing loaded
+    LonBatch() = default;
+    LonBatch(const LonBatch&) = delete;
+    LonBatch& operator=(const LonBatch&) = delete;
+    ~LonBatch();
+    void fit(int n); // capacity for n slots; count = n
+  };
+  LonBatch lon_batch_;
+  std::vector<char> batched_;
+
+  // Per-group decomposition of the drafting and lateral-contact phases.
+  // Neither interaction reaches further than a bike length plus the draft
+  // range, so runs of lon_order_ split at GroupTracker's gap_threshold (or
+  // that reach, if larger) never interact: each run is solved as its own
+  // pool task on its own scratch.  Drafting matches a whole-field solve
+  // exactly (lateral: see step_lateral_solve).  A breakaway, a chase and a
+  // peloton are three tasks.
+  struct GroupScratch {
+    std::vector<int> order; // 0..n-1: gathered front-to-back already
+    std::vector<DraftRiderState> draft;
+    std::vector<double> factors;
+    DraftScratch draft_work;
+    std::vector<LateralRiderState> lat;
+    std::vector<LateralUpdate> updates;
+    LateralSolver::Scratch lat_work;
+
+    // Runs land on scratch sets by index, so regrouping hands a set a
+    // bigger run than it has seen.  A set that has to grow grows straight
+    // to the whole field: at most once per set per roster size.
+    void fit(int run_size, int field_size);
+  };
+  std::vector<LonOrder::Run> runs_;
+  std::vector<GroupScratch> group_scratch_; // one per run, grown on demand
+  void split_runs(double cut);
 
   void fill_snapshot(FrameSnapshot& out) const;
 
+  // Rider names, policy names and group labels for FrameSnapshot
+  // (string_table.h).
+  StringInterner strings_;
+  // The tracker's group labels, interned at the group rate and by
+  // load_state(): index = ordinal.
+  std::vector<StringId> group_labels_;
+  void intern_group_labels();
+  // Slots in ascending rider id order, kept by add_rider; fill_snapshot
+  // maps it through lon_order_ into FrameSnapshot::by_id.
+  std::vector<int> slots_by_id_;
+
+  // Per-tick scratch arena (tick_arena.h), reset at the top of update().
+  // Serial phases only; mutable because build_context() is const.  With it
+  // and the reused buffers below, a steady-state update() performs no heap
+  // allocation (tests/test_tick_alloc.cpp).
+  mutable TickArena arena_;
+
   CollisionParams params;
   LateralSolver lateral_solver_; // stateless; holds a copy of params
                                  //
@@ -63,10 +156,25 @@ class PhysicsEngine {
   // step_lateral_solve().  lat_updates_ is written by the solver and consumed
   // by step_lateral_apply().
   std::vector<LateralRiderState> lat_states_;
+  double lat_max_bike_len_ = 0.0; // over lat_states_; bounds build_context
   std::vector<LateralUpdate> lat_updates_;
+  LateralContext behavior_ctx_; // reused by every behavior query
 
-  // draft_states_ is rebuilt each tick by step_draft_apply().
+  // draft_states_ is rebuilt at the draft rate by step_draft_links(), which
+  // also restarts the per-slot factor ramp draft_from_ -> draft_to_ that
+  // step_draft_apply() advances every tick (draft_step_ of draft_period_).
   std::vector<DraftRiderState> draft_states_;
+  std::vector<double> draft_from_;
+  std::vector<double> draft_to_;
+  int draft_period_ = 1;
+  int draft_step_ = 0;
+
+  // Multi-rate schedule (phase_schedule.h).  tick_ counts update() calls;
+  // phases_dirty_ forces every slow phase on the next tick (set by
+  // add_rider and set_phase_rates).
+  PhaseRates phase_rates_;
+  std::int64_t tick_ = 0;
+  bool phases_dirty_ = true;
 
   FollowParams follow_params_;
   // Follow targets: presence of an entry means the rider is in Follow mode
@@ -78,7 +186,20 @@ class PhysicsEngine {
   // while it exists — don't mix with manual set_follow_target on the same
   // riders.
   std::unique_ptr<PacelineRotation> rotation_;
-  std::vector<RotationInput> rotation_inputs_; // rebuilt each tick
+
+  // One per active rotation (manual first, then reconciled), rebuilt each
+  // tick.  Rosters are disjoint, so the ticks run as independent pool tasks;
+  // the directives are then applied serially in this order.
+  struct RotationTask {
+    PacelineRotation* rot = nullptr;
+    std::vector<RotationInput> inputs;
+    std::vector<RotationDirective> directives;
+  };
+  std::vector<RotationTask> rotation_tasks_;
+
+  // Follow controllers each write only their own rider and read their
+  // leader's kinematics, so they run as one pool task per chunk of entries.
+  std::vector<std::pair<RiderId, FollowState*>> follow_jobs_;
 
   // Reconciled rotations (C2): formed per group from riders declaring
   // GroupRole::Paceline, by reconcile_rotations() at the decision cadence.
@@ -86,22 +207,28 @@ class PhysicsEngine {
   std::vector<std::unique_ptr<PacelineRotation>> auto_rotations_;
   RotationParams auto_rotation_params_;
 
-  // One rotation's directives -> follow subsystem (the body shared by the
+  // One rotation's member inputs -> its tick's directives (pool task), and
+  // those directives -> follow subsystem (serial; the body shared by the
   // manual and reconciled rotations in step_rotation_apply).
-  void apply_rotation(PacelineRotation& rot, double dt);
+  void tick_rotation(RotationTask& task, double dt);
+  void apply_rotation(const RotationTask& task);
 
   // One rider's flat drafting input (position, extent, apparent-wind
-  // components).  Used by step_draft_apply for every rider and by
+  // components).  Used by step_draft_links for every rider and by
   // step_follow_apply for each follower's leader.
   DraftRiderState build_draft_state(RiderId id, const Rider& r) const;
 
-  void step_draft_apply(); // computes and writes per-rider cda_factor
+  void step_draft_links(int period); // draft factors -> draft_to_ (slow)
+  void step_draft_apply(); // ramps and writes per-rider cda_factor
+  void draft_run(int r);   // one run of runs_ (pool task)
   void step_rotation_apply(double dt); // rotation directives -> follow states
   void step_follow_apply(double dt); // gap controllers write target_effort
                                      // and wake-axis lat_target
+  void follow_one(RiderId id, FollowState& fs, double dt); // one controller
   void step_longitudinal(double dt);
   void step_lateral_behavior();       // builds lat_states_, queries behaviors
   void step_lateral_solve(double dt); // calls lateral_solver_.solve()
+  void lateral_run(int r, double dt); // one run of runs_ (pool task)
   void step_lateral_apply();          // writes lat_updates_ back into riders
 
   void build_group_input();   // populates group_input_ from current rider state
@@ -112,12 +239,15 @@ class PhysicsEngine {
   // Approximate surplus power: rider output minus resistive losses at current
   // speed.  Used to populate LateralRiderState::surplus_power.
   // Intentionally a rough estimate — it is used only to size the shove budget,
-  // not to drive longitudinal physics.
-  double compute_surplus_power(const Rider& r) const;
-
-  // Build a LateralContext for one rider from the current lat_states_ snapshot.
-  // Nearby riders are filtered to those within one bike_length longitudinally.
-  LateralContext build_context(RiderId id) const;
+  // not to drive longitudinal physics.  slope: the course at r's position.
+  double compute_surplus_power(const Rider& r, double slope) const;
+
+  // Build a LateralContext for the rider in `slot` from the current
+  // lat_states_ snapshot.  Nearby riders are filtered to those within one
+  // bike_length longitudinally, found by walking lon_order_ out from the
+  // rider's rank (O(neighbours), not O(N)).
+  LateralContext build_context(int slot) const;
+  void build_context(int slot, LateralContext& ctx) const; // reuses ctx
 public:
   // Build a GroupContext for one rider from the current GroupTracker
   // snapshot — reflects the fully-resolved state of the last completed tick.
@@ -130,9 +260,43 @@ class PhysicsEngine {
   const GroupTracker& get_group_tracker() const { return group_tracker_; }
 
   explicit PhysicsEngine(const Course* c);
+
+  // Deep copy for Simulation::fork (physics-thread-only, between ticks):
+  // riders, follow controllers, rotations, the group snapshot, the schedule
+  // position — everything a tick carries into the next.  Per-tick scratch
+  // starts empty; the course and lateral behaviors (immutable) are shared;
+  // the copy gets its own pool of the same size.
+  PhysicsEngine(const PhysicsEngine& o);
+  PhysicsEngine& operator=(const PhysicsEngine&) = delete;
+
   bool add_rider(const RiderConfig cfg);
   void update(double dt);
 
+  // Per-phase update rates (phase_schedule.h).  Physics-thread-only,
+  // between ticks; takes effect on the next update(), which runs every
+  // slow phase once to resynchronise.
+  void set_phase_rates(const PhaseRates& rates);
+  // Back to a new engine's schedule: tick count 0, no draft ramp in flight,
+  // every slow phase forced on the next tick.  Used by Simulation::reset().
+  void reset_schedule();
+  const PhaseRates& get_phase_rates() const { return phase_rates_; }
+
+  // Checkpoints (checkpoint.h; physics-thread-only, between ticks).  The
+  // setup record is the course length, the roster in slot order and which
+  // riders have a lateral behavior; check_setup fails unless this engine
+  // matches, and changes nothing.  The state is every rider's, the
+  // multi-rate schedule's position and draft ramp, follow controllers,
+  // rotations, the group snapshot and the string table.
+  void save_setup(CheckpointWriter& w) const;
+  bool check_setup(CheckpointReader& r) const;
+  void save_state(CheckpointWriter& w) const;
+  bool load_state(CheckpointReader& r);
+
+  // Threads used by update(), including the calling one; clamped to >= 1.
+  // Physics-thread-only, between ticks.
+  void set_thread_count(int n);
+  int get_thread_count() const { return pool_->thread_count(); }
+
   // Setup-time (before stepping starts) — create teams first, then add
   // riders whose configs carry the returned TeamId.
   TeamId add_team(std::string name) { return teams_.add_team(std::move(name)); }
@@ -142,7 +306,7 @@ class PhysicsEngine {
   double get_course_length() const { return course->get_total_length(); }
 
   // do these returns need to/should be const?
-  const std::unordered_map<RiderId, std::unique_ptr<Rider>>& get_riders() const;
+  const RiderTable& get_riders() const;
   const Rider* get_rider_by_id(RiderId id) const;
 
   // physicsengine mutates rider state
@@ -150,6 +314,10 @@ class PhysicsEngine {
 
   void step_and_snapshot(double dt, FrameSnapshot& out);
 
+  // Physics-thread-only.  Simulation interns policy names here, so one
+  // table serves the whole frame.
+  StringInterner& get_strings() { return strings_; }
+
   // Replaces any previously assigned behavior.  nullptr → clear_rider_behavior.
   void set_rider_behavior(RiderId id,
                           std::shared_ptr<ILateralBehavior> behavior);
@@ -243,26 +411,39 @@ class Simulation {
   std::atomic<double> time_factor{1.0};
   double sim_seconds = 0.0;
 
-  // UI -> sim command funnel.  Public mutators push closures here; step_fixed
-  // drains them on the physics thread, so engine/rider/schedule mutation is
-  // single-threaded.
-  mutable std::mutex commands_mtx;
-  std::vector<std::function<void()>> pending_commands;
+  // UI -> sim command funnel (command_queue.h).  Public mutators push typed
+  // records here; step_fixed drains them on the physics thread, so
+  // engine/rider/schedule mutation is single-threaded.
+  static constexpr std::size_t kCommandCapacity = 1024;
+  MpscRing<SimCommand> commands_{kCommandCapacity};
+  // Physics-thread scratch for one drain (reserved to capacity up front)
+  // and the riders already seen while coalescing efforts.
+  std::vector<SimCommand> drained_;
+  std::vector<RiderId> effort_seen_;
+  std::uint64_t coalesced_ = 0;
   void drain_commands(); // called at the top of step_fixed()
+  void apply_command(SimCommand& cmd);
+  // Records what drain_commands() applies (input_journal.h); not owned,
+  // and not carried into a fork.
+  InputJournal* journal_ = nullptr;
+  void end_journal(const char* why);
 
   double dt = 0.01; // 100 Hz physics
 
   std::unordered_map<int, std::shared_ptr<EffortSchedule>> effort_schedules;
 
-  // Double buffers
-  FrameSnapshot snap_prev; // published previous
-  FrameSnapshot snap_curr; // published current
-  FrameSnapshot snap_back; // build buffer
-                           //
-  // Called at the end of step_fixed(), while frame_mtx is still held
-  void publish_snapshot();
+  // Published frames (frame_channel.h): step_fixed builds into a free slot
+  // and publishes it; readers pin the pair without copying or locking.
+  FrameChannel frames_;
+  // Stands in for a slot when readers pin them all: the step still runs,
+  // its frame is just not published.
+  FrameSnapshot dropped_frame_;
+
+  // Called at the end of step_fixed() with the frame it built.
+  void publish_snapshot(FrameSnapshot& back);
 
-  mutable std::mutex snapshot_swap_mtx;
+  // fork()'s deep copy.
+  Simulation(const Simulation& o);
 
 public:
   Simulation(const Course* c);
@@ -273,10 +454,44 @@ class Simulation {
 
   void step_fixed(double dt);
 
+  // An independent copy of this run for what-if lookahead: step it, change
+  // it, hand it to another thread — the original never notices.  Copies
+  // the engine (riders, follow controllers, rotations, groups), the
+  // decision system (race clock, cloned policies) and the sim clock; shares
+  // only what is immutable: the course (which must outlive the fork),
+  // CourseIntel, effort schedules and lateral behaviors.  Starts with an
+  // empty command queue and nothing published.  Call from the physics
+  // thread or while no driver is stepping.
+  std::unique_ptr<Simulation> fork() const;
+
+  // Checkpoints (checkpoint.h): the full run state as bytes or a file, and
+  // back.  Call only while no driver is stepping.  A checkpoint loads into
+  // a Simulation set up as the saved one was (course, riders, teams,
+  // policies, schedules, behaviors, race plans); stepping on from it
+  // reproduces the saved run bit for bit.  Loading fails — logged, nothing
+  // changed — on a foreign, corrupt or mismatched checkpoint.  Queued
+  // commands are not part of a checkpoint; loading drops them, and clears
+  // the published frames like reset().
+  std::vector<char> save_checkpoint() const;
+  bool load_checkpoint(const std::vector<char>& bytes);
+  bool save_checkpoint_file(const std::string& path) const;
+  bool load_checkpoint_file(const std::string& path);
+
+  // The setup a checkpoint checks but does not carry — policies, race plans
+  // and effort schedules — for rewinding (keyframes.h): restore_setup()
+  // puts a copy back, so a checkpoint saved under it loads.  Policies are
+  // cloned both ways.  Physics thread, or while no driver is stepping.
+  struct Setup {
+    DecisionSystem::Setup decision;
+    std::unordered_map<int, std::shared_ptr<EffortSchedule>> schedules;
+  };
+  Setup copy_setup() const;
+  void restore_setup(const Setup& setup);
+
   void set_time_factor(double f) { time_factor = f; }
   double get_time_factor() const { return time_factor; }
 
-  double get_dt() { return dt; }
+  double get_dt() const { return dt; }
   void set_dt(double dt_) { dt = dt_; }
 
   double get_sim_seconds() const;
@@ -287,8 +502,9 @@ class Simulation {
   // thread or while no driver is stepping.
   const DecisionSystem& get_decision() const { return decision_; }
 
-  // Queued: applied on the physics thread at the start of the next step.
-  // set_rider_effort is a no-op unless the rider's EffortSource is Manual.
+  // Queued: applied on the physics thread at the start of the next step,
+  // in call order.  set_rider_effort is a no-op unless the rider's
+  // EffortSource is Manual; a run of them lands as the last per rider.
   // Policies and schedules are mutually exclusive: assigning either replaces
   // the other (C2).
   void set_effort_schedule(int rider_id,
@@ -309,11 +525,40 @@ class Simulation {
   void promote_sitter(RiderId id);
   void request_paceline_join(RiderId id, bool sits_in);
 
+  // Input journaling (input_journal.h).  start_journal() checkpoints the
+  // state into the journal and records every applied command from the next
+  // step on, until stop_journal(), reset() or load_checkpoint().  Call from
+  // the physics thread or while no driver is stepping; one journal at a
+  // time.  queue_command() queues a journaled record as it was drained, for
+  // replay_journal().
+  void start_journal(InputJournal* journal);
+  void stop_journal() { journal_ = nullptr; }
+  const InputJournal* get_journal() const { return journal_; }
+  void queue_command(SimCommand cmd);
+
+  // Command queue diagnostics.  Depth (commands waiting for the next step)
+  // and drops (pushed into a full queue, lost) are readable from any
+  // thread; coalesced counts set_rider_effort calls superseded by a later
+  // one for the same rider within a step, and is physics-thread state.
+  std::size_t get_command_queue_depth() const { return commands_.size(); }
+  std::size_t get_command_queue_capacity() const {
+    return commands_.capacity();
+  }
+  std::uint64_t get_dropped_commands() const { return commands_.dropped(); }
+  std::uint64_t get_coalesced_commands() const { return coalesced_; }
+
   // Reads physics-thread state — call from the physics thread or while no
   // driver is stepping (tests, debug UI via snapshot preferred).
   EffortSource get_effort_source(RiderId rider_id) const;
 
-  // Called by the renderer each frame; returns false if no new frame
+  // The latest published (prev, curr) pair, pinned until the handle is
+  // dropped — the renderer's per-frame read.  Empty before the first frame.
+  FramePair acquire_frames() const { return frames_.acquire(); }
+  // Frames not published because readers held every slot.
+  std::uint64_t get_dropped_frames() const { return frames_.dropped(); }
+
+  // Copying variant of acquire_frames(); returns false if nothing has been
+  // published yet.
   bool consume_latest_frame_pair(FrameSnapshot& out_prev,
                                  FrameSnapshot& out_curr);
 };
@@ -331,11 +576,11 @@ class FinishLineCondition : public SimulationEndCondition {
   bool should_stop(const Simulation& sim) const override {
     for (const auto& [id, r] : sim.get_engine()->get_riders()) {
       if (!r->finished()) {
-        // SDL_Log("%s: %.1f", r->name.c_str(), r->pos);
+        // sim_log("%s: %.1f", r->name.c_str(), r->pos);
         return false;
       }
     }
-    SDL_Log("all riders finished");
+    sim_log("all riders finished");
     return true;
   }
 };
@@ -0,0 +1,28 @@
+// sim_log.h — the simulation library's logging sink.
+//
+// The engine, decision layer and analysis code log through sim_log()
+// instead of SDL_Log, so sim_lib links without SDL.  A message is
+// formatted printf-style and handed to the installed sink, one call per
+// message, without a trailing newline.  The default sink writes the line
+// to stderr; the app installs one that forwards to SDL_Log (main.cpp), a
+// batch tool might count, filter or silence them.
+//
+// set_log_sink is meant for startup, before the physics thread runs: the
+// swap itself is atomic, but a sink must not be torn down while another
+// thread may still be calling it.
+
+#ifndef SIM_LOG_H
+#define SIM_LOG_H
+
+// `user` is passed back verbatim.
+using LogSink = void (*)(const char* message, void* user);
+
+// nullptr restores the default (stderr) sink.
+void set_log_sink(LogSink sink, void* user = nullptr);
+
+#if defined(__GNUC__)
+__attribute__((format(printf, 1, 2)))
+#endif
+void sim_log(const char* fmt, ...);
+
+#endif
@@ -20,6 +20,33 @@ class ISimControl {
   virtual void pause() = 0;
   virtual void resume() = 0;
   virtual bool is_paused() const = 0;
+  // Back to an earlier sim time, as far as the driver keeps keyframes.
+  virtual void rewind_to(double sim_time) = 0;
+};
+
+// What the screen's widgets hold instead of the runner itself: forwards to
+// the live runner, or to a replay (trace_replay.h) while one is shown, so
+// the same time controls drive either.  Neither is owned.
+class SimControlSwitch : public ISimControl {
+public:
+  explicit SimControlSwitch(ISimControl* live) : live_(live) {}
+
+  // nullptr goes back to live.
+  void set_replay(ISimControl* replay) { replay_ = replay; }
+  ISimControl* target() const { return replay_ ? replay_ : live_; }
+
+  void set_rider_effort(RiderId id, double effort) override {
+    target()->set_rider_effort(id, effort);
+  }
+  void set_time_factor(double f) override { target()->set_time_factor(f); }
+  void pause() override { target()->pause(); }
+  void resume() override { target()->resume(); }
+  bool is_paused() const override { return target()->is_paused(); }
+  void rewind_to(double sim_time) override { target()->rewind_to(sim_time); }
+
+private:
+  ISimControl* live_;
+  ISimControl* replay_ = nullptr;
 };
 
 #endif
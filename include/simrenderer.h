@@ -3,6 +3,7 @@
 
 #include "corerenderer.h"
 #include "display.h"
+#include "frame_channel.h"
 #include "snapshot.h"
 #include "ui_layout.h"
 #include <memory>
@@ -10,6 +11,7 @@
 class Simulation;
 class Camera;
 class RiderPanel;
+class TraceReplay;
 
 class SimulationRenderer : public CoreRenderer {
 public:
@@ -31,6 +33,11 @@ class SimulationRenderer : public CoreRenderer {
 
   void set_ui_root(std::unique_ptr<UIRoot> ui_root);
 
+  // Shows a recorded race instead of the live sim (trace_replay.h); not
+  // owned, nullptr goes back to live.
+  void set_replay(TraceReplay* replay);
+  TraceReplay* get_replay() const { return replay; }
+
   bool handle_event(const SDL_Event* e);
 
 private:
@@ -41,8 +48,15 @@ class SimulationRenderer : public CoreRenderer {
 
   std::unique_ptr<UIRoot> ui_root;
 
-  FrameSnapshot frame_prev; // published previous
-  FrameSnapshot frame_curr; // published current
+  // Pinned published pair (frame_channel.h); read in place, never copied.
+  FramePair frames;
+
+  // Replay mode: the pair is built here by the replay instead.
+  TraceReplay* replay = nullptr; // Not owned
+  FrameSnapshot replay_prev;
+  FrameSnapshot replay_curr;
+  const FrameSnapshot& prev_frame() const;
+  const FrameSnapshot& curr_frame() const;
 };
 
 #endif
@@ -5,9 +5,14 @@
 #include "group.h"
 #include "mytypes.h"
 #include "pch.hpp"
+#include "string_table.h"
 #include "visualmodel.h"
-#include <string>
-#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 enum class PowerTerm : int {
   Aerodynamic = 0,
@@ -30,8 +35,10 @@ struct RiderRenderState {
   // no policy).  Stamped by Simulation at snapshot time (the engine alone
   // can't know about schedules/policies).
   EffortSource effort_source = EffortSource::Manual;
-  std::string policy;
-  std::string name;
+  // Views into the frame's StringTable (string_table.h): valid while the
+  // frame is held, i.e. for the render pass that built this state.
+  std::string_view policy;
+  std::string_view name;
   double max_effort;
   double pos;
   double slope;
@@ -53,14 +60,17 @@ struct RiderRenderState {
   // std::array<double, (int)PowerTerm::COUNT> power_breakdown;
 };
 
+// Plain data (static_assert below): names are StringIds into the frame's
+// table, and pos2d is rebuilt from pos / altitude on demand, so a frame's
+// rider array copies as one block.
 struct RiderSnapshot {
   RiderId id;
   GroupId group_id;
   GroupRole group_role;
   // C2: see RiderRenderState — stamped by Simulation at snapshot time.
   EffortSource effort_source = EffortSource::Manual;
-  std::string policy;
-  std::string name;
+  StringId policy = kNoString;
+  StringId name = kNoString;
   double max_effort;
   double pos;
   double slope;
@@ -74,25 +84,84 @@ struct RiderSnapshot {
 
   // interpolated
   double lat_pos;
-  Vector2d pos2d;
+  double altitude;
 
   int team_id;
 
   BikeType visual_type;
   // std::array<double, (int)PowerTerm::COUNT> power_breakdown;
+
+  Vector2d pos2d() const { return Vector2d{pos, altitude}; }
+};
+
+static_assert(std::is_trivially_copyable_v<RiderSnapshot>,
+              "RiderSnapshot must stay plain data");
+
+// A group as the frame carries it, plain data like RiderSnapshot: the
+// label is a StringId into the frame's table, and the members are a range
+// of FrameSnapshot::group_members, paceline first, then the body.
+struct FrameGroup {
+  GroupId id;
+  int ordinal;
+  StringId label = kNoString;
+  int first = 0;    // into FrameSnapshot::group_members
+  int paceline = 0; // members in the paceline; the body follows them
+  int count = 0;
+  double time_gap_ahead = -1.0; // see Group::time_gap_ahead
+
+  int size() const { return count; }
 };
 
-using SnapshotMap = std::unordered_map<int, RiderSnapshot>;
+static_assert(std::is_trivially_copyable_v<FrameGroup> &&
+                  std::is_trivially_copyable_v<GroupMember>,
+              "FrameGroup and its members must stay plain data");
+
+// FrameSnapshot::real_time's clock: steady, in seconds.  The renderer
+// interpolates against it, so both ends read this one.
+inline double frame_clock_seconds() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 
 struct FrameSnapshot {
   double sim_time =
       -1.0;            // -1 means unpopulated, makes sure we publish at time 0
   double sim_dt = 0.0; // seconds per physics step (constant)
   double time_factor = 1.0; // sim_speed / real_speed
-  double real_time = 0.0;   // seconds (steady clock / SDL time) when captured
-
-  SnapshotMap riders;
-  GroupSnapshot groups;
+  double real_time = 0.0;   // frame_clock_seconds() when captured
+
+  // Front of the race first (pos descending, the engine's LonOrder).
+  std::vector<RiderSnapshot> riders;
+  // Indices into riders in ascending id order, for find().
+  std::vector<int> by_id;
+  // Names behind RiderSnapshot::name / policy.  Shared, immutable, and the
+  // same pointer from frame to frame until a new string is interned.
+  std::shared_ptr<const StringTable> strings;
+  // Front group first (GroupTracker's order: id = ordinal), and every
+  // group's members, group after group.
+  std::vector<FrameGroup> groups;
+  std::vector<GroupMember> group_members;
+
+  // nullptr if the rider is not in this frame.  Binary search over by_id.
+  const RiderSnapshot* find(RiderId id) const {
+    auto it = std::lower_bound(
+        by_id.begin(), by_id.end(), id,
+        [this](int idx, RiderId v) { return riders[idx].id < v; });
+    if (it == by_id.end() || riders[*it].id != id)
+      return nullptr;
+    return &riders[*it];
+  }
+
+  // The group's g.count members: its paceline, then its body.
+  const GroupMember* members(const FrameGroup& g) const {
+    return group_members.data() + g.first;
+  }
+
+  // Empty for kNoString, or before the first frame.
+  std::string_view str(StringId id) const {
+    return strings ? std::string_view(strings->at(id)) : std::string_view();
+  }
 };
 
 #endif
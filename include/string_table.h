@@ -0,0 +1,67 @@
+// string_table.h — interned strings for FrameSnapshot.
+//
+// Snapshot records carry a StringId instead of a std::string, so a frame of
+// riders is plain data.  The strings themselves live in a StringTable that
+// is immutable once shared: the interner copies it into a fresh table only
+// when a new string arrives (a rider added, a policy name first seen), and
+// frames hold the current table by shared_ptr.  In steady state every frame
+// shares the same table and no string is built or copied.
+//
+// Id 0 is the empty string ("no policy").  Not thread-safe: the interner
+// belongs to the physics thread; readers only touch published tables.
+// Header-only (same precedent as team.h).
+
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using StringId = int;
+
+inline constexpr StringId kNoString = 0;
+
+struct StringTable {
+  std::vector<std::string> strings{std::string()};
+
+  // Empty for kNoString and unknown ids.
+  const std::string& at(StringId id) const {
+    if (id <= 0 || id >= static_cast<StringId>(strings.size()))
+      return strings[0];
+    return strings[id];
+  }
+};
+
+class StringInterner {
+public:
+  StringInterner() : table_(std::make_shared<const StringTable>()) {}
+
+  // The id for s, adding it (and replacing the table) if new.  The lookup
+  // itself builds no string.
+  StringId intern(std::string_view s) {
+    if (s.empty())
+      return kNoString;
+    auto it = ids_.find(s);
+    if (it != ids_.end())
+      return it->second;
+
+    auto next = std::make_shared<StringTable>(*table_);
+    const StringId id = static_cast<StringId>(next->strings.size());
+    next->strings.emplace_back(s);
+    table_ = std::move(next);
+    ids_.emplace(std::string(s), id);
+    return id;
+  }
+
+  // The current table; the same pointer until the next new string.
+  const std::shared_ptr<const StringTable>& table() const { return table_; }
+
+private:
+  std::shared_ptr<const StringTable> table_;
+  std::map<std::string, StringId, std::less<>> ids_;
+};
+
+#endif
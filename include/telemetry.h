@@ -0,0 +1,263 @@
+// telemetry.h — columnar binary race traces.
+//
+// TelemetryRecorder is a SimulationObserver that appends every rider's
+// state each tick — position, speed, power, effort, W′ balance, CdA factor,
+// lateral position, group id and role — to a trace file.  It exists for
+// full-race recording: MetricObserver's one std::function and one id
+// lookup per metric per sample does not scale to every field of every
+// rider at physics rate.
+//
+// The physics thread only quantises: each value is stored as a fixed-point
+// int32 (kTelemetryScale) into the current chunk, slot-parallel with the
+// RiderTable, through Rider's plain getters; group ids and roles are
+// re-read from the GroupTracker only when its revision() moves.  A full
+// chunk goes through a lock-free ring (MpscRing, command_queue.h) to a
+// background writer thread, which encodes and writes it and hands the
+// buffer back through a second ring.  If the writer falls max_chunks
+// behind, the chunk is dropped (counted in dropped_chunks()) rather than
+// stall physics, same policy as FrameChannel.
+//
+// File layout, host byte order (not an exchange format):
+//
+//   TelemetryFileHeader
+//   TelemetryRiderInfo x riders        roster in slot order
+//   chunk*                              TelemetryChunkHeader, then
+//                                       ticks x double sim times, then the
+//                                       columns
+//   TelemetryIndexEntry x chunks        at header.index_offset
+//
+// A chunk holds up to chunk_ticks consecutive recorded ticks.  Its columns
+// are stored one after the other in TelemetryColumn order; raw, a column
+// is ticks x riders int32, tick-major (one tick's riders contiguous).
+// Delta-coded (kTelemetryDelta), each rider's series within the column is
+// stored as zigzag varints of the difference to a prediction: the previous
+// value, or for positions the linear extrapolation of the previous two.
+// Chunks restart prediction, so any chunk decodes on its own.  Recorded
+// tick k lives in chunk k / chunk_ticks; the index gives its offset and
+// first sim time.  Dropped chunks leave a jump in sim time, not a hole.
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "analysis.h"
+#include "command_queue.h" // MpscRing
+#include "group.h"
+#include "mytypes.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RiderTable;
+
+enum class TelemetryColumn : int {
+  Pos = 0,   // m
+  Speed,     // m/s
+  Power,     // W
+  Effort,    // actual effort
+  WBal,      // J of W′ left
+  CdaFactor, // draft x yaw
+  LatPos,    // m
+  GroupId,
+  GroupRole,
+  COUNT
+};
+
+inline constexpr int kTelemetryColumns =
+    static_cast<int>(TelemetryColumn::COUNT);
+
+// Value = stored int32 x scale.
+inline constexpr double kTelemetryScale[kTelemetryColumns] = {
+    1e-3, 1e-3, 0.1, 1e-4, 0.1, 1e-4, 1e-3, 1.0, 1.0};
+
+inline constexpr char kTelemetryMagic[8] = {'C', 'S', 'I', 'M',
+                                            'T', 'R', 'C', 'E'};
+inline constexpr std::uint32_t kTelemetryVersion = 1;
+inline constexpr std::uint32_t kTelemetryChunkMagic = 0x4B4E4843; // "CHNK"
+inline constexpr std::uint32_t kTelemetryDelta = 1u << 0;          // flags
+
+struct TelemetryFileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint32_t riders;
+  std::uint32_t columns;
+  std::uint32_t chunk_ticks;
+  std::uint32_t reserved;
+  double dt;            // s per physics step at on_start
+  double course_length; // m
+  std::uint64_t ticks;  // recorded ticks (dropped chunks not counted)
+  std::uint64_t chunks;
+  std::uint64_t index_offset; // 0 until the recorder finished
+};
+
+struct TelemetryRiderInfo {
+  std::int32_t id;
+  std::int32_t team_id;
+  std::int32_t bike_type; // BikeType
+  std::int32_t reserved;
+  double max_effort;
+  double w_prime; // J; WBal / w_prime is the snapshot's wbal_fraction
+  char name[32];  // NUL-terminated, truncated
+};
+
+struct TelemetryChunkHeader {
+  std::uint32_t magic;
+  std::uint32_t ticks;
+  std::uint64_t bytes; // payload after this header: times and columns
+};
+
+struct TelemetryIndexEntry {
+  std::uint64_t offset; // of the chunk header
+  double t_first;       // sim time of the chunk's first tick
+};
+
+struct TelemetryOptions {
+  std::uint32_t chunk_ticks = 256;
+  bool delta = true;
+  // Chunks allocated at most (in the ring or being filled); past that the
+  // recorder drops rather than waits.
+  std::size_t max_chunks = 64;
+};
+
+// One chunk's worth of ticks: the physics thread fills it, the writer
+// thread encodes it.  raw is [column][tick][slot].
+struct TelemetryChunk {
+  std::uint32_t ticks = 0;
+  std::vector<double> times;
+  std::vector<std::int32_t> raw;
+};
+
+// Serialises a chunk's payload (times, then columns) into out.
+void encode_telemetry_chunk(const TelemetryChunk& c, std::uint32_t riders,
+                            bool delta, std::vector<char>& out);
+// Inverse of encode_telemetry_chunk; false on a malformed payload.  c.raw
+// is resized to the ticks actually held.
+bool decode_telemetry_chunk(const char* data, std::size_t bytes,
+                            std::uint32_t ticks, std::uint32_t riders,
+                            bool delta, TelemetryChunk& c);
+
+class TelemetryRecorder : public SimulationObserver {
+public:
+  explicit TelemetryRecorder(std::string path, TelemetryOptions opts = {});
+  ~TelemetryRecorder() override; // finishes an open trace
+  TelemetryRecorder(const TelemetryRecorder&) = delete;
+  TelemetryRecorder& operator=(const TelemetryRecorder&) = delete;
+
+  // Opens the file and starts the writer.  The roster is fixed from here.
+  void on_start(const Simulation& sim) override;
+  // Physics thread: one tick into the current chunk.
+  void on_step(const Simulation& sim) override;
+  // Flushes, joins the writer, writes the index and patches the header.
+  void on_finish(const Simulation& sim) override;
+
+  // False once opening or any write failed (logged once).
+  bool ok() const { return !failed_.load(std::memory_order_relaxed); }
+  std::uint64_t ticks() const { return ticks_; }
+  std::uint64_t dropped_chunks() const { return dropped_; }
+  // File size after on_finish.
+  std::uint64_t bytes_written() const { return offset_; }
+
+private:
+  void finish();
+  void writer_loop();
+  void write_chunk(const TelemetryChunk& c);
+  std::unique_ptr<TelemetryChunk> take_chunk();
+  void refresh_groups(const RiderTable& riders, const GroupTracker& groups);
+  void fail(const char* what);
+
+  std::string path_;
+  TelemetryOptions opts_;
+  std::uint32_t riders_ = 0;
+
+  // physics thread
+  std::unique_ptr<TelemetryChunk> filling_;
+  std::size_t allocated_ = 0;
+  std::uint64_t ticks_ = 0;
+  std::uint64_t dropped_ = 0;
+  std::uint64_t group_revision_ = ~0ull;
+  std::vector<std::int32_t> group_ids_; // slot-parallel
+  std::vector<std::int32_t> group_roles_;
+
+  MpscRing<std::unique_ptr<TelemetryChunk>> full_;
+  MpscRing<std::unique_ptr<TelemetryChunk>> free_;
+
+  // writer thread (and finish(), after the join)
+  std::ofstream out_;
+  std::uint64_t offset_ = 0;
+  std::uint64_t written_ticks_ = 0;
+  std::vector<TelemetryIndexEntry> index_;
+  std::vector<char> scratch_;
+
+  std::thread writer_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> failed_{false};
+  bool open_ = false;
+};
+
+// Reads a finished trace back, memory-mapped: opening reads the header,
+// roster and index and nothing else.  A raw trace's columns are read in
+// place; a delta-coded chunk is decoded on first use.  The two most
+// recently used chunks are kept, so reading across a chunk boundary (a
+// replay's frame pair) does not decode back and forth.
+class TelemetryReader {
+public:
+  TelemetryReader() = default;
+  ~TelemetryReader();
+  TelemetryReader(const TelemetryReader&) = delete;
+  TelemetryReader& operator=(const TelemetryReader&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+
+  const TelemetryFileHeader& header() const { return header_; }
+  const std::vector<TelemetryRiderInfo>& riders() const { return riders_; }
+  std::uint64_t ticks() const { return header_.ticks; }
+  // Sim time of the first and last recorded tick; 0 for an empty trace.
+  double start_time() const;
+  double end_time() const;
+
+  // The last recorded tick at or before sim time t (the first for t before
+  // it).  From the index alone: O(1) unless chunks were dropped, then a
+  // binary search over the index.  Decodes nothing.
+  std::uint64_t tick_at(double t) const;
+
+  // Sim time of recorded tick k, and the value of a column for the rider
+  // in `slot`; k < ticks(), slot < riders().size().  NaN if k's chunk is
+  // corrupt.
+  double time(std::uint64_t k);
+  double value(std::uint64_t k, int slot, TelemetryColumn c);
+  // One column of tick k, riders().size() stored values in slot order
+  // (x kTelemetryScale); nullptr if k's chunk is corrupt.
+  const std::int32_t* row(std::uint64_t k, TelemetryColumn c);
+
+  // Chunks loaded (decoded, for delta traces) since open(): cache misses.
+  std::uint64_t chunk_loads() const { return chunk_loads_; }
+
+private:
+  struct Cached {
+    std::uint64_t chunk = ~0ull;
+    std::uint32_t ticks = 0;
+    const char* times = nullptr;       // ticks doubles, maybe unaligned
+    const std::int32_t* raw = nullptr; // [column][tick][slot]
+    TelemetryChunk decoded;            // delta traces: what raw points into
+  };
+
+  // k's chunk, loading it into the older cache entry on a miss.
+  const Cached* load(std::uint64_t k);
+
+  const char* map_ = nullptr;
+  std::size_t size_ = 0;
+  TelemetryFileHeader header_{};
+  std::vector<TelemetryRiderInfo> riders_;
+  std::vector<TelemetryIndexEntry> index_;
+  Cached cache_[2];
+  int recent_ = 0; // cache_ entry used last
+  std::uint64_t chunk_loads_ = 0;
+};
+
+#endif
@@ -0,0 +1,70 @@
+// tick_arena.h — per-tick scratch arena for PhysicsEngine::update().
+//
+// A monotonic buffer over one engine-owned block: allocation is a pointer
+// bump, deallocation is a no-op, and reset() at the top of update() rewinds
+// the whole block at once.  Anything a tick needed beyond the block came
+// from the heap; the next reset() grows the block to cover it, so once a
+// field has run a few ticks the arena never touches the heap again.
+//
+// For transient buffers of the serial phases (std::pmr containers on
+// resource()).  Not thread-safe: pool tasks keep their working sets in
+// per-run scratch instead (PhysicsEngine::GroupScratch).
+//
+// Header-only (same precedent as team.h).
+
+#ifndef TICK_ARENA_H
+#define TICK_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+class TickArena {
+public:
+  explicit TickArena(std::size_t bytes = 16 * 1024) : block_(bytes) {
+    buffer_.emplace(block_.data(), block_.size(), &overflow_);
+  }
+
+  TickArena(const TickArena&) = delete;
+  TickArena& operator=(const TickArena&) = delete;
+
+  std::pmr::memory_resource* resource() { return &*buffer_; }
+
+  // Everything allocated since the last reset() is invalid afterwards.
+  void reset() {
+    buffer_.reset(); // returns any overflow chunks to the heap
+    if (overflow_.bytes > 0) {
+      block_.assign(2 * (block_.size() + overflow_.bytes), std::byte{});
+      overflow_.bytes = 0;
+    }
+    buffer_.emplace(block_.data(), block_.size(), &overflow_);
+  }
+
+  std::size_t capacity() const { return block_.size(); }
+
+private:
+  // Upstream of the monotonic buffer: the heap, tallied so reset() knows
+  // how far the block fell short.
+  struct Overflow : std::pmr::memory_resource {
+    std::size_t bytes = 0;
+
+    void* do_allocate(std::size_t n, std::size_t align) override {
+      bytes += n;
+      return std::pmr::new_delete_resource()->allocate(n, align);
+    }
+    void do_deallocate(void* p, std::size_t n, std::size_t align) override {
+      std::pmr::new_delete_resource()->deallocate(p, n, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& o) const
+        noexcept override {
+      return this == &o;
+    }
+  };
+
+  std::vector<std::byte> block_;
+  Overflow overflow_;
+  std::optional<std::pmr::monotonic_buffer_resource> buffer_;
+};
+
+#endif
@@ -11,6 +11,7 @@ class Simulation;
 class Course;
 struct RiderConfig;
 struct RiderTimelineEntry;
+template <typename Result> class ResultsChannel;
 using RiderId = int;
 
 // Per-rider result: their timeline entries at each checkpoint + finish
@@ -18,11 +19,16 @@ struct RiderTimeTrialResult {
   RiderId rider_id;
   std::string name;
   std::vector<RiderTimelineEntry> timeline; // ordered: chk1, chk2, ..., finish
+  double distance = 0.0; // where they are (past the finish once done)
 };
 
 struct TimeTrialResult {
-  std::vector<RiderTimeTrialResult> riders; // sorted by finish time, DNFs last
+  // Leaderboard: most checkpoints passed first, then by the time at the
+  // last of them, then by distance.  Once run, that is by finish time with
+  // DNFs last.
+  std::vector<RiderTimeTrialResult> riders;
   std::vector<double> checkpoint_distances; // the distances that were measured
+  double sim_time = 0.0;                    // when this was taken
 };
 
 // Builds start offsets map: rider[i] starts at i * gap_seconds.
@@ -39,8 +45,12 @@ void setup_tt_schedules(Simulation* sim, const std::vector<RiderConfig>& riders,
 // Riders are staggered by `start_gap_seconds` in order of their position in
 // the configs vector. Checkpoints are auto-generated at 25/50/75/100% of the
 // course length (finish line is always the last checkpoint).
-TimeTrialResult run_time_trial(const Course& course,
-                               const std::vector<RiderConfig>& riders,
-                               double start_gap_seconds = 60.0);
+// With a channel (results_channel.h), the splits and leaderboard so far are
+// published as the race runs, and cancelling it stops the race where it is:
+// the result is then the leaderboard at that point.
+TimeTrialResult
+run_time_trial(const Course& course, const std::vector<RiderConfig>& riders,
+               double start_gap_seconds = 60.0,
+               ResultsChannel<TimeTrialResult>* channel = nullptr);
 
 #endif
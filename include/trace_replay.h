@@ -0,0 +1,96 @@
+// trace_replay.h — play a recorded race back from its telemetry trace.
+//
+// TraceReplay serves FrameSnapshots from a finished trace (telemetry.h)
+// through the same consume_latest_frame_pair() contract as Simulation, so
+// SimulationRenderer can show a race without re-running it.  There is no
+// physics: a playhead moves through the trace at any speed (0 pauses),
+// seek() jumps anywhere, and each call builds the pair of recorded ticks
+// around the playhead straight from the mapped columns.  Opening reads the
+// header, roster and index only; seeking is arithmetic on the index, and
+// at most two chunks are decoded at a time.
+//
+// What the trace does not record comes from the course (slope, heading,
+// altitude at each position) or is left at its default: effort source and
+// policy, yaw factor, group time gaps.  Groups are rebuilt from the
+// recorded group ids, front to back, with the tracker's labels.
+//
+// It is an ISimControl, so the screen's time controls drive the playhead
+// while a replay is shown (SimControlSwitch, simcontrol.h): the speed is
+// the time factor, rewind_to() seeks, and efforts are recorded, not set.
+//
+// UI-thread only, like the renderer that reads it.
+
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include "simcontrol.h"
+#include "snapshot.h"
+#include "string_table.h"
+#include "telemetry.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Course;
+
+class TraceReplay : public ISimControl {
+public:
+  // `course` must be the one recorded on (checked by length) and outlive
+  // the replay.  Starts paused at the first tick, speed 1.
+  bool open(const std::string& path, const Course* course);
+
+  double start_time() const { return reader_.start_time(); }
+  double end_time() const { return reader_.end_time(); }
+  const TelemetryReader& reader() const { return reader_; }
+
+  // --- playhead ---
+
+  // Sim time shown now, within [start_time(), end_time()].
+  double get_time() const;
+  void seek(double sim_time);
+  // Sim seconds per real second; negative clamps to 0.
+  void set_speed(double speed);
+  double get_speed() const { return speed_; }
+  void set_paused(bool paused);
+  bool is_paused() const override { return paused_; }
+
+  // --- ISimControl ---
+
+  void set_rider_effort(RiderId, double) override {}
+  void set_time_factor(double f) override { set_speed(f); }
+  void pause() override { set_paused(true); }
+  void resume() override { set_paused(false); }
+  void rewind_to(double sim_time) override { seek(sim_time); }
+
+  // The recorded ticks either side of the playhead, stamped so the
+  // renderer's interpolation lands on it; at the end or while paused both
+  // are the tick at the playhead.  False before open() or on a corrupt
+  // chunk.
+  bool consume_latest_frame_pair(FrameSnapshot& out_prev,
+                                 FrameSnapshot& out_curr);
+
+private:
+  bool build_frame(std::uint64_t k, FrameSnapshot& out);
+
+  TelemetryReader reader_;
+  const Course* course_ = nullptr;
+  StringInterner interner_;
+  std::vector<StringId> names_;        // slot-parallel
+  std::vector<StringId> group_labels_; // by ordinal, interned on first use
+  std::shared_ptr<const StringTable> strings_;
+
+  // get_time() = anchor_time_ + (now - anchor_real_) x speed while playing.
+  double anchor_time_ = 0.0;
+  double anchor_real_ = 0.0;
+  double speed_ = 1.0;
+  bool paused_ = true;
+
+  std::vector<int> by_id_slots_; // slots in ascending id order
+  std::vector<int> order_;       // scratch: slots front to back
+  std::vector<int> rank_;        // scratch: slot -> index in order_
+  std::vector<int> fill_;        // scratch: next member slot per group
+};
+
+#endif
@@ -245,6 +245,17 @@ class PauseButton : public Button {
   void render(const RenderContext* ctx) override;
 };
 
+// Jumps back `seconds` of sim time from the frame shown (rewind_to).
+class RewindButton : public Button {
+private:
+  double shown_time = 0.0; // sim time of the last frame rendered
+
+public:
+  RewindButton(int x, int y, int w, int h, double seconds, ISimControl* sim,
+               TTF_Font* font);
+  void render(const RenderContext* ctx) override;
+};
+
 class ValueField : public Widget, public ILayoutWidget {
 protected:
   int x, y, w, h;
@@ -0,0 +1,82 @@
+// worker_pool.h — engine-owned work-stealing pool for per-rider phases.
+//
+// parallel_for(n, grain, fn) splits [0, n) into chunks of at most `grain`
+// indices and runs fn(lo, hi) over all of them.  Each participant (the
+// calling thread plus thread_count() - 1 workers) starts on its own
+// contiguous block of chunks, popping from the front of its queue; once
+// empty it steals from the back of the others', so an uneven phase (a few
+// riders on an expensive path) still finishes together.
+//
+// Determinism (kb/07): the pool only decides *who* runs a chunk, never what
+// the chunk computes.  Callers must write per-index state only — no shared
+// accumulators — so results are bit-identical for every thread count.
+// thread_count 1 spawns nothing and calls fn(0, n) inline: exactly the
+// serial loop.
+//
+// Not reentrant: fn must not call parallel_for on the same pool.
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+  using RangeFn = std::function<void(int lo, int hi)>;
+
+  // threads: total participants including the caller; clamped to >= 1.
+  explicit WorkerPool(int threads = 1);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  int thread_count() const { return static_cast<int>(queues_.size()); }
+
+  void parallel_for(int n, int grain, const RangeFn& fn);
+
+  // Chunks the last parallel_for ran on a queue other than the one it was
+  // dealt to.  Diagnostic only (tests, profiling).
+  int last_steals() const { return steals_.load(); }
+
+private:
+  struct Chunk {
+    int lo, hi;
+  };
+  // The live chunks are chunks[head, chunks.size()): the owner pops at
+  // head, thieves pop the back.  A plain vector refilled per job, so its
+  // capacity carries over and dealing a job allocates nothing.
+  struct Queue {
+    std::mutex m;
+    std::vector<Chunk> chunks;
+    size_t head = 0;
+  };
+
+  void worker_loop(int self);
+  // Pop from own queue, else steal.  False when every queue is empty.
+  bool run_one(int self);
+
+  std::vector<std::unique_ptr<Queue>> queues_; // [0] is the caller's
+  std::vector<std::thread> threads_;
+
+  // Job state: fn_ is written before the chunks are queued and read only
+  // after one is popped (the queue mutex orders the two).
+  const RangeFn* fn_ = nullptr;
+  std::atomic<int> remaining_{0};
+  std::atomic<int> steals_{0};
+
+  std::mutex wake_m_;
+  std::condition_variable wake_cv_; // workers: new job or shutdown
+  std::condition_variable done_cv_; // caller: remaining_ hit 0
+  std::uint64_t generation_ = 0;
+  bool stop_ = false;
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "analysis.h"
 #include "sim.h"
 
+#include <algorithm>
+
 OfflineSimulationRunner::OfflineSimulationRunner(std::unique_ptr<Simulation> s)
     : sim(std::move(s)) {}
 
@@ -17,7 +19,12 @@ void OfflineSimulationRunner::run() {
   for (auto* o : observers)
     o->on_start(*sim);
 
+  was_cancelled = false;
   while (true) {
+    if (cancel && cancel->load(std::memory_order_relaxed)) {
+      was_cancelled = true;
+      break;
+    }
     sim->step_fixed(sim->get_dt());
 
     for (auto* o : observers)
@@ -35,6 +42,78 @@ void MetricObserver::on_step(const Simulation& sim) {
   samples.push_back({sim.get_sim_seconds(), metric(sim)});
 }
 
+void MetricSummaryObserver::on_step(const Simulation& sim) {
+  summary_.add(sim.get_sim_seconds(), metric(sim));
+}
+
+ProgressObserver::ProgressObserver(ProgressFn fn,
+                                   std::map<RiderId, double> offsets,
+                                   double interval_s)
+    : fn(std::move(fn)), start_offsets(std::move(offsets)),
+      interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(interval_s))) {}
+
+void ProgressObserver::on_start(const Simulation& sim) {
+  start_pos.clear();
+  for (const auto& [id, rider] : sim.get_engine()->get_riders())
+    start_pos[id] = rider->get_pos();
+  next = std::chrono::steady_clock::now() + interval;
+}
+
+void ProgressObserver::on_step(const Simulation& sim) {
+  const auto now = std::chrono::steady_clock::now();
+  if (now < next)
+    return;
+  next = now + interval;
+  const double expected = expected_time(sim);
+  const double t = sim.get_sim_seconds();
+  fn(sim, expected > 0.0 ? std::min(t / expected, 1.0) : 0.0);
+}
+
+double ProgressObserver::expected_time(const Simulation& sim) const {
+  constexpr double FALLBACK_SPEED = 10.0; // m/s, before anyone has moved
+  const double t = sim.get_sim_seconds();
+  const double length = sim.get_engine()->get_course_length();
+
+  auto offset = [this](RiderId id) {
+    auto it = start_offsets.find(id);
+    return it != start_offsets.end() ? it->second : 0.0;
+  };
+  auto from = [this](RiderId id) {
+    auto it = start_pos.find(id);
+    return it != start_pos.end() ? it->second : 0.0;
+  };
+
+  // Average speeds of the riders under way.
+  double speed_sum = 0.0;
+  int moving = 0;
+  for (const auto& [id, rider] : sim.get_engine()->get_riders()) {
+    const double riding = t - offset(id);
+    const double covered = rider->get_pos() - from(id);
+    if (riding > 0.0 && covered > 0.0) {
+      speed_sum += covered / riding;
+      ++moving;
+    }
+  }
+  const double field_speed = moving ? speed_sum / moving : FALLBACK_SPEED;
+
+  double expected = t;
+  for (const auto& [id, rider] : sim.get_engine()->get_riders()) {
+    if (rider->finished())
+      continue;
+    const double start = offset(id);
+    const double covered = rider->get_pos() - from(id);
+    const double remaining = length - rider->get_pos();
+    double finish;
+    if (t > start && covered > 0.0)
+      finish = t + remaining * (t - start) / covered;
+    else
+      finish = std::max(t, start) + remaining / field_speed;
+    expected = std::max(expected, finish);
+  }
+  return expected;
+}
+
 TimelineObserver::TimelineObserver(std::vector<double> checkpoints,
                                    std::map<RiderId, double> offsets)
     : checkpoints(std::move(checkpoints)), start_offsets(std::move(offsets)) {
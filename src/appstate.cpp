@@ -48,6 +48,7 @@ AppState::AppState() {
   runner = std::make_unique<RealtimeSimRunner>(sim.get());
 
   runner->set_time_factor(0.2);
+  runner->enable_keyframes(KeyframeParams{}); // the panel's rewind button
 
   TeamId team = sim->get_engine()->add_team("Team1");
   RiderConfig cfg = {0,   "Pedro", 320, 6,   2,     0.05,
@@ -162,3 +163,32 @@ void AppState::start_realtime_tt(double gap_seconds) {
 
   runner->start();
 }
+
+bool AppState::open_replay(const std::string& path) {
+  auto next = std::make_unique<TraceReplay>();
+  if (!next->open(path, course.get()))
+    return false;
+  if (!replay)
+    live_was_paused = runner->is_paused();
+  runner->pause();
+  next->resume();
+
+  // The screen lets go of the old replay before it is destroyed.
+  std::unique_ptr<TraceReplay> old = std::move(replay);
+  replay = std::move(next);
+  if (auto* s = dynamic_cast<SimulationScreen*>(screens->top()))
+    s->set_replay(replay.get());
+  else
+    screens->replace(ScreenType::Simulation);
+  return true;
+}
+
+void AppState::close_replay() {
+  if (!replay)
+    return;
+  if (auto* s = dynamic_cast<SimulationScreen*>(screens->top()))
+    s->set_replay(nullptr);
+  replay.reset();
+  if (!live_was_paused)
+    runner->resume();
+}
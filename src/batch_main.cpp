@@ -0,0 +1,473 @@
+// cyclingsim-batch — headless scenario runner.
+//
+// Loads a scenario (scenario.h: a built-in name or a file), runs it through
+// BatchRunner — one OfflineSimulationRunner per repetition, as fast as the
+// cores allow — and writes per-run finish times, gaps, W′ minima and
+// RaceClock checkpoint splits, then per-rider summaries over all runs, as
+// text, CSV or JSON.  Runs are written as they complete, in run order.
+
+#include "batch_runner.h"
+#include "scenario.h"
+#include "sim.h"
+#include "timetrial.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* kUsage =
+    "usage: cyclingsim-batch [options] [SCENARIO]\n"
+    "\n"
+    "SCENARIO is a built-in name (demo, tt) or a scenario file (scenario.h);\n"
+    "default demo.\n"
+    "\n"
+    "  -n, --runs N        repetitions (default 1)\n"
+    "  -j, --threads N     worker threads; 0 = every core (default 0)\n"
+    "      --dt S          fixed physics step, s (default 0.1)\n"
+    "      --seed N        seed of run 0, run i draws seed + i (default 1)\n"
+    "      --spread SD     relative sd of per-rider FTP, CdA and W' draws\n"
+    "                      (default 0: every run is the same race)\n"
+    "      --time-limit S  override the scenario's time limit, s\n"
+    "  -f, --format F      text | csv | json (default text)\n"
+    "  -o, --out FILE      write to FILE instead of stdout\n"
+    "      --summary-only  skip the per-run results\n"
+    "  -q, --quiet         drop simulation log lines\n"
+    "  -h, --help          this text\n";
+
+struct Options {
+  std::string scenario = "demo";
+  int runs = 1;
+  int threads = 0;
+  double dt = 0.1;
+  unsigned long long seed = 1;
+  double spread = 0.0;
+  double time_limit = 0.0; // 0 = the scenario's
+  std::string format = "text";
+  std::string out;
+  bool summary_only = false;
+  bool quiet = false;
+};
+
+bool parse_args(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    auto value = [&](const char*& v) {
+      if (i + 1 >= argc) {
+        std::fprintf(stderr, "%s needs a value\n", a.c_str());
+        return false;
+      }
+      v = argv[++i];
+      return true;
+    };
+    auto number = [&](double& out) {
+      const char* v;
+      if (!value(v))
+        return false;
+      char* end;
+      out = std::strtod(v, &end);
+      if (*end != '\0' || !std::isfinite(out)) {
+        std::fprintf(stderr, "%s: not a number: %s\n", a.c_str(), v);
+        return false;
+      }
+      return true;
+    };
+
+    const char* v;
+    double d;
+    if (a == "-h" || a == "--help") {
+      std::fputs(kUsage, stdout);
+      std::exit(0);
+    } else if (a == "-n" || a == "--runs") {
+      if (!number(d) || d < 1)
+        return false;
+      o.runs = static_cast<int>(d);
+    } else if (a == "-j" || a == "--threads") {
+      if (!number(d) || d < 0)
+        return false;
+      o.threads = static_cast<int>(d);
+    } else if (a == "--dt") {
+      if (!number(o.dt) || o.dt <= 0.0)
+        return false;
+    } else if (a == "--seed") {
+      if (!number(d) || d < 0)
+        return false;
+      o.seed = static_cast<unsigned long long>(d);
+    } else if (a == "--spread") {
+      if (!number(o.spread) || o.spread < 0.0)
+        return false;
+    } else if (a == "--time-limit") {
+      if (!number(o.time_limit) || o.time_limit <= 0.0)
+        return false;
+    } else if (a == "-f" || a == "--format") {
+      if (!value(v))
+        return false;
+      o.format = v;
+      if (o.format != "text" && o.format != "csv" && o.format != "json") {
+        std::fprintf(stderr, "unknown format %s\n", v);
+        return false;
+      }
+    } else if (a == "-o" || a == "--out") {
+      if (!value(v))
+        return false;
+      o.out = v;
+    } else if (a == "--summary-only") {
+      o.summary_only = true;
+    } else if (a == "-q" || a == "--quiet") {
+      o.quiet = true;
+    } else if (!a.empty() && a[0] == '-') {
+      std::fprintf(stderr, "unknown option %s\n", a.c_str());
+      return false;
+    } else {
+      o.scenario = a;
+    }
+  }
+  return true;
+}
+
+// What every writer needs besides the results themselves.
+struct ReportContext {
+  const ScenarioSpec& spec;
+  const Options& opts;
+  double course_length;
+  std::vector<Checkpoint> checkpoints; // the RaceClock's: the finish last
+  std::map<RiderId, std::string> names;
+
+  const std::string& name(RiderId id) const {
+    static const std::string unknown = "?";
+    auto it = names.find(id);
+    return it == names.end() ? unknown : it->second;
+  }
+};
+
+class ReportWriter {
+public:
+  explicit ReportWriter(std::ostream& os) : os_(os) {}
+  virtual ~ReportWriter() = default;
+  virtual void begin(const ReportContext& ctx) = 0;
+  virtual void run(const ReportContext& ctx, const RunSummary& s) = 0;
+  virtual void end(const ReportContext& ctx, const BatchStats& stats) = 0;
+
+protected:
+  std::ostream& os_;
+};
+
+// h:mm:ss.ss, or DNF.
+std::string clock_time(double t) {
+  if (t < 0.0)
+    return "DNF";
+  const int h = static_cast<int>(t / 3600.0);
+  const int m = static_cast<int>((t - h * 3600.0) / 60.0);
+  const double s = t - h * 3600.0 - m * 60.0;
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%d:%02d:%05.2f", h, m, s);
+  return buf;
+}
+
+// Pos, Id, Name, Finish, Gap, W′ min; splits follow.
+const char* kRunRow = "  %3s %4s %-16.16s %11s %9s %8s";
+
+class TextWriter : public ReportWriter {
+public:
+  using ReportWriter::ReportWriter;
+
+  void begin(const ReportContext& ctx) override {
+    char buf[160];
+    std::snprintf(buf, sizeof(buf),
+                  "Scenario %s: %zu riders, %.1f km, %d run(s), dt %g s\n",
+                  ctx.spec.name.c_str(), ctx.spec.riders.size(),
+                  ctx.course_length / 1000.0, ctx.opts.runs, ctx.opts.dt);
+    os_ << buf;
+  }
+
+  void run(const ReportContext& ctx, const RunSummary& s) override {
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "\nRun %zu (seed %llu), %.1f s simulated\n",
+                  s.index, static_cast<unsigned long long>(s.seed),
+                  s.sim_seconds);
+    os_ << buf;
+    std::snprintf(buf, sizeof(buf), kRunRow, "Pos", "Id", "Name", "Finish",
+                  "Gap", "W'min kJ");
+    os_ << buf;
+    for (size_t k = 0; k + 1 < ctx.checkpoints.size(); ++k) {
+      std::snprintf(buf, sizeof(buf), " %12.12s",
+                    ctx.checkpoints[k].label.c_str());
+      os_ << buf;
+    }
+    os_ << "\n";
+
+    for (size_t pos = 0; pos < s.riders.size(); ++pos) {
+      const RiderRunResult& r = s.riders[pos];
+      const std::string place =
+          r.finish_time >= 0.0 ? std::to_string(pos + 1) : "-";
+      const std::string gap =
+          r.gap >= 0.0 ? "+" + clock_time(r.gap).substr(2) : "";
+      char w_min[16];
+      std::snprintf(w_min, sizeof(w_min), "%.1f", r.w_prime_min / 1000.0);
+      std::snprintf(buf, sizeof(buf), kRunRow, place.c_str(),
+                    std::to_string(r.id).c_str(), ctx.name(r.id).c_str(),
+                    clock_time(r.finish_time).c_str(), gap.c_str(), w_min);
+      os_ << buf;
+      for (size_t k = 0; k + 1 < r.splits.size(); ++k) {
+        std::snprintf(buf, sizeof(buf), " %12s",
+                      clock_time(r.splits[k]).c_str());
+        os_ << buf;
+      }
+      os_ << "\n";
+    }
+  }
+
+  void end(const ReportContext& ctx, const BatchStats& stats) override {
+    char buf[200];
+    std::snprintf(buf, sizeof(buf),
+                  "\nSummary: %zu run(s) in %.2f s wall; winning time %s "
+                  "(sd %.2f s)\n"
+                  "   Id Name              Fin  Wins   Pos  Finish mean"
+                  "    sd s         Best    Gap mean  W'min kJ\n",
+                  stats.runs, stats.wall_seconds,
+                  clock_time(stats.winning_time.n ? stats.winning_time.mean
+                                                  : -1.0)
+                      .c_str(),
+                  stats.winning_time.sd());
+    os_ << buf;
+    for (const RiderBatchStats& r : stats.riders) {
+      const bool fin = r.finishes > 0;
+      std::snprintf(
+          buf, sizeof(buf),
+          "  %3d %-16.16s %4d %5d %5.1f %12s %7.2f %12s %11s %9.1f\n", r.id,
+          ctx.name(r.id).c_str(), r.finishes, r.wins,
+          fin ? r.position.mean : 0.0,
+          clock_time(fin ? r.finish_time.mean : -1.0).c_str(),
+          r.finish_time.sd(),
+          clock_time(fin ? r.finish_time.min : -1.0).c_str(),
+          fin ? ("+" + clock_time(r.gap.mean).substr(2)).c_str() : "",
+          r.w_prime_min.mean / 1000.0);
+      os_ << buf;
+    }
+  }
+};
+
+std::string csv_field(const std::string& s) {
+  if (s.find_first_of(",\"\n") == std::string::npos)
+    return s;
+  std::string q = "\"";
+  for (char c : s)
+    q += c == '"' ? std::string("\"\"") : std::string(1, c);
+  return q + "\"";
+}
+
+// Two tables, a blank line apart: one row per rider per run, then one row
+// per rider over the batch.  Times in s; -1 = DNF / not reached.
+class CsvWriter : public ReportWriter {
+public:
+  using ReportWriter::ReportWriter;
+
+  void begin(const ReportContext& ctx) override {
+    if (ctx.opts.summary_only)
+      return;
+    os_ << "run,seed,position,rider,name,finish,gap,w_prime_min";
+    for (size_t k = 0; k + 1 < ctx.checkpoints.size(); ++k)
+      os_ << "," << csv_field("split " + ctx.checkpoints[k].label);
+    os_ << "\n";
+  }
+
+  void run(const ReportContext& ctx, const RunSummary& s) override {
+    for (size_t pos = 0; pos < s.riders.size(); ++pos) {
+      const RiderRunResult& r = s.riders[pos];
+      os_ << s.index << "," << s.seed << ","
+          << (r.finish_time >= 0.0 ? static_cast<int>(pos + 1) : -1) << ","
+          << r.id << "," << csv_field(ctx.name(r.id)) << "," << r.finish_time
+          << "," << r.gap << "," << r.w_prime_min;
+      for (size_t k = 0; k + 1 < r.splits.size(); ++k)
+        os_ << "," << r.splits[k];
+      os_ << "\n";
+    }
+  }
+
+  void end(const ReportContext& ctx, const BatchStats& stats) override {
+    if (!ctx.opts.summary_only)
+      os_ << "\n";
+    os_ << "rider,name,runs,finishes,wins,position_mean,finish_mean,"
+           "finish_sd,finish_min,finish_max,gap_mean,w_prime_min_mean\n";
+    for (const RiderBatchStats& r : stats.riders) {
+      const bool fin = r.finishes > 0;
+      os_ << r.id << "," << csv_field(ctx.name(r.id)) << "," << stats.runs
+          << "," << r.finishes << "," << r.wins << ","
+          << (fin ? r.position.mean : -1.0) << ","
+          << (fin ? r.finish_time.mean : -1.0) << "," << r.finish_time.sd()
+          << "," << (fin ? r.finish_time.min : -1.0) << ","
+          << (fin ? r.finish_time.max : -1.0) << ","
+          << (fin ? r.gap.mean : -1.0) << "," << r.w_prime_min.mean << "\n";
+    }
+  }
+};
+
+std::string json_string(const std::string& s) {
+  std::string q = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      q += '\\';
+      q += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+      q += buf;
+    } else {
+      q += c;
+    }
+  }
+  return q + "\"";
+}
+
+// Seconds, or null for DNF / not reached.
+std::string json_time(double t) {
+  if (t < 0.0)
+    return "null";
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.3f", t);
+  return buf;
+}
+
+std::string json_stat(const RunningStat& s) {
+  if (s.n == 0)
+    return "null";
+  char buf[160];
+  std::snprintf(buf, sizeof(buf),
+                "{\"mean\": %.3f, \"sd\": %.3f, \"min\": %.3f, \"max\": %.3f}",
+                s.mean, s.sd(), s.min, s.max);
+  return buf;
+}
+
+// One object: the scenario, "runs" (streamed) and "summary".
+class JsonWriter : public ReportWriter {
+public:
+  using ReportWriter::ReportWriter;
+
+  void begin(const ReportContext& ctx) override {
+    os_ << "{\n  \"scenario\": " << json_string(ctx.spec.name)
+        << ",\n  \"course_length\": " << ctx.course_length
+        << ",\n  \"checkpoints\": [";
+    for (size_t k = 0; k < ctx.checkpoints.size(); ++k)
+      os_ << (k ? ", " : "") << "{\"pos\": " << ctx.checkpoints[k].pos
+          << ", \"label\": " << json_string(ctx.checkpoints[k].label) << "}";
+    os_ << "],\n  \"runs\": [";
+  }
+
+  void run(const ReportContext& ctx, const RunSummary& s) override {
+    os_ << (s.index ? "," : "") << "\n    {\"index\": " << s.index
+        << ", \"seed\": " << s.seed << ", \"sim_seconds\": " << s.sim_seconds
+        << ", \"riders\": [";
+    for (size_t pos = 0; pos < s.riders.size(); ++pos) {
+      const RiderRunResult& r = s.riders[pos];
+      os_ << (pos ? "," : "") << "\n      {\"rider\": " << r.id
+          << ", \"name\": " << json_string(ctx.name(r.id))
+          << ", \"finish\": " << json_time(r.finish_time)
+          << ", \"gap\": " << json_time(r.gap)
+          << ", \"w_prime_min\": " << r.w_prime_min << ", \"splits\": [";
+      for (size_t k = 0; k < r.splits.size(); ++k)
+        os_ << (k ? ", " : "") << json_time(r.splits[k]);
+      os_ << "]}";
+    }
+    os_ << "]}";
+  }
+
+  void end(const ReportContext& ctx, const BatchStats& stats) override {
+    os_ << "],\n  \"summary\": {\"runs\": " << stats.runs
+        << ", \"wall_seconds\": " << stats.wall_seconds
+        << ", \"winning_time\": " << json_stat(stats.winning_time)
+        << ", \"riders\": [";
+    for (size_t i = 0; i < stats.riders.size(); ++i) {
+      const RiderBatchStats& r = stats.riders[i];
+      os_ << (i ? "," : "") << "\n    {\"rider\": " << r.id
+          << ", \"name\": " << json_string(ctx.name(r.id))
+          << ", \"finishes\": " << r.finishes << ", \"wins\": " << r.wins
+          << ", \"position\": " << json_stat(r.position)
+          << ", \"finish\": " << json_stat(r.finish_time)
+          << ", \"gap\": " << json_stat(r.gap)
+          << ", \"w_prime_min\": " << json_stat(r.w_prime_min) << "}";
+    }
+    os_ << "]}\n}\n";
+  }
+};
+
+void quiet_sink(const char*, void*) {}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!parse_args(argc, argv, opts)) {
+    std::fputs(kUsage, stderr);
+    return 2;
+  }
+  if (opts.quiet)
+    set_log_sink(quiet_sink);
+
+  ScenarioSpec spec;
+  if (!builtin_scenario(opts.scenario, spec) &&
+      !load_scenario_file(opts.scenario, spec)) {
+    std::fprintf(stderr, "cannot load scenario %s\n", opts.scenario.c_str());
+    return 1;
+  }
+  if (opts.time_limit > 0.0)
+    spec.time_limit = opts.time_limit;
+
+  std::ofstream file;
+  if (!opts.out.empty()) {
+    file.open(opts.out);
+    if (!file) {
+      std::fprintf(stderr, "cannot write %s\n", opts.out.c_str());
+      return 1;
+    }
+  }
+  std::ostream& os = opts.out.empty() ? std::cout : file;
+
+  const Course course = spec.make_course();
+  BatchParams params;
+  params.threads = opts.threads;
+  params.dt = opts.dt;
+  params.time_limit = spec.time_limit;
+  if (spec.tt_gap > 0.0)
+    params.start_offsets = build_start_offsets(spec.riders, spec.tt_gap);
+  BatchRunner runner(
+      course, spec.riders,
+      [&spec](const Course& c, const std::vector<RiderConfig>& riders) {
+        return spec.build(c, riders);
+      },
+      params);
+
+  std::vector<RunPerturbation> runs(opts.runs);
+  for (int i = 0; i < opts.runs; ++i) {
+    runs[i].seed = opts.seed + i;
+    runs[i].ftp_sd = runs[i].cda_sd = runs[i].w_prime_sd = opts.spread;
+  }
+
+  ReportContext ctx{spec, opts, course.get_total_length(),
+                    course.get_checkpoints(), {}};
+  for (const RiderConfig& cfg : spec.riders)
+    ctx.names[cfg.rider_id] = cfg.name;
+
+  std::unique_ptr<ReportWriter> writer;
+  if (opts.format == "csv")
+    writer = std::make_unique<CsvWriter>(os);
+  else if (opts.format == "json")
+    writer = std::make_unique<JsonWriter>(os);
+  else
+    writer = std::make_unique<TextWriter>(os);
+
+  writer->begin(ctx);
+  const BatchStats stats = runner.run(runs, [&](const RunSummary& s) {
+    if (!opts.summary_only)
+      writer->run(ctx, s);
+  });
+  writer->end(ctx, stats);
+  os.flush();
+  return os ? 0 : 1;
+}
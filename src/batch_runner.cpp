@@ -0,0 +1,264 @@
+#include "batch_runner.h"
+#include "analysis.h"
+#include "sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace {
+
+// Lowest W′ balance per rider, in roster (slot) order.
+class WPrimeMinObserver : public SimulationObserver {
+public:
+  void on_start(const Simulation& sim) override {
+    const auto& riders = sim.get_engine()->get_riders();
+    mins_.clear();
+    for (const auto& [id, r] : riders)
+      mins_.push_back({id, r->get_energy()});
+  }
+
+  void on_step(const Simulation& sim) override {
+    size_t i = 0;
+    for (const auto& [id, r] : sim.get_engine()->get_riders()) {
+      double& m = mins_[i++].second;
+      m = std::min(m, r->get_energy());
+    }
+  }
+
+  const std::vector<std::pair<RiderId, double>>& data() const { return mins_; }
+
+private:
+  std::vector<std::pair<RiderId, double>> mins_;
+};
+
+// The whole field across the line, or out of time.  (FinishLineCondition
+// logs every time it fires: once per run is noise in a batch.)
+class FieldInCondition : public SimulationEndCondition {
+public:
+  explicit FieldInCondition(double time_limit) : time_limit_(time_limit) {}
+
+  bool should_stop(const Simulation& sim) const override {
+    if (sim.get_sim_seconds() >= time_limit_)
+      return true;
+    const PhysicsEngine& eng = *sim.get_engine();
+    const double length = eng.get_course()->get_total_length();
+    for (const auto& [id, r] : eng.get_riders())
+      if (r->get_pos() < length)
+        return false;
+    return true;
+  }
+
+private:
+  double time_limit_;
+};
+
+double draw_factor(std::mt19937_64& rng, double sd) {
+  std::normal_distribution<double> n(0.0, 1.0);
+  const double z = n(rng); // drawn even at sd 0: streams stay aligned
+  return std::clamp(1.0 + sd * z, 0.5, 1.5);
+}
+
+void fold(BatchStats& stats, const RunSummary& s) {
+  ++stats.runs;
+  if (!s.riders.empty() && s.riders.front().finish_time >= 0.0)
+    stats.winning_time.add(s.riders.front().finish_time);
+
+  for (size_t pos = 0; pos < s.riders.size(); ++pos) {
+    const RiderRunResult& rr = s.riders[pos];
+    auto it = std::lower_bound(
+        stats.riders.begin(), stats.riders.end(), rr.id,
+        [](const RiderBatchStats& a, RiderId id) { return a.id < id; });
+    if (it == stats.riders.end() || it->id != rr.id)
+      continue; // not in the base roster (added by the factory)
+    it->w_prime_min.add(rr.w_prime_min);
+    if (rr.finish_time < 0.0)
+      continue;
+    ++it->finishes;
+    if (pos == 0)
+      ++it->wins;
+    it->position.add(static_cast<double>(pos + 1));
+    it->finish_time.add(rr.finish_time);
+    it->gap.add(rr.gap);
+  }
+}
+
+} // namespace
+
+void RunningStat::add(double x) {
+  if (n == 0) {
+    min = max = x;
+  } else {
+    min = std::min(min, x);
+    max = std::max(max, x);
+  }
+  ++n;
+  const double d = x - mean;
+  mean += d / static_cast<double>(n);
+  m2 += d * (x - mean);
+}
+
+double RunningStat::variance() const {
+  return n > 1 ? m2 / static_cast<double>(n - 1) : 0.0;
+}
+
+double RunningStat::sd() const { return std::sqrt(variance()); }
+
+BatchRunner::BatchRunner(const Course& course, std::vector<RiderConfig> riders,
+                         ScenarioFactory factory, BatchParams params)
+    : course_(course), riders_(std::move(riders)),
+      factory_(std::move(factory)), params_(params) {}
+
+std::vector<RiderConfig>
+BatchRunner::perturb_riders(const RunPerturbation& p) const {
+  std::vector<RiderConfig> riders = riders_;
+  std::mt19937_64 rng(p.seed);
+  for (RiderConfig& cfg : riders) {
+    cfg.ftp_base *= draw_factor(rng, p.ftp_sd);
+    cfg.cda *= draw_factor(rng, p.cda_sd);
+    cfg.w_prime_base *= draw_factor(rng, p.w_prime_sd);
+  }
+  return riders;
+}
+
+RunSummary BatchRunner::run_one(size_t index, const RunPerturbation& p) const {
+  // A wind override needs its own (rebaked) course; otherwise runs share
+  // the base one.
+  std::optional<Course> windy;
+  if (p.wind) {
+    windy.emplace(course_);
+    windy->set_wind(*p.wind);
+  }
+  const Course& course = windy ? *windy : course_;
+
+  std::unique_ptr<Simulation> sim = factory_(course, perturb_riders(p));
+  sim->set_dt(params_.dt);
+  for (const auto& [team, plan] : p.race_plans)
+    sim->set_race_plan(team, plan);
+  Simulation& s = *sim;
+
+  WPrimeMinObserver wprime;
+  OfflineSimulationRunner runner(std::move(sim));
+  runner.add_observer(&wprime);
+  runner.set_end_condition(
+      std::make_unique<FieldInCondition>(params_.time_limit));
+  runner.run();
+
+  RunSummary out;
+  out.index = index;
+  out.seed = p.seed;
+  out.sim_seconds = s.get_sim_seconds();
+
+  const RaceClock& clock = s.get_decision().race_clock();
+  const std::vector<Checkpoint>& cps = clock.checkpoints();
+  const size_t n_cp = cps.size();
+  // The finish by position, not by order: it need not be the last entry.
+  size_t finish = n_cp;
+  for (size_t k = 0; k < n_cp && finish == n_cp; ++k)
+    if (cps[k].pos >= course.get_total_length())
+      finish = k;
+  for (const auto& [id, w_min] : wprime.data()) {
+    auto off = params_.start_offsets.find(id);
+    const double t0 = off == params_.start_offsets.end() ? 0.0 : off->second;
+    RiderRunResult rr;
+    rr.id = id;
+    rr.w_prime_min = w_min;
+    rr.splits.resize(n_cp, -1.0);
+    for (size_t k = 0; k < n_cp; ++k)
+      if (std::optional<double> t = clock.checkpoint_time(id, k))
+        rr.splits[k] = *t - t0;
+    rr.finish_time = finish < n_cp ? rr.splits[finish] : -1.0;
+    out.riders.push_back(rr);
+  }
+  std::sort(out.riders.begin(), out.riders.end(),
+            [](const RiderRunResult& a, const RiderRunResult& b) {
+              const bool fa = a.finish_time >= 0.0, fb = b.finish_time >= 0.0;
+              if (fa != fb)
+                return fa;
+              if (fa && a.finish_time != b.finish_time)
+                return a.finish_time < b.finish_time;
+              return a.id < b.id;
+            });
+  if (!out.riders.empty() && out.riders.front().finish_time >= 0.0) {
+    const double winner = out.riders.front().finish_time;
+    for (RiderRunResult& rr : out.riders)
+      if (rr.finish_time >= 0.0)
+        rr.gap = rr.finish_time - winner;
+  }
+  return out;
+}
+
+BatchStats BatchRunner::run(const std::vector<RunPerturbation>& runs,
+                            const RunCallback& on_run) const {
+  const auto t0 = std::chrono::steady_clock::now();
+
+  BatchStats stats;
+  for (const RiderConfig& cfg : riders_) {
+    RiderBatchStats r;
+    r.id = cfg.rider_id;
+    stats.riders.push_back(r);
+  }
+  std::sort(stats.riders.begin(), stats.riders.end(),
+            [](const RiderBatchStats& a, const RiderBatchStats& b) {
+              return a.id < b.id;
+            });
+
+  int threads = params_.threads > 0
+                    ? params_.threads
+                    : static_cast<int>(std::thread::hardware_concurrency());
+  threads = std::clamp(threads, 1,
+                       std::max(1, static_cast<int>(runs.size())));
+  const size_t window =
+      params_.window > 0 ? params_.window : 4 * static_cast<size_t>(threads);
+
+  std::mutex m;
+  std::condition_variable cv;
+  size_t next = 0;   // next run to start
+  size_t folded = 0; // runs [0, folded) are in stats
+  std::map<size_t, RunSummary> pending; // done, waiting on a predecessor
+
+  auto worker = [&] {
+    for (;;) {
+      size_t i;
+      {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] {
+          return next >= runs.size() || next < folded + window;
+        });
+        if (next >= runs.size())
+          return;
+        i = next++;
+      }
+
+      RunSummary s = run_one(i, runs[i]);
+
+      std::lock_guard<std::mutex> lock(m);
+      pending.emplace(i, std::move(s));
+      while (!pending.empty() && pending.begin()->first == folded) {
+        fold(stats, pending.begin()->second);
+        if (on_run)
+          on_run(pending.begin()->second);
+        pending.erase(pending.begin());
+        ++folded;
+      }
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; ++t)
+    pool.emplace_back(worker);
+  worker(); // the caller is a participant too (same as WorkerPool)
+  for (std::thread& t : pool)
+    t.join();
+
+  stats.wall_seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - t0)
+                           .count();
+  return stats;
+}
@@ -1,9 +1,44 @@
 #include "course.h"
-#include "SDL3/SDL_log.h"
+#include "sim_log.h"
 #include "pch.hpp"
 #include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
+// Segments a cursor walks forward before giving up and binary-searching.
+static constexpr int kCursorWalk = 4;
+
+// The per-segment terms of CourseSample; Course::bake stores exactly these.
+static SegmentEnv segment_env(double slope, double heading, Wind wind) {
+  return SegmentEnv{
+      .grav_sin = std::sin(std::atan(slope)),
+      .headwind = wind.speed * std::cos(wind.heading - heading),
+      .crosswind = wind.speed * std::sin(wind.heading - heading),
+  };
+}
+
+CourseSample ICourseView::sample(double pos, SegmentCursor& /*cursor*/) const {
+  const double slope = get_slope(pos);
+  const double heading = get_heading(pos);
+  const double altitude = get_altitude(pos);
+  const Wind wind = get_wind(pos);
+  const SegmentEnv e = segment_env(slope, heading, wind);
+  return CourseSample{
+      .slope = slope,
+      .crr = get_crr(pos),
+      .heading = heading,
+      .road_width = get_road_width(pos),
+      .altitude = altitude,
+      .wind = wind,
+      .grav_sin = e.grav_sin,
+      .headwind = e.headwind,
+      .crosswind = e.crosswind,
+      .segment = -1,
+      .seg_alt0 = altitude,
+      .seg_alt1 = altitude,
+  };
+}
+
 // make CourseSegment easier to print
 std::ostream& operator<<(std::ostream& os, const Segment& cs) {
   os << cs.length << " m at " << cs.slope * 100 << "%";
@@ -26,9 +61,16 @@ Course::Course(const std::vector<std::array<double, 5>> segments_,
   points.push_back({x, y, 0.0}); // final endpoint
 
   total_length_ = x;
-  SDL_Log("Total course length: %.1f m", total_length_);
+  sim_log("Total course length: %.1f m", total_length_);
 
   checkpoints_.push_back({total_length_, "Finish"});
+  bake();
+}
+
+void Course::bake() {
+  env_.resize(segments.size());
+  for (size_t i = 0; i < segments.size(); ++i)
+    env_[i] = segment_env(points[i].slope, segments[i].heading, wind_);
 }
 
 void Course::add_checkpoint(double pos, std::string label) {
@@ -83,10 +125,35 @@ double Course::get_heading(double pos) const {
   return segments[find_segment(pos)].heading;
 }
 
+// One segment lookup for the whole record; same values as the getters.
+CourseSample Course::sample(double pos, SegmentCursor& cursor) const {
+  const int idx = find_segment(pos, cursor);
+  const Segment& seg = segments[idx];
+  const CoursePoint& pt = points[idx];
+  const SegmentEnv& e = env_[idx];
+  return CourseSample{
+      .slope = pt.slope,
+      .crr = seg.crr,
+      .heading = seg.heading,
+      .road_width = seg.road_width,
+      .altitude = pt.y + pt.slope * (pos - pt.x),
+      .wind = get_wind(pos),
+      .grav_sin = e.grav_sin,
+      .headwind = e.headwind,
+      .crosswind = e.crosswind,
+      .segment = idx,
+      .seg_alt0 = pt.y,
+      .seg_alt1 = points[idx + 1].y,
+  };
+}
+
 // The pos parameter stays: per-segment wind overrides are future scope.
 Wind Course::get_wind(double /*pos*/) const { return wind_; }
 
-void Course::set_wind(Wind w) { wind_ = w; }
+void Course::set_wind(Wind w) {
+  wind_ = w;
+  bake();
+}
 
 MatrixX2d Course::get_points(double x_min, double x_max) const {
   if (x_min > x_max)
@@ -132,7 +199,7 @@ int Course::find_segment(double x) const {
   // >= : x exactly at total_length (the finish) belongs to the last
   // segment; the strict > let it fall through the binary search and throw.
   if (x >= total_length_) {
-    // SDL_Log("Trying to find segment for x > total_length (%.1f > %f.1f) in "
+    // sim_log("Trying to find segment for x > total_length (%.1f > %f.1f) in "
     //         "Course::find segment()",
     //         x, total_length_);
     return segments.size() - 1;
@@ -150,6 +217,24 @@ int Course::find_segment(double x) const {
   throw std::out_of_range("x out of course bounds");
 }
 
+// Walk forward from the cursor's segment with the same boundary rules as
+// the binary search above (the last segment also takes everything past the
+// finish); anything else — a backward move, a jump — searches.
+int Course::find_segment(double x, SegmentCursor& cursor) const {
+  const int last = static_cast<int>(segments.size()) - 1;
+  int i = std::clamp(cursor.seg, 0, last);
+  for (int step = 0; step < kCursorWalk; ++step, ++i) {
+    if (x < segments[i].start_x)
+      break;
+    if (i == last || x < segments[i].start_x + segments[i].length) {
+      cursor.seg = i;
+      return i;
+    }
+  }
+  cursor.seg = find_segment(x);
+  return cursor.seg;
+}
+
 void Course::print() {
   std::cout << "Course:" << std::endl;
   for (const Segment& course_segment : segments) {
@@ -1,4 +1,5 @@
 #include "decision.h"
+#include "checkpoint.h"
 #include "sim.h"
 
 #include <algorithm>
@@ -9,13 +10,37 @@ namespace {
 constexpr int kLastTableSlot =
     static_cast<int>(sizeof(DraftingParams::paceline_table) / sizeof(double)) -
     1;
+// One clone per shared instance; stateless policies (clone() == nullptr)
+// stay shared.
+std::unordered_map<RiderId, std::shared_ptr<IRiderPolicy>> clone_policies(
+    const std::unordered_map<RiderId, std::shared_ptr<IRiderPolicy>>& from) {
+  std::unordered_map<RiderId, std::shared_ptr<IRiderPolicy>> to;
+  std::unordered_map<const IRiderPolicy*, std::shared_ptr<IRiderPolicy>>
+      clones;
+  for (const auto& [id, p] : from) {
+    auto [it, fresh] = clones.try_emplace(p.get());
+    if (fresh) {
+      it->second = p->clone();
+      if (!it->second)
+        it->second = p; // stateless: shared
+    }
+    to.emplace(id, it->second);
+  }
+  return to;
+}
 } // namespace
 
 DecisionSystem::DecisionSystem(const Course* course, DecisionParams params)
     : params_(params),
       clock_(course->get_total_length(), course->get_checkpoints(),
              params.grid_spacing),
-      intel_(*course) {}
+      intel_(std::make_shared<const CourseIntel>(*course)) {}
+
+DecisionSystem::DecisionSystem(const DecisionSystem& o)
+    : params_(o.params_), clock_(o.clock_), intel_(o.intel_),
+      policies_(clone_policies(o.policies_)),
+      policy_follow_(o.policy_follow_), directors_(o.directors_),
+      directives_(o.directives_) {}
 
 void DecisionSystem::observe(const PhysicsEngine& engine, double t) {
   // Per-rider traces are independent — iteration order is irrelevant here
@@ -33,6 +58,110 @@ void DecisionSystem::reset() {
   directives_.clear();
 }
 
+// Everything keyed by id goes out in sorted id order, so equal states give
+// equal bytes.
+static std::vector<RiderId> sorted_policy_ids(
+    const std::unordered_map<RiderId, std::shared_ptr<IRiderPolicy>>& m) {
+  std::vector<RiderId> ids;
+  ids.reserve(m.size());
+  for (const auto& [id, p] : m)
+    ids.push_back(id);
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+void DecisionSystem::save_setup(CheckpointWriter& w) const {
+  std::vector<TeamId> teams;
+  for (const auto& [team, dir] : directors_)
+    teams.push_back(team);
+  std::sort(teams.begin(), teams.end());
+  w.pods(teams);
+
+  const std::vector<RiderId> ids = sorted_policy_ids(policies_);
+  w.pod(static_cast<std::uint64_t>(ids.size()));
+  for (RiderId id : ids) {
+    w.pod(id);
+    w.str(policies_.at(id)->name());
+  }
+}
+
+bool DecisionSystem::check_setup(CheckpointReader& r) const {
+  std::vector<TeamId> teams;
+  if (!r.pods(teams))
+    return false;
+  bool same = teams.size() == directors_.size();
+  for (TeamId team : teams)
+    same = same && directors_.count(team) > 0;
+  if (!same)
+    return r.fail("race plans differ from the checkpoint's");
+
+  if (!r.expect_count(policies_.size(), "policy assignments differ"))
+    return false;
+  for (size_t i = 0; i < policies_.size(); ++i) {
+    RiderId id = -1;
+    std::string name;
+    r.pod(id);
+    r.str(name);
+    auto it = policies_.find(id);
+    if (!r.ok() || it == policies_.end() || name != it->second->name())
+      return r.fail("policy assignments differ");
+  }
+  return r.ok();
+}
+
+void DecisionSystem::save_state(CheckpointWriter& w) const {
+  clock_.save_state(w);
+  w.pods(std::vector<RiderId>(policy_follow_.begin(), policy_follow_.end()));
+
+  std::vector<RiderId> ids;
+  for (const auto& [id, d] : directives_)
+    ids.push_back(id);
+  std::sort(ids.begin(), ids.end());
+  w.pod(static_cast<std::uint64_t>(ids.size()));
+  for (RiderId id : ids) {
+    w.pod(id);
+    w.pod(directives_.at(id));
+  }
+
+  for (RiderId id : sorted_policy_ids(policies_))
+    policies_.at(id)->save_state(w);
+}
+
+bool DecisionSystem::load_state(CheckpointReader& r) {
+  if (!clock_.load_state(r))
+    return false;
+
+  std::vector<RiderId> follow;
+  r.pods(follow);
+  policy_follow_ = std::set<RiderId>(follow.begin(), follow.end());
+
+  directives_.clear();
+  std::uint64_t n = 0;
+  if (!r.count(n, sizeof(RiderId) + sizeof(Directive)))
+    return false;
+  for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+    RiderId id = -1;
+    Directive d;
+    r.pod(id);
+    r.pod(d);
+    directives_[id] = d;
+  }
+
+  for (RiderId id : sorted_policy_ids(policies_))
+    if (r.ok() && !policies_.at(id)->load_state(r))
+      return r.fail("policy state rejected");
+  return r.ok();
+}
+
+DecisionSystem::Setup DecisionSystem::copy_setup() const {
+  return Setup{clone_policies(policies_), directors_};
+}
+
+void DecisionSystem::restore_setup(const Setup& setup) {
+  policies_ = clone_policies(setup.policies);
+  directors_ = setup.directors;
+}
+
 // --- C4: race plans + the director phase ---
 
 void DecisionSystem::set_race_plan(TeamId team, RacePlan plan) {
@@ -454,7 +583,7 @@ DecisionContext DecisionSystem::build_context(const Simulation& sim,
     }
   }
 
-  c.intel = &intel_;
+  c.intel = intel_.get();
   c.clock = &clock_;
   c.self = r;
   return c;
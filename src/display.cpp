@@ -281,13 +281,15 @@ void GroupBoardDrawable::render(const RenderContext* ctx) {
 
   char buf[96];
   for (size_t i = 0; i < ctx->groups.size(); ++i) {
-    const Group& g = ctx->groups[i];
+    const FrameGroup& g = ctx->groups[i];
+    const std::string_view label = ctx->group_label(g);
+    const int len = static_cast<int>(label.size());
     if (g.time_gap_ahead >= 0.0) {
       const long s = std::lround(g.time_gap_ahead);
-      std::snprintf(buf, sizeof buf, "%s (%d)  +%ld:%02ld",
-                    g.display_name.c_str(), g.size(), s / 60, s % 60);
+      std::snprintf(buf, sizeof buf, "%.*s (%d)  +%ld:%02ld", len,
+                    label.data(), g.size(), s / 60, s % 60);
     } else {
-      std::snprintf(buf, sizeof buf, "%s (%d)", g.display_name.c_str(),
+      std::snprintf(buf, sizeof buf, "%.*s (%d)", len, label.data(),
                     g.size());
     }
     Line& l = lines_[i];
@@ -397,13 +399,16 @@ void RiderBoardDrawable::render(const RenderContext* ctx) {
   char buf[128];
   for (size_t i = 0; i < sorted.size(); ++i) {
     const RiderRenderState& rs = *sorted[i];
+    const int name_len = static_cast<int>(rs.name.size());
     if (rs.policy.empty())
-      std::snprintf(buf, sizeof buf, "%s  %c %.2f", rs.name.c_str(),
-                    effort_source_letter(rs.effort_source), rs.effort);
+      std::snprintf(buf, sizeof buf, "%.*s  %c %.2f", name_len,
+                    rs.name.data(), effort_source_letter(rs.effort_source),
+                    rs.effort);
     else
-      std::snprintf(buf, sizeof buf, "%s  %c %.2f  %s", rs.name.c_str(),
-                    effort_source_letter(rs.effort_source), rs.effort,
-                    rs.policy.c_str());
+      std::snprintf(buf, sizeof buf, "%.*s  %c %.2f  %.*s", name_len,
+                    rs.name.data(), effort_source_letter(rs.effort_source),
+                    rs.effort, static_cast<int>(rs.policy.size()),
+                    rs.policy.data());
     Line& l = lines_[i];
     if (l.text != buf) {
       l.text = buf;
@@ -1,7 +1,9 @@
 #include "drafting.h"
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <numeric>
+#include <unordered_map>
 
 namespace {
 
@@ -60,22 +62,52 @@ double draft_gap_falloff(double gap, const DraftingParams& p) {
 std::vector<double>
 compute_draft_factors(const std::vector<DraftRiderState>& riders,
                       const DraftingParams& p) {
-  const int n = static_cast<int>(riders.size());
-  std::vector<double> factors(n, 1.0);
-  if (n < 2)
-    return factors;
-
-  // Front-to-back processing order so a leader's depth and link strength are
-  // resolved before its followers read them.
-  std::vector<int> order(n);
+  std::vector<int> order(riders.size());
   std::iota(order.begin(), order.end(), 0);
   std::sort(order.begin(), order.end(), [&riders](int a, int b) {
     return riders[a].lon_pos > riders[b].lon_pos;
   });
+  return compute_draft_factors(riders, order, p);
+}
+
+std::vector<double>
+compute_draft_factors(const std::vector<DraftRiderState>& riders,
+                      const std::vector<int>& order, const DraftingParams& p) {
+  DraftScratch scratch;
+  std::vector<double> factors;
+  compute_draft_factors(riders, order, p, scratch, factors);
+  return factors;
+}
 
-  std::vector<int> leader_of(n, -1);
-  std::vector<double> link_s(n, 0.0); // own-link strength: falloff · align
-  std::vector<double> depth(n, 0.0);  // continuous chain depth, 0 = head
+void compute_draft_factors(const std::vector<DraftRiderState>& riders,
+                           const std::vector<int>& order,
+                           const DraftingParams& p, DraftScratch& scratch,
+                           std::vector<double>& factors) {
+  const int n = static_cast<int>(riders.size());
+  factors.assign(n, 1.0);
+  if (n < 2)
+    return;
+  assert(static_cast<int>(order.size()) == n);
+
+  // `order` is front-to-back so a leader's depth and link strength are
+  // resolved before its followers read them.
+
+  std::vector<int>& leader_of = scratch.leader_of;
+  std::vector<double>& link_s = scratch.link_s; // own link: falloff · align
+  std::vector<double>& depth = scratch.depth;   // continuous chain depth
+  // Strongest link any follower has on this rider, accumulated as links
+  // form (max is order-free, so this equals a scan over all followers).
+  std::vector<double>& follower_s = scratch.follower_s;
+  leader_of.assign(n, -1);
+  link_s.assign(n, 0.0);
+  depth.assign(n, 0.0); // 0 = head
+  follower_s.assign(n, 0.0);
+
+  // Once lon_sep minus the longest bike reaches max_draft_gap, no wheel that
+  // far ahead (or further) can be in range, so the candidate walk stops.
+  double max_bike_len = 0.0;
+  for (const auto& r : riders)
+    max_bike_len = std::max(max_bike_len, r.bike_len);
 
   // Links are built for every rider regardless of role: a Body rider's wheel
   // is still air shelter, and its link strength propagates depth to riders
@@ -94,8 +126,8 @@ compute_draft_factors(const std::vector<DraftRiderState>& riders,
     //
     // order[0..k) are the riders at or ahead of me, so walking k2 downward
     // visits them nearest-first.  Out-of-range wheels don't consume a
-    // candidate slot (no early break: bike_len differences make lon_sep
-    // ordering not strictly gap ordering).
+    // candidate slot (bike_len differences make lon_sep ordering not
+    // strictly gap ordering); only the max_bike_len bound ends the walk.
     int best = -1;
     double best_benefit = 0.0, best_s = 0.0, best_depth = 0.0;
     int evaluated = 0;
@@ -104,6 +136,8 @@ compute_draft_factors(const std::vector<DraftRiderState>& riders,
       const double lon_sep = riders[j].lon_pos - me.lon_pos;
       if (lon_sep <= 0.0)
         continue; // co-located: no link
+      if (lon_sep - max_bike_len >= p.max_draft_gap)
+        break;
       const double gap = lon_sep - riders[j].bike_len;
       if (gap >= p.max_draft_gap)
         continue;
@@ -128,21 +162,42 @@ compute_draft_factors(const std::vector<DraftRiderState>& riders,
     leader_of[i] = best;
     link_s[i] = best_s;
     depth[i] = best_depth;
+    follower_s[best] = std::max(follower_s[best], best_s);
+  }
+
+  // Body riders: count same-group riders strictly ahead within body_window.
+  // Walking the order back, that window is order[lo, hi) — hi is the first
+  // rider level with me, lo the first within body_window — and both bounds
+  // only advance, so each rider enters and leaves the per-group counts once.
+  std::vector<int>& body_ahead = scratch.body_ahead;
+  body_ahead.assign(n, 0);
+  if (std::any_of(riders.begin(), riders.end(), [](const DraftRiderState& r) {
+        return r.role == GroupRole::Body;
+      })) {
+    // Zeroed rather than cleared: the nodes for groups seen before are kept.
+    std::unordered_map<GroupId, int>& in_window = scratch.in_window;
+    for (auto& [group, count] : in_window)
+      count = 0;
+    int lo = 0, hi = 0;
+    for (int k = 0; k < n; ++k) {
+      const int i = order[k];
+      const double pos = riders[i].lon_pos;
+      for (; hi < k && riders[order[hi]].lon_pos - pos > 0.0; ++hi)
+        ++in_window[riders[order[hi]].group_id];
+      for (; lo < hi && riders[order[lo]].lon_pos - pos > p.body_window; ++lo)
+        --in_window[riders[order[lo]].group_id];
+      if (riders[i].role == GroupRole::Body) {
+        const auto it = in_window.find(riders[i].group_id);
+        body_ahead[i] = (it != in_window.end()) ? it->second : 0;
+      }
+    }
   }
 
   constexpr int NB = sizeof(DraftingParams{}.body_curve) / sizeof(double);
 
   for (int i = 0; i < n; ++i) {
     if (riders[i].role == GroupRole::Body) {
-      int n_ahead = 0;
-      for (int j = 0; j < n; ++j) {
-        if (j == i || riders[j].group_id != riders[i].group_id)
-          continue;
-        const double d = riders[j].lon_pos - riders[i].lon_pos;
-        if (d > 0.0 && d <= p.body_window)
-          ++n_ahead;
-      }
-      factors[i] = p.body_curve[std::min(n_ahead, NB - 1)];
+      factors[i] = p.body_curve[std::min(body_ahead[i], NB - 1)];
       continue;
     }
 
@@ -157,16 +212,9 @@ compute_draft_factors(const std::vector<DraftRiderState>& riders,
     // none — the TTT table already includes it — but it fades in smoothly as
     // the rider's own link ahead fades, so a chain splitting doesn't step
     // the new head's CdA by the push amount.
-    double follower_s = 0.0;
-    for (int f = 0; f < n; ++f) {
-      if (leader_of[f] == i)
-        follower_s = std::max(follower_s, link_s[f]);
-    }
     const double benefit_behind =
-        (1.0 - p.paceline_table[0]) * follower_s * (1.0 - s);
+        (1.0 - p.paceline_table[0]) * follower_s[i] * (1.0 - s);
 
     factors[i] = 1.0 - benefit_ahead - benefit_behind;
   }
-
-  return factors;
 }
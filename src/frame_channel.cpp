@@ -0,0 +1,111 @@
+#include "frame_channel.h"
+
+// Memory ordering: a reader pins (readers++) and then re-loads state_; the
+// writer stores state_ and later loads a slot's reader count before reusing
+// it.  Both pairs are seq_cst, so either the writer sees the pin and skips
+// the slot, or the reader sees the newer word and retries — a reader never
+// holds a slot the writer is rebuilding.  (A slot is only reused once it is
+// out of the published word, so the word must have changed under such a
+// reader.)
+
+static const FrameSnapshot& empty_frame() {
+  static const FrameSnapshot empty{};
+  return empty;
+}
+
+FramePair::FramePair(FramePair&& o) noexcept
+    : ch_(o.ch_), prev_(o.prev_), curr_(o.curr_) {
+  o.ch_ = nullptr;
+  o.prev_ = o.curr_ = -1;
+}
+
+FramePair& FramePair::operator=(FramePair&& o) noexcept {
+  if (this != &o) {
+    release();
+    ch_ = o.ch_;
+    prev_ = o.prev_;
+    curr_ = o.curr_;
+    o.ch_ = nullptr;
+    o.prev_ = o.curr_ = -1;
+  }
+  return *this;
+}
+
+const FrameSnapshot& FramePair::prev() const {
+  return prev_ >= 0 ? ch_->slots_[prev_].frame : empty_frame();
+}
+
+const FrameSnapshot& FramePair::curr() const {
+  return curr_ >= 0 ? ch_->slots_[curr_].frame : empty_frame();
+}
+
+void FramePair::release() {
+  if (!ch_)
+    return;
+  ch_->unpin(prev_);
+  ch_->unpin(curr_);
+  ch_ = nullptr;
+  prev_ = curr_ = -1;
+}
+
+void FrameChannel::unpin(int slot) const {
+  if (slot >= 0)
+    slots_[slot].readers.fetch_sub(1, std::memory_order_release);
+}
+
+FrameSnapshot* FrameChannel::begin() {
+  const std::uint64_t w = state_.load(std::memory_order_relaxed);
+  const int curr = curr_of(w), prev = prev_of(w);
+  for (int i = 0; i < kSlots; ++i) {
+    if (i == curr || i == prev || slots_[i].readers.load() != 0)
+      continue;
+    building_ = i;
+    return &slots_[i].frame;
+  }
+  ++dropped_;
+  return nullptr;
+}
+
+void FrameChannel::publish() {
+  if (building_ < 0)
+    return;
+  const std::uint64_t w = state_.load(std::memory_order_relaxed);
+  const std::uint64_t curr = w & 0xFF;
+  state_.store(pack(static_cast<std::uint64_t>(building_), curr,
+                    seq_of(w) + 1));
+  building_ = -1;
+}
+
+void FrameChannel::abandon() { building_ = -1; }
+
+const FrameSnapshot* FrameChannel::published() const {
+  const int curr = curr_of(state_.load(std::memory_order_relaxed));
+  return curr >= 0 ? &slots_[curr].frame : nullptr;
+}
+
+void FrameChannel::clear() {
+  const std::uint64_t w = state_.load(std::memory_order_relaxed);
+  state_.store(pack(kNone, kNone, seq_of(w) + 1));
+  building_ = -1;
+}
+
+FramePair FrameChannel::acquire() const {
+  FramePair out;
+  for (;;) {
+    const std::uint64_t w = state_.load();
+    const int curr = curr_of(w), prev = prev_of(w);
+    if (curr < 0)
+      return out;
+    slots_[curr].readers.fetch_add(1);
+    if (prev >= 0)
+      slots_[prev].readers.fetch_add(1);
+    if (state_.load() == w) {
+      out.ch_ = this;
+      out.curr_ = curr;
+      out.prev_ = prev;
+      return out;
+    }
+    unpin(prev);
+    unpin(curr);
+  }
+}
@@ -1,6 +1,9 @@
 #include "group.h"
+#include "checkpoint.h"
 #include <algorithm>
+#include <cassert>
 #include <limits>
+#include <numeric>
 
 double Group::front_pos() const {
   double p = std::numeric_limits<double>::lowest();
@@ -39,63 +42,86 @@ GroupTracker::GroupTracker(const GroupingParams& params) : params_(params) {}
 //
 // Algorithm:
 //   1. Early-out on empty input.
-//   2. Sort members descending by lon_pos (front of race = index 0).
+//   2. Order members descending by lon_pos (front of race = index 0) —
+//      sorted here, or taken from the caller's front_to_back order.
 //   3. Walk consecutive pairs.  Cut a new group wherever the gap between
 //      adjacent riders exceeds gap_threshold.
-//   4. Assign ordinal, id, and display_name to each group.
+//   4. Assign ordinal and id to each group (display_name once per slot).
 //   5. Rebuild rider_to_group_ and rider_to_role_ lookup maps.
 //
 // All members land in group.body after this call.
 // paceline is empty until apply_role_declarations() runs.
 // ---------------------------------------------------------------------------
 void GroupTracker::update(const std::vector<GroupMember>& members) {
-  snapshot_.clear();
-  rider_to_group_.clear();
-  rider_to_role_.clear();
+  std::vector<int> order(members.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&members](int a, int b) {
+    return members[a].lon_pos > members[b].lon_pos; // descending: front first
+  });
+  update(members, order);
+}
 
-  if (members.empty())
+void GroupTracker::update(const std::vector<GroupMember>& members,
+                          const std::vector<int>& front_to_back) {
+  ++revision_;
+  if (members.empty()) {
+    snapshot_.clear();
+    rider_to_group_.clear();
+    rider_to_role_.clear();
     return;
-
-  // Step 1 — sort a local copy; preserve caller's buffer
-  std::vector<GroupMember> sorted = members;
-  std::sort(sorted.begin(), sorted.end(),
-            [](const GroupMember& a, const GroupMember& b) {
-              return a.lon_pos > b.lon_pos; // descending: front first
-            });
-
-  // Step 2 — scan and cut into groups
-  Group current;
-  current.body.push_back(sorted[0]);
-
-  for (int i = 1; i < static_cast<int>(sorted.size()); ++i) {
-    const double gap = sorted[i - 1].lon_pos - sorted[i].lon_pos;
-
-    if (gap > params_.gap_threshold) {
-      // Gap is too large — close current group and open a new one
-      const int ordinal = static_cast<int>(snapshot_.size());
-      current.ordinal = ordinal;
-      current.id = ordinal;
-      current.display_name = default_group_label(ordinal, current.size());
-      snapshot_.push_back(std::move(current));
-      current = Group{};
+  }
+  assert(front_to_back.size() == members.size());
+
+  // Step 1 — gather an ordered local copy; preserve caller's buffer
+  sorted_.clear();
+  for (int i : front_to_back)
+    sorted_.push_back(members[i]);
+
+  // Step 2 — scan and cut into groups.  Group slots are reused in place, so
+  // their member vectors keep their capacity from tick to tick; a slot is
+  // labelled once, when first created (the default label depends only on
+  // the ordinal).
+  int n_groups = 0;
+  auto open_group = [this, &n_groups]() -> Group& {
+    const int ordinal = n_groups++;
+    if (static_cast<int>(snapshot_.size()) < n_groups) {
+      snapshot_.emplace_back();
+      snapshot_.back().display_name = default_group_label(ordinal, 0);
     }
-
-    current.body.push_back(sorted[i]);
+    Group& g = snapshot_[ordinal];
+    g.id = ordinal;
+    g.ordinal = ordinal;
+    g.paceline.clear();
+    g.body.clear();
+    g.time_gap_ahead = -1.0;
+    return g;
+  };
+
+  Group* current = &open_group();
+  current->body.push_back(sorted_[0]);
+
+  for (int i = 1; i < static_cast<int>(sorted_.size()); ++i) {
+    const double gap = sorted_[i - 1].lon_pos - sorted_[i].lon_pos;
+    if (gap > params_.gap_threshold)
+      current = &open_group(); // gap too large — open a new group
+    current->body.push_back(sorted_[i]);
   }
-
-  // Close the final (or only) group
-  const int ordinal = static_cast<int>(snapshot_.size());
-  current.ordinal = ordinal;
-  current.id = ordinal;
-  current.display_name = default_group_label(ordinal, current.size());
-  snapshot_.push_back(std::move(current));
-
-  // Step 3 — rebuild lookup maps
-  for (const auto& group : snapshot_) {
-    for (const auto& m : group.body) {
-      rider_to_group_[m.id] = group.id;
-      rider_to_role_[m.id] = GroupRole::Unassigned;
+  snapshot_.resize(n_groups);
+
+  // Step 3 — rebuild lookup maps.  Entries are overwritten in place, so the
+  // maps' nodes are reused while the roster is unchanged; only a rider
+  // leaving (the map outgrowing this tick's members) forces a clear.
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const auto& group : snapshot_) {
+      for (const auto& m : group.body) {
+        rider_to_group_[m.id] = group.id;
+        rider_to_role_[m.id] = GroupRole::Unassigned;
+      }
     }
+    if (rider_to_group_.size() == members.size())
+      break;
+    rider_to_group_.clear();
+    rider_to_role_.clear();
   }
 }
 
@@ -105,18 +131,20 @@ void GroupTracker::update(const std::vector<GroupMember>& members) {
 // For each group, collect all current members (all in body at this point),
 // then redistribute according to the declarations map.
 // Riders absent from decls go into body as Unassigned.
-// paceline is sorted front-to-back after distribution.
+// paceline is front-to-back after distribution: update() leaves each group's
+// members front-to-back, and the filter preserves that order.
 // ---------------------------------------------------------------------------
 void GroupTracker::apply_role_declarations(
     const std::unordered_map<RiderId, GroupRole>& decls) {
-
+  ++revision_;
   for (auto& group : snapshot_) {
-    // All members are currently in body (placed there by update())
-    std::vector<GroupMember> all = std::move(group.body);
+    // All members are currently in body (placed there by update()); copied
+    // out rather than moved so body keeps its buffer.
+    all_.assign(group.body.begin(), group.body.end());
     group.paceline.clear();
     group.body.clear();
 
-    for (auto& m : all) {
+    for (auto& m : all_) {
       const auto it = decls.find(m.id);
       const GroupRole role =
           (it != decls.end()) ? it->second : GroupRole::Unassigned;
@@ -131,10 +159,10 @@ void GroupTracker::apply_role_declarations(
     }
 
     // Paceline ordered front-to-back: index 0 is the paceline leader
-    std::sort(group.paceline.begin(), group.paceline.end(),
-              [](const GroupMember& a, const GroupMember& b) {
-                return a.lon_pos > b.lon_pos;
-              });
+    assert(std::is_sorted(group.paceline.begin(), group.paceline.end(),
+                          [](const GroupMember& a, const GroupMember& b) {
+                            return a.lon_pos > b.lon_pos;
+                          }));
   }
 }
 
@@ -149,3 +177,67 @@ GroupRole GroupTracker::get_role(RiderId id) const {
 }
 
 const GroupSnapshot& GroupTracker::get_snapshot() const { return snapshot_; }
+
+// Field by field: GroupMember has padding.
+static void save_members(CheckpointWriter& w,
+                         const std::vector<GroupMember>& members) {
+  w.pod(static_cast<std::uint64_t>(members.size()));
+  for (const GroupMember& m : members) {
+    w.pod(m.id);
+    w.pod(m.lon_pos);
+    w.pod(m.speed);
+    w.pod(m.role);
+  }
+}
+
+static bool load_members(CheckpointReader& r,
+                         std::vector<GroupMember>& members) {
+  std::uint64_t n = 0;
+  if (!r.count(n, sizeof(RiderId) + 2 * sizeof(double) + sizeof(GroupRole)))
+    return false;
+  members.resize(n);
+  for (GroupMember& m : members) {
+    r.pod(m.id);
+    r.pod(m.lon_pos);
+    r.pod(m.speed);
+    r.pod(m.role);
+  }
+  return r.ok();
+}
+
+void GroupTracker::save_state(CheckpointWriter& w) const {
+  w.pod(static_cast<std::uint64_t>(snapshot_.size()));
+  for (const Group& g : snapshot_) {
+    w.pod(g.id);
+    w.pod(g.ordinal);
+    w.str(g.display_name);
+    save_members(w, g.paceline);
+    save_members(w, g.body);
+    w.pod(g.time_gap_ahead);
+  }
+}
+
+bool GroupTracker::load_state(CheckpointReader& r) {
+  std::uint64_t n = 0;
+  if (!r.count(n, 2 * sizeof(int)))
+    return false;
+  ++revision_;
+  snapshot_.resize(n);
+  rider_to_group_.clear();
+  rider_to_role_.clear();
+  for (Group& g : snapshot_) {
+    r.pod(g.id);
+    r.pod(g.ordinal);
+    r.str(g.display_name);
+    load_members(r, g.paceline);
+    load_members(r, g.body);
+    r.pod(g.time_gap_ahead);
+    for (const auto* members : {&g.paceline, &g.body}) {
+      for (const GroupMember& m : *members) {
+        rider_to_group_[m.id] = g.id;
+        rider_to_role_[m.id] = m.role;
+      }
+    }
+  }
+  return r.ok();
+}
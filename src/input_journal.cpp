@@ -0,0 +1,101 @@
+#include "input_journal.h"
+#include "analysis.h"
+#include "sim.h"
+#include "sim_log.h"
+
+#include <utility>
+
+void InputJournal::begin(std::vector<char> start_state, double dt) {
+  start_ = std::move(start_state);
+  dt_ = dt;
+  entries_.clear();
+  steps_ = 0;
+}
+
+void InputJournal::record(const SimCommand& cmd) {
+  entries_.push_back({steps_, copy_journaled_command(cmd)});
+}
+
+SimCommand copy_journaled_command(const SimCommand& cmd) {
+  SimCommand copy = cmd;
+  if (auto* c = std::get_if<SetRiderPolicyCmd>(&copy))
+    if (c->policy)
+      if (std::shared_ptr<IRiderPolicy> fresh = c->policy->clone())
+        c->policy = std::move(fresh);
+  return copy;
+}
+
+namespace {
+
+// Queues each entry just before the step it was applied at: entries for
+// step 0 at on_start, those for step k + 1 after step k.  drain_commands()
+// runs at the top of step_fixed(), so they land on the same step.
+class JournalFeeder : public SimulationObserver {
+public:
+  JournalFeeder(const InputJournal& j, Simulation* sim)
+      : journal_(j), sim_(sim) {}
+
+  void on_start(const Simulation&) override { feed(); }
+  void on_step(const Simulation&) override {
+    ++step_;
+    feed();
+  }
+
+private:
+  void feed() {
+    const std::vector<JournalEntry>& entries = journal_.entries();
+    for (; next_ < entries.size() && entries[next_].step == step_; ++next_)
+      sim_->queue_command(copy_journaled_command(entries[next_].cmd));
+  }
+
+  const InputJournal& journal_;
+  Simulation* sim_; // owned by the runner
+  std::uint64_t step_ = 0;
+  std::size_t next_ = 0;
+};
+
+class StepCountCondition : public SimulationEndCondition {
+public:
+  explicit StepCountCondition(std::uint64_t steps) : steps_(steps) {}
+
+  bool should_stop(const Simulation&) const override {
+    return ++taken_ >= steps_;
+  }
+
+private:
+  std::uint64_t steps_;
+  mutable std::uint64_t taken_ = 0;
+};
+
+} // namespace
+
+bool replay_journal(const InputJournal& journal,
+                    std::unique_ptr<Simulation> sim,
+                    const std::vector<SimulationObserver*>& observers) {
+  if (!sim->load_checkpoint(journal.start_state())) {
+    sim_log("replay_journal: the start state does not load into this "
+            "scenario");
+    return false;
+  }
+  sim->set_dt(journal.dt());
+
+  JournalFeeder feeder(journal, sim.get());
+  Simulation* raw = sim.get();
+  OfflineSimulationRunner runner(std::move(sim));
+  runner.add_observer(&feeder);
+  for (SimulationObserver* o : observers)
+    runner.add_observer(o);
+  if (journal.steps() == 0) {
+    // The runner always takes one step; nothing was journaled past the
+    // start, so the start is the whole session.
+    for (SimulationObserver* o : observers) {
+      o->on_start(*raw);
+      o->on_finish(*raw);
+    }
+    return true;
+  }
+  runner.set_end_condition(
+      std::make_unique<StepCountCondition>(journal.steps()));
+  runner.run();
+  return true;
+}
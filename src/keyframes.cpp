@@ -0,0 +1,92 @@
+#include "keyframes.h"
+#include "sim_log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+void KeyframeRing::on_step(Simulation& sim) {
+  if (!frames_.empty() && !ours(sim)) {
+    // Journaling ended under us: the keyframes no longer lead here.
+    frames_.clear();
+    trim();
+  }
+  if (frames_.empty() ||
+      sim.get_sim_seconds() >=
+          frames_.back().time + params_.interval - 0.5 * sim.get_dt())
+    capture(sim);
+}
+
+void KeyframeRing::capture(Simulation& sim) {
+  frames_.push_back(Keyframe{sim.get_sim_seconds(), sim.copy_setup(), {}});
+  sim.start_journal(&frames_.back().journal);
+  trim();
+}
+
+void KeyframeRing::trim() {
+  auto footprint = [](const Keyframe& k) {
+    return k.journal.start_state().size() +
+           k.journal.entries().size() * sizeof(JournalEntry);
+  };
+  std::size_t total = 0;
+  for (const Keyframe& k : frames_)
+    total += footprint(k);
+  while (total > params_.max_bytes && frames_.size() > 1) {
+    total -= footprint(frames_.front());
+    frames_.pop_front();
+  }
+  earliest_ = frames_.empty() ? -1.0 : frames_.front().time;
+  bytes_ = total;
+}
+
+bool KeyframeRing::rewind(Simulation& sim, double t) {
+  if (!ours(sim)) {
+    sim_log("KeyframeRing: no keyframes to rewind to");
+    return false;
+  }
+  t = std::min(t, sim.get_sim_seconds());
+  auto it = std::upper_bound(
+      frames_.begin(), frames_.end(), t,
+      [](double time, const Keyframe& k) { return time < k.time; });
+  if (it != frames_.begin())
+    --it; // else t is before the earliest: rewind to that
+  Keyframe& k = *it;
+  const double dt = k.journal.dt();
+  const std::uint64_t steps = std::min<std::uint64_t>(
+      static_cast<std::uint64_t>(std::llround(std::max(t - k.time, 0.0) / dt)),
+      k.journal.steps());
+
+  const Simulation::Setup live = sim.copy_setup();
+  sim.stop_journal();
+  sim.restore_setup(k.setup);
+  if (!sim.load_checkpoint(k.journal.start_state())) {
+    // Only what the setup copy does not cover (lateral behaviors) gets
+    // here; the state is unchanged, so keyframes start over from it.
+    sim_log("KeyframeRing: the keyframe at %.2f s no longer loads", k.time);
+    sim.restore_setup(live);
+    frames_.clear();
+    capture(sim);
+    return false;
+  }
+
+  // From here the future past k is abandoned; k's journal is re-recorded
+  // as its commands are fed back.
+  const std::vector<JournalEntry> entries = k.journal.entries();
+  frames_.erase(std::next(it), frames_.end());
+  sim.start_journal(&k.journal);
+  std::size_t next = 0;
+  for (std::uint64_t s = 0; s < steps; ++s) {
+    for (; next < entries.size() && entries[next].step == s; ++next)
+      sim.queue_command(copy_journaled_command(entries[next].cmd));
+    sim.step_fixed(dt);
+  }
+  trim();
+  return true;
+}
+
+void KeyframeRing::clear(Simulation& sim) {
+  if (ours(sim))
+    sim.stop_journal();
+  frames_.clear();
+  trim();
+}
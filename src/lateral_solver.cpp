@@ -69,32 +69,46 @@ LateralUpdate LateralSolver::free_movement(const LateralRiderState& r,
 // candidates, so we do not miss contacts that close during integration.
 //
 // Algorithm:
-//   Sort a copy of rider indices by lon_pos (O(N log N)).
-//   Walk a sliding window: for each rider A, advance a pointer forward
-//   collecting riders B within bike_length.  This gives O(N·k) pair
-//   candidates where k is average window occupancy — negligible at N ≤ 20.
+//   Walk the riders back-to-front in longitudinal order (the caller's shared
+//   front_to_back order, or sorted here, O(N log N)).  Sliding window: for
+//   each rider A, advance a pointer forward collecting riders B within
+//   bike_length.  This gives O(N·k) pair candidates where k is average
+//   window occupancy.
 // ============================================================================
 std::vector<LateralSolver::ContactPair> LateralSolver::find_proximity_pairs(
     const std::vector<LateralRiderState>& riders) const {
-
-  const int N = static_cast<int>(riders.size());
-  if (N < 2)
-    return {};
-
-  // Sort indices by longitudinal position
-  std::vector<int> idx(N);
-  std::iota(idx.begin(), idx.end(), 0);
-  std::sort(idx.begin(), idx.end(), [&](int i, int j) {
-    return riders[i].lon_pos < riders[j].lon_pos;
+  std::vector<int> order(riders.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int i, int j) {
+    return riders[i].lon_pos > riders[j].lon_pos;
   });
+  return find_proximity_pairs(riders, order);
+}
 
+std::vector<LateralSolver::ContactPair> LateralSolver::find_proximity_pairs(
+    const std::vector<LateralRiderState>& riders,
+    const std::vector<int>& idx) const {
   std::vector<ContactPair> pairs;
+  find_proximity_pairs(riders, idx, pairs);
+  return pairs;
+}
+
+void LateralSolver::find_proximity_pairs(
+    const std::vector<LateralRiderState>& riders, const std::vector<int>& idx,
+    std::vector<ContactPair>& pairs) const {
+
+  pairs.clear();
+  const int N = static_cast<int>(riders.size());
+  if (N < 2)
+    return;
+  assert(static_cast<int>(idx.size()) == N);
 
-  for (int si = 0; si < N; ++si) {
+  // idx is front-to-back: A walks from the back, B forward (toward index 0).
+  for (int si = N - 1; si >= 0; --si) {
     const int ai = idx[si];
     const double lon_a = riders[ai].lon_pos;
 
-    for (int sj = si + 1; sj < N; ++sj) {
+    for (int sj = si - 1; sj >= 0; --sj) {
       const int bi = idx[sj];
       const double lon_b = riders[bi].lon_pos;
       const double lon_sep = lon_b - lon_a; // always >= 0 due to sort
@@ -117,8 +131,6 @@ std::vector<LateralSolver::ContactPair> LateralSolver::find_proximity_pairs(
       }
     }
   }
-
-  return pairs;
 }
 
 // ============================================================================
@@ -138,8 +150,6 @@ std::vector<LateralSolver::ContactPair> LateralSolver::find_proximity_pairs(
 bool LateralSolver::is_blocked(
     int rider_idx, const std::vector<LateralRiderState>& riders) const {
   const LateralRiderState& own = riders[rider_idx];
-  const double min_gap = 2.0 * own.rider_radius;
-  const double half_road = own.road_width / 2.0;
 
   // Collect riders ahead within their bike_length
   std::vector<double> ahead_lat;
@@ -151,6 +161,39 @@ bool LateralSolver::is_blocked(
       ahead_lat.push_back(riders[i].lat_pos);
   }
 
+  return lanes_blocked(own, ahead_lat);
+}
+
+// Ordered variant: the riders ahead of rider_idx are front_to_back[0, rank),
+// nearest at rank - 1, so the scan walks forward from there and stops once
+// even the longest bike can no longer reach back to us.  Same ahead set as
+// the full scan (co-located riders have lon_offset 0 and never count, so
+// their side of the tie in the order doesn't matter).
+bool LateralSolver::is_blocked(int rider_idx,
+                               const std::vector<LateralRiderState>& riders,
+                               const std::vector<int>& front_to_back, int rank,
+                               double max_bike_len,
+                               std::vector<double>& ahead_lat) const {
+  const LateralRiderState& own = riders[rider_idx];
+
+  ahead_lat.clear();
+  for (int k = rank - 1; k >= 0; --k) {
+    const LateralRiderState& other = riders[front_to_back[k]];
+    const double lon_offset = other.lon_pos - own.lon_pos;
+    if (lon_offset >= max_bike_len)
+      break;
+    if (lon_offset > 0.0 && lon_offset < other.bike_length)
+      ahead_lat.push_back(other.lat_pos);
+  }
+
+  return lanes_blocked(own, ahead_lat);
+}
+
+bool LateralSolver::lanes_blocked(const LateralRiderState& own,
+                                  std::vector<double>& ahead_lat) const {
+  const double min_gap = 2.0 * own.rider_radius;
+  const double half_road = own.road_width / 2.0;
+
   if (ahead_lat.empty())
     return false; // clear road
 
@@ -341,37 +384,79 @@ LateralSolver::compute_shove(const LateralRiderState& a,
 std::vector<LateralUpdate>
 LateralSolver::solve(const std::vector<LateralRiderState>& riders,
                      double dt) const {
+  std::vector<int> order(riders.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int i, int j) {
+    return riders[i].lon_pos > riders[j].lon_pos;
+  });
+  return solve(riders, order, dt);
+}
+
+std::vector<LateralUpdate>
+LateralSolver::solve(const std::vector<LateralRiderState>& riders,
+                     const std::vector<int>& front_to_back, double dt) const {
+  Scratch scratch;
+  std::vector<LateralUpdate> updates;
+  solve(riders, front_to_back, dt, scratch, updates);
+  return updates;
+}
+
+void LateralSolver::solve(const std::vector<LateralRiderState>& riders,
+                          const std::vector<int>& front_to_back, double dt,
+                          Scratch& scratch,
+                          std::vector<LateralUpdate>& updates) const {
 
   const int N = static_cast<int>(riders.size());
+  updates.resize(N);
   if (N == 0)
-    return {};
+    return;
 
   // --- [1] Free movement (spring-damper, optional steering) ---
-  std::vector<LateralUpdate> updates;
-  updates.reserve(N);
-  for (const auto& r : riders)
-    updates.push_back(free_movement(r, dt));
+  for (int i = 0; i < N; ++i)
+    updates[i] = free_movement(riders[i], dt);
 
   if (N == 1)
-    return updates; // no contacts possible
+    return; // no contacts possible
 
   // --- [2] Contact pair detection on current positions ---
-  std::vector<ContactPair> pairs = find_proximity_pairs(riders);
+  std::vector<ContactPair>& pairs = scratch.pairs;
+  find_proximity_pairs(riders, front_to_back, pairs);
 
   if (pairs.empty())
-    return updates; // clean run — free movement only
+    return; // clean run — free movement only
+
+  // Blockade flags, one per rider that is A (behind) in some pair, computed
+  // in a single sweep of the order rather than once per pair: a rider
+  // squeezed from both sides would otherwise rebuild and sort the same
+  // ahead set for each contact.  The longest bike bounds each scan.
+  double max_bike_len = 0.0;
+  for (const auto& r : riders)
+    max_bike_len = std::max(max_bike_len, r.bike_length);
+
+  std::vector<char>& blocked = scratch.blocked;
+  std::vector<char>& needs_blocked = scratch.needs_blocked;
+  blocked.assign(N, 0);
+  needs_blocked.assign(N, 0);
+  for (const auto& pair : pairs)
+    needs_blocked[pair.a_idx] = 1;
+  for (int k = 0; k < N; ++k) {
+    const int i = front_to_back[k];
+    if (needs_blocked[i])
+      blocked[i] = is_blocked(i, riders, front_to_back, k, max_bike_len,
+                              scratch.ahead_lat);
+  }
 
   // --- [3] Shove model — accumulate deltas and multiply penalties ---
 
   // Working accumulators indexed by position in the riders vector
-  std::vector<double> delta_acc(N, 0.0);   // accumulated lat_pos deltas
-  std::vector<double> penalty_acc(N, 1.0); // accumulated speed multipliers
+  std::vector<double>& delta_acc = scratch.delta_acc;     // lat_pos deltas
+  std::vector<double>& penalty_acc = scratch.penalty_acc; // speed multipliers
+  delta_acc.assign(N, 0.0);
+  penalty_acc.assign(N, 1.0);
 
   for (const auto& pair : pairs) {
-    // O(N) per pair — fine at N <= 20.
-    const bool a_blocked = is_blocked(pair.a_idx, riders);
-    const ShoveOutcome out =
-        compute_shove(riders[pair.a_idx], riders[pair.b_idx], pair, a_blocked);
+    const ShoveOutcome out = compute_shove(
+        riders[pair.a_idx], riders[pair.b_idx], pair, blocked[pair.a_idx]);
     // Single rate -> per-step conversion.  The penalty multiplier is floored
     // at 0 so large dt values can't produce a negative speed factor.
     delta_acc[pair.a_idx] += out.a_lat_rate * dt;
@@ -394,6 +479,4 @@ LateralSolver::solve(const std::vector<LateralRiderState>& riders,
   for (int i = 0; i < N; ++i) {
     updates[i].new_lat_vel = (updates[i].new_lat_pos - riders[i].lat_pos) / dt;
   }
-
-  return updates;
 }
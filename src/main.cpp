@@ -4,7 +4,9 @@
 #include "backends/imgui_impl_sdl3.h"
 #include "screenmanager.h"
 #include "sim.h"
+#include "sim_log.h"
 #include <chrono>
+#include <cstring>
 #include <exception>
 #include <thread>
 #define SDL_MAIN_USE_CALLBACKS 1 /* use the callbacks instead of main() */
@@ -16,7 +18,14 @@ int SCREEN_WIDTH = 1000;
 int SCREEN_HEIGHT = 640;
 int WORLD_WIDTH = 400;
 
+// sim_lib logs through sim_log (sim_log.h); in the app, lines go to SDL_Log
+// like everything else.
+static void sdl_log_sink(const char* message, void*) {
+  SDL_Log("%s", message);
+}
+
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
+  set_log_sink(sdl_log_sink);
   try {
     auto* state = new AppState();
 
@@ -28,6 +37,13 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
 
     state->screens->replace(ScreenType::Simulation);
 
+    // --replay TRACE: open on a recorded race (trace_replay.h) instead of
+    // the live one; L goes back to live.
+    for (int i = 1; i + 1 < argc; ++i)
+      if (std::strcmp(argv[i], "--replay") == 0 &&
+          !state->open_replay(argv[i + 1]))
+        SDL_Log("Cannot replay %s; showing the live race", argv[i + 1]);
+
     *appstate = state;
     return SDL_APP_CONTINUE;
   } catch (const std::exception& e) {
@@ -63,8 +79,13 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
       return SDL_APP_CONTINUE;
 
     case SDLK_R:
+      state->close_replay();
       state->start_realtime_tt();
       return SDL_APP_CONTINUE;
+
+    case SDLK_L:
+      state->close_replay();
+      return SDL_APP_CONTINUE;
     }
   }
   // Pass event to current screen
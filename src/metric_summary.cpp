@@ -0,0 +1,146 @@
+#include "metric_summary.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Twice the area of the triangle (ax, ay), (bx, by), (cx, cy).
+double area2(double ax, double ay, double bx, double by, double cx,
+             double cy) {
+  return std::abs((bx - ax) * (cy - ay) - (cx - ax) * (by - ay));
+}
+
+// The representative of `level[i]`, against the one before it (or, first,
+// the bucket's start at its mean).
+void pick_rep(std::vector<MetricBucket>& level, std::size_t i) {
+  MetricBucket& b = level[i];
+  const double ax = i ? level[i - 1].rep_x : b.x0;
+  const double ay = i ? level[i - 1].rep_y : b.mean;
+  const bool max_wins = area2(ax, ay, b.x_max, b.max, b.x, b.mean) >
+                        area2(ax, ay, b.x_min, b.min, b.x, b.mean);
+  b.rep_x = max_wins ? b.x_max : b.x_min;
+  b.rep_y = max_wins ? b.max : b.min;
+}
+
+MetricBucket merge(const MetricBucket& a, const MetricBucket& b) {
+  MetricBucket m;
+  m.n = a.n + b.n;
+  const double wa = double(a.n) / m.n, wb = double(b.n) / m.n;
+  m.x = a.x * wa + b.x * wb;
+  m.mean = a.mean * wa + b.mean * wb;
+  const bool a_min = a.min <= b.min, a_max = a.max >= b.max;
+  m.min = a_min ? a.min : b.min;
+  m.x_min = a_min ? a.x_min : b.x_min;
+  m.max = a_max ? a.max : b.max;
+  m.x_max = a_max ? a.x_max : b.x_max;
+  m.x0 = a.x0;
+  m.x1 = b.x1;
+  return m;
+}
+
+} // namespace
+
+MetricSummary::MetricSummary(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(4, capacity + capacity % 2)) {
+  level_at(0);
+}
+
+std::vector<MetricBucket>& MetricSummary::level_at(int k) {
+  if (k == levels())
+    levels_.emplace_back().reserve(std::max<std::size_t>(capacity_ >> k, 1));
+  return levels_[k];
+}
+
+void MetricSummary::add(double x, double y) {
+  std::vector<MetricBucket>& l0 = levels_[0];
+  if (!open_) {
+    if (l0.size() == capacity_) {
+      compact();
+      add(x, y);
+      return;
+    }
+    l0.push_back(MetricBucket{x, y, y, y, x, x, x, y, x, x, 0});
+    open_ = true;
+  }
+  // Running means; extremes keep their first occurrence.
+  MetricBucket& b = l0.back();
+  ++b.n;
+  b.x += (x - b.x) / b.n;
+  b.mean += (y - b.mean) / b.n;
+  if (y < b.min) {
+    b.min = y;
+    b.x_min = x;
+  }
+  if (y > b.max) {
+    b.max = y;
+    b.x_max = x;
+  }
+  b.x1 = x;
+  pick_rep(l0, l0.size() - 1);
+  ++count_;
+  if (b.n == width_) {
+    open_ = false;
+    closed(0);
+  }
+}
+
+void MetricSummary::closed(int k) {
+  const std::size_t i = levels_[k].size() - 1;
+  if (i % 2 == 0)
+    return; // waits for its pair
+  const MetricBucket m = merge(levels_[k][i - 1], levels_[k][i]);
+  std::vector<MetricBucket>& up = level_at(k + 1);
+  up.push_back(m);
+  pick_rep(up, up.size() - 1);
+  closed(k + 1);
+}
+
+// Level 0 is full and closed, so level 1 is exactly its pairs: the same
+// buckets and representatives compacting would produce.
+void MetricSummary::compact() {
+  levels_.erase(levels_.begin());
+  levels_[0].reserve(capacity_);
+  width_ *= 2;
+}
+
+MetricSummary::View MetricSummary::view(double x0, double x1,
+                                        int max_points) const {
+  View v;
+  for (int k = 0; k < levels(); ++k) {
+    const std::vector<MetricBucket>& l = levels_[k];
+    if (l.empty())
+      break;
+    auto lo = std::lower_bound(
+        l.begin(), l.end(), x0,
+        [](const MetricBucket& b, double x) { return b.x1 < x; });
+    auto hi = std::upper_bound(
+        lo, l.end(), x1,
+        [](double x, const MetricBucket& b) { return x < b.x0; });
+    if (lo != l.begin())
+      --lo;
+    if (hi != l.end())
+      ++hi;
+    v.data = &*lo;
+    v.count = static_cast<int>(hi - lo);
+    v.level = k;
+    if (v.count <= max_points + 2)
+      break;
+  }
+  return v;
+}
+
+double MetricSummary::min_x() const {
+  return empty() ? 0.0 : levels_[0].front().x0;
+}
+
+double MetricSummary::max_x() const {
+  return empty() ? 0.0 : levels_[0].back().x1;
+}
+
+std::size_t MetricSummary::memory_bytes() const {
+  std::size_t bytes = sizeof(*this);
+  for (const std::vector<MetricBucket>& l : levels_)
+    bytes += l.capacity() * sizeof(MetricBucket) + sizeof(l);
+  return bytes;
+}
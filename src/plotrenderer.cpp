@@ -34,11 +34,17 @@ void PlotRenderer::render_plot_imgui() {
   ImGui::Begin("Plot");
   ImGui::SetWindowSize(ImVec2(800, 600));
 
+  if (progress >= 0.0) {
+    char overlay[32];
+    snprintf(overlay, sizeof(overlay), "Running... %.0f%%", progress * 100.0);
+    ImGui::ProgressBar(static_cast<float>(progress), ImVec2(780, 0), overlay);
+  }
+
   if (plot_data.empty()) {
     ImGui::Text("No data yet...");
   } else {
     if (!ImPlot::BeginPlot(("Metrics " + plot_title).c_str(),
-                           ImVec2(780, 550))) {
+                           ImVec2(780, progress >= 0.0 ? 525 : 550))) {
 
       ImPlot::EndPlot();
       return;
@@ -46,26 +52,38 @@ void PlotRenderer::render_plot_imgui() {
 
     ImPlot::SetupAxes("Time (s)", "");
     ImPlot::SetupAxis(ImAxis_Y2, "W'bal", ImPlotAxisFlags_AuxDefault);
+    // Follows the data while it grows; the user's zoom once it is complete.
+    ImPlot::SetupAxisLimits(ImAxis_X1, plot_data.front().summary.min_x(),
+                            plot_data.front().summary.max_x(),
+                            progress >= 0.0 || refit ? ImPlotCond_Always
+                                                     : ImPlotCond_Once);
+    refit = false;
+
+    // Each series at the resolution of the visible range: buckets straight
+    // from the summary, strided — the min/max band behind the line through
+    // the buckets' representatives.
+    const ImPlotRect limits = ImPlot::GetPlotLimits();
+    const int pixels = static_cast<int>(ImPlot::GetPlotSize().x);
+    constexpr int stride = sizeof(MetricBucket);
 
     for (const auto& series : plot_data) {
 
-      if (series.samples.empty())
+      if (series.summary.empty())
         continue;
 
-      std::vector<double> xs;
-      std::vector<double> ys;
-      xs.reserve(series.samples.size());
-      ys.reserve(series.samples.size());
-
-      for (const auto& s : series.samples) {
-        xs.push_back(s.x);
-        ys.push_back(s.y);
-      }
+      const MetricSummary::View v =
+          series.summary.view(limits.X.Min, limits.X.Max, pixels);
+      const MetricBucket& b = v.data[0];
 
       ImPlot::SetAxis(series.y_axis == 1 ? ImAxis_Y2 : ImAxis_Y1);
 
-      ImPlot::PlotLine(series.label.c_str(), xs.data(), ys.data(),
-                       static_cast<int>(xs.size()));
+      if (series.summary.bucket_width() > 1 || v.level > 0) {
+        ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.25f);
+        ImPlot::PlotShaded(series.label.c_str(), &b.x, &b.min, &b.max,
+                           v.count, 0, 0, stride);
+      }
+      ImPlot::PlotLine(series.label.c_str(), &b.rep_x, &b.rep_y, v.count, 0,
+                       0, stride);
     }
     ImPlot::EndPlot();
   }
@@ -86,3 +104,8 @@ void PlotRenderer::set_data(PlotResult result) {
   plot_title = result.title;
   plot_data = std::move(result.series);
 }
+
+void PlotRenderer::set_progress(double p) {
+  refit = refit || (progress >= 0.0 && p < 0.0);
+  progress = p;
+}
@@ -1,9 +1,11 @@
 #include "plotting.h"
+#include "results_channel.h"
 #include "sim.h"
 
 PlotResult run_plot_simulation(const Course& course,
                                const std::vector<RiderConfig>& riders,
-                               int rider_id) {
+                               int rider_id,
+                               ResultsChannel<PlotResult>* channel) {
   auto sim = std::make_unique<Simulation>(&course);
 
   sim->set_dt(0.1);
@@ -24,50 +26,66 @@ PlotResult run_plot_simulation(const Course& course,
 
   OfflineSimulationRunner runner(std::move(sim));
 
-  MetricObserver effort_obs([rider_id](const Simulation& s) {
+  MetricSummaryObserver effort_obs([rider_id](const Simulation& s) {
     const Rider* r = s.get_engine()->get_rider_by_id(rider_id);
     return r ? r->get_target_effort() : 0.0;
   });
 
-  MetricObserver effortlimit_obs([rider_id](const Simulation& s) {
+  MetricSummaryObserver effortlimit_obs([rider_id](const Simulation& s) {
     const Rider* r = s.get_engine()->get_rider_by_id(rider_id);
     return r ? r->get_effort_limit() : 0.0;
   });
 
-  MetricObserver speed_obs([rider_id](const Simulation& s) {
+  MetricSummaryObserver speed_obs([rider_id](const Simulation& s) {
     const Rider* r = s.get_engine()->get_rider_by_id(rider_id);
     return r ? r->get_speed() * 3.6 : 0.0;
   });
 
-  MetricObserver wbal_fraction_obs([rider_id](const Simulation& sim) {
+  MetricSummaryObserver wbal_fraction_obs([rider_id](const Simulation& sim) {
     const Rider* r = sim.get_engine()->get_rider_by_id(rider_id);
     return r ? r->get_energy_fraction() : 0.0;
   });
 
-  runner.add_observer(&effort_obs);
-  runner.add_observer(&effortlimit_obs);
-  runner.add_observer(&wbal_fraction_obs);
-  runner.add_observer(&speed_obs);
-  runner.set_end_condition(std::make_unique<FinishLineCondition>());
-  runner.run();
+  // The series as they stand: summaries are fixed-size, so a copy is cheap.
+  auto collect = [&]() {
+    PlotResult result;
+
+    result.title = rider_name;
 
-  PlotResult result;
+    result.series.push_back({.label = "Effort limit (%)",
+                             .summary = effortlimit_obs.summary(),
+                             .y_axis = 0});
 
-  result.title = rider_name;
+    result.series.push_back({.label = "Target effort (%)",
+                             .summary = effort_obs.summary(),
+                             .y_axis = 0});
 
-  result.series.push_back({.label = "Effort limit (%)",
-                           .samples = effortlimit_obs.data(),
-                           .y_axis = 0});
+    result.series.push_back({.label = "Speed (km/h)",
+                             .summary = speed_obs.summary(),
+                             .y_axis = 0});
 
-  result.series.push_back({.label = "Target effort (%)",
-                           .samples = effort_obs.data(),
-                           .y_axis = 0});
+    result.series.push_back({.label = "W'bal (%)",
+                             .summary = wbal_fraction_obs.summary(),
+                             .y_axis = 1});
+    return result;
+  };
 
-  result.series.push_back(
-      {.label = "Speed (km/h)", .samples = speed_obs.data(), .y_axis = 0});
+  ProgressObserver progress_obs(
+      [&](const Simulation&, double progress) {
+        channel->publish(collect(), progress);
+      },
+      {}, channel ? channel->publish_interval() : 0.25);
 
-  result.series.push_back(
-      {.label = "W'bal (%)", .samples = wbal_fraction_obs.data(), .y_axis = 1});
+  runner.add_observer(&effort_obs);
+  runner.add_observer(&effortlimit_obs);
+  runner.add_observer(&wbal_fraction_obs);
+  runner.add_observer(&speed_obs);
+  if (channel) {
+    runner.add_observer(&progress_obs);
+    runner.set_cancel_flag(channel->cancel_flag());
+  }
+  runner.set_end_condition(std::make_unique<FinishLineCondition>());
+  runner.run();
 
-  return result;
+  return collect();
 }
@@ -1,4 +1,6 @@
 #include "race_clock.h"
+#include "checkpoint.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -15,7 +17,18 @@ RaceClock::RaceClock(double course_length, std::vector<Checkpoint> checkpoints,
     : spacing_(grid_spacing), course_len_(course_length),
       checkpoints_(std::move(checkpoints)) {}
 
-void RaceClock::reset() { traces_.clear(); }
+void RaceClock::reset() {
+  traces_.clear();
+  grid_t_.clear();
+  cp_t_.clear();
+}
+
+size_t RaceClock::add_row() {
+  const size_t row = grid_t_.size() / grid_n();
+  grid_t_.resize(grid_t_.size() + grid_n(), kUnset);
+  cp_t_.resize(cp_t_.size() + checkpoints_.size(), kUnset);
+  return row;
+}
 
 void RaceClock::record(RiderId id, double pos, double t) {
   auto [it, inserted] = traces_.try_emplace(id);
@@ -24,8 +37,7 @@ void RaceClock::record(RiderId id, double pos, double t) {
   if (inserted) {
     tr.anchor_pos = tr.latest_pos = pos;
     tr.anchor_t = tr.latest_t = t;
-    tr.grid_t.assign(static_cast<size_t>(course_len_ / spacing_) + 2, kUnset);
-    tr.cp_t.assign(checkpoints_.size(), kUnset);
+    tr.row = add_row();
     // Checkpoints already behind the spawn position stay uncrossed.
     while (tr.next_cp < checkpoints_.size() &&
            checkpoints_[tr.next_cp].pos <= pos)
@@ -39,18 +51,23 @@ void RaceClock::record(RiderId id, double pos, double t) {
 
   const double p0 = tr.latest_pos;
   const double t0 = tr.latest_t;
+  const size_t n = grid_n();
 
   // Gridlines strictly above the previous sample, up to (and including) pos.
+  double* grid_t = nullptr;
   for (size_t i = static_cast<size_t>(std::floor(p0 / spacing_)) + 1;
-       i < tr.grid_t.size() && static_cast<double>(i) * spacing_ <= pos; ++i)
-    tr.grid_t[i] = lerp_t(p0, t0, pos, t, static_cast<double>(i) * spacing_);
+       i < n && static_cast<double>(i) * spacing_ <= pos; ++i) {
+    if (!grid_t)
+      grid_t = grid_row(tr);
+    grid_t[i] = lerp_t(p0, t0, pos, t, static_cast<double>(i) * spacing_);
+  }
 
   // Checkpoints crossed this step: exact capture, once each.
   while (tr.next_cp < checkpoints_.size() &&
          checkpoints_[tr.next_cp].pos <= pos) {
     const double x = checkpoints_[tr.next_cp].pos;
     if (x > p0)
-      tr.cp_t[tr.next_cp] = lerp_t(p0, t0, pos, t, x);
+      cp_row(tr)[tr.next_cp] = lerp_t(p0, t0, pos, t, x);
     ++tr.next_cp;
   }
 
@@ -72,17 +89,19 @@ std::optional<double> RaceClock::crossing_time(RiderId id, double pos) const {
   // Every gridline in (anchor, latest] is recorded, so the nearest known
   // points bracketing pos are its cell's gridlines — or the trace endpoints
   // where the cell sticks out past them.
+  const double* grid_t = grid_row(tr);
+  const size_t n = grid_n();
   const size_t lo_i = static_cast<size_t>(std::floor(pos / spacing_));
   double lo_pos = tr.anchor_pos, lo_t = tr.anchor_t;
-  if (lo_i < tr.grid_t.size() && !std::isnan(tr.grid_t[lo_i])) {
+  if (lo_i < n && !std::isnan(grid_t[lo_i])) {
     lo_pos = static_cast<double>(lo_i) * spacing_;
-    lo_t = tr.grid_t[lo_i];
+    lo_t = grid_t[lo_i];
   }
   const size_t hi_i = lo_i + 1;
   double hi_pos = tr.latest_pos, hi_t = tr.latest_t;
-  if (hi_i < tr.grid_t.size() && !std::isnan(tr.grid_t[hi_i])) {
+  if (hi_i < n && !std::isnan(grid_t[hi_i])) {
     hi_pos = static_cast<double>(hi_i) * spacing_;
-    hi_t = tr.grid_t[hi_i];
+    hi_t = grid_t[hi_i];
   }
 
   if (hi_pos <= lo_pos)
@@ -100,8 +119,63 @@ std::optional<double> RaceClock::time_gap(RiderId ahead, double behind_pos,
 
 std::optional<double> RaceClock::checkpoint_time(RiderId id, size_t k) const {
   auto it = traces_.find(id);
-  if (it == traces_.end() || k >= it->second.cp_t.size() ||
-      std::isnan(it->second.cp_t[k]))
+  if (it == traces_.end() || k >= checkpoints_.size())
+    return std::nullopt;
+  const double t = cp_row(it->second)[k];
+  if (std::isnan(t))
     return std::nullopt;
-  return it->second.cp_t[k];
+  return t;
+}
+
+void RaceClock::save_state(CheckpointWriter& w) const {
+  std::vector<RiderId> ids;
+  ids.reserve(traces_.size());
+  for (const auto& [id, tr] : traces_)
+    ids.push_back(id);
+  std::sort(ids.begin(), ids.end());
+
+  w.pod(static_cast<std::uint64_t>(ids.size()));
+  for (RiderId id : ids) {
+    const Trace& tr = traces_.at(id);
+    w.pod(id);
+    w.pod(tr.anchor_pos);
+    w.pod(tr.anchor_t);
+    w.pod(tr.latest_pos);
+    w.pod(tr.latest_t);
+    w.pods(grid_row(tr), grid_n());
+    w.pods(cp_row(tr), checkpoints_.size());
+    w.pod(static_cast<std::uint64_t>(tr.next_cp));
+  }
+}
+
+bool RaceClock::load_state(CheckpointReader& r) {
+  reset();
+  std::uint64_t n = 0;
+  if (!r.count(n, sizeof(RiderId) + 4 * sizeof(double)))
+    return false;
+  std::vector<double> grid_t, cp_t;
+  for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+    RiderId id = -1;
+    std::uint64_t next_cp = 0;
+    r.pod(id);
+    auto [it, inserted] = traces_.try_emplace(id);
+    if (!inserted)
+      return r.fail("race clock trace repeated");
+    Trace& tr = it->second;
+    r.pod(tr.anchor_pos);
+    r.pod(tr.anchor_t);
+    r.pod(tr.latest_pos);
+    r.pod(tr.latest_t);
+    r.pods(grid_t);
+    r.pods(cp_t);
+    r.pod(next_cp);
+    tr.next_cp = static_cast<size_t>(next_cp);
+    if (grid_t.size() != grid_n() || cp_t.size() != checkpoints_.size() ||
+        tr.next_cp > cp_t.size())
+      return r.fail("race clock trace does not match the course");
+    tr.row = add_row();
+    std::copy(grid_t.begin(), grid_t.end(), grid_row(tr));
+    std::copy(cp_t.begin(), cp_t.end(), cp_row(tr));
+  }
+  return r.ok();
 }
@@ -1,8 +1,9 @@
 // src/realtime_runner.cpp
 #include "realtime_runner.h"
 #include "sim.h"
-#include <SDL3/SDL_log.h>
+#include "sim_log.h"
 #include <chrono>
+#include <cmath>
 
 RealtimeSimRunner::RealtimeSimRunner(Simulation* sim) : sim(sim) {}
 
@@ -13,6 +14,7 @@ void RealtimeSimRunner::start() {
     return; // already running
 
   paused = false;
+  rewind_target_ = std::numeric_limits<double>::quiet_NaN();
   physics_error = false;
   physics_error_message.clear();
 
@@ -40,12 +42,41 @@ bool RealtimeSimRunner::is_paused() const { return paused; }
 
 void RealtimeSimRunner::toggle_pause() { paused = !paused; }
 
+void RealtimeSimRunner::rewind_to(double sim_time) {
+  rewind_target_ = sim_time;
+}
+
+void RealtimeSimRunner::enable_keyframes(const KeyframeParams& params) {
+  if (keyframes_)
+    keyframes_->clear(*sim);
+  keyframes_ = std::make_unique<KeyframeRing>(params);
+}
+
+double RealtimeSimRunner::get_rewind_limit() const {
+  return keyframes_ ? keyframes_->earliest() : -1.0;
+}
+
 void RealtimeSimRunner::loop() {
   double accumulator = 0.0;
 
   auto t_prev = std::chrono::steady_clock::now();
 
   while (running) {
+    const double rewind =
+        rewind_target_.exchange(std::numeric_limits<double>::quiet_NaN());
+    if (!std::isnan(rewind) && keyframes_) {
+      try {
+        keyframes_->rewind(*sim, rewind);
+      } catch (const std::exception& e) {
+        physics_error_message = e.what();
+        physics_error = true;
+        running = false;
+      }
+      // The re-simulation is not owed to the pacing.
+      accumulator = 0.0;
+      t_prev = std::chrono::steady_clock::now();
+    }
+
     if (paused) {
       t_prev = std::chrono::steady_clock::now();
       std::this_thread::sleep_for(std::chrono::milliseconds(1));
@@ -58,7 +89,7 @@ void RealtimeSimRunner::loop() {
 
     accumulator += frame_time * sim->get_time_factor();
     if (accumulator > 0.25) {
-      SDL_Log("accumulator %f > 0.25 s. Setting to 0.25s.", accumulator);
+      sim_log("accumulator %f > 0.25 s. Setting to 0.25s.", accumulator);
       accumulator = 0.25;
     }
 
@@ -75,13 +106,15 @@ void RealtimeSimRunner::loop() {
         running = false;
       }
       accumulator -= dt;
+      if (keyframes_)
+        keyframes_->on_step(*sim);
 
       // what follows is only to check for exceeding the time
       auto step_end = std::chrono::steady_clock::now();
       double step_time =
           std::chrono::duration<double>(step_end - step_start).count();
       if (step_time > dt) {
-        SDL_Log("Hey! engine.update(dt=%f) took %f. spiral of death!", dt,
+        sim_log("Hey! engine.update(dt=%f) took %f. spiral of death!", dt,
                 step_time);
       }
     }
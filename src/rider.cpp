@@ -1,7 +1,9 @@
 #include "rider.h"
-#include "SDL3/SDL_log.h"
+#include "sim_log.h"
+#include "checkpoint.h"
 #include "course.h"
 #include <cmath>
+#include <cstddef>
 
 #include "sim_core.h"
 
@@ -15,6 +17,12 @@ static constexpr double kYawDragGain = 1.0;   // k_yaw in CdA_ratio
 static constexpr double kMinApparentLon = 1.0; // m/s floor on |u|
 static constexpr double kYawFactorCap = 3.0;
 
+// Environment constants: the same for every rider, so a batch shares them.
+static constexpr double kAirDensity = 1.2234; // kg/m^3
+static constexpr double kGravity = 9.80665;   // m/s^2
+static constexpr double kBearingC0 = 0.091;
+static constexpr double kBearingC1 = 0.0087;
+
 Bike::Bike(double mass_, double wheel_i_, double wheel_r_, double wheelbase_,
            double wheel_drag_factor_, double crr_, double dt_loss_,
            BikeType type_)
@@ -52,7 +60,7 @@ Rider::Rider(RiderConfig config_)
   p.oxy_p50 = config_.oxy_p50;
 
   // lat_pos = (std::rand() % 100 - 50.0) / 200.0;
-  // SDL_Log("%.2f", lat_pos);
+  // sim_log("%.2f", lat_pos);
 
   rider_state_init(&state, &p);
   // All riders use the SIM_SOLVER_ACCEL_FORCE default set by
@@ -73,10 +81,33 @@ RiderConfig Rider::default_config(TeamId team_id) {
           24000, Bike::create_road(), team_id};
 }
 
-void Rider::set_course(const ICourseView* cv) { course = cv; }
+void Rider::set_course(const ICourseView* cv) {
+  course = cv;
+  course_cursor_ = SegmentCursor{};
+  alt_cache_ = AltitudeFactorCache{};
+}
+
+double Rider::altitude_factor(const CourseSample& cs) {
+  if (cs.segment < 0)
+    return altitude_ftp_factor(cs.altitude, state.oxy_p50, &state);
+  AltitudeFactorCache& c = alt_cache_;
+  if (c.segment != cs.segment) {
+    c.segment = cs.segment;
+    c.alt0 = cs.seg_alt0;
+    c.alt1 = cs.seg_alt1;
+    c.f0 = altitude_ftp_factor(c.alt0, state.oxy_p50, &state);
+    c.f1 = c.alt1 == c.alt0 ? c.f0
+                            : altitude_ftp_factor(c.alt1, state.oxy_p50, &state);
+  }
+  if (c.alt1 == c.alt0)
+    return c.f0; // flat: exact
+  return c.f0 + (c.f1 - c.f0) * ((cs.altitude - c.alt0) / (c.alt1 - c.alt0));
+}
 
 void Rider::reset() {
   rider_reset(&state);
+  ++state_epoch_;
+  course_cursor_ = SegmentCursor{};
   draft_factor_ = 1.0;
   yaw_factor_ = 1.0;
   state.cda_factor = 1.0; // not covered by rider_reset
@@ -85,26 +116,23 @@ void Rider::reset() {
   lat_target = std::nullopt;
 }
 
-void Rider::update(double dt) {
-  if (!course)
-    return;
+void Rider::prepare_env() {
+  env.rho = kAirDensity;
+  env.g = kGravity;
 
-  env.rho = 1.2234;
-  env.g = 9.80665;
-
-  env.slope = course->get_slope(state.pos);
-  env.crr = course->get_crr(state.pos);
+  const CourseSample cs = sample_course();
+  env.slope = cs.slope;
+  env.crr = cs.crr;
   state.slope = env.slope;
 
-  heading = course->get_heading(state.pos);
-  auto [wind_dir, wind_speed] = course->get_wind(state.pos);
-  env.headwind = wind_speed * std::cos(wind_dir - heading);
+  heading = cs.heading;
+  env.headwind = cs.headwind;
 
   // B2: crosswind costs energy through yaw-dependent longitudinal drag.  The
   // core's drag term is 1/2 rho CdA cda_factor v_air |v_air|, so scaling
   // cda_factor by yaw_factor_ = CdA_ratio(yaw) V_a / |u| reproduces the
   // target force 1/2 rho CdA CdA_ratio V_a u exactly, signs included.
-  const double c = wind_speed * std::sin(wind_dir - heading);
+  const double c = cs.crosswind;
   if (c == 0.0) {
     // Exact by definition: pure longitudinal wind is fully carried by
     // env.headwind (and V_a = |u| would only misbehave under the |u| floor).
@@ -119,23 +147,106 @@ void Rider::update(double dt) {
   }
   state.cda_factor = draft_factor_ * yaw_factor_;
 
-  double altitude = course->get_altitude(state.pos);
-  env.altitude = altitude;
+  env.altitude = cs.altitude;
+
+  // Position-only terms come baked (course.h); the core skips its libm.
+  env.baked = SIM_ENV_GRAV_SIN | SIM_ENV_ALT_FACTOR;
+  env.grav_sin = cs.grav_sin;
+  env.alt_factor = altitude_factor(cs);
+
+  env.bearing_c0 = kBearingC0;
+  env.bearing_c1 = kBearingC1;
+}
 
-  env.bearing_c0 = 0.091;
-  env.bearing_c1 = 0.0087;
+void Rider::update(double dt) {
+  if (!course)
+    return;
+
+  prepare_env();
 
   /* --- step physics in C --- */
   StepDiagnostics diag{};
   sim_step_rider(&state, &env, dt, &diag);
 
   if ((state.solver == SIM_SOLVER_POWER_BALANCE) && !diag.converged) {
-    SDL_Log("Rider %d: Newton did not converge (residual %.3f W)", id,
+    sim_log("Rider %d: Newton did not converge (residual %.3f W)", id,
             diag.residual_power);
   }
 
   /* --- sync UI-facing state --- */
-  _pos2d = Vector2d{state.pos, altitude};
+  _pos2d = Vector2d{state.pos, env.altitude};
+}
+
+bool Rider::load_batch(RiderBatch* b, EnvBatch* e, int slot,
+                       std::uint32_t& loaded_epoch) {
+  if (!course || state.solver != SIM_SOLVER_ACCEL_FORCE) {
+    loaded_epoch = 0;
+    return false;
+  }
+  prepare_env();
+  if (loaded_epoch == state_epoch_) {
+    rider_batch_load_inputs(b, slot, &state);
+  } else {
+    rider_batch_load(b, slot, &state);
+    loaded_epoch = state_epoch_;
+  }
+  env_batch_set_slot(e, slot, &env);
+  return true;
+}
+
+void Rider::store_batch(const RiderBatch* b, int slot) {
+  rider_batch_store(b, slot, &state);
+  _pos2d = Vector2d{state.pos, env.altitude};
+}
+
+void Rider::set_batch_env(EnvBatch* e) {
+  e->rho = kAirDensity;
+  e->g = kGravity;
+  e->bearing_c0 = kBearingC0;
+  e->bearing_c1 = kBearingC1;
+  e->baked = SIM_ENV_GRAV_SIN | SIM_ENV_ALT_FACTOR;
+}
+
+void Rider::save_state(CheckpointWriter& w) const {
+  w.pod_padded(state, offsetof(RiderState, solver) + sizeof(state.solver),
+               sizeof(RiderState));
+  w.pod_padded(env, offsetof(EnvState, baked) + sizeof(env.baked),
+               offsetof(EnvState, grav_sin));
+  w.pod(group_id);
+  w.pod(group_role);
+  w.pod(heading);
+  w.pod(draft_factor_);
+  w.pod(yaw_factor_);
+  w.pod(_pos2d.x());
+  w.pod(_pos2d.y());
+  w.pod(lat_pos);
+  w.pod(lat_vel);
+  w.pod(lat_target.has_value());
+  w.pod(lat_target.value_or(0.0));
+}
+
+bool Rider::load_state(CheckpointReader& r) {
+  double x = 0.0, y = 0.0, target = 0.0;
+  bool has_target = false;
+  r.pod(state);
+  r.pod(env);
+  r.pod(group_id);
+  r.pod(group_role);
+  r.pod(heading);
+  r.pod(draft_factor_);
+  r.pod(yaw_factor_);
+  r.pod(x);
+  r.pod(y);
+  r.pod(lat_pos);
+  r.pod(lat_vel);
+  r.pod(has_target);
+  r.pod(target);
+  _pos2d = Vector2d{x, y};
+  lat_target = has_target ? std::optional<double>(target) : std::nullopt;
+  course_cursor_ = SegmentCursor{};
+  alt_cache_ = AltitudeFactorCache{};
+  ++state_epoch_;
+  return r.ok();
 }
 
 void Rider::apply_lateral_update(double new_lat_pos, double new_lat_vel,
@@ -164,8 +275,8 @@ RiderSnapshot Rider::snapshot() const {
       .group_role = this->group_role,
       // Stamped by Simulation at snapshot time; the engine doesn't know.
       .effort_source = EffortSource::Manual,
-      .policy = {},
-      .name = this->name,
+      .policy = kNoString,
+      .name = this->name_id_,
       .max_effort = this->state.max_effort,
       .pos = this->state.pos,
       .slope = this->state.slope,
@@ -177,7 +288,7 @@ RiderSnapshot Rider::snapshot() const {
       .cda_factor = this->get_cda_factor(),
       .yaw_factor = this->yaw_factor_,
       .lat_pos = this->lat_pos,
-      .pos2d = this->_pos2d,
+      .altitude = this->_pos2d.y(),
       .team_id = this->config.team_id,
       .visual_type = this->bike.type,
   };
@@ -193,6 +304,7 @@ double Rider::cruise_speed_at(double power, double slope, double headwind,
   EnvState e = env;
   s.cda_factor = cda_factor;
   e.slope = slope;
+  e.baked &= ~SIM_ENV_GRAV_SIN; // baked for the rider's own slope only
   e.headwind = headwind;
   return sim_cruise_speed(&s, &e, power);
 }
@@ -203,6 +315,7 @@ double Rider::cruise_power_at(double v, double slope, double headwind,
   EnvState e = env;
   s.cda_factor = cda_factor;
   e.slope = slope;
+  e.baked &= ~SIM_ENV_GRAV_SIN; // baked for the rider's own slope only
   e.headwind = headwind;
   return sim_cruise_power(&s, &e, v);
 }
@@ -1,4 +1,5 @@
 #include "rotation.h"
+#include "checkpoint.h"
 #include <algorithm>
 #include <cmath>
 
@@ -115,6 +116,13 @@ double& PacelineRotation::detach_timer(RiderId id) {
 
 std::vector<RotationDirective>
 PacelineRotation::tick(double dt, const std::vector<RotationInput>& in) {
+  std::vector<RotationDirective> out;
+  tick(dt, in, out);
+  return out;
+}
+
+void PacelineRotation::tick(double dt, const std::vector<RotationInput>& in,
+                            std::vector<RotationDirective>& out) {
   removed_.clear();
   prune_missing(inline_, in);
   prune_missing(drifting_, in);
@@ -228,7 +236,8 @@ PacelineRotation::tick(double dt, const std::vector<RotationInput>& in) {
   // negative by construction while merging; a blown drifter attaches
   // positionally first and is then caught by this rule as an InLine member.
   {
-    std::vector<std::pair<RiderId, RiderId>> pairs; // (member, ahead)
+    auto& pairs = detach_pairs_; // (member, ahead)
+    pairs.clear();
     for (size_t i = 1; i < inline_.size(); ++i)
       pairs.emplace_back(inline_[i], inline_[i - 1]);
     if (!sitting_.empty() && !inline_.empty()) {
@@ -288,7 +297,7 @@ PacelineRotation::tick(double dt, const std::vector<RotationInput>& in) {
   }
 
   // --- 4. Directives ---
-  std::vector<RotationDirective> out;
+  out.clear();
   out.reserve(inline_.size() + drifting_.size() + sitting_.size() +
               promoting_.size() + joining_.size());
   for (size_t i = 0; i < inline_.size(); ++i) {
@@ -350,5 +359,40 @@ PacelineRotation::tick(double dt, const std::vector<RotationInput>& in) {
     }
     out.push_back(d);
   }
-  return out;
+}
+
+void PacelineRotation::save_state(CheckpointWriter& w) const {
+  w.pod(params_);
+  w.pods(inline_);
+  w.pods(drifting_);
+  w.pods(sitting_);
+  w.pods(promoting_);
+  w.pods(joining_);
+  w.pod(static_cast<std::uint64_t>(detach_timers_.size()));
+  for (const auto& [id, t] : detach_timers_) {
+    w.pod(id);
+    w.pod(t);
+  }
+  w.pod(pull_timer_);
+  w.pods(removed_);
+}
+
+bool PacelineRotation::load_state(CheckpointReader& r) {
+  r.pod(params_);
+  r.pods(inline_);
+  r.pods(drifting_);
+  r.pods(sitting_);
+  r.pods(promoting_);
+  r.pods(joining_);
+  std::uint64_t n = 0;
+  if (!r.count(n, sizeof(RiderId) + sizeof(double)))
+    return false;
+  detach_timers_.resize(n);
+  for (auto& [id, t] : detach_timers_) {
+    r.pod(id);
+    r.pod(t);
+  }
+  r.pod(pull_timer_);
+  r.pods(removed_);
+  return r.ok();
 }
@@ -0,0 +1,277 @@
+#include "scenario.h"
+#include "sim.h"
+#include "sim_log.h"
+#include "timetrial.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// The app's rider defaults (AppState): everything a rider line may omit.
+RiderConfig default_rider(RiderId id, std::string name) {
+  return RiderConfig{id,  std::move(name), 300, 6,   2,     0.05,
+                     700, 3.5,             88,  0.5, 24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+bool parse_number(const std::string& s, double& out) {
+  std::istringstream is(s);
+  is >> out;
+  return !is.fail() && is.eof() && std::isfinite(out);
+}
+
+std::string trim(const std::string& s) {
+  const size_t a = s.find_first_not_of(" \t\r");
+  if (a == std::string::npos)
+    return {};
+  const size_t b = s.find_last_not_of(" \t\r");
+  return s.substr(a, b - a + 1);
+}
+
+// One `key=value` of a rider line.
+bool apply_rider_key(const ScenarioSpec& spec, const std::string& key,
+                     const std::string& value, RiderConfig& cfg,
+                     double& effort, double& start) {
+  if (key == "bike") {
+    if (value == "road")
+      cfg.bike = Bike::create_road();
+    else if (value == "tt")
+      cfg.bike = Bike::create_tt();
+    else
+      return false;
+    return true;
+  }
+  if (key == "team") {
+    auto it = std::find(spec.teams.begin(), spec.teams.end(), value);
+    if (it == spec.teams.end())
+      return false;
+    cfg.team_id = static_cast<TeamId>(it - spec.teams.begin());
+    return true;
+  }
+
+  double v;
+  if (!parse_number(value, v))
+    return false;
+  if (key == "ftp")
+    cfg.ftp_base = v;
+  else if (key == "mass")
+    cfg.mass = v;
+  else if (key == "cda")
+    cfg.cda = v;
+  else if (key == "w_prime")
+    cfg.w_prime_base = v;
+  else if (key == "max_effort")
+    cfg.max_effort = v;
+  else if (key == "degrade_threshold")
+    cfg.ftp_degrade_threshold = v;
+  else if (key == "degrade_rate")
+    cfg.ftp_degrade_rate = v;
+  else if (key == "max_drive_force")
+    cfg.max_drive_force = v;
+  else if (key == "oxy_p50")
+    cfg.oxy_p50 = v;
+  else if (key == "effort")
+    effort = v;
+  else if (key == "start")
+    start = v;
+  else
+    return false;
+  return true;
+}
+
+// The spec's segments or named course, before wind and checkpoints.
+Course base_course(const ScenarioSpec& s) {
+  return !s.segments.empty()         ? Course(s.segments, s.altitude)
+         : s.course == "flat"       ? Course::create_flat()
+         : s.course == "flat_short" ? Course::create_flat_short()
+                                    : Course::create_endulating();
+}
+
+} // namespace
+
+Course ScenarioSpec::make_course() const {
+  Course c = base_course(*this);
+  c.set_wind(wind);
+  const double length = c.get_total_length();
+  for (const Checkpoint& cp : checkpoints) {
+    if (cp.pos >= length) {
+      sim_log("make_course: checkpoint '%s' at %.1f m is not before the "
+              "finish (%.1f m), left out",
+              cp.label.c_str(), cp.pos, length);
+      continue;
+    }
+    c.add_checkpoint(cp.pos, cp.label);
+  }
+  return c;
+}
+
+std::unique_ptr<Simulation>
+ScenarioSpec::build(const Course& c,
+                    const std::vector<RiderConfig>& roster) const {
+  auto sim = std::make_unique<Simulation>(&c);
+  PhysicsEngine& eng = *sim->get_engine();
+  for (const std::string& team : teams)
+    eng.add_team(team);
+  sim->add_riders(roster);
+
+  for (const auto& [id, pos] : starts)
+    if (Rider* r = eng.get_riders().find(id))
+      r->set_start_pos(pos);
+
+  if (tt_gap > 0.0) {
+    setup_tt_schedules(sim.get(), roster, build_start_offsets(roster, tt_gap));
+    return sim;
+  }
+  for (const RiderConfig& cfg : roster) {
+    auto it = efforts.find(cfg.rider_id);
+    sim->set_rider_effort(cfg.rider_id, it == efforts.end() ? 1.0 : it->second);
+  }
+  return sim;
+}
+
+bool parse_scenario(std::istream& in, const std::string& source,
+                    ScenarioSpec& out) {
+  std::string raw;
+  int lineno = 0;
+  auto fail = [&](const char* what) {
+    sim_log("%s:%d: %s", source.c_str(), lineno, what);
+    return false;
+  };
+
+  while (std::getline(in, raw)) {
+    ++lineno;
+    const std::string line = trim(raw.substr(0, raw.find('#')));
+    if (line.empty())
+      continue;
+    std::istringstream is(line);
+    std::string word;
+    is >> word;
+
+    if (word == "course") {
+      is >> out.course;
+      if (out.course != "flat" && out.course != "flat_short" &&
+          out.course != "endulating")
+        return fail("unknown course (flat, flat_short, endulating)");
+    } else if (word == "segment") {
+      std::array<double, 5> s{};
+      for (double& v : s)
+        is >> v;
+      if (is.fail() || s[0] <= 0.0 || s[4] <= 0.0)
+        return fail("segment needs: length slope crr heading width");
+      out.segments.push_back(s);
+    } else if (word == "altitude") {
+      if (!(is >> out.altitude))
+        return fail("altitude needs a number");
+    } else if (word == "wind") {
+      if (!(is >> out.wind.heading >> out.wind.speed))
+        return fail("wind needs: heading speed");
+    } else if (word == "checkpoint") {
+      Checkpoint cp;
+      if (!(is >> cp.pos) || cp.pos <= 0.0)
+        return fail("checkpoint needs a position");
+      std::getline(is, cp.label);
+      cp.label = trim(cp.label);
+      if (cp.label.empty())
+        return fail("checkpoint needs a label");
+      out.checkpoints.push_back(cp);
+    } else if (word == "team") {
+      std::string name, extra;
+      if (!(is >> name) || is >> extra)
+        return fail("team needs a one-word name");
+      out.teams.push_back(name);
+    } else if (word == "rider") {
+      RiderId id;
+      std::string name;
+      if (!(is >> id >> name))
+        return fail("rider needs: id name [key=value ...]");
+      for (const RiderConfig& r : out.riders)
+        if (r.rider_id == id)
+          return fail("rider id repeated");
+      RiderConfig cfg = default_rider(id, name);
+      double effort = 1.0, start = 0.0;
+      std::string kv;
+      while (is >> kv) {
+        const size_t eq = kv.find('=');
+        if (eq == std::string::npos ||
+            !apply_rider_key(out, kv.substr(0, eq), kv.substr(eq + 1), cfg,
+                             effort, start))
+          return fail("bad rider key (or unknown team)");
+      }
+      out.riders.push_back(cfg);
+      out.efforts[id] = effort;
+      if (start != 0.0)
+        out.starts[id] = start;
+    } else if (word == "tt_gap") {
+      if (!(is >> out.tt_gap) || out.tt_gap < 0.0)
+        return fail("tt_gap needs a non-negative number");
+    } else if (word == "time_limit") {
+      if (!(is >> out.time_limit) || out.time_limit <= 0.0)
+        return fail("time_limit needs a positive number");
+    } else {
+      return fail("unknown directive");
+    }
+  }
+
+  if (out.riders.empty()) {
+    sim_log("%s: scenario has no riders", source.c_str());
+    return false;
+  }
+  // Checkpoints come before the finish; the course is only known now.
+  const double length = base_course(out).get_total_length();
+  for (const Checkpoint& cp : out.checkpoints)
+    if (cp.pos >= length) {
+      sim_log("%s: checkpoint '%s' at %.1f m is not before the finish "
+              "(%.1f m)",
+              source.c_str(), cp.label.c_str(), cp.pos, length);
+      return false;
+    }
+  return true;
+}
+
+bool load_scenario_file(const std::string& path, ScenarioSpec& out) {
+  std::ifstream in(path);
+  if (!in) {
+    sim_log("Cannot open scenario %s", path.c_str());
+    return false;
+  }
+  out.name = path;
+  return parse_scenario(in, path, out);
+}
+
+bool builtin_scenario(const std::string& name, ScenarioSpec& out) {
+  // AppState's race: riders 0-6 in a line 3 m apart, Luka 30 m back.
+  static const char* kDemo =
+      "course endulating\n"
+      "wind 1.0471975511965976 3.5\n"
+      "team Team1\n"
+      "rider 0 Pedro ftp=320 mass=90 team=Team1 start=48\n"
+      "rider 1 Power ftp=300 team=Team1 start=45\n"
+      "rider 2 AccelForce team=Team1 start=42\n"
+      "rider 3 AccelEnergy team=Team1 start=39\n"
+      "rider 4 Mario ftp=310 team=Team1 start=36\n"
+      "rider 5 Kojo ftp=320 team=Team1 start=33\n"
+      "rider 6 Hari ftp=400 team=Team1 start=30\n"
+      "rider 7 Luka ftp=320 team=Team1\n";
+  static const char* kTt =
+      "course flat\n"
+      "checkpoint 10000 10 km\n"
+      "checkpoint 20000 20 km\n"
+      "tt_gap 60\n"
+      "rider 0 Pedro ftp=320 mass=90 bike=tt\n"
+      "rider 1 Power ftp=300 bike=tt\n"
+      "rider 2 AccelForce bike=tt\n"
+      "rider 3 AccelEnergy bike=tt\n"
+      "rider 4 Mario ftp=310 bike=tt\n"
+      "rider 5 Kojo ftp=320 bike=tt\n"
+      "rider 6 Hari ftp=400 bike=tt\n"
+      "rider 7 Luka ftp=320 bike=tt\n";
+  const char* text = name == "demo" ? kDemo : name == "tt" ? kTt : nullptr;
+  if (!text)
+    return false;
+  std::istringstream in(text);
+  out.name = name;
+  return parse_scenario(in, name, out);
+}
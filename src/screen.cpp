@@ -14,6 +14,7 @@
 #include "snapshot.h"
 #include "ui_layout.h"
 #include "widget.h"
+#include <cmath>
 #include <memory>
 #include <vector>
 
@@ -33,7 +34,8 @@ void ResultsScreen::render() {
   SDL_RenderPresent(state->renderer);
 }
 
-SimulationScreen::SimulationScreen(AppState* s) : state(s) {
+SimulationScreen::SimulationScreen(AppState* s)
+    : state(s), controls(s->runner.get()) {
   Vector2d screensize = s->get_window_size();
   auto cam = std::make_shared<Camera>(s->course.get(), WORLD_WIDTH, screensize);
   sim_renderer = std::make_unique<SimulationRenderer>(
@@ -58,7 +60,7 @@ SimulationScreen::SimulationScreen(AppState* s) : state(s) {
 
   auto panel = std::make_unique<RiderPanel>(20, 120, default_font);
   rider_panel = panel.get(); // screen owns the reference
-  panel->add_effort_slider(s->runner.get());
+  panel->add_effort_slider(&controls);
 
   top_left->add(std::move(panel));
   ui->add(UIAnchor::TopLeft, 10, std::move(top_left));
@@ -71,7 +73,7 @@ SimulationScreen::SimulationScreen(AppState* s) : state(s) {
 
   ui->add(UIAnchor::TopCenter, 20,
           std::make_unique<TimeControlPanel>(400, 20, 40, default_font,
-                                             s->runner.get()));
+                                             &controls));
 
   auto bottom_right = std::make_unique<HStack>(8, 0, VAlign::Bottom);
   bottom_right->add(
@@ -92,6 +94,8 @@ SimulationScreen::SimulationScreen(AppState* s) : state(s) {
 
   ui->resolve(); // one call computes all positions
   sim_renderer->set_ui_root(std::move(ui));
+
+  set_replay(s->replay.get());
 }
 
 SimulationScreen::~SimulationScreen() = default;
@@ -115,6 +119,11 @@ void SimulationScreen::render() {
 
 void SimulationScreen::reset() { sim_renderer->reset(); }
 
+void SimulationScreen::set_replay(TraceReplay* replay) {
+  controls.set_replay(replay);
+  sim_renderer->set_replay(replay);
+}
+
 bool SimulationScreen::handle_event(const SDL_Event* e) {
   if (sim_renderer->handle_event(e))
     return true;
@@ -205,7 +214,8 @@ PlotScreen::PlotScreen(AppState* s) : state(s) {
       [this]() { state->runner->toggle_pause(); }));
 }
 
-PlotScreen::~PlotScreen() = default;
+// Stops the run: the future then waits for one step at most.
+PlotScreen::~PlotScreen() { channel.cancel(); }
 
 void PlotScreen::update() {
   if (!running && !result.has_value()) {
@@ -213,7 +223,14 @@ void PlotScreen::update() {
 
     future = std::async(std::launch::async, run_plot_simulation,
                         std::cref(*state->course),
-                        std::cref(state->rider_configs), target_id);
+                        std::cref(state->rider_configs), target_id, &channel);
+  }
+
+  // Partial series as the run goes
+  PlotResult partial;
+  if (running && channel.take(partial)) {
+    renderer->set_data(std::move(partial));
+    renderer->set_progress(channel.progress());
   }
 
   // Poll completion (non-blocking)
@@ -222,23 +239,20 @@ void PlotScreen::update() {
     result = future.get();
     running = false;
 
-    if (result.has_value())
+    if (result.has_value()) {
       renderer->set_data(*result);
+      renderer->set_progress(-1.0);
+    }
   }
 }
 
 void PlotScreen::render() { renderer->render_frame(); }
 
+// Leaving while the run goes cancels it (the destructor).
 bool PlotScreen::handle_event(const SDL_Event* e) {
   if (renderer->handle_event(e))
     return true;
 
-  // primitive but it prevents changing screen while sim is running
-  if (running) {
-    SDL_Log("can't change screen - sim is runnning.");
-    return true; // consume input
-  }
-
   if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_ESCAPE) {
     state->screens->replace(ScreenType::Simulation);
     return true;
@@ -344,15 +358,23 @@ static void log_results(const TimeTrialResult& r) {
 
 TimeTrialScreen::TimeTrialScreen(AppState* s) : state(s) {}
 
+// Stops the race: the future then waits for one step at most.
+TimeTrialScreen::~TimeTrialScreen() { channel.cancel(); }
+
 void TimeTrialScreen::update() {
   // Kick off the async run once
   if (!running && !result.has_value()) {
     running = true;
-    future = std::async(
-        std::launch::async, run_time_trial, std::cref(*state->course),
-        std::cref(state->rider_configs), 60.0 /* start gap seconds */);
+    future = std::async(std::launch::async, run_time_trial,
+                        std::cref(*state->course),
+                        std::cref(state->rider_configs),
+                        60.0 /* start gap seconds */, &channel);
   }
 
+  // The leaderboard so far, as the race runs
+  if (running)
+    channel.take(partial);
+
   // Poll for completion (non-blocking)
   if (running && future.wait_for(std::chrono::milliseconds(0)) ==
                      std::future_status::ready) {
@@ -363,19 +385,96 @@ void TimeTrialScreen::update() {
 }
 
 void TimeTrialScreen::render() {
-  // Placeholder — just clear the screen while running / after logging
   SDL_SetRenderDrawColor(state->renderer, 20, 20, 20, 255);
   SDL_RenderClear(state->renderer);
 
-  // TODO: replace with ImGui results table
+  ImGui_ImplSDLRenderer3_NewFrame();
+  ImGui_ImplSDL3_NewFrame();
+  ImGui::NewFrame();
+  render_leaderboard_imgui();
+  ImGui::Render();
+  ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), state->renderer);
+
+  SDL_RenderPresent(state->renderer);
 }
 
-bool TimeTrialScreen::handle_event(const SDL_Event* e) {
+// Splits per checkpoint, the distance reached since the last one, and the
+// gap to the fastest at the last checkpoint passed: live while the race
+// runs, final once it is done.
+void TimeTrialScreen::render_leaderboard_imgui() {
+  const TimeTrialResult& r = result ? *result : partial;
+  const int checkpoints = static_cast<int>(r.checkpoint_distances.size());
+
+  ImGui::Begin("Time trial");
+  ImGui::SetWindowSize(ImVec2(800, 600), ImGuiCond_Once);
+
   if (running) {
-    SDL_Log("Time trial running, please wait...");
-    return true;
+    char overlay[48];
+    snprintf(overlay, sizeof(overlay), "%s  (%.0f%%)",
+             fmt_time(r.sim_time).c_str(), channel.progress() * 100.0);
+    ImGui::ProgressBar(static_cast<float>(channel.progress()), ImVec2(-1, 0),
+                       overlay);
+  }
+
+  if (r.riders.empty()) {
+    ImGui::Text("Starting...");
+    ImGui::End();
+    return;
   }
 
+  std::vector<double> best(checkpoints, INFINITY);
+  for (const auto& rider : r.riders)
+    for (int k = 0; k < (int)rider.timeline.size() && k < checkpoints; ++k)
+      best[k] = std::min(best[k], rider.timeline[k].race_time);
+
+  if (ImGui::BeginTable("leaderboard", checkpoints + 3,
+                        ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+    ImGui::TableSetupColumn("Rank");
+    ImGui::TableSetupColumn("Name");
+    for (double d : r.checkpoint_distances) {
+      char col[16];
+      snprintf(col, sizeof(col), "%.1f km", d / 1000.0);
+      ImGui::TableSetupColumn(col);
+    }
+    ImGui::TableSetupColumn("Gap");
+    ImGui::TableHeadersRow();
+
+    for (int i = 0; i < (int)r.riders.size(); ++i) {
+      const auto& rider = r.riders[i];
+      const int passed = static_cast<int>(rider.timeline.size());
+
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%d", i + 1);
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(rider.name.c_str());
+
+      for (int k = 0; k < checkpoints; ++k) {
+        ImGui::TableNextColumn();
+        if (k < passed)
+          ImGui::TextUnformatted(fmt_time(rider.timeline[k].race_time).c_str());
+        else if (k == passed && rider.distance > 0.0)
+          ImGui::TextDisabled("%.2f km", rider.distance / 1000.0);
+      }
+
+      ImGui::TableNextColumn();
+      if (passed > 0 && passed <= checkpoints) {
+        const double gap = rider.timeline[passed - 1].race_time -
+                           best[passed - 1];
+        if (gap > 0.0)
+          ImGui::Text("+%.1fs", gap);
+        else
+          ImGui::TextUnformatted("-");
+      }
+    }
+    ImGui::EndTable();
+  }
+
+  ImGui::End();
+}
+
+// Leaving while the race runs cancels it (the destructor).
+bool TimeTrialScreen::handle_event(const SDL_Event* e) {
   if (e->type == SDL_EVENT_KEY_DOWN && e->key.key == SDLK_ESCAPE) {
     state->screens->replace(ScreenType::Simulation);
     return true;
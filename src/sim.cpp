@@ -1,6 +1,8 @@
 #include "sim.h"
+#include "checkpoint.h"
 #include "drafting.h"
 #include "group.h"
+#include "input_journal.h"
 #include "lateral_solver.h"
 #include "rider.h"
 #include "snapshot.h"
@@ -8,8 +10,11 @@
 #include <cassert>
 #include <chrono>
 #include <cmath>
+#include <fstream>
 #include <limits>
 #include <memory>
+#include <new>
+#include <numeric>
 #include <thread>
 #include <unordered_map>
 
@@ -20,23 +25,60 @@
 PhysicsEngine::PhysicsEngine(const Course* c)
     : course(c), lateral_solver_(params), group_tracker_(group_params_) {}
 
-bool PhysicsEngine::add_rider(const RiderConfig cfg) {
-  auto r = std::make_unique<Rider>(cfg);
+// Member by member: what update() reads before writing it this tick.  The
+// scratch (runs_, group_scratch_, lat_states_, draft_states_, ...) is
+// rebuilt by the copy's first tick.  tests/test_fork.cpp checks the copy
+// against a checkpoint of the original, byte for byte.
+PhysicsEngine::PhysicsEngine(const PhysicsEngine& o)
+    : course(o.course), riders(o.riders), lon_order_(o.lon_order_),
+      pool_(std::make_unique<WorkerPool>(o.get_thread_count())),
+      strings_(o.strings_), group_labels_(o.group_labels_),
+      slots_by_id_(o.slots_by_id_), params(o.params),
+      lateral_solver_(params), group_params_(o.group_params_),
+      group_tracker_(o.group_tracker_), teams_(o.teams_),
+      drafting_params_(o.drafting_params_), behaviors_(o.behaviors_),
+      draft_from_(o.draft_from_), draft_to_(o.draft_to_),
+      draft_period_(o.draft_period_), draft_step_(o.draft_step_),
+      phase_rates_(o.phase_rates_), tick_(o.tick_),
+      phases_dirty_(o.phases_dirty_), follow_params_(o.follow_params_),
+      follow_states_(o.follow_states_),
+      auto_rotation_params_(o.auto_rotation_params_) {
+  if (o.rotation_)
+    rotation_ = std::make_unique<PacelineRotation>(*o.rotation_);
+  auto_rotations_.reserve(o.auto_rotations_.size());
+  for (const auto& rot : o.auto_rotations_)
+    auto_rotations_.push_back(std::make_unique<PacelineRotation>(*rot));
+}
 
+bool PhysicsEngine::add_rider(const RiderConfig cfg) {
   // could even raise here?
-  if (riders.count(r->get_id()) > 0) {
-    SDL_Log("PhysicsEngine::add_rider: Tried to add rider who is already in "
+  if (riders.count(cfg.rider_id) > 0) {
+    sim_log("PhysicsEngine::add_rider: Tried to add rider who is already in "
             "the list! %s",
-            r->name.c_str());
+            cfg.name.c_str());
     return false;
   }
   std::lock_guard<std::mutex> lock(frame_mtx);
-  r->set_course(course);
-  riders.emplace(cfg.rider_id, std::move(r));
+  Rider r(cfg);
+  r.set_course(course);
+  r.set_name_id(strings_.intern(cfg.name));
+  riders.add(std::move(r));
+  const int slot = riders.size() - 1;
+  slots_by_id_.insert(
+      std::upper_bound(slots_by_id_.begin(), slots_by_id_.end(), cfg.rider_id,
+                       [this](RiderId id, int s) { return id < riders.id_at(s); }),
+      slot);
   teams_.register_rider(cfg.rider_id, cfg.team_id);
+  phases_dirty_ = true;
   return true;
 }
 
+void PhysicsEngine::set_thread_count(int n) {
+  n = std::max(1, n);
+  if (n != pool_->thread_count())
+    pool_ = std::make_unique<WorkerPool>(n);
+}
+
 // --- Update pipeline ---
 //
 // Ordering guarantee for the snapshot:
@@ -48,15 +90,230 @@ bool PhysicsEngine::add_rider(const RiderConfig cfg) {
 //   the current step — no off-by-one between longitudinal and lateral.
 
 void PhysicsEngine::update(double dt) {
-  step_group_classify();
-  step_group_role_apply();
+  arena_.reset();
+  repair_lon_order(); // positions may have moved outside update() (setup)
+
+  // Slow phases at their own rates (phase_schedule.h); forced after a
+  // roster or rate change so no phase reads state sized for another field.
+  if (phases_dirty_ ||
+      phase_due(tick_, phase_period(phase_rates_.group_hz, dt),
+                phase_rates_.group_offset)) {
+    step_group_classify();
+    step_group_role_apply();
+  }
+  const int draft_period = phase_period(phase_rates_.draft_hz, dt);
+  if (phases_dirty_ ||
+      phase_due(tick_, draft_period, phase_rates_.draft_offset))
+    step_draft_links(draft_period);
+  phases_dirty_ = false;
+
   step_draft_apply();
   step_rotation_apply(dt);
   step_follow_apply(dt);
   step_longitudinal(dt);
+  repair_lon_order();
   step_lateral_behavior();
   step_lateral_solve(dt);
   step_lateral_apply();
+  ++tick_;
+}
+
+void PhysicsEngine::set_phase_rates(const PhaseRates& rates) {
+  phase_rates_ = rates;
+  phases_dirty_ = true;
+}
+
+void PhysicsEngine::reset_schedule() {
+  tick_ = 0;
+  phases_dirty_ = true;
+  draft_from_.clear();
+  draft_to_.clear();
+  draft_period_ = 1;
+  draft_step_ = 0;
+}
+
+// --- Checkpoints ---
+
+// Keyed state goes out in sorted id order, so equal states give equal
+// bytes whatever the maps' histories.
+template <class Map> static std::vector<RiderId> sorted_keys(const Map& m) {
+  std::vector<RiderId> ids;
+  ids.reserve(m.size());
+  for (const auto& kv : m)
+    ids.push_back(kv.first);
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+void PhysicsEngine::save_setup(CheckpointWriter& w) const {
+  w.pod(course->get_total_length());
+  std::vector<RiderId> roster(riders.size());
+  for (int i = 0; i < riders.size(); ++i)
+    roster[i] = riders.id_at(i);
+  w.pods(roster);
+  w.pods(sorted_keys(behaviors_));
+}
+
+bool PhysicsEngine::check_setup(CheckpointReader& r) const {
+  double length = 0.0;
+  std::vector<RiderId> roster, behaviors;
+  r.pod(length);
+  r.pods(roster);
+  r.pods(behaviors);
+  if (!r.ok())
+    return false;
+  if (length != course->get_total_length())
+    return r.fail("course differs from the checkpoint's");
+  bool same = static_cast<int>(roster.size()) == riders.size();
+  for (int i = 0; same && i < riders.size(); ++i)
+    same = roster[i] == riders.id_at(i);
+  if (!same)
+    return r.fail("rider roster differs from the checkpoint's");
+  if (behaviors != sorted_keys(behaviors_))
+    return r.fail("lateral behaviors differ from the checkpoint's");
+  return true;
+}
+
+void PhysicsEngine::save_state(CheckpointWriter& w) const {
+  for (const auto& [id, r] : riders)
+    r->save_state(w);
+
+  w.pod(tick_);
+  w.pod(phases_dirty_);
+  w.pod(phase_rates_);
+  w.pod(draft_period_);
+  w.pod(draft_step_);
+  w.pods(draft_from_);
+  w.pods(draft_to_);
+
+  const std::vector<RiderId> following = sorted_keys(follow_states_);
+  w.pod(static_cast<std::uint64_t>(following.size()));
+  for (RiderId id : following) {
+    w.pod(id);
+    w.pod(follow_states_.at(id));
+  }
+
+  w.pod(rotation_ != nullptr);
+  if (rotation_)
+    rotation_->save_state(w);
+  w.pod(static_cast<std::uint64_t>(auto_rotations_.size()));
+  for (const auto& rot : auto_rotations_)
+    rot->save_state(w);
+  w.pod(auto_rotation_params_);
+
+  group_tracker_.save_state(w);
+
+  const std::vector<std::string>& strings = strings_.table()->strings;
+  w.pod(static_cast<std::uint64_t>(strings.size()));
+  for (const std::string& str : strings)
+    w.str(str);
+}
+
+bool PhysicsEngine::load_state(CheckpointReader& r) {
+  for (const auto& [id, rider] : riders)
+    if (!rider->load_state(r))
+      return false;
+
+  r.pod(tick_);
+  r.pod(phases_dirty_);
+  r.pod(phase_rates_);
+  r.pod(draft_period_);
+  r.pod(draft_step_);
+  r.pods(draft_from_);
+  r.pods(draft_to_);
+  if (!r.ok())
+    return false;
+  if (static_cast<int>(draft_to_.size()) != riders.size() ||
+      draft_from_.size() != draft_to_.size())
+    return r.fail("draft ramp does not match the roster");
+
+  follow_states_.clear();
+  std::uint64_t n = 0;
+  if (!r.count(n, sizeof(RiderId) + sizeof(FollowState)))
+    return false;
+  for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+    RiderId id = -1;
+    r.pod(id);
+    r.pod(follow_states_[id]);
+  }
+
+  bool has_rotation = false;
+  r.pod(has_rotation);
+  rotation_.reset();
+  if (has_rotation) {
+    rotation_ = std::make_unique<PacelineRotation>(
+        std::vector<RotationMember>{}, RotationParams{});
+    rotation_->load_state(r);
+  }
+  auto_rotations_.clear();
+  if (!r.count(n, sizeof(RotationParams)))
+    return false;
+  for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+    auto_rotations_.push_back(std::make_unique<PacelineRotation>(
+        std::vector<RotationMember>{}, RotationParams{}));
+    auto_rotations_.back()->load_state(r);
+  }
+  r.pod(auto_rotation_params_);
+
+  if (!group_tracker_.load_state(r))
+    return false;
+
+  // Re-interned in table order, so every id — the riders' names included —
+  // keeps its value.
+  StringInterner strings;
+  if (!r.count(n, sizeof(std::uint64_t)))
+    return false;
+  for (std::uint64_t i = 0; i < n && r.ok(); ++i) {
+    std::string str;
+    r.str(str);
+    if (r.ok() && i > 0 && strings.intern(str) != static_cast<StringId>(i))
+      return r.fail("string table is not a set of unique strings");
+  }
+  if (!r.ok())
+    return false;
+  strings_ = std::move(strings);
+  intern_group_labels(); // ids into the table just loaded
+
+  repair_lon_order();
+  return true;
+}
+
+// Insertion-sort repair: ~N comparisons when nobody overtook, one shift per
+// overtake otherwise.  The first call (and any call after riders were added)
+// does a full sort.
+void PhysicsEngine::repair_lon_order() {
+  lon_order_.repair(riders.size(),
+                    [this](int slot) { return riders[slot].get_pos(); });
+}
+
+// Runs of lon_order_ more than `cut` apart, each with its scratch set.
+// Scratch only ever grows, so steady state reuses every buffer.
+void PhysicsEngine::split_runs(double cut) {
+  lon_order_.split(cut, runs_);
+  if (group_scratch_.size() < runs_.size())
+    group_scratch_.resize(runs_.size());
+}
+
+void PhysicsEngine::GroupScratch::fit(int run_size, int field_size) {
+  if (static_cast<int>(order.capacity()) >= run_size)
+    return;
+  const size_t n = static_cast<size_t>(std::max(run_size, field_size));
+  order.reserve(n);
+  draft.reserve(n);
+  factors.reserve(n);
+  draft_work.leader_of.reserve(n);
+  draft_work.link_s.reserve(n);
+  draft_work.depth.reserve(n);
+  draft_work.follower_s.reserve(n);
+  draft_work.body_ahead.reserve(n);
+  lat.reserve(n);
+  updates.reserve(n);
+  lat_work.pairs.reserve(n);
+  lat_work.blocked.reserve(n);
+  lat_work.needs_blocked.reserve(n);
+  lat_work.ahead_lat.reserve(n);
+  lat_work.delta_acc.reserve(n);
+  lat_work.penalty_acc.reserve(n);
 }
 
 void PhysicsEngine::step_and_snapshot(double dt, FrameSnapshot& out) {
@@ -65,43 +322,78 @@ void PhysicsEngine::step_and_snapshot(double dt, FrameSnapshot& out) {
   fill_snapshot(out);
 }
 
+// Flat and string-free: records go out front to back (lon_order_ was
+// repaired after the last step_longitudinal(), so it is exact), by_id is
+// slots_by_id_ through the same order, and the string table is shared.  The
+// vectors keep their capacity, so this allocates nothing per tick.
 void PhysicsEngine::fill_snapshot(FrameSnapshot& out) const {
   // this needs to be called under phys_lock, but we lock in sim::step_fixed
-  out.riders.clear();
-  for (const auto& [id, r] : riders) {
-    auto snap = r->snapshot();
+  const std::vector<int>& order = lon_order_.front_to_back();
+  out.riders.resize(order.size());
+  for (size_t k = 0; k < order.size(); ++k) {
+    const int slot = order[k];
+    const RiderId id = riders.id_at(slot);
+    RiderSnapshot& snap = out.riders[k];
+    snap = riders[slot].snapshot();
     snap.group_id = group_tracker_.get_group_id(id);
     snap.group_role = group_tracker_.get_role(id);
-    out.riders.emplace(id, std::move(snap));
   }
-  out.groups = group_tracker_.get_snapshot(); // value copy; small at N<=20
+  out.by_id.resize(slots_by_id_.size());
+  for (size_t k = 0; k < slots_by_id_.size(); ++k)
+    out.by_id[k] = lon_order_.rank_of(slots_by_id_[k]);
+  out.strings = strings_.table();
+
+  // Groups the same way: labels are ids, members one flat array.
+  const GroupSnapshot& groups = group_tracker_.get_snapshot();
+  out.groups.resize(groups.size());
+  out.group_members.clear();
+  for (size_t g = 0; g < groups.size(); ++g) {
+    const Group& src = groups[g];
+    FrameGroup& dst = out.groups[g];
+    dst.id = src.id;
+    dst.ordinal = src.ordinal;
+    dst.label = g < group_labels_.size() ? group_labels_[g] : kNoString;
+    dst.first = static_cast<int>(out.group_members.size());
+    dst.paceline = static_cast<int>(src.paceline.size());
+    dst.count = src.size();
+    dst.time_gap_ahead = src.time_gap_ahead;
+    out.group_members.insert(out.group_members.end(), src.paceline.begin(),
+                             src.paceline.end());
+    out.group_members.insert(out.group_members.end(), src.body.begin(),
+                             src.body.end());
+  }
+}
+
+// A lookup per group once the labels are in the table: no string is built.
+void PhysicsEngine::intern_group_labels() {
+  const GroupSnapshot& groups = group_tracker_.get_snapshot();
+  group_labels_.resize(groups.size());
+  for (size_t g = 0; g < groups.size(); ++g)
+    group_labels_[g] = strings_.intern(groups[g].display_name);
 }
 
-const std::unordered_map<RiderId, std::unique_ptr<Rider>>&
-PhysicsEngine::get_riders() const {
+const RiderTable& PhysicsEngine::get_riders() const {
   return riders;
 }
 
 // this is (now) only used to set camera to first rider... kinda useless if
 // fixed
 const Rider* PhysicsEngine::get_rider_by_id(RiderId id) const {
-  auto it = riders.find(id);
-  if (it == riders.end()) {
-    SDL_Log("Engine::get_rider_by_id: id %d not found", id);
-    return nullptr;
-  }
-  return it->second.get();
+  const Rider* r = riders.find(id);
+  if (!r)
+    sim_log("Engine::get_rider_by_id: id %d not found", id);
+  return r;
 }
 
 // Physics-thread-only: reached via Simulation's command queue or the
 // effort-schedule loop in step_fixed(), never directly from the UI.
 void PhysicsEngine::set_rider_effort(int id, double effort) {
-  auto it = riders.find(id);
-  if (it == riders.end()) {
-    SDL_Log("Engine::set_rider_effort: id %d not found", id);
+  Rider* r = riders.find(id);
+  if (!r) {
+    sim_log("Engine::set_rider_effort: id %d not found", id);
     return;
   }
-  it->second->set_effort(effort);
+  r->set_effort(effort);
 }
 
 // --- Behavior management ---
@@ -120,16 +412,16 @@ void PhysicsEngine::clear_rider_behavior(RiderId id) { behaviors_.erase(id); }
 
 void PhysicsEngine::set_follow_target(RiderId rider, RiderId target,
                                       FollowRelation relation) {
-  auto it = riders.find(rider);
-  if (it == riders.end() || riders.count(target) == 0 || rider == target) {
-    SDL_Log("Engine::set_follow_target: invalid pair rider %d -> target %d",
+  Rider* r = riders.find(rider);
+  if (!r || riders.count(target) == 0 || rider == target) {
+    sim_log("Engine::set_follow_target: invalid pair rider %d -> target %d",
             rider, target);
     return;
   }
   // Bootstrap the integrator from the current effort so the controller takes
   // over smoothly instead of collapsing effort to ~0 and rebuilding it.
-  double integ = it->second->get_target_effort();
-  const double max_effort = it->second->get_config().max_effort;
+  double integ = r->get_target_effort();
+  const double max_effort = r->get_config().max_effort;
   if (integ < 0.0)
     integ = 0.0;
   else if (integ > max_effort)
@@ -142,17 +434,15 @@ void PhysicsEngine::clear_follow_target(RiderId rider) {
   if (follow_states_.erase(rider) > 0) {
     // Drop the wake-axis steering along with the effort controller, or the
     // rider would keep springing toward the ex-leader's line forever.
-    auto it = riders.find(rider);
-    if (it != riders.end())
-      it->second->clear_lat_target();
+    if (Rider* r = riders.find(rider))
+      r->clear_lat_target();
   }
 }
 
 void PhysicsEngine::clear_follow_targets() {
   for (const auto& [id, fs] : follow_states_) {
-    auto it = riders.find(id);
-    if (it != riders.end())
-      it->second->clear_lat_target();
+    if (Rider* r = riders.find(id))
+      r->clear_lat_target();
   }
   follow_states_.clear();
 }
@@ -228,10 +518,10 @@ void PhysicsEngine::reconcile_rotations() {
     // the manual rotation's riders — that roster is API-owned.
     std::vector<RiderId> declared;
     for (const GroupMember& m : g.all_members()) {
-      auto it = riders.find(m.id);
-      if (it == riders.end())
+      const Rider* r = riders.find(m.id);
+      if (!r)
         continue;
-      if (it->second->get_group_role() != GroupRole::Paceline)
+      if (r->get_group_role() != GroupRole::Paceline)
         continue;
       if (rotation_ && rotation_->is_member(m.id))
         continue;
@@ -339,19 +629,29 @@ void PhysicsEngine::reconcile_rotations() {
 // directives to the follow subsystem.  Runs right before step_follow_apply
 // so this tick's controllers see this tick's follow graph.
 void PhysicsEngine::step_rotation_apply(double dt) {
+  rotation_tasks_.resize((rotation_ ? 1 : 0) + auto_rotations_.size());
+  size_t t = 0;
   if (rotation_)
-    apply_rotation(*rotation_, dt);
+    rotation_tasks_[t++].rot = rotation_.get();
   for (auto& rot : auto_rotations_)
-    apply_rotation(*rot, dt);
+    rotation_tasks_[t++].rot = rot.get();
+
+  pool_->parallel_for(static_cast<int>(rotation_tasks_.size()), 1,
+                      [this, dt](int lo, int hi) {
+                        for (int i = lo; i < hi; ++i)
+                          tick_rotation(rotation_tasks_[i], dt);
+                      });
+  for (const RotationTask& task : rotation_tasks_)
+    apply_rotation(task);
 }
 
-void PhysicsEngine::apply_rotation(PacelineRotation& rot, double dt) {
-  rotation_inputs_.clear();
+void PhysicsEngine::tick_rotation(RotationTask& task, double dt) {
+  task.inputs.clear();
   for (const auto& [id, r] : riders) {
-    if (!rot.is_member(id))
+    if (!task.rot->is_member(id))
       continue;
     const auto [wind_dir, wind_speed] = course->get_wind(r->get_pos());
-    rotation_inputs_.push_back(RotationInput{
+    task.inputs.push_back(RotationInput{
         .id = id,
         .lon_pos = r->get_pos(),
         .speed = r->get_speed(),
@@ -361,17 +661,19 @@ void PhysicsEngine::apply_rotation(PacelineRotation& rot, double dt) {
         .target_effort = r->get_target_effort(),
     });
   }
+  task.rot->tick(dt, task.inputs, task.directives);
+}
 
-  const auto directives = rot.tick(dt, rotation_inputs_);
-  for (const auto& d : directives) {
-    auto it = riders.find(d.id);
-    if (it == riders.end())
+void PhysicsEngine::apply_rotation(const RotationTask& task) {
+  for (const auto& d : task.directives) {
+    Rider* r = riders.find(d.id);
+    if (!r)
       continue;
 
     if (d.pulling) {
       clear_follow_target(d.id); // also drops the wake-axis lat target
       if (d.set_effort)
-        it->second->set_effort(*d.set_effort);
+        r->set_effort(*d.set_effort);
       continue;
     }
     if (d.follow < 0)
@@ -391,8 +693,8 @@ void PhysicsEngine::apply_rotation(PacelineRotation& rot, double dt) {
       fit->second.side = d.swing_side;
       // Seed the drift speed-hold from the current effort so the swing-off
       // eases from the pull rather than dipping to zero and rebuilding.
-      double seed = it->second->get_target_effort();
-      const double max_effort = it->second->get_config().max_effort;
+      double seed = r->get_target_effort();
+      const double max_effort = r->get_config().max_effort;
       if (seed < 0.0)
         seed = 0.0;
       else if (seed > max_effort)
@@ -406,16 +708,16 @@ void PhysicsEngine::apply_rotation(PacelineRotation& rot, double dt) {
       // line's speed with the rider's current draft, floored at threshold —
       // enough to gain ground, never a sprint.  Recomputed every tick: as the
       // rider pulls out of the shelter its P_hold (and so the cap) rises.
-      auto tit = riders.find(d.follow);
-      const Rider& me = *it->second;
-      if (tit != riders.end() && me.get_ftp() > 0.0) {
-        const double p_hold = me.cruise_power(tit->second->get_speed());
+      const Rider* target = riders.find(d.follow);
+      const Rider& me = *r;
+      if (target && me.get_ftp() > 0.0) {
+        const double p_hold = me.cruise_power(target->get_speed());
         fit->second.effort_cap = std::max(1.0, 1.2 * p_hold / me.get_ftp());
       }
     }
   }
 
-  for (RiderId id : rot.removed_last_tick())
+  for (RiderId id : task.rot->removed_last_tick())
     clear_follow_target(id);
 }
 
@@ -423,115 +725,138 @@ void PhysicsEngine::apply_rotation(PacelineRotation& rot, double dt) {
 // single active effort writer for riders in Follow mode.  Runs before
 // step_longitudinal() so the command applies this tick; positions are
 // one tick stale, same as drafting.
+//
+// Each controller writes only its own rider and FollowState and reads only
+// its leader's kinematics (never target_effort / lat_target), so entries
+// are independent and run as pool tasks.  A leader may sit in another group
+// (a chase, a protect), so the split is by controller, not by group.
 void PhysicsEngine::step_follow_apply(double dt) {
-  for (auto& [id, fs] : follow_states_) {
-    auto rit = riders.find(id);
-    auto lit = riders.find(fs.leader);
-    if (rit == riders.end() || lit == riders.end())
-      continue; // stale entry — rider or leader removed; hold last effort
-
-    Rider& r = *rit->second;
-    const Rider& leader = *lit->second;
-
-    // Protect (C4): the reference rider is the ward *behind*.  The gap is the
-    // ward's own wheel-to-wheel view of the pair (own bike_len — identical
-    // quantity to what the ward's follow controller measures, so a mutual
-    // pairing agrees on the setpoint from both ends).  No lateral write: the
-    // protector holds its line and the ward's controller steers into *our*
-    // wake; there is no wake ahead to seek.  Swing/move-up mechanics never
-    // apply — only rotations set those, and rotations never install protects.
-    if (fs.relation == FollowRelation::Ahead) {
-      const Rider& ward = leader;
-      const FollowInput in{
-          .gap = (r.get_pos() - ward.get_pos()) - r.get_bike_len(),
-          .rel_speed = ward.get_speed() - r.get_speed(),
-          .own_speed = r.get_speed(),
-          .max_effort = r.get_config().max_effort,
-      };
-      r.set_effort(protect_effort(in, dt, fs.integrator, follow_params_));
-      continue;
-    }
+  follow_jobs_.clear();
+  for (auto& [id, fs] : follow_states_)
+    follow_jobs_.emplace_back(id, &fs);
+
+  pool_->parallel_for(
+      static_cast<int>(follow_jobs_.size()), kPoolGrain,
+      [this, dt](int lo, int hi) {
+        for (int i = lo; i < hi; ++i)
+          follow_one(follow_jobs_[i].first, *follow_jobs_[i].second, dt);
+      });
+}
 
+void PhysicsEngine::follow_one(RiderId id, FollowState& fs, double dt) {
+  Rider* rp = riders.find(id);
+  const Rider* lp = riders.find(fs.leader);
+  if (!rp || !lp)
+    return; // stale entry — rider or leader removed; hold last effort
+
+  Rider& r = *rp;
+  const Rider& leader = *lp;
+
+  // Protect (C4): the reference rider is the ward *behind*.  The gap is the
+  // ward's own wheel-to-wheel view of the pair (own bike_len — identical
+  // quantity to what the ward's follow controller measures, so a mutual
+  // pairing agrees on the setpoint from both ends).  No lateral write: the
+  // protector holds its line and the ward's controller steers into *our*
+  // wake; there is no wake ahead to seek.  Swing/move-up mechanics never
+  // apply — only rotations set those, and rotations never install protects.
+  if (fs.relation == FollowRelation::Ahead) {
+    const Rider& ward = leader;
     const FollowInput in{
-        .gap = (leader.get_pos() - r.get_pos()) - leader.get_bike_len(),
-        .rel_speed = leader.get_speed() - r.get_speed(),
+        .gap = (r.get_pos() - ward.get_pos()) - r.get_bike_len(),
+        .rel_speed = ward.get_speed() - r.get_speed(),
         .own_speed = r.get_speed(),
         .max_effort = r.get_config().max_effort,
     };
-    double effort = follow_effort(in, dt, fs.integrator, follow_params_);
-
-    // Steer to the leader's wake axis (apparent-wind direction — the same
-    // axis the shelter test scores against), not to the leader's line:
-    // with crosswind the sweet spot is offset leeward, and this is what
-    // forms echelons once B2 lands real wind.  An assigned ILateralBehavior
-    // overrides this (it runs later in the tick) — that's the D3 swing-off
-    // hook.
-    double lat = wake_axis_lat(build_draft_state(fs.leader, leader),
-                               r.get_pos());
-
-    // Merging back after a pull (rotation, D3): hold v_leader - drift_delta
-    // via the speed-hold PI, max-combined with the gap controller — far from
-    // the tail the gap controller wants ~0 and the drift term paces the
-    // fall-back; near the wheel the gap controller rises through it.  Ride
-    // offset to the swing side, full while overlapped (gap <= 0), fading
-    // linearly to sit exactly on the axis at the gap setpoint.
-    if (fs.side != 0.0) {
-      const double setpoint =
-          follow_params_.d0 + follow_params_.h * in.own_speed;
-      if (in.gap >= setpoint) {
-        // Merge complete — the offset has already faded to 0 here, so
-        // clearing causes no lateral step.  Hand the drift integrator's held
-        // cruise effort to the gap integrator (same bootstrap discipline as
-        // set_follow_target) so the takeover doesn't dip effort and reopen
-        // the gap.
-        fs.integrator = std::max(fs.integrator, fs.drift_integrator);
-        fs.side = 0.0;
-        fs.drift_integrator = 0.0;
-      } else {
-        const double v_err = (leader.get_speed() - follow_params_.drift_delta)
-                             - r.get_speed();
-        effort = std::max(effort,
-                          drift_effort(v_err, dt, fs.drift_integrator,
-                                       in.max_effort, follow_params_));
-        const double fade =
-            (in.gap <= 0.0) ? 1.0 : 1.0 - in.gap / setpoint;
-        lat += fs.side * follow_params_.swing_offset_radii * r.get_radius() *
-               fade;
-      }
+    r.set_effort(protect_effort(in, dt, fs.integrator, follow_params_));
+    return;
+  }
+
+  const FollowInput in{
+      .gap = (leader.get_pos() - r.get_pos()) - leader.get_bike_len(),
+      .rel_speed = leader.get_speed() - r.get_speed(),
+      .own_speed = r.get_speed(),
+      .max_effort = r.get_config().max_effort,
+  };
+  double effort = follow_effort(in, dt, fs.integrator, follow_params_);
+
+  // Steer to the leader's wake axis (apparent-wind direction — the same
+  // axis the shelter test scores against), not to the leader's line:
+  // with crosswind the sweet spot is offset leeward, and this is what
+  // forms echelons once B2 lands real wind.  An assigned ILateralBehavior
+  // overrides this (it runs later in the tick) — that's the D3 swing-off
+  // hook.
+  double lat = wake_axis_lat(build_draft_state(fs.leader, leader),
+                             r.get_pos());
+
+  // Merging back after a pull (rotation, D3): hold v_leader - drift_delta
+  // via the speed-hold PI, max-combined with the gap controller — far from
+  // the tail the gap controller wants ~0 and the drift term paces the
+  // fall-back; near the wheel the gap controller rises through it.  Ride
+  // offset to the swing side, full while overlapped (gap <= 0), fading
+  // linearly to sit exactly on the axis at the gap setpoint.
+  if (fs.side != 0.0) {
+    const double setpoint =
+        follow_params_.d0 + follow_params_.h * in.own_speed;
+    if (in.gap >= setpoint) {
+      // Merge complete — the offset has already faded to 0 here, so
+      // clearing causes no lateral step.  Hand the drift integrator's held
+      // cruise effort to the gap integrator (same bootstrap discipline as
+      // set_follow_target) so the takeover doesn't dip effort and reopen
+      // the gap.
+      fs.integrator = std::max(fs.integrator, fs.drift_integrator);
+      fs.side = 0.0;
+      fs.drift_integrator = 0.0;
+    } else {
+      const double v_err = (leader.get_speed() - follow_params_.drift_delta)
+                           - r.get_speed();
+      effort = std::max(effort,
+                        drift_effort(v_err, dt, fs.drift_integrator,
+                                     in.max_effort, follow_params_));
+      const double fade =
+          (in.gap <= 0.0) ? 1.0 : 1.0 - in.gap / setpoint;
+      lat += fs.side * follow_params_.swing_offset_radii * r.get_radius() *
+             fade;
     }
+  }
 
-    // Move-up transit (sitter promotion, C-pre-b; the C4 join reuses this):
-    // approach the tail from behind riding offset to the advance side, effort
-    // clamped to the cap set by the rotation phase.  The offset fades to 0
-    // over the last approach_fade_len metres above the setpoint, so the
-    // cut-in ends exactly on the wake axis; at the setpoint the transit is
-    // complete and clearing causes no lateral step.
-    if (fs.approach_side != 0.0) {
-      const double setpoint =
-          follow_params_.d0 + follow_params_.h * in.own_speed;
-      if (in.gap <= setpoint) {
-        fs.approach_side = 0.0;
-        fs.effort_cap = -1.0;
-      } else {
-        if (fs.effort_cap >= 0.0)
-          effort = std::min(effort, fs.effort_cap);
-        const double fade = std::min(
-            1.0, (in.gap - setpoint) / follow_params_.approach_fade_len);
-        lat += fs.approach_side * follow_params_.swing_offset_radii *
-               r.get_radius() * fade;
+  // Move-up transit (sitter promotion, C-pre-b; the C4 join reuses this):
+  // approach the tail from behind riding offset to the advance side, effort
+  // clamped to the cap set by the rotation phase.  The offset fades to 0
+  // over the last approach_fade_len metres above the setpoint, so the
+  // cut-in ends exactly on the wake axis; at the setpoint the transit is
+  // complete and clearing causes no lateral step.
+  if (fs.approach_side != 0.0) {
+    const double setpoint =
+        follow_params_.d0 + follow_params_.h * in.own_speed;
+    if (in.gap <= setpoint) {
+      fs.approach_side = 0.0;
+      fs.effort_cap = -1.0;
+    } else {
+      if (fs.effort_cap >= 0.0) {
+        effort = std::min(effort, fs.effort_cap);
+        // Anti-windup: metres of gap error would otherwise wind the
+        // integrator to max_effort behind the cap, and the transit would end
+        // in exactly the sprint the cap exists to prevent.
+        fs.integrator = std::min(fs.integrator, fs.effort_cap);
       }
+      const double fade = std::min(
+          1.0, (in.gap - setpoint) / follow_params_.approach_fade_len);
+      lat += fs.approach_side * follow_params_.swing_offset_radii *
+             r.get_radius() * fade;
     }
-
-    r.set_effort(effort);
-    r.set_lat_target(lat);
   }
+
+  r.set_effort(effort);
+  r.set_lat_target(lat);
 }
 
-// Drafting phase: compute per-rider CdA multipliers from formation geometry
-// and write them into the riders.  Runs after the group phases (so
-// roles/groups are current for this tick) and before step_longitudinal(),
-// whose drag terms consume cda_factor.  Positions are one tick stale — fine
-// at 100 Hz.
+// Drafting phase, in two parts.  step_draft_links() computes per-rider CdA
+// multipliers from formation geometry at the draft rate (phase_schedule.h);
+// step_draft_apply() writes them into the riders every tick, ramping from
+// each rider's previous factor over one draft period so a refresh never
+// steps CdA.  Runs after the group phases (so roles/groups are as current
+// as their rate) and before step_longitudinal(), whose drag terms consume
+// cda_factor.  Positions are one tick stale — fine at 100 Hz.
 DraftRiderState PhysicsEngine::build_draft_state(RiderId id,
                                                  const Rider& r) const {
   const auto [wind_dir, wind_speed] = course->get_wind(r.get_pos());
@@ -550,26 +875,121 @@ DraftRiderState PhysicsEngine::build_draft_state(RiderId id,
   };
 }
 
+void PhysicsEngine::step_draft_links(int period) {
+  const int n = riders.size();
+  // The ramp restarts from wherever each rider is now — mid-ramp included.
+  draft_from_.resize(n);
+  draft_to_.resize(n);
+  for (int i = 0; i < n; ++i)
+    draft_from_[i] = riders[i].get_draft_factor();
+  draft_period_ = period;
+  draft_step_ = 0;
+
+  draft_states_.resize(n);
+  pool_->parallel_for(n, kPoolGrain, [this](int lo, int hi) {
+    for (int i = lo; i < hi; ++i)
+      draft_states_[i] = build_draft_state(riders.id_at(i), riders[i]);
+  });
+
+  // Per group: no link reaches past max_draft_gap + the longest bike, and
+  // Body counts stay within a group_id, so runs split at the larger of that
+  // and gap_threshold are independent.  Each run gathers its riders
+  // front-to-back into its own scratch (local order = 0..n-1) and writes
+  // factors straight back to their slots of draft_to_.
+  double max_bike_len = 0.0;
+  for (const DraftRiderState& d : draft_states_)
+    max_bike_len = std::max(max_bike_len, d.bike_len);
+  split_runs(std::max(group_params_.gap_threshold,
+                      drafting_params_.max_draft_gap + max_bike_len));
+
+  pool_->parallel_for(static_cast<int>(runs_.size()), 1,
+                      [this](int lo, int hi) {
+                        for (int r = lo; r < hi; ++r)
+                          draft_run(r);
+                      });
+}
+
 void PhysicsEngine::step_draft_apply() {
-  draft_states_.clear();
-  draft_states_.reserve(riders.size());
+  ++draft_step_;
+  const int n = static_cast<int>(draft_to_.size());
+  assert(n == riders.size());
+  if (draft_step_ >= draft_period_) {
+    // Ramp done (always, at period 1): the exact link factors.
+    for (int i = 0; i < n; ++i)
+      riders[i].set_cda_factor(draft_to_[i]);
+    return;
+  }
+  const double t = static_cast<double>(draft_step_) / draft_period_;
+  for (int i = 0; i < n; ++i)
+    riders[i].set_cda_factor(draft_from_[i] +
+                             (draft_to_[i] - draft_from_[i]) * t);
+}
 
-  for (const auto& [id, r] : riders)
-    draft_states_.push_back(build_draft_state(id, *r));
-
-  const std::vector<double> factors =
-      compute_draft_factors(draft_states_, drafting_params_);
-  for (size_t i = 0; i < draft_states_.size(); ++i) {
-    auto it = riders.find(draft_states_[i].id);
-    if (it != riders.end())
-      it->second->set_cda_factor(factors[i]);
+void PhysicsEngine::draft_run(int r) {
+  const std::vector<int>& order = lon_order_.front_to_back();
+  const LonOrder::Run run = runs_[r];
+  GroupScratch& s = group_scratch_[r];
+  const int n = run.end - run.begin;
+  s.fit(n, riders.size());
+
+  s.draft.clear();
+  for (int k = run.begin; k < run.end; ++k)
+    s.draft.push_back(draft_states_[order[k]]);
+  s.order.resize(n);
+  std::iota(s.order.begin(), s.order.end(), 0);
+
+  compute_draft_factors(s.draft, s.order, drafting_params_, s.draft_work,
+                        s.factors);
+  for (int k = 0; k < n; ++k)
+    draft_to_[order[run.begin + k]] = s.factors[k];
+}
+
+PhysicsEngine::LonBatch::~LonBatch() {
+  rider_batch_free(&riders);
+  env_batch_free(&env);
+}
+
+void PhysicsEngine::LonBatch::fit(int n) {
+  if (n > riders.capacity) {
+    rider_batch_free(&riders);
+    env_batch_free(&env);
+    if (!rider_batch_init(&riders, n) || !env_batch_init(&env, n))
+      throw std::bad_alloc();
+    Rider::set_batch_env(&env);
+    epochs.assign(n, 0); // fresh columns: every slot reloads
   }
+  epochs.resize(n);
+  riders.count = n;
 }
 
-// Phase 1: advance each rider's longitudinal physics independently.
+// Phase 1: advance each rider's longitudinal physics independently — per
+// chunk, one batched core step over each run of the chunk's batched slots
+// (sim_core.h), the same arithmetic as Rider::update() rider by rider.
 void PhysicsEngine::step_longitudinal(double dt) {
-  for (const auto& [id, r] : riders)
-    r->update(dt);
+  const int n = riders.size();
+  lon_batch_.fit(n);
+  batched_.resize(n);
+  pool_->parallel_for(n, kPoolGrain, [this, dt](int lo, int hi) {
+    RiderBatch* b = &lon_batch_.riders;
+    EnvBatch* env = &lon_batch_.env;
+    for (int i = lo; i < hi; ++i) {
+      batched_[i] = riders[i].load_batch(b, env, i, lon_batch_.epochs[i]);
+      if (!batched_[i])
+        riders[i].update(dt);
+    }
+    for (int i = lo; i < hi;) {
+      if (!batched_[i]) {
+        ++i;
+        continue;
+      }
+      int end = i + 1;
+      while (end < hi && batched_[end])
+        ++end;
+      sim_step_riders_range(b, env, i, end, dt);
+      for (; i < end; ++i)
+        riders[i].store_batch(b, i);
+    }
+  });
 }
 
 // Phase 2: query each assigned behavior for an optional lateral target and
@@ -582,36 +1002,43 @@ void PhysicsEngine::step_longitudinal(double dt) {
 //   means all proximity queries are consistent within the same step.
 void PhysicsEngine::step_lateral_behavior() {
   // Build the shared state snapshot from post-longitudinal rider state.
-  lat_states_.clear();
-  lat_states_.reserve(riders.size());
-
-  for (const auto& [id, r] : riders) {
-    lat_states_.push_back(LateralRiderState{
-        .id = id,
-        .lon_pos = r->get_pos(),
-        .speed = r->get_speed(),
-        .lat_pos = r->get_lat_pos(),
-        .lat_vel = r->get_lat_vel(),
-        .lat_target = r->get_lat_target(),
-        .w_prime_frac = r->get_energy_fraction(),
-        .surplus_power = compute_surplus_power(*r),
-        .mass = r->get_total_mass(),
-        .rider_radius = r->get_radius(),
-        .bike_length = r->get_bike_len(),
-        .road_width = course->get_road_width(r->get_pos()),
-    });
-  }
+  const int n = riders.size();
+  lat_states_.resize(n);
+  pool_->parallel_for(n, kPoolGrain, [this](int lo, int hi) {
+    for (int i = lo; i < hi; ++i) {
+      const Rider& r = riders[i];
+      const CourseSample env = r.sample_course(); // this slot's own cursor
+      lat_states_[i] = LateralRiderState{
+          .id = riders.id_at(i),
+          .lon_pos = r.get_pos(),
+          .speed = r.get_speed(),
+          .lat_pos = r.get_lat_pos(),
+          .lat_vel = r.get_lat_vel(),
+          .lat_target = r.get_lat_target(),
+          .w_prime_frac = r.get_energy_fraction(),
+          .surplus_power = compute_surplus_power(r, env.slope),
+          .mass = r.get_total_mass(),
+          .rider_radius = r.get_radius(),
+          .bike_length = r.get_bike_len(),
+          .road_width = env.road_width,
+      };
+    }
+  });
+  lat_max_bike_len_ = 0.0;
+  for (const LateralRiderState& l : lat_states_)
+    lat_max_bike_len_ = std::max(lat_max_bike_len_, l.bike_length);
 
   // Call each assigned behavior.
   for (const auto& [id, behavior] : behaviors_) {
-    auto rider_it = riders.find(id);
-    if (rider_it == riders.end())
+    const int slot = riders.slot_of(id);
+    if (slot < 0)
       continue; // stale entry — rider was removed
 
-    const LateralContext ctx = build_context(id);
-    const std::optional<double> target = behavior->compute_lat_target(ctx);
+    build_context(slot, behavior_ctx_);
+    const std::optional<double> target =
+        behavior->compute_lat_target(behavior_ctx_);
 
-    Rider& r = *rider_it->second;
+    Rider& r = riders[slot];
     if (target.has_value())
       r.set_lat_target(target.value());
     else
@@ -619,12 +1046,7 @@ void PhysicsEngine::step_lateral_behavior() {
 
     // Keep lat_states_ in sync so subsequent build_context() calls within
     // this step see the updated target.
-    for (auto& s : lat_states_) {
-      if (s.id == id) {
-        s.lat_target = r.get_lat_target();
-        break;
-      }
-    }
+    lat_states_[slot].lat_target = r.get_lat_target();
   }
 }
 
@@ -634,32 +1056,71 @@ void PhysicsEngine::step_lateral_solve(double dt) {
   // step_lateral_behavior(). If there are no assigned behaviors, it still
   // contains all riders with their current lat_target (typically nullopt) — the
   // solver handles that correctly.
-  lat_updates_ = lateral_solver_.solve(lat_states_, dt);
+  //
+  // Per group, as in step_draft_links: contact pairs and the blockade scan
+  // both stay within one bike length, so runs split at gap_threshold (or the
+  // longest bike, if larger) are solved independently.  lon_order_ was
+  // repaired after step_longitudinal(), so the runs are this tick's groups.
+  // One difference from a whole-field solve: solve() keeps the free-movement
+  // lat_vel when it finds no contact at all, and that early-out is now per
+  // group — a shove in the peloton no longer re-derives a clean breakaway's
+  // velocities from displacement (equal up to rounding away from the kerb).
+  double max_bike_len = 0.0;
+  for (const LateralRiderState& l : lat_states_)
+    max_bike_len = std::max(max_bike_len, l.bike_length);
+  split_runs(std::max(group_params_.gap_threshold, max_bike_len));
+
+  lat_updates_.resize(lat_states_.size());
+  pool_->parallel_for(static_cast<int>(runs_.size()), 1,
+                      [this, dt](int lo, int hi) {
+                        for (int r = lo; r < hi; ++r)
+                          lateral_run(r, dt);
+                      });
 }
 
-// Phase 4: write solver output back into Rider objects.
+void PhysicsEngine::lateral_run(int r, double dt) {
+  const std::vector<int>& order = lon_order_.front_to_back();
+  const LonOrder::Run run = runs_[r];
+  GroupScratch& s = group_scratch_[r];
+  const int n = run.end - run.begin;
+  s.fit(n, riders.size());
+
+  s.lat.clear();
+  for (int k = run.begin; k < run.end; ++k)
+    s.lat.push_back(lat_states_[order[k]]);
+  s.order.resize(n);
+  std::iota(s.order.begin(), s.order.end(), 0);
+
+  lateral_solver_.solve(s.lat, s.order, dt, s.lat_work, s.updates);
+  for (int k = 0; k < n; ++k)
+    lat_updates_[order[run.begin + k]] = s.updates[k];
+}
+
+// Phase 4: write solver output back into Rider objects.  The solver returns
+// one update per input state, in input order, so lat_updates_[i] is slot i.
 //
 // speed_penalty is passed through to Rider::apply_lateral_update(), but the
 // state.speed *= speed_penalty line there is currently commented out — the
 // penalty is computed and plumbed but intentionally disabled until tuned.
 void PhysicsEngine::step_lateral_apply() {
-  for (const auto& upd : lat_updates_) {
-    auto it = riders.find(upd.id);
-    if (it == riders.end())
-      continue;
-    it->second->apply_lateral_update(upd.new_lat_pos, upd.new_lat_vel,
-                                     upd.speed_penalty);
+  assert(static_cast<int>(lat_updates_.size()) == riders.size());
+  for (int i = 0; i < static_cast<int>(lat_updates_.size()); ++i) {
+    const LateralUpdate& upd = lat_updates_[i];
+    assert(upd.id == riders.id_at(i));
+    riders[i].apply_lateral_update(upd.new_lat_pos, upd.new_lat_vel,
+                                   upd.speed_penalty);
   }
 }
 
 void PhysicsEngine::build_group_input() {
+  const int n = riders.size();
   group_input_.clear();
-  group_input_.reserve(riders.size());
-  for (const auto& [id, r] : riders) {
+  group_input_.reserve(n);
+  for (int i = 0; i < n; ++i) {
     group_input_.push_back(GroupMember{
-        .id = id,
-        .lon_pos = r->get_pos(),
-        .speed = r->get_speed(),
+        .id = riders.id_at(i),
+        .lon_pos = riders[i].get_pos(),
+        .speed = riders[i].get_speed(),
         .role = GroupRole::Unassigned,
     });
   }
@@ -667,20 +1128,19 @@ void PhysicsEngine::build_group_input() {
 
 void PhysicsEngine::step_group_classify() {
   build_group_input();
-  group_tracker_.update(group_input_);
+  group_tracker_.update(group_input_, lon_order_.front_to_back());
+  intern_group_labels();
 
   // for (const auto& g : group_tracker_.get_snapshot())
-  //   SDL_Log("Group %d (%s): %d riders, front %.0f m, span %.0f m", g.ordinal,
+  //   sim_log("Group %d (%s): %d riders, front %.0f m, span %.0f m", g.ordinal,
   //           g.display_name.c_str(), g.size(), g.front_pos(), g.back_pos());
 }
 
 void PhysicsEngine::step_group_role_apply() {
-  role_decls_.clear();
-  for (const auto& [id, r] : riders) {
-    const GroupRole role = r->get_group_role();
-    if (role != GroupRole::Unassigned)
-      role_decls_[id] = role;
-  }
+  // Every rider gets an entry, Unassigned included (the tracker treats that
+  // as no declaration), so the map's nodes are reused instead of rebuilt.
+  for (const auto& [id, r] : riders)
+    role_decls_[id] = r->get_group_role();
   group_tracker_.apply_role_declarations(role_decls_);
 }
 
@@ -689,13 +1149,13 @@ void PhysicsEngine::step_group_role_apply() {
 // Approximate power consumed by longitudinal resistance at current speed.
 // Uses a simplified model intentionally — surplus_power is used only to size
 // the shove budget, not to drive physics.  Exact values are not required.
-double PhysicsEngine::compute_surplus_power(const Rider& r) const {
+double PhysicsEngine::compute_surplus_power(const Rider& r,
+                                            double slope) const {
   const double v = r.get_speed();
   const double rho = 1.2234;
   const double g = 9.80665;
   const double cda = r.get_config().cda * r.get_cda_factor();
   const double m = r.get_total_mass();
-  const double slope = course->get_slope(r.get_pos());
 
   const double P_aero = 0.5 * rho * cda * v * v * v;
   const double P_roll = 0.006 * m * g * v; // crr ≈ 0.006
@@ -704,28 +1164,50 @@ double PhysicsEngine::compute_surplus_power(const Rider& r) const {
   return std::max(0.0, r.get_power() - (P_aero + P_roll + P_grav));
 }
 
-// Build a LateralContext for one rider from the current lat_states_ snapshot.
-LateralContext PhysicsEngine::build_context(RiderId id) const {
-  const LateralRiderState* own = nullptr;
-  for (const auto& s : lat_states_) {
-    if (s.id == id) {
-      own = &s;
-      break;
-    }
+// Build a LateralContext for one rider from the current lat_states_ snapshot
+// (slot-parallel to riders, so the rider's own state is lat_states_[slot]).
+LateralContext PhysicsEngine::build_context(int slot) const {
+  LateralContext ctx;
+  build_context(slot, ctx);
+  return ctx;
+}
+
+void PhysicsEngine::build_context(int slot, LateralContext& ctx) const {
+  if (slot < 0 || slot >= static_cast<int>(lat_states_.size())) {
+    ctx = {};
+    return;
   }
-  if (!own)
-    return {};
+  const LateralRiderState* own = &lat_states_[slot];
 
-  LateralContext ctx;
+  ctx.nearby.clear();
   ctx.own_lat_pos = own->lat_pos;
   ctx.own_lat_vel = own->lat_vel;
   ctx.own_speed = own->speed;
   ctx.own_w_prime_frac = own->w_prime_frac;
   ctx.road_width = own->road_width;
 
-  for (const auto& s : lat_states_) {
-    if (s.id == id)
-      continue;
+  // lon_order_ was repaired after step_longitudinal(), so it orders exactly
+  // these lon_pos values: walk out from our rank both ways until even the
+  // longest bike can no longer reach.  Collected slots are re-sorted so
+  // nearby keeps slot order (behaviors break ties by first match).
+  const std::vector<int>& order = lon_order_.front_to_back();
+  const int n = static_cast<int>(order.size());
+  const int rank = lon_order_.rank_of(slot);
+  std::pmr::vector<int> near(arena_.resource());
+  for (int k = rank - 1;
+       k >= 0 && lat_states_[order[k]].lon_pos - own->lon_pos <=
+                     lat_max_bike_len_;
+       --k)
+    near.push_back(order[k]);
+  for (int k = rank + 1;
+       k < n && own->lon_pos - lat_states_[order[k]].lon_pos <=
+                    lat_max_bike_len_;
+       ++k)
+    near.push_back(order[k]);
+  std::sort(near.begin(), near.end());
+
+  for (int i : near) {
+    const LateralRiderState& s = lat_states_[i];
     const double lon_offset = s.lon_pos - own->lon_pos;
     if (std::fabs(lon_offset) <= s.bike_length) {
       ctx.nearby.push_back(NearbyRider{
@@ -736,8 +1218,6 @@ LateralContext PhysicsEngine::build_context(RiderId id) const {
       });
     }
   }
-
-  return ctx;
 }
 
 GroupContext PhysicsEngine::build_group_context(RiderId id) const {
@@ -800,7 +1280,23 @@ GroupContext PhysicsEngine::build_group_context(RiderId id) const {
 
 // SIMULATION
 
-Simulation::Simulation(const Course* c) : engine(c), decision_(c) {}
+Simulation::Simulation(const Course* c) : engine(c), decision_(c) {
+  drained_.reserve(kCommandCapacity);
+  effort_seen_.reserve(kCommandCapacity);
+}
+
+Simulation::Simulation(const Simulation& o)
+    : engine(o.engine), decision_(o.decision_),
+      decision_accum_(o.decision_accum_), time_factor(o.time_factor.load()),
+      sim_seconds(o.sim_seconds), dt(o.dt),
+      effort_schedules(o.effort_schedules) {
+  drained_.reserve(kCommandCapacity);
+  effort_seen_.reserve(kCommandCapacity);
+}
+
+std::unique_ptr<Simulation> Simulation::fork() const {
+  return std::unique_ptr<Simulation>(new Simulation(*this));
+}
 
 // C0: derive race-style time gaps for the snapshot.  Groups are ordered
 // front-to-back (ordinal 0 leads); each chasing group's gap is measured
@@ -809,24 +1305,25 @@ Simulation::Simulation(const Course* c) : engine(c), decision_(c) {}
 static void fill_time_gaps(FrameSnapshot& snap, const RaceClock& clock,
                            double now) {
   for (size_t gi = 1; gi < snap.groups.size(); ++gi) {
-    Group& g = snap.groups[gi];
-    const Group& ahead = snap.groups[gi - 1];
+    FrameGroup& g = snap.groups[gi];
+    const FrameGroup& ahead = snap.groups[gi - 1];
 
     RiderId rear = -1;
     double rear_pos = std::numeric_limits<double>::infinity();
-    auto scan = [&](const std::vector<GroupMember>& v) {
-      for (const auto& m : v)
-        if (m.lon_pos < rear_pos) {
-          rear_pos = m.lon_pos;
-          rear = m.id;
-        }
-    };
-    scan(ahead.paceline);
-    scan(ahead.body);
+    const GroupMember* m = snap.members(ahead);
+    for (int k = 0; k < ahead.count; ++k)
+      if (m[k].lon_pos < rear_pos) {
+        rear_pos = m[k].lon_pos;
+        rear = m[k].id;
+      }
     if (rear < 0)
       continue; // empty group ahead (shouldn't happen after update)
 
-    const auto gap = clock.time_gap(rear, g.front_pos(), now);
+    double front_pos = 0.0; // as Group::front_pos()
+    m = snap.members(g);
+    for (int k = 0; k < g.count; ++k)
+      front_pos = k ? std::max(front_pos, m[k].lon_pos) : m[k].lon_pos;
+    const auto gap = clock.time_gap(rear, front_pos, now);
     g.time_gap_ahead = gap.value_or(-1.0);
   }
 }
@@ -835,44 +1332,122 @@ void Simulation::add_riders(const std::vector<RiderConfig>& configs) {
   for (const auto& cfg : configs) {
     assert(cfg.rider_id >= 0);
     if (!engine.add_rider(cfg))
-      SDL_Log("add_riders: engine rejected rider_id %d", cfg.rider_id);
+      sim_log("add_riders: engine rejected rider_id %d", cfg.rider_id);
   }
 }
 
-void Simulation::publish_snapshot() {
-  snap_back.real_time = SDL_GetTicks() / 1000.0;
-
-  std::scoped_lock lock(snapshot_swap_mtx);
-
-  if (snap_back.sim_time <= snap_curr.sim_time)
-    return; // physics didn't advance (shouldn't happen in step_fixed, but safe)
+void Simulation::publish_snapshot(FrameSnapshot& back) {
+  back.real_time = frame_clock_seconds();
 
-  snap_prev = std::move(snap_curr);
-  snap_curr = std::move(snap_back);
+  const FrameSnapshot* curr = frames_.published();
+  if (curr && back.sim_time <= curr->sim_time) {
+    // physics didn't advance (shouldn't happen in step_fixed, but safe)
+    frames_.abandon();
+    return;
+  }
+  frames_.publish();
 }
 
 bool Simulation::consume_latest_frame_pair(FrameSnapshot& out_prev,
                                            FrameSnapshot& out_curr) {
-  std::scoped_lock lock(snapshot_swap_mtx);
-
-  if (snap_curr.sim_time < 0.0)
+  const FramePair frames = frames_.acquire();
+  if (!frames)
     return false; // nothing published yet
 
-  out_prev = snap_prev;
-  out_curr = snap_curr;
+  out_prev = frames.prev();
+  out_curr = frames.curr();
   return true;
 }
 
-// Runs queued UI commands on the physics thread.  Swap under the lock,
-// execute outside it, so command bodies can't deadlock against the queue.
+// Runs queued UI commands on the physics thread.  Pops at most one ring's
+// worth, so producers can't keep a step draining forever.
+//
+// Effort coalescing: inside a run of consecutive set_rider_effort records,
+// only the last per rider survives.  Anything else in between (a schedule,
+// policy, follow...) ends the run, since it can change whether an effort
+// applies at all — across it, each side keeps its own last effort.
 void Simulation::drain_commands() {
-  std::vector<std::function<void()>> cmds;
-  {
-    std::scoped_lock lock(commands_mtx);
-    cmds.swap(pending_commands);
+  drained_.clear();
+  SimCommand cmd;
+  while (drained_.size() < kCommandCapacity && commands_.pop(cmd))
+    drained_.push_back(std::move(cmd));
+
+  // Walk back to front: the first effort met per rider is its last.
+  effort_seen_.clear();
+  for (size_t i = drained_.size(); i-- > 0;) {
+    auto* e = std::get_if<SetRiderEffortCmd>(&drained_[i]);
+    if (!e) {
+      effort_seen_.clear();
+      continue;
+    }
+    bool seen = false;
+    for (RiderId r : effort_seen_)
+      seen = seen || r == e->rider;
+    if (seen) {
+      drained_[i] = std::monostate{};
+      ++coalesced_;
+    } else {
+      effort_seen_.push_back(e->rider);
+    }
+  }
+
+  for (SimCommand& c : drained_) {
+    if (journal_ && !std::holds_alternative<std::monostate>(c))
+      journal_->record(c); // copied before apply moves out of it
+    apply_command(c);
+  }
+  drained_.clear();
+}
+
+void Simulation::start_journal(InputJournal* journal) {
+  journal_ = journal;
+  if (journal_)
+    journal_->begin(save_checkpoint(), dt);
+}
+
+void Simulation::end_journal(const char* why) {
+  if (!journal_)
+    return;
+  sim_log("Simulation: input journal ended by %s", why);
+  journal_ = nullptr;
+}
+
+void Simulation::queue_command(SimCommand cmd) {
+  commands_.push(std::move(cmd));
+}
+
+void Simulation::apply_command(SimCommand& cmd) {
+  if (auto* c = std::get_if<SetRiderEffortCmd>(&cmd)) {
+    // The slider acts only in Manual mode; Follow and Schedule own the
+    // rider's effort exclusively while active.
+    if (get_effort_source(c->rider) == EffortSource::Manual)
+      engine.set_rider_effort(c->rider, c->effort);
+  } else if (auto* c = std::get_if<SetEffortScheduleCmd>(&cmd)) {
+    effort_schedules[c->rider] = std::move(c->schedule);
+    decision_.clear_policy(c->rider); // schedule replaces any policy (C2)
+  } else if (auto* c = std::get_if<ClearEffortScheduleCmd>(&cmd)) {
+    effort_schedules.erase(c->rider);
+  } else if (auto* c = std::get_if<SetRiderPolicyCmd>(&cmd)) {
+    effort_schedules.erase(c->rider); // policy replaces any schedule (C2)
+    decision_.set_policy(c->rider, std::move(c->policy));
+  } else if (auto* c = std::get_if<ClearRiderPolicyCmd>(&cmd)) {
+    decision_.clear_policy(c->rider);
+  } else if (auto* c = std::get_if<SetRacePlanCmd>(&cmd)) {
+    decision_.set_race_plan(c->team, std::move(c->plan));
+  } else if (auto* c = std::get_if<SetFollowTargetCmd>(&cmd)) {
+    engine.set_follow_target(c->rider, c->target, c->relation);
+  } else if (auto* c = std::get_if<ClearFollowTargetCmd>(&cmd)) {
+    engine.clear_follow_target(c->rider);
+  } else if (auto* c = std::get_if<SetPacelineRotationCmd>(&cmd)) {
+    engine.set_paceline_rotation(c->roster, c->params);
+  } else if (std::holds_alternative<ClearPacelineRotationCmd>(cmd)) {
+    engine.clear_paceline_rotation();
+  } else if (auto* c = std::get_if<PromoteSitterCmd>(&cmd)) {
+    engine.promote_sitter(c->rider);
+  } else if (auto* c = std::get_if<RequestPacelineJoinCmd>(&cmd)) {
+    engine.request_paceline_join(c->rider, c->sits_in);
   }
-  for (auto& cmd : cmds)
-    cmd();
+  // monostate: an empty record or a coalesced effort — nothing to do.
 }
 
 void Simulation::step_fixed(double dt) {
@@ -884,6 +1459,8 @@ void Simulation::step_fixed(double dt) {
     if (!engine.has_follow_target(id))
       engine.set_rider_effort(id, sched->effort_at(sim_seconds));
 
+  FrameSnapshot* slot = frames_.begin();
+  FrameSnapshot& snap_back = slot ? *slot : dropped_frame_;
   engine.step_and_snapshot(dt, snap_back);
 
   sim_seconds += dt;
@@ -904,103 +1481,197 @@ void Simulation::step_fixed(double dt) {
   }
 
   // C2: stamp effort ownership into the frame (only Simulation knows about
-  // schedules and policies).
-  for (auto& [id, snap] : snap_back.riders) {
-    snap.effort_source = get_effort_source(id);
-    if (const IRiderPolicy* p = decision_.get_policy(id))
-      snap.policy = p->name();
+  // schedules and policies).  Policy names are interned: a new name swaps
+  // the frame's table, a known one is an id lookup.
+  StringInterner& strings = engine.get_strings();
+  for (RiderSnapshot& snap : snap_back.riders) {
+    snap.effort_source = get_effort_source(snap.id);
+    if (const IRiderPolicy* p = decision_.get_policy(snap.id))
+      snap.policy = strings.intern(p->name());
   }
+  snap_back.strings = strings.table();
 
   snap_back.sim_time = sim_seconds;
   snap_back.sim_dt = dt;
   snap_back.time_factor = time_factor;
 
-  publish_snapshot(); // acquires snapshot_swap_mtx
+  if (slot)
+    publish_snapshot(snap_back);
+  if (journal_)
+    journal_->end_step();
 }
 
 void Simulation::set_effort_schedule(int rider_id,
                                      std::shared_ptr<EffortSchedule> schedule) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back([this, rider_id, s = std::move(schedule)]() {
-    effort_schedules[rider_id] = s;
-    decision_.clear_policy(rider_id); // schedule replaces any policy (C2)
-  });
+  commands_.push(SetEffortScheduleCmd{rider_id, std::move(schedule)});
 }
 
 void Simulation::set_rider_policy(RiderId rider_id,
                                   std::shared_ptr<IRiderPolicy> policy) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back([this, rider_id, p = std::move(policy)]() {
-    effort_schedules.erase(rider_id); // policy replaces any schedule (C2)
-    decision_.set_policy(rider_id, p);
-  });
+  commands_.push(SetRiderPolicyCmd{rider_id, std::move(policy)});
 }
 
 void Simulation::clear_rider_policy(RiderId rider_id) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back(
-      [this, rider_id]() { decision_.clear_policy(rider_id); });
+  commands_.push(ClearRiderPolicyCmd{rider_id});
 }
 
 void Simulation::set_race_plan(TeamId team, RacePlan plan) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back([this, team, p = std::move(plan)]() {
-    decision_.set_race_plan(team, p);
-  });
+  commands_.push(SetRacePlanCmd{team, std::move(plan)});
 }
 
 void Simulation::clear_effort_schedule(RiderId rider_id) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back(
-      [this, rider_id]() { effort_schedules.erase(rider_id); });
+  commands_.push(ClearEffortScheduleCmd{rider_id});
 }
 
 void Simulation::set_rider_effort(RiderId rider_id, double effort) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back([this, rider_id, effort]() {
-    // The slider acts only in Manual mode; Follow and Schedule own the
-    // rider's effort exclusively while active.
-    if (get_effort_source(rider_id) == EffortSource::Manual)
-      engine.set_rider_effort(rider_id, effort);
-  });
+  commands_.push(SetRiderEffortCmd{rider_id, effort});
 }
 
 void Simulation::set_follow_target(RiderId rider, RiderId target,
                                    FollowRelation relation) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back([this, rider, target, relation]() {
-    engine.set_follow_target(rider, target, relation);
-  });
+  commands_.push(SetFollowTargetCmd{rider, target, relation});
 }
 
 void Simulation::clear_follow_target(RiderId rider) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back(
-      [this, rider]() { engine.clear_follow_target(rider); });
+  commands_.push(ClearFollowTargetCmd{rider});
 }
 
 void Simulation::set_paceline_rotation(std::vector<RotationMember> roster,
                                        RotationParams params) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back([this, roster = std::move(roster), params]() {
-    engine.set_paceline_rotation(roster, params);
-  });
+  commands_.push(SetPacelineRotationCmd{std::move(roster), params});
 }
 
 void Simulation::clear_paceline_rotation() {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back([this]() { engine.clear_paceline_rotation(); });
+  commands_.push(ClearPacelineRotationCmd{});
 }
 
 void Simulation::promote_sitter(RiderId id) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back([this, id]() { engine.promote_sitter(id); });
+  commands_.push(PromoteSitterCmd{id});
 }
 
 void Simulation::request_paceline_join(RiderId id, bool sits_in) {
-  std::scoped_lock lock(commands_mtx);
-  pending_commands.push_back(
-      [this, id, sits_in]() { engine.request_paceline_join(id, sits_in); });
+  commands_.push(RequestPacelineJoinCmd{id, sits_in});
+}
+
+// Header, payload (setup records, then state), hash patched in last.
+std::vector<char> Simulation::save_checkpoint() const {
+  CheckpointWriter w;
+  for (char c : kCheckpointMagic)
+    w.pod(c);
+  w.pod(kCheckpointVersion);
+  w.pod(static_cast<std::uint32_t>(sizeof(RiderState)));
+  w.pod(static_cast<std::uint32_t>(sizeof(EnvState)));
+  const std::size_t size_at = w.size();
+  w.pod(std::uint64_t{0}); // payload bytes
+  w.pod(std::uint64_t{0}); // payload hash
+  const std::size_t payload_at = w.size();
+
+  engine.save_setup(w);
+  decision_.save_setup(w);
+  w.pods(sorted_keys(effort_schedules));
+
+  engine.save_state(w);
+  decision_.save_state(w);
+  w.pod(sim_seconds);
+  w.pod(decision_accum_);
+  w.pod(dt);
+
+  const std::size_t payload = w.size() - payload_at;
+  w.patch(size_at, static_cast<std::uint64_t>(payload));
+  w.patch(size_at + sizeof(std::uint64_t),
+          checkpoint_hash(w.bytes().data() + payload_at, payload));
+  return std::move(w.bytes());
+}
+
+bool Simulation::load_checkpoint(const std::vector<char>& bytes) {
+  CheckpointReader r(bytes.data(), bytes.size());
+  char magic[sizeof(kCheckpointMagic)] = {};
+  std::uint32_t version = 0, rider_size = 0, env_size = 0;
+  std::uint64_t payload = 0, hash = 0;
+  for (char& c : magic)
+    r.pod(c);
+  r.pod(version);
+  r.pod(rider_size);
+  r.pod(env_size);
+  r.pod(payload);
+  r.pod(hash);
+
+  if (!r.ok() ||
+      std::memcmp(magic, kCheckpointMagic, sizeof(magic)) != 0) {
+    r.fail("not a checkpoint");
+  } else if (version != kCheckpointVersion || rider_size != sizeof(RiderState) ||
+             env_size != sizeof(EnvState)) {
+    r.fail("checkpoint from another format version or build");
+  } else if (payload != r.remaining() ||
+             hash != checkpoint_hash(r.data(), r.remaining())) {
+    r.fail("checkpoint is truncated or corrupt");
+  } else if (engine.check_setup(r) && decision_.check_setup(r)) {
+    std::vector<RiderId> schedules;
+    r.pods(schedules);
+    if (r.ok() && schedules != sorted_keys(effort_schedules))
+      r.fail("effort schedules differ from the checkpoint's");
+  }
+  if (!r.ok()) {
+    sim_log("Simulation::load_checkpoint: %s", r.error());
+    return false;
+  }
+
+  // Setup matched and the bytes are intact: from here on the load cannot
+  // fail short of a checkpoint written by a buggy build.
+  if (engine.load_state(r))
+    decision_.load_state(r);
+  r.pod(sim_seconds);
+  r.pod(decision_accum_);
+  r.pod(dt);
+  if (!r.ok() || !r.at_end()) {
+    sim_log("Simulation::load_checkpoint: %s (state left partial)",
+            r.ok() ? "trailing bytes" : r.error());
+    return false;
+  }
+
+  end_journal("load_checkpoint()");
+  // Queued commands belonged to the saved-over run; frames too.
+  SimCommand discarded;
+  while (commands_.pop(discarded)) {
+  }
+  frames_.clear();
+  return true;
+}
+
+Simulation::Setup Simulation::copy_setup() const {
+  return Setup{decision_.copy_setup(), effort_schedules};
+}
+
+void Simulation::restore_setup(const Setup& setup) {
+  decision_.restore_setup(setup.decision);
+  effort_schedules = setup.schedules;
+}
+
+bool Simulation::save_checkpoint_file(const std::string& path) const {
+  const std::vector<char> bytes = save_checkpoint();
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  if (!out) {
+    sim_log("Simulation::save_checkpoint_file: cannot write %s", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool Simulation::load_checkpoint_file(const std::string& path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    sim_log("Simulation::load_checkpoint_file: cannot open %s", path.c_str());
+    return false;
+  }
+  std::vector<char> bytes(static_cast<size_t>(in.tellg()));
+  in.seekg(0);
+  in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  if (!in) {
+    sim_log("Simulation::load_checkpoint_file: cannot read %s", path.c_str());
+    return false;
+  }
+  return load_checkpoint(bytes);
 }
 
 EffortSource Simulation::get_effort_source(RiderId rider_id) const {
@@ -1017,32 +1688,27 @@ EffortSource Simulation::get_effort_source(RiderId rider_id) const {
 // RealtimeSimRunner::stop()). No locking needed because there's no
 // concurrent access.
 void Simulation::reset() {
+  end_journal("reset()");
   sim_seconds = 0.0;
   decision_accum_ = 0.0;
   effort_schedules.clear();
   engine.clear_paceline_rotation();
   engine.clear_auto_rotations();
   engine.clear_follow_targets();
+  engine.reset_schedule();
   decision_.reset(); // drops traces and policies
-  {
-    std::scoped_lock lock(commands_mtx);
-    pending_commands.clear();
+  SimCommand discarded;
+  while (commands_.pop(discarded)) {
   }
 
-  // Clear the published snapshot buffers back to the "nothing published"
-  // sentinel (sim_time -1).  Without this, publish_snapshot()'s monotonicity
-  // guard (snap_back.sim_time <= snap_curr.sim_time) silently drops every
-  // frame of the new run until its clock passes the old run's final time —
-  // the display stays frozen for exactly that long.
-  {
-    std::scoped_lock lock(snapshot_swap_mtx);
-    snap_prev = FrameSnapshot{};
-    snap_curr = FrameSnapshot{};
-    snap_back = FrameSnapshot{};
-  }
+  // Clear the published frames back to "nothing published".  Without this,
+  // publish_snapshot()'s monotonicity guard (back.sim_time <= curr.sim_time)
+  // silently drops every frame of the new run until its clock passes the
+  // old run's final time — the display stays frozen for exactly that long.
+  frames_.clear();
 
-  // get_riders() returns const ref, but unique_ptr<Rider> still lets us
-  // call non-const methods on the Rider through the pointer.
+  // get_riders() returns const ref, but the table still hands out mutable
+  // Rider pointers (see rider_table.h).
   for (const auto& [id, r] : engine.get_riders())
     r->reset();
 }
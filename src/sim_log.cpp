@@ -0,0 +1,42 @@
+#include "sim_log.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+
+void stderr_sink(const char* message, void*) {
+  std::fprintf(stderr, "%s\n", message);
+}
+
+// One record, swapped whole, so a message never pairs one sink with
+// another's user pointer.
+struct SinkRecord {
+  LogSink sink;
+  void* user;
+};
+
+SinkRecord default_record{stderr_sink, nullptr};
+std::atomic<const SinkRecord*> current{&default_record};
+
+} // namespace
+
+void set_log_sink(LogSink sink, void* user) {
+  // Installed records live for the program: a logger may still hold the
+  // previous one.  Sinks are set a handful of times per run at most.
+  const SinkRecord* rec =
+      sink ? new SinkRecord{sink, user} : &default_record;
+  current.store(rec, std::memory_order_release);
+}
+
+void sim_log(const char* fmt, ...) {
+  char buf[1024];
+  va_list args;
+  va_start(args, fmt);
+  std::vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+
+  const SinkRecord* rec = current.load(std::memory_order_acquire);
+  rec->sink(buf, rec->user);
+}
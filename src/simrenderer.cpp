@@ -3,6 +3,7 @@
 #include "display.h"
 #include "sim.h"
 #include "snapshot.h"
+#include "trace_replay.h"
 #include <limits>
 #include <memory>
 
@@ -13,8 +14,8 @@ SimulationRenderer::SimulationRenderer(SDL_Renderer* r,
     : CoreRenderer(r, resources), sim(sim_), camera(std::move(cam)) {
   build_and_swap_snapshots();
   // this could probably be removed
-  if (frame_curr.riders.count(0)) {
-    camera->set_center(frame_curr.riders.at(0).pos2d);
+  if (const RiderSnapshot* r0 = curr_frame().find(0)) {
+    camera->set_center(r0->pos2d());
   }
 }
 
@@ -28,8 +29,29 @@ void SimulationRenderer::set_ui_root(std::unique_ptr<UIRoot> root) {
   ui_root = std::move(root);
 }
 
+void SimulationRenderer::set_replay(TraceReplay* r) {
+  replay = r;
+  build_and_swap_snapshots();
+}
+
+const FrameSnapshot& SimulationRenderer::prev_frame() const {
+  return replay ? replay_prev : frames.prev();
+}
+
+const FrameSnapshot& SimulationRenderer::curr_frame() const {
+  return replay ? replay_curr : frames.curr();
+}
+
+// Keeps the previous pair until something is published, as the copying
+// version did.  A replay builds its pair into the renderer's own frames,
+// which keep their capacity from one call to the next.
 void SimulationRenderer::build_and_swap_snapshots() {
-  sim->consume_latest_frame_pair(frame_prev, frame_curr);
+  if (replay) {
+    replay->consume_latest_frame_pair(replay_prev, replay_curr);
+    return;
+  }
+  if (FramePair latest = sim->acquire_frames())
+    frames = std::move(latest);
 }
 
 void SimulationRenderer::update() {
@@ -41,6 +63,9 @@ void SimulationRenderer::render_frame() {
   SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
   SDL_RenderClear(renderer);
 
+  const FrameSnapshot& frame_prev = prev_frame();
+  const FrameSnapshot& frame_curr = curr_frame();
+
   RenderContext ctx;
   ctx.renderer = renderer;
   ctx.resources = resources;
@@ -49,9 +74,9 @@ void SimulationRenderer::render_frame() {
   // Read the live control value, not the snapshot stamp: while the sim is
   // paused no snapshots are published, but set_time_factor() takes effect
   // immediately (atomic), and the UI should reflect it.
-  ctx.time_factor = sim->get_time_factor();
+  ctx.time_factor = replay ? replay->get_speed() : sim->get_time_factor();
 
-  double now = SDL_GetTicks() / 1000.0;
+  double now = frame_clock_seconds();
   const double sim_dt = frame_curr.sim_time - frame_prev.sim_time;
   const double real_since_curr = now - frame_curr.real_time;
 
@@ -63,20 +88,20 @@ void SimulationRenderer::render_frame() {
   ctx.interp_sim_time =
       frame_prev.sim_time * (1.0 - ctx.alpha) + frame_curr.sim_time * ctx.alpha;
 
-  for (const auto& [id, s1] : frame_curr.riders) {
-    auto it0 = frame_prev.riders.find(id);
-    if (it0 == frame_prev.riders.end())
+  for (const RiderSnapshot& s1 : frame_curr.riders) {
+    const RiderSnapshot* p0 = frame_prev.find(s1.id);
+    if (!p0)
       continue;
-    const RiderSnapshot& s0 = it0->second;
+    const RiderSnapshot& s0 = *p0;
 
     RiderRenderState rs;
     // Interpolated
-    rs.pos2d = s0.pos2d * (1.0 - ctx.alpha) + s1.pos2d * ctx.alpha;
+    rs.pos2d = s0.pos2d() * (1.0 - ctx.alpha) + s1.pos2d() * ctx.alpha;
     rs.lat_pos = s0.lat_pos * (1.0 - ctx.alpha) + s1.lat_pos * ctx.alpha;
 
     // Non-interpolated from curr_frame
     rs.id = s1.id;
-    rs.name = s1.name;
+    rs.name = frame_curr.str(s1.name);
     rs.effort = s1.effort;
     rs.max_effort = s1.max_effort;
     rs.pos = s1.pos;
@@ -93,15 +118,14 @@ void SimulationRenderer::render_frame() {
     rs.group_id = s1.group_id;
     rs.group_role = s1.group_role;
     rs.effort_source = s1.effort_source;
-    rs.policy = s1.policy;
+    rs.policy = frame_curr.str(s1.policy);
     // rs.power_breakdown = s1.power_breakdown;
 
-    ctx.riders[id] = std::move(rs);
+    ctx.riders[s1.id] = std::move(rs);
   }
 
-  ctx.groups = frame_curr.groups;
-  // NOTE This is a value copy of a std::vector<Group>. At N ≤ 20 riders this is
-  // well under 1 KB. No allocation concern.
+  ctx.groups = frame_curr.groups; // plain data: one block
+  ctx.strings = frame_curr.strings.get();
 
   camera->update(ctx.riders);
 
@@ -129,10 +153,10 @@ RiderId SimulationRenderer::pick_rider(double screen_x, double screen_y) const {
   RiderId found_id = -1;
   float best_d2 = std::numeric_limits<float>::max();
 
-  for (const auto& [id, snap] : frame_curr.riders) {
+  for (const RiderSnapshot& snap : curr_frame().riders) {
     const RiderVisualModel& model = resolve_visual_model(snap.visual_type);
     const SDL_FRect rect =
-        rider_sprite_rect(*camera, model, snap.pos2d, snap.lat_pos);
+        rider_sprite_rect(*camera, model, snap.pos2d(), snap.lat_pos);
 
     if (!SDL_PointInRectFloat(&p, &rect))
       continue;
@@ -144,7 +168,7 @@ RiderId SimulationRenderer::pick_rider(double screen_x, double screen_y) const {
     const float d2 = (cx - p.x) * (cx - p.x) + (cy - p.y) * (cy - p.y);
     if (d2 < best_d2) {
       best_d2 = d2;
-      found_id = id;
+      found_id = snap.id;
     }
   }
 
@@ -153,15 +177,13 @@ RiderId SimulationRenderer::pick_rider(double screen_x, double screen_y) const {
   return found_id;
 }
 
+// Frames list riders front to back already.
 std::vector<RiderId> SimulationRenderer::get_rider_ids() const {
+  const FrameSnapshot& frame_curr = curr_frame();
   std::vector<RiderId> ids;
   ids.reserve(frame_curr.riders.size());
-  for (const auto& [id, _] : frame_curr.riders)
-    ids.push_back(id);
-
-  std::sort(ids.begin(), ids.end(), [&](RiderId a, RiderId b) {
-    return frame_curr.riders.at(a).pos >= frame_curr.riders.at(b).pos;
-  });
+  for (const RiderSnapshot& snap : frame_curr.riders)
+    ids.push_back(snap.id);
   return ids;
 }
 
@@ -0,0 +1,527 @@
+#include "telemetry.h"
+#include "sim.h"
+#include "sim_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Positions are smooth to second order at physics rate: extrapolating the
+// last two samples leaves a residual of a few mm, one varint byte.
+constexpr bool kSecondOrder[kTelemetryColumns] = {true,  false, false,
+                                                  false, false, false,
+                                                  false, false, false};
+
+// Round to the column's fixed point, to nearest even: adding 1.5 x 2^52
+// leaves the rounded integer in the low mantissa bits.  No branch or libm
+// call — this runs seven times per rider per tick.  Values must stay within
+// int32 range of the scale; infinities and the default NaN store 0.
+inline std::int32_t quantise(double v, int column) {
+  const double x = v * (1.0 / kTelemetryScale[column]) + 6755399441055744.0;
+  std::int64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return static_cast<std::int32_t>(bits);
+}
+
+std::int64_t predict(std::int64_t p, std::int64_t pp, std::uint32_t t,
+                     int column) {
+  if (t == 0)
+    return 0;
+  return kSecondOrder[column] && t >= 2 ? 2 * p - pp : p;
+}
+
+void put_varint(std::vector<char>& out, std::int64_t d) {
+  std::uint64_t z = (static_cast<std::uint64_t>(d) << 1) ^
+                    static_cast<std::uint64_t>(d >> 63); // zigzag
+  while (z >= 0x80) {
+    out.push_back(static_cast<char>((z & 0x7F) | 0x80));
+    z >>= 7;
+  }
+  out.push_back(static_cast<char>(z));
+}
+
+bool get_varint(const char*& p, const char* end, std::int64_t& d) {
+  std::uint64_t z = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (p == end)
+      return false;
+    const auto b = static_cast<unsigned char>(*p++);
+    z |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      d = static_cast<std::int64_t>(z >> 1) ^
+          -static_cast<std::int64_t>(z & 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+void encode_telemetry_chunk(const TelemetryChunk& c, std::uint32_t riders,
+                            bool delta, std::vector<char>& out) {
+  out.clear();
+  const std::size_t stride = c.raw.size() / kTelemetryColumns;
+  const char* times = reinterpret_cast<const char*>(c.times.data());
+  out.insert(out.end(), times, times + c.ticks * sizeof(double));
+
+  for (int col = 0; col < kTelemetryColumns; ++col) {
+    const std::int32_t* block = c.raw.data() + col * stride;
+    if (!delta) {
+      const char* b = reinterpret_cast<const char*>(block);
+      out.insert(out.end(), b,
+                 b + std::size_t(c.ticks) * riders * sizeof(std::int32_t));
+      continue;
+    }
+    for (std::uint32_t slot = 0; slot < riders; ++slot) {
+      std::int64_t p = 0, pp = 0;
+      for (std::uint32_t t = 0; t < c.ticks; ++t) {
+        const std::int64_t v = block[std::size_t(t) * riders + slot];
+        put_varint(out, v - predict(p, pp, t, col));
+        pp = p;
+        p = v;
+      }
+    }
+  }
+}
+
+bool decode_telemetry_chunk(const char* data, std::size_t bytes,
+                            std::uint32_t ticks, std::uint32_t riders,
+                            bool delta, TelemetryChunk& c) {
+  const std::size_t cells = std::size_t(ticks) * riders;
+  const std::size_t times_bytes = ticks * sizeof(double);
+  if (bytes < times_bytes ||
+      (!delta && bytes != times_bytes + kTelemetryColumns * cells * 4))
+    return false;
+  c.ticks = ticks;
+  c.times.resize(ticks);
+  std::memcpy(c.times.data(), data, times_bytes);
+  c.raw.resize(kTelemetryColumns * cells);
+  if (!delta) {
+    std::memcpy(c.raw.data(), data + times_bytes, c.raw.size() * 4);
+    return true;
+  }
+
+  const char* p = data + times_bytes;
+  const char* end = data + bytes;
+  for (int col = 0; col < kTelemetryColumns; ++col) {
+    std::int32_t* block = c.raw.data() + col * cells;
+    for (std::uint32_t slot = 0; slot < riders; ++slot) {
+      std::int64_t prev = 0, prev2 = 0;
+      for (std::uint32_t t = 0; t < ticks; ++t) {
+        std::int64_t d;
+        if (!get_varint(p, end, d))
+          return false;
+        const std::int64_t v = predict(prev, prev2, t, col) + d;
+        if (v < std::numeric_limits<std::int32_t>::min() ||
+            v > std::numeric_limits<std::int32_t>::max())
+          return false;
+        block[std::size_t(t) * riders + slot] = static_cast<std::int32_t>(v);
+        prev2 = prev;
+        prev = v;
+      }
+    }
+  }
+  return p == end;
+}
+
+// --- recorder ---
+
+TelemetryRecorder::TelemetryRecorder(std::string path, TelemetryOptions opts)
+    : path_(std::move(path)), opts_(opts),
+      full_(opts.max_chunks), free_(opts.max_chunks) {
+  opts_.chunk_ticks = std::max<std::uint32_t>(opts_.chunk_ticks, 1);
+  opts_.max_chunks = std::max<std::size_t>(opts_.max_chunks, 2);
+}
+
+TelemetryRecorder::~TelemetryRecorder() { finish(); }
+
+void TelemetryRecorder::fail(const char* what) {
+  if (!failed_.exchange(true))
+    sim_log("TelemetryRecorder: %s (%s)", what, path_.c_str());
+}
+
+void TelemetryRecorder::on_start(const Simulation& sim) {
+  finish(); // a recorder reused for another run starts a new trace
+  failed_.store(false);
+  stop_.store(false);
+  const RiderTable& riders = sim.get_engine()->get_riders();
+  riders_ = static_cast<std::uint32_t>(riders.size());
+  std::unique_ptr<TelemetryChunk> stale;
+  while (free_.pop(stale)) {
+  }
+  filling_.reset();
+  allocated_ = 0;
+  ticks_ = dropped_ = 0;
+  offset_ = written_ticks_ = 0;
+  index_.clear();
+
+  out_.open(path_, std::ios::binary | std::ios::trunc);
+  if (!out_) {
+    fail("cannot open the trace");
+    return;
+  }
+
+  TelemetryFileHeader h{};
+  std::memcpy(h.magic, kTelemetryMagic, sizeof(h.magic));
+  h.version = kTelemetryVersion;
+  h.flags = opts_.delta ? kTelemetryDelta : 0;
+  h.riders = riders_;
+  h.columns = kTelemetryColumns;
+  h.chunk_ticks = opts_.chunk_ticks;
+  h.dt = sim.get_dt();
+  h.course_length = sim.get_engine()->get_course()->get_total_length();
+  out_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+  for (const auto& [id, r] : riders) {
+    const RiderConfig cfg = r->get_config();
+    TelemetryRiderInfo info{};
+    info.id = id;
+    info.team_id = cfg.team_id;
+    info.bike_type = static_cast<std::int32_t>(cfg.bike.type);
+    info.max_effort = cfg.max_effort;
+    info.w_prime = cfg.w_prime_base;
+    std::strncpy(info.name, cfg.name.c_str(), sizeof(info.name) - 1);
+    out_.write(reinterpret_cast<const char*>(&info), sizeof(info));
+  }
+  offset_ = sizeof(h) + riders_ * sizeof(TelemetryRiderInfo);
+  if (!out_) {
+    fail("cannot write the trace header");
+    out_.close();
+    return;
+  }
+
+  filling_ = take_chunk();
+  open_ = true;
+  writer_ = std::thread(&TelemetryRecorder::writer_loop, this);
+}
+
+std::unique_ptr<TelemetryChunk> TelemetryRecorder::take_chunk() {
+  std::unique_ptr<TelemetryChunk> c;
+  if (free_.pop(c))
+    return c;
+  if (allocated_ >= opts_.max_chunks)
+    return nullptr;
+  ++allocated_;
+  c = std::make_unique<TelemetryChunk>();
+  c->times.resize(opts_.chunk_ticks);
+  c->raw.resize(std::size_t(kTelemetryColumns) * opts_.chunk_ticks * riders_);
+  return c;
+}
+
+void TelemetryRecorder::on_step(const Simulation& sim) {
+  if (!open_)
+    return;
+  const RiderTable& riders = sim.get_engine()->get_riders();
+  if (static_cast<std::uint32_t>(riders.size()) != riders_) {
+    fail("the roster changed while recording");
+    return;
+  }
+
+  const GroupTracker& groups = sim.get_engine()->get_group_tracker();
+  if (groups.revision() != group_revision_)
+    refresh_groups(riders, groups);
+
+  if (filling_->ticks == opts_.chunk_ticks) {
+    if (std::unique_ptr<TelemetryChunk> next = take_chunk()) {
+      full_.push(std::move(filling_)); // never full: it holds every chunk
+      filling_ = std::move(next);
+    } else {
+      ++dropped_; // the writer is max_chunks behind: lose this one
+      ticks_ -= filling_->ticks;
+    }
+    filling_->ticks = 0;
+  }
+
+  const std::uint32_t t = filling_->ticks++;
+  filling_->times[t] = sim.get_sim_seconds();
+  const std::size_t stride = std::size_t(opts_.chunk_ticks) * riders_;
+  std::int32_t* row = filling_->raw.data() + std::size_t(t) * riders_;
+  for (int slot = 0; slot < riders.size(); ++slot) {
+    const Rider& r = riders[slot];
+    std::int32_t* cell = row + slot;
+    cell[0 * stride] = quantise(r.get_pos(), 0);
+    cell[1 * stride] = quantise(r.get_speed(), 1);
+    cell[2 * stride] = quantise(r.get_power(), 2);
+    cell[3 * stride] = quantise(r.get_effort(), 3);
+    cell[4 * stride] = quantise(r.get_energy(), 4);
+    cell[5 * stride] = quantise(r.get_cda_factor(), 5);
+    cell[6 * stride] = quantise(r.get_lat_pos(), 6);
+  }
+  std::copy(group_ids_.begin(), group_ids_.end(), row + 7 * stride);
+  std::copy(group_roles_.begin(), group_roles_.end(), row + 8 * stride);
+  ++ticks_;
+}
+
+// Group ids and roles come from the tracker, keyed by RiderId; they only
+// change at the group rate, so the slot-order copy is rebuilt then.
+void TelemetryRecorder::refresh_groups(const RiderTable& riders,
+                                       const GroupTracker& groups) {
+  group_revision_ = groups.revision();
+  group_ids_.assign(riders_, kNoGroup);
+  group_roles_.assign(riders_, GroupRole::Unassigned);
+  for (const Group& g : groups.get_snapshot())
+    for (const auto* members : {&g.paceline, &g.body})
+      for (const GroupMember& m : *members) {
+        const int slot = riders.slot_of(m.id);
+        if (slot < 0)
+          continue;
+        group_ids_[slot] = g.id;
+        group_roles_[slot] = m.role;
+      }
+}
+
+void TelemetryRecorder::on_finish(const Simulation&) { finish(); }
+
+void TelemetryRecorder::writer_loop() {
+  std::unique_ptr<TelemetryChunk> c;
+  for (;;) {
+    // Read before popping: once stop_ is seen, every chunk pushed before
+    // it is poppable, so an empty pop after it means done.
+    const bool stopping = stop_.load(std::memory_order_acquire);
+    if (full_.pop(c)) {
+      write_chunk(*c);
+      c->ticks = 0;
+      free_.push(std::move(c));
+      continue;
+    }
+    if (stopping)
+      return;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+}
+
+void TelemetryRecorder::write_chunk(const TelemetryChunk& c) {
+  if (!ok())
+    return;
+  encode_telemetry_chunk(c, riders_, opts_.delta, scratch_);
+  const TelemetryChunkHeader h{kTelemetryChunkMagic, c.ticks,
+                               static_cast<std::uint64_t>(scratch_.size())};
+  index_.push_back(TelemetryIndexEntry{offset_, c.times[0]});
+  out_.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  out_.write(scratch_.data(), static_cast<std::streamsize>(scratch_.size()));
+  if (!out_)
+    fail("cannot write a chunk");
+  offset_ += sizeof(h) + scratch_.size();
+  written_ticks_ += c.ticks;
+}
+
+void TelemetryRecorder::finish() {
+  if (!open_)
+    return;
+  open_ = false;
+  if (filling_ && filling_->ticks > 0)
+    full_.push(std::move(filling_));
+  stop_.store(true, std::memory_order_release);
+  writer_.join();
+
+  if (ok()) {
+    const std::uint64_t index_offset = offset_;
+    out_.write(reinterpret_cast<const char*>(index_.data()),
+               static_cast<std::streamsize>(index_.size() *
+                                            sizeof(TelemetryIndexEntry)));
+    offset_ += index_.size() * sizeof(TelemetryIndexEntry);
+
+    // Patch the header fields only the end knows, in place.
+    out_.seekp(offsetof(TelemetryFileHeader, ticks));
+    const std::uint64_t tail[3] = {written_ticks_, index_.size(),
+                                   index_offset};
+    out_.write(reinterpret_cast<const char*>(tail), sizeof(tail));
+    if (!out_)
+      fail("cannot write the index");
+  }
+  out_.close();
+}
+
+// --- reader ---
+
+TelemetryReader::~TelemetryReader() { close(); }
+
+void TelemetryReader::close() {
+  if (map_)
+    munmap(const_cast<char*>(map_), size_);
+  map_ = nullptr;
+  size_ = 0;
+  header_ = {};
+  riders_.clear();
+  index_.clear();
+  for (Cached& c : cache_)
+    c.chunk = ~0ull;
+  chunk_loads_ = 0;
+}
+
+bool TelemetryReader::open(const std::string& path) {
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  struct stat st {};
+  if (fd < 0 || fstat(fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < sizeof(header_)) {
+    if (fd >= 0)
+      ::close(fd);
+    sim_log("TelemetryReader: cannot read %s", path.c_str());
+    return false;
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  void* m = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps the file
+  if (m == MAP_FAILED) {
+    size_ = 0;
+    sim_log("TelemetryReader: cannot map %s", path.c_str());
+    return false;
+  }
+  map_ = static_cast<const char*>(m);
+
+  std::memcpy(&header_, map_, sizeof(header_));
+  if (std::memcmp(header_.magic, kTelemetryMagic, sizeof(header_.magic)) ||
+      header_.version != kTelemetryVersion ||
+      header_.columns != kTelemetryColumns || header_.chunk_ticks == 0) {
+    sim_log("TelemetryReader: %s is not a telemetry trace", path.c_str());
+    close();
+    return false;
+  }
+  if (header_.index_offset == 0) {
+    sim_log("TelemetryReader: %s was not finished", path.c_str());
+    close();
+    return false;
+  }
+
+  const std::size_t roster = header_.riders * sizeof(TelemetryRiderInfo);
+  const std::size_t index = header_.chunks * sizeof(TelemetryIndexEntry);
+  if (sizeof(header_) + roster > size_ || header_.index_offset > size_ ||
+      header_.chunks > size_ / sizeof(TelemetryIndexEntry) ||
+      index > size_ - header_.index_offset ||
+      header_.ticks > std::uint64_t(header_.chunks) * header_.chunk_ticks) {
+    sim_log("TelemetryReader: %s is truncated", path.c_str());
+    close();
+    return false;
+  }
+  riders_.resize(header_.riders);
+  index_.resize(header_.chunks);
+  std::memcpy(riders_.data(), map_ + sizeof(header_), roster);
+  std::memcpy(index_.data(), map_ + header_.index_offset, index);
+  return true;
+}
+
+double TelemetryReader::start_time() const {
+  return index_.empty() ? 0.0 : index_.front().t_first;
+}
+
+double TelemetryReader::end_time() const {
+  if (header_.ticks == 0)
+    return 0.0;
+  // The last chunk's first time plus its ticks: recorded steps are dt
+  // apart within a chunk.
+  const std::uint64_t last = header_.ticks - 1;
+  return index_.back().t_first +
+         double(last % header_.chunk_ticks) * header_.dt;
+}
+
+std::uint64_t TelemetryReader::tick_at(double t) const {
+  if (header_.ticks == 0 || t <= index_.front().t_first)
+    return 0;
+  // Without drops, chunk c starts chunk_ticks * c ticks after the first.
+  const double span = header_.dt * header_.chunk_ticks;
+  std::uint64_t c = index_.size() - 1;
+  if (span > 0.0) {
+    const double guess = std::floor((t - index_.front().t_first) / span);
+    c = std::min<std::uint64_t>(c, guess < 0.0 ? 0 : std::uint64_t(guess));
+  }
+  const auto fits = [&](std::uint64_t i) {
+    return index_[i].t_first <= t &&
+           (i + 1 == index_.size() || index_[i + 1].t_first > t);
+  };
+  if (!fits(c)) {
+    const auto it = std::upper_bound(
+        index_.begin(), index_.end(), t,
+        [](double v, const TelemetryIndexEntry& e) { return v < e.t_first; });
+    c = std::uint64_t(it - index_.begin()) - 1;
+  }
+  const double into = header_.dt > 0.0
+                          ? (t - index_[c].t_first) / header_.dt + 1e-6
+                          : 0.0;
+  const std::uint64_t first = c * header_.chunk_ticks;
+  return std::min(first + std::min<std::uint64_t>(
+                              std::uint64_t(into), header_.chunk_ticks - 1),
+                  header_.ticks - 1);
+}
+
+const TelemetryReader::Cached* TelemetryReader::load(std::uint64_t k) {
+  const std::uint64_t chunk = k / header_.chunk_ticks;
+  for (int i = 0; i < 2; ++i) {
+    if (cache_[i].chunk == chunk) {
+      recent_ = i;
+      return &cache_[i];
+    }
+  }
+  if (k >= header_.ticks || chunk >= index_.size())
+    return nullptr;
+
+  Cached& c = cache_[1 - recent_];
+  c.chunk = ~0ull;
+  ++chunk_loads_;
+  const std::uint64_t at = index_[chunk].offset;
+  TelemetryChunkHeader h{};
+  if (at > size_ || size_ - at < sizeof(h))
+    return nullptr;
+  std::memcpy(&h, map_ + at, sizeof(h));
+  const char* payload = map_ + at + sizeof(h);
+  const std::size_t cells = std::size_t(h.ticks) * header_.riders;
+  const std::size_t times_bytes = h.ticks * sizeof(double);
+  if (h.magic != kTelemetryChunkMagic || h.ticks > header_.chunk_ticks ||
+      h.bytes > size_ - at - sizeof(h))
+    return nullptr;
+
+  c.ticks = h.ticks;
+  c.times = payload;
+  if (header_.flags & kTelemetryDelta) {
+    if (!decode_telemetry_chunk(payload, h.bytes, h.ticks, header_.riders,
+                                true, c.decoded))
+      return nullptr;
+    c.raw = c.decoded.raw.data();
+  } else {
+    // In place: everything before a raw chunk's columns is a multiple of
+    // four bytes, so they are aligned for int32.
+    if (h.bytes != times_bytes + kTelemetryColumns * cells * 4)
+      return nullptr;
+    c.raw = reinterpret_cast<const std::int32_t*>(payload + times_bytes);
+  }
+  c.chunk = chunk;
+  recent_ = 1 - recent_;
+  return &c;
+}
+
+double TelemetryReader::time(std::uint64_t k) {
+  const Cached* c = load(k);
+  if (!c)
+    return std::nan("");
+  double t;
+  std::memcpy(&t, c->times + (k % header_.chunk_ticks) * sizeof(double),
+              sizeof(t));
+  return t;
+}
+
+const std::int32_t* TelemetryReader::row(std::uint64_t k, TelemetryColumn col) {
+  const Cached* c = load(k);
+  if (!c)
+    return nullptr;
+  const std::size_t cells = std::size_t(c->ticks) * header_.riders;
+  return c->raw + static_cast<int>(col) * cells +
+         (k % header_.chunk_ticks) * header_.riders;
+}
+
+double TelemetryReader::value(std::uint64_t k, int slot, TelemetryColumn c) {
+  const std::int32_t* r = row(k, c);
+  if (!r)
+    return std::nan("");
+  return r[slot] * kTelemetryScale[static_cast<int>(c)];
+}
@@ -1,7 +1,10 @@
 #include "timetrial.h"
 #include "analysis.h"
+#include "results_channel.h"
 #include "sim.h"
 
+#include <algorithm>
+
 static const double RACE_WINDOW = 7200.0; // 2h ceiling
 
 std::map<RiderId, double>
@@ -35,9 +38,54 @@ void setup_tt_schedules(Simulation* sim,
   }
 }
 
+// The leaderboard as of now, from the timeline observer's splits.
+static TimeTrialResult
+assemble_results(const Simulation& sim,
+                 const std::vector<RiderConfig>& ridercfgs,
+                 const std::vector<double>& checkpoints,
+                 const TimelineObserver& timeline_obs) {
+  const auto& raw = timeline_obs.data();
+
+  TimeTrialResult result;
+  result.checkpoint_distances = checkpoints;
+  result.sim_time = sim.get_sim_seconds();
+
+  for (const auto& cfg : ridercfgs) {
+    RiderTimeTrialResult r;
+    r.rider_id = cfg.rider_id;
+    r.name = cfg.name;
+
+    auto it = raw.find(cfg.rider_id);
+    if (it != raw.end()) {
+      r.timeline = it->second;
+    }
+    if (const Rider* rider = sim.get_engine()->get_rider_by_id(cfg.rider_id))
+      r.distance = rider->get_pos();
+    result.riders.push_back(std::move(r));
+  }
+
+  // Furthest through the checkpoints first; among riders at the same one,
+  // whoever got there fastest, then whoever is furthest since.  Finished
+  // riders thus sort by finish time, and riders with incomplete timelines
+  // (DNF) after them.
+  std::stable_sort(
+      result.riders.begin(), result.riders.end(),
+      [](const RiderTimeTrialResult& a, const RiderTimeTrialResult& b) {
+        if (a.timeline.size() != b.timeline.size())
+          return a.timeline.size() > b.timeline.size();
+        if (!a.timeline.empty() &&
+            a.timeline.back().race_time != b.timeline.back().race_time)
+          return a.timeline.back().race_time < b.timeline.back().race_time;
+        return a.distance > b.distance;
+      });
+
+  return result;
+}
+
 TimeTrialResult run_time_trial(const Course& course,
                                const std::vector<RiderConfig>& ridercfgs,
-                               double start_gap_seconds) {
+                               double start_gap_seconds,
+                               ResultsChannel<TimeTrialResult>* channel) {
   // --- Build checkpoints: 25%, 50%, 75%, finish ---
   const double length = course.get_total_length();
   std::vector<double> checkpoints = {
@@ -55,48 +103,29 @@ TimeTrialResult run_time_trial(const Course& course,
   sim->set_dt(0.1);
   sim->add_riders(ridercfgs);
   setup_tt_schedules(sim.get(), ridercfgs, start_offsets);
+  const Simulation* view = sim.get();
 
   // --- Attach timeline observer ---
   TimelineObserver timeline_obs(checkpoints, start_offsets);
 
+  // --- Publish the leaderboard so far as the race runs ---
+  ProgressObserver progress_obs(
+      [&](const Simulation& s, double progress) {
+        channel->publish(
+            assemble_results(s, ridercfgs, checkpoints, timeline_obs),
+            progress);
+      },
+      start_offsets, channel ? channel->publish_interval() : 0.25);
+
   OfflineSimulationRunner runner(std::move(sim));
   runner.add_observer(&timeline_obs);
+  if (channel) {
+    runner.add_observer(&progress_obs);
+    runner.set_cancel_flag(channel->cancel_flag());
+  }
   runner.set_end_condition(std::make_unique<FinishLineCondition>());
   runner.run();
 
   // --- Assemble results ---
-  const auto& raw = timeline_obs.data();
-
-  TimeTrialResult result;
-  result.checkpoint_distances = checkpoints;
-
-  for (const auto& cfg : ridercfgs) {
-    RiderTimeTrialResult r;
-    r.rider_id = cfg.rider_id;
-    r.name = cfg.name;
-
-    auto it = raw.find(cfg.rider_id);
-    if (it != raw.end()) {
-      r.timeline = it->second;
-    }
-    result.riders.push_back(std::move(r));
-  }
-
-  // Sort by finish time (last checkpoint = finish line).
-  // Riders with incomplete timelines (DNF) sort to the end.
-  std::sort(result.riders.begin(), result.riders.end(),
-            [&](const RiderTimeTrialResult& a, const RiderTimeTrialResult& b) {
-              bool a_finished = !a.timeline.empty() &&
-                                a.timeline.back().checkpoint_distance >= length;
-              bool b_finished = !b.timeline.empty() &&
-                                b.timeline.back().checkpoint_distance >= length;
-              if (a_finished && b_finished)
-                return a.timeline.back().race_time <
-                       b.timeline.back().race_time;
-              if (a_finished)
-                return true;
-              return false;
-            });
-
-  return result;
+  return assemble_results(*view, ridercfgs, checkpoints, timeline_obs);
 }
@@ -0,0 +1,193 @@
+#include "trace_replay.h"
+#include "course.h"
+#include "sim_log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+bool TraceReplay::open(const std::string& path, const Course* course) {
+  course_ = nullptr;
+  if (!reader_.open(path))
+    return false;
+  const TelemetryFileHeader& h = reader_.header();
+  if (!course || std::abs(course->get_total_length() - h.course_length) > 1.0) {
+    sim_log("TraceReplay: %s was not recorded on this course", path.c_str());
+    reader_.close();
+    return false;
+  }
+  course_ = course;
+
+  const std::vector<TelemetryRiderInfo>& riders = reader_.riders();
+  interner_ = StringInterner();
+  names_.resize(riders.size());
+  for (size_t slot = 0; slot < riders.size(); ++slot) {
+    const char* name = riders[slot].name;
+    names_[slot] = interner_.intern(
+        std::string_view(name, strnlen(name, sizeof(riders[slot].name))));
+  }
+  group_labels_.clear();
+  strings_ = interner_.table();
+
+  by_id_slots_.resize(riders.size());
+  std::iota(by_id_slots_.begin(), by_id_slots_.end(), 0);
+  std::sort(by_id_slots_.begin(), by_id_slots_.end(),
+            [&riders](int a, int b) { return riders[a].id < riders[b].id; });
+
+  anchor_time_ = reader_.start_time();
+  anchor_real_ = frame_clock_seconds();
+  speed_ = 1.0;
+  paused_ = true;
+  return true;
+}
+
+double TraceReplay::get_time() const {
+  double t = anchor_time_;
+  if (!paused_)
+    t += (frame_clock_seconds() - anchor_real_) * speed_;
+  return std::clamp(t, start_time(), end_time());
+}
+
+void TraceReplay::seek(double sim_time) {
+  anchor_time_ = std::clamp(sim_time, start_time(), end_time());
+  anchor_real_ = frame_clock_seconds();
+}
+
+// Both re-anchor at the time shown now, so the playhead never jumps.
+void TraceReplay::set_speed(double speed) {
+  seek(get_time());
+  speed_ = std::max(speed, 0.0);
+}
+
+void TraceReplay::set_paused(bool paused) {
+  seek(get_time());
+  paused_ = paused;
+}
+
+bool TraceReplay::consume_latest_frame_pair(FrameSnapshot& out_prev,
+                                            FrameSnapshot& out_curr) {
+  if (!course_ || reader_.ticks() == 0)
+    return false;
+  const double now = frame_clock_seconds();
+  const double t = get_time();
+  const std::uint64_t k = reader_.tick_at(t);
+  const bool moving = !paused_ && speed_ > 0.0 && k + 1 < reader_.ticks();
+  const std::uint64_t k1 = moving ? k + 1 : k;
+  if (!build_frame(k, out_prev) || !build_frame(k1, out_curr))
+    return false;
+
+  // The renderer blends by (now - curr.real_time) x time_factor over the
+  // pair's sim dt; stamp curr so that lands on t.
+  out_curr.real_time = now;
+  if (moving)
+    out_curr.real_time -= (t - out_prev.sim_time) / speed_;
+  out_prev.real_time =
+      moving ? out_curr.real_time -
+                   (out_curr.sim_time - out_prev.sim_time) / speed_
+             : now;
+  return true;
+}
+
+// Columns to records: front to back like the engine's, by_id through the
+// same order, groups from the group id column.
+bool TraceReplay::build_frame(std::uint64_t k, FrameSnapshot& out) {
+  const std::vector<TelemetryRiderInfo>& riders = reader_.riders();
+  const int n = static_cast<int>(riders.size());
+  const std::int32_t* col[kTelemetryColumns];
+  for (int c = 0; c < kTelemetryColumns; ++c)
+    if (!(col[c] = reader_.row(k, TelemetryColumn(c))))
+      return false;
+  auto value = [&col](TelemetryColumn c, int slot) {
+    const int i = static_cast<int>(c);
+    return col[i][slot] * kTelemetryScale[i];
+  };
+
+  out.sim_time = reader_.time(k);
+  out.sim_dt = reader_.header().dt;
+  out.time_factor = paused_ ? 0.0 : speed_;
+
+  const std::int32_t* pos = col[static_cast<int>(TelemetryColumn::Pos)];
+  order_.resize(n);
+  std::iota(order_.begin(), order_.end(), 0);
+  std::stable_sort(order_.begin(), order_.end(),
+                   [pos](int a, int b) { return pos[a] > pos[b]; });
+  rank_.resize(n);
+
+  out.riders.resize(n);
+  int groups = 0;
+  for (int i = 0; i < n; ++i) {
+    const int slot = order_[i];
+    const TelemetryRiderInfo& info = riders[slot];
+    rank_[slot] = i;
+    RiderSnapshot& s = out.riders[i];
+    s.id = info.id;
+    s.group_id = col[static_cast<int>(TelemetryColumn::GroupId)][slot];
+    if (s.group_id >= n) // at most one group per rider
+      s.group_id = kNoGroup;
+    s.group_role = static_cast<GroupRole>(
+        col[static_cast<int>(TelemetryColumn::GroupRole)][slot]);
+    s.effort_source = EffortSource::Manual;
+    s.policy = kNoString;
+    s.name = names_[slot];
+    s.max_effort = info.max_effort;
+    s.pos = value(TelemetryColumn::Pos, slot);
+    s.slope = course_->get_slope(s.pos);
+    s.heading = course_->get_heading(s.pos);
+    s.speed = value(TelemetryColumn::Speed, slot);
+    s.effort = value(TelemetryColumn::Effort, slot);
+    s.power = value(TelemetryColumn::Power, slot);
+    s.wbal_fraction = info.w_prime > 0.0
+                          ? value(TelemetryColumn::WBal, slot) / info.w_prime
+                          : 0.0;
+    s.cda_factor = value(TelemetryColumn::CdaFactor, slot);
+    s.yaw_factor = 1.0;
+    s.lat_pos = value(TelemetryColumn::LatPos, slot);
+    s.altitude = course_->get_altitude(s.pos);
+    s.team_id = info.team_id;
+    s.visual_type = static_cast<BikeType>(info.bike_type);
+    groups = std::max(groups, s.group_id + 1);
+  }
+
+  out.by_id.resize(n);
+  for (int j = 0; j < n; ++j)
+    out.by_id[j] = rank_[by_id_slots_[j]];
+
+  // The tracker numbers groups front to back, id = ordinal, and lists
+  // members front to back, paceline then body.  A label first seen
+  // replaces the shared table, as a new rider name does live.
+  for (int g = static_cast<int>(group_labels_.size()); g < groups; ++g) {
+    group_labels_.push_back(interner_.intern(default_group_label(g, 0)));
+    strings_ = interner_.table();
+  }
+  out.strings = strings_;
+
+  out.groups.resize(groups);
+  for (int g = 0; g < groups; ++g)
+    out.groups[g] = FrameGroup{g, g, group_labels_[g], 0, 0, 0, -1.0};
+  for (const RiderSnapshot& s : out.riders) {
+    if (s.group_id < 0)
+      continue;
+    FrameGroup& grp = out.groups[s.group_id];
+    ++grp.count;
+    if (s.group_role == GroupRole::Paceline)
+      ++grp.paceline;
+  }
+  int first = 0;
+  fill_.resize(2 * groups); // paceline, body
+  for (int g = 0; g < groups; ++g) {
+    FrameGroup& grp = out.groups[g];
+    grp.first = first;
+    fill_[2 * g] = first;
+    fill_[2 * g + 1] = first + grp.paceline;
+    first += grp.count;
+  }
+  out.group_members.resize(first);
+  for (const RiderSnapshot& s : out.riders)
+    if (s.group_id >= 0) {
+      const int at = 2 * s.group_id + (s.group_role != GroupRole::Paceline);
+      out.group_members[fill_[at]++] =
+          GroupMember{s.id, s.pos, s.speed, s.group_role};
+    }
+  return true;
+}
@@ -601,6 +601,18 @@ void PauseButton::render(const RenderContext* ctx) {
   Button::render(ctx);
 }
 
+RewindButton::RewindButton(int x, int y, int w, int h, double seconds,
+                           ISimControl* sim_, TTF_Font* font)
+    : Button(x, y, w, h, "-" + std::to_string(int(seconds)) + " s", font,
+             [this, seconds, sim_]() {
+               sim_->rewind_to(shown_time - seconds);
+             }) {}
+
+void RewindButton::render(const RenderContext* ctx) {
+  shown_time = ctx->sim_time;
+  Button::render(ctx);
+}
+
 TimeControlPanel::TimeControlPanel(int x_, int y_, int h_, TTF_Font* font,
                                    ISimControl* sim_)
     : x(x_), y(y_), h(h_), sim(sim_) {
@@ -638,6 +650,11 @@ TimeControlPanel::TimeControlPanel(int x_, int y_, int h_, TTF_Font* font,
   child_rel_positions.push_back({next_x - x, widget_y});
   children.push_back(std::make_unique<PauseButton>(next_x, widget_y, button_w,
                                                    widget_h, sim, font));
+  next_x += gap_w + button_w;
+
+  child_rel_positions.push_back({next_x - x, widget_y});
+  children.push_back(std::make_unique<RewindButton>(
+      next_x, widget_y, button_w, widget_h, 10.0, sim, font));
 
   // w is otherwise never assigned; render() draws the background with it.
   w = get_preferred_size().w;
@@ -652,8 +669,9 @@ LayoutSize TimeControlPanel::get_preferred_size() const {
   //   + (gap_w + button_w)       <- existing extra skip (preserved)
   //   + button_w                 <- pause button width
   //   + gap_w                    <- right margin
+  //   + (gap_w + button_w)       <- rewind button
   int w =
-      gap_w + valfield_w + gap_w + slider_w + gap_w + 4 * (gap_w + button_w);
+      gap_w + valfield_w + gap_w + slider_w + gap_w + 5 * (gap_w + button_w);
   return {w, h};
 }
 
@@ -0,0 +1,123 @@
+#include "worker_pool.h"
+#include <algorithm>
+#include <cassert>
+
+WorkerPool::WorkerPool(int threads) {
+  const int n = std::max(1, threads);
+  queues_.reserve(n);
+  for (int i = 0; i < n; ++i)
+    queues_.push_back(std::make_unique<Queue>());
+  threads_.reserve(n - 1);
+  for (int i = 1; i < n; ++i)
+    threads_.emplace_back([this, i]() { worker_loop(i); });
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::scoped_lock lock(wake_m_);
+    stop_ = true;
+  }
+  wake_cv_.notify_all();
+  for (auto& t : threads_)
+    t.join();
+}
+
+void WorkerPool::parallel_for(int n, int grain, const RangeFn& fn) {
+  if (n <= 0)
+    return;
+  grain = std::max(1, grain);
+
+  const int participants = thread_count();
+  const int n_chunks = (n + grain - 1) / grain;
+  steals_ = 0;
+
+  // Serial path: one participant, or nothing to split.
+  if (participants == 1 || n_chunks == 1) {
+    fn(0, n);
+    return;
+  }
+
+  assert(remaining_ == 0 && "WorkerPool::parallel_for is not reentrant");
+  fn_ = &fn;
+  remaining_ = n_chunks;
+
+  // Deal contiguous blocks of chunks, one block per participant, so a
+  // participant's own work is adjacent in memory.
+  for (int p = 0; p < participants; ++p) {
+    const int c_lo = n_chunks * p / participants;
+    const int c_hi = n_chunks * (p + 1) / participants;
+    std::scoped_lock lock(queues_[p]->m);
+    queues_[p]->chunks.clear();
+    queues_[p]->head = 0;
+    for (int c = c_lo; c < c_hi; ++c)
+      queues_[p]->chunks.push_back(
+          Chunk{c * grain, std::min(n, (c + 1) * grain)});
+  }
+
+  {
+    std::scoped_lock lock(wake_m_);
+    ++generation_;
+  }
+  wake_cv_.notify_all();
+
+  while (run_one(0)) {
+  }
+
+  std::unique_lock lock(wake_m_);
+  done_cv_.wait(lock, [this]() { return remaining_ == 0; });
+  fn_ = nullptr;
+}
+
+bool WorkerPool::run_one(int self) {
+  const int participants = thread_count();
+  Chunk c{};
+  bool found = false;
+
+  {
+    Queue& own = *queues_[self];
+    std::scoped_lock lock(own.m);
+    if (own.head < own.chunks.size()) {
+      c = own.chunks[own.head++];
+      found = true;
+    }
+  }
+
+  // Steal from the back of the next non-empty queue, scanning from self + 1
+  // so thieves spread out instead of all hitting queue 0.
+  for (int k = 1; !found && k < participants; ++k) {
+    Queue& victim = *queues_[(self + k) % participants];
+    std::scoped_lock lock(victim.m);
+    if (victim.head < victim.chunks.size()) {
+      c = victim.chunks.back();
+      victim.chunks.pop_back();
+      found = true;
+      ++steals_;
+    }
+  }
+
+  if (!found)
+    return false;
+
+  (*fn_)(c.lo, c.hi);
+
+  if (--remaining_ == 0) {
+    std::scoped_lock lock(wake_m_);
+    done_cv_.notify_all();
+  }
+  return true;
+}
+
+void WorkerPool::worker_loop(int self) {
+  std::uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock lock(wake_m_);
+      wake_cv_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+      if (stop_)
+        return;
+      seen = generation_;
+    }
+    while (run_one(self)) {
+    }
+  }
+}
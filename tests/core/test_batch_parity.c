@@ -0,0 +1,328 @@
+#define _POSIX_C_SOURCE 199309L
+
+/*
+ * test_batch_parity.c
+ *
+ * sim_step_riders() (structure-of-arrays batch) against sim_step_rider()
+ * (scalar ACCEL_FORCE reference):
+ *   1. A mixed field — varied masses, CdA, FTP, standing starts, per-rider
+ *      slope / wind / altitude, riders past their FTP-degradation threshold
+ *      and riders draining W' — stays bit-identical over a long run; also
+ *      with baked gravity / altitude terms (as the engine steps it), and
+ *      stepped as two ranges.
+ *   2. A resident batch — loaded once, then only rider_batch_load_inputs()
+ *      between steps while the caller changes efforts, draft and speed —
+ *      stays bit-identical to the scalar riders it is stored back into.
+ *   3. rider_batch_store() round-trips the mutable state into RiderState.
+ *   4. Capacity / empty-batch edge cases.
+ * Also prints scalar vs batch ns/rider-step for a large field (no assert).
+ */
+
+#include "sim_core.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+static int tests_failed = 0;
+
+#define CHECK(cond, msg)                                                       \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      ++tests_failed;                                                          \
+      printf("FAIL  %s\n", msg);                                               \
+    } else {                                                                   \
+      printf("pass  %s\n", msg);                                               \
+    }                                                                          \
+  } while (0)
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static EnvState base_env(void) {
+  EnvState env = {.rho = 1.2234,
+                  .g = 9.80665,
+                  .crr = 0.0,
+                  .slope = 0.0,
+                  .headwind = 0.0,
+                  .altitude = 0.0,
+                  .bearing_c0 = 0.091,
+                  .bearing_c1 = 0.0087};
+  return env;
+}
+
+/* Deterministic spread of riders; k selects the variant. */
+static void make_rider(RiderState* r, int k) {
+  RiderInitParams p = {0};
+  p.ftp_base = 220.0 + 7.0 * (k % 23);
+  p.w_prime = 12000.0 + 500.0 * (k % 17);
+  p.max_effort = 4.0 + 0.25 * (k % 9);
+  /* every 4th rider starts degrading almost immediately */
+  p.ftp_degrade_threshold = (k % 4 == 0) ? 0.01 : 2.0;
+  p.ftp_degrade_rate = 0.05;
+  p.max_drive_force = 500.0 + 25.0 * (k % 13);
+  p.oxy_p50 = 2.5 + 0.1 * (k % 15);
+  p.mass_rider = 55.0 + 1.5 * (k % 21);
+  p.cda = 0.22 + 0.01 * (k % 11);
+  p.mass_bike = 6.8 + 0.2 * (k % 5);
+  p.wheel_i = 0.14;
+  p.wheel_r = 0.311;
+  p.wheel_drag_factor = 0.02;
+  p.crr = 0.004 + 0.0005 * (k % 5);
+  p.drivetrain_loss = 0.02;
+  rider_state_init(r, &p);
+
+  r->solver = SIM_SOLVER_ACCEL_FORCE;
+  r->speed = (k % 3 == 0) ? 0.0 : 5.0 + 0.3 * (k % 19);
+  r->pos = 10.0 * k;
+  r->cda_factor = 0.6 + 0.02 * (k % 20);
+  /* some riders attack beyond their cap, some soft-pedal, one stops */
+  r->target_effort = (k % 5 == 0) ? 3.0 : 0.5 + 0.05 * (k % 10);
+  if (k == 7)
+    r->target_effort = 0.0;
+}
+
+static void make_env(EnvState* env, int k, int step) {
+  *env = base_env();
+  env->slope = 0.02 * sin(0.01 * step + 0.3 * k);
+  env->headwind = 3.0 * cos(0.005 * step + 0.7 * k);
+  env->crr = (k % 6 == 0) ? 0.002 : 0.0;
+  env->altitude = 100.0 * (k % 25);
+}
+
+/* Baked terms deliberately unlike what the step would derive, so parity
+ * shows they are the ones used. */
+static void make_baked_env(EnvState* env, int k, int step) {
+  make_env(env, k, step);
+  env->baked = SIM_ENV_GRAV_SIN | SIM_ENV_ALT_FACTOR;
+  env->grav_sin = env->slope;
+  env->alt_factor = 0.97 - 0.001 * k;
+}
+
+static int same_rider(const RiderState* a, const RiderState* b) {
+  return a->pos == b->pos && a->speed == b->speed && a->effort == b->effort &&
+         a->power == b->power && a->ftp == b->ftp &&
+         a->sealevel_sat == b->sealevel_sat &&
+         a->energy.ftp == b->energy.ftp &&
+         a->energy.w_expended == b->energy.w_expended &&
+         a->energy.fatigue_I == b->energy.fatigue_I &&
+         a->energy.effort_limit == b->energy.effort_limit;
+}
+
+#define N_PARITY 64
+
+static void test_parity(int baked) {
+  static RiderState scalar[N_PARITY];
+  static RiderState out[N_PARITY];
+  RiderBatch b;
+  EnvBatch eb;
+  CHECK(rider_batch_init(&b, N_PARITY), "rider_batch_init");
+  CHECK(env_batch_init(&eb, N_PARITY), "env_batch_init");
+
+  for (int k = 0; k < N_PARITY; ++k) {
+    make_rider(&scalar[k], k);
+    out[k] = scalar[k];
+    rider_batch_push(&b, &scalar[k]);
+  }
+
+  const double dt = 0.1;
+  const int steps = 20000; /* ~33 min of race time */
+  int first_bad_step = -1;
+  int degraded = 0, drained = 0;
+
+  for (int s = 0; s < steps && first_bad_step < 0; ++s) {
+    for (int k = 0; k < N_PARITY; ++k) {
+      EnvState env;
+      if (baked)
+        make_baked_env(&env, k, s);
+      else
+        make_env(&env, k, s);
+      env_batch_set(&eb, k, &env);
+      sim_step_rider(&scalar[k], &env, dt, NULL);
+    }
+    if (baked) {
+      sim_step_riders_range(&b, &eb, 0, N_PARITY / 3, dt);
+      sim_step_riders_range(&b, &eb, N_PARITY / 3, N_PARITY, dt);
+    } else {
+      sim_step_riders(&b, &eb, dt);
+    }
+
+    for (int k = 0; k < N_PARITY; ++k) {
+      rider_batch_store(&b, k, &out[k]);
+      if (!same_rider(&out[k], &scalar[k])) {
+        first_bad_step = s;
+        printf("      rider %d diverged at step %d: v %.17g vs %.17g\n", k, s,
+               out[k].speed, scalar[k].speed);
+        break;
+      }
+    }
+  }
+
+  for (int k = 0; k < N_PARITY; ++k) {
+    if (scalar[k].energy.ftp < scalar[k].energy.ftp_base * 0.99)
+      ++degraded;
+    if (energy_wbal_fraction(&scalar[k].energy) < 0.2)
+      ++drained;
+  }
+
+  CHECK(first_bad_step < 0,
+        baked ? "baked envs, in ranges: bit-identical over 20000 steps"
+              : "batch bit-identical to scalar over 20000 steps");
+  CHECK(degraded > 0, "run covers FTP degradation");
+  CHECK(drained > 0, "run covers W' depletion");
+
+  rider_batch_free(&b);
+  env_batch_free(&eb);
+}
+
+/* What a caller does to a rider between steps, the same on both sides. */
+static void perturb(RiderState* r, int k, int step) {
+  r->target_effort = 0.5 + 0.4 * fabs(sin(0.002 * step + 0.9 * k));
+  r->cda_factor = 0.6 + 0.3 * fabs(cos(0.003 * step + 0.4 * k));
+  if ((step + k) % 97 == 0)
+    r->speed *= 0.95; /* a lateral contact */
+}
+
+static void test_resident(void) {
+  static RiderState scalar[N_PARITY];
+  static RiderState out[N_PARITY];
+  RiderBatch b;
+  EnvBatch eb;
+  CHECK(rider_batch_init(&b, N_PARITY) && env_batch_init(&eb, N_PARITY),
+        "resident: init");
+
+  for (int k = 0; k < N_PARITY; ++k) {
+    make_rider(&scalar[k], k);
+    out[k] = scalar[k];
+    rider_batch_push(&b, &out[k]);
+  }
+
+  const double dt = 0.1;
+  const int steps = 5000;
+  int first_bad_step = -1;
+  for (int s = 0; s < steps && first_bad_step < 0; ++s) {
+    for (int k = 0; k < N_PARITY; ++k) {
+      EnvState env;
+      make_baked_env(&env, k, s);
+      env_batch_set(&eb, k, &env);
+      perturb(&scalar[k], k, s);
+      sim_step_rider(&scalar[k], &env, dt, NULL);
+      perturb(&out[k], k, s);
+      rider_batch_load_inputs(&b, k, &out[k]);
+    }
+    sim_step_riders(&b, &eb, dt);
+    for (int k = 0; k < N_PARITY; ++k) {
+      rider_batch_store(&b, k, &out[k]);
+      if (!same_rider(&out[k], &scalar[k])) {
+        first_bad_step = s;
+        break;
+      }
+    }
+  }
+  CHECK(first_bad_step < 0,
+        "resident batch, inputs reloaded: bit-identical over 5000 steps");
+
+  rider_batch_free(&b);
+  env_batch_free(&eb);
+}
+
+static void test_store_roundtrip(void) {
+  RiderState r;
+  make_rider(&r, 5);
+  r.heading = 1.25;
+
+  RiderBatch b;
+  rider_batch_init(&b, 1);
+  rider_batch_push(&b, &r);
+  b.pos[0] = 1234.5;
+  b.speed[0] = 11.0;
+  b.fatigue_I[0] = 42.0;
+
+  RiderState out = r;
+  rider_batch_store(&b, 0, &out);
+  CHECK(out.pos == 1234.5 && out.speed == 11.0, "store writes kinematics");
+  CHECK(out.energy.fatigue_I == 42.0, "store writes energy state");
+  CHECK(out.heading == 1.25 && out.mass_rider == r.mass_rider,
+        "store leaves static fields untouched");
+
+  rider_batch_free(&b);
+}
+
+static void test_edges(void) {
+  RiderBatch b;
+  RiderState r;
+  make_rider(&r, 1);
+
+  CHECK(rider_batch_init(&b, 2), "init capacity 2");
+  CHECK(rider_batch_push(&b, &r) == 0, "push slot 0");
+  CHECK(rider_batch_push(&b, &r) == 1, "push slot 1");
+  CHECK(rider_batch_push(&b, &r) == -1, "push past capacity refused");
+  rider_batch_free(&b);
+  CHECK(b.count == 0 && b.capacity == 0 && b.pos == NULL, "free clears batch");
+
+  EnvBatch eb;
+  CHECK(rider_batch_init(&b, 0) && env_batch_init(&eb, 0), "empty init");
+  sim_step_riders(&b, &eb, 0.1); /* no-op, must not touch NULL columns */
+  rider_batch_free(&b);
+  env_batch_free(&eb);
+}
+
+#define N_BENCH 1000
+
+static void bench(void) {
+  static RiderState riders[N_BENCH];
+  static EnvState envs[N_BENCH];
+  RiderBatch b;
+  EnvBatch eb;
+  rider_batch_init(&b, N_BENCH);
+  env_batch_init(&eb, N_BENCH);
+
+  for (int k = 0; k < N_BENCH; ++k) {
+    make_rider(&riders[k], k);
+    make_env(&envs[k], k, 0);
+    rider_batch_push(&b, &riders[k]);
+    env_batch_set(&eb, k, &envs[k]);
+  }
+
+  const double dt = 0.1;
+  const int steps = 1000;
+
+  double t0 = now_seconds();
+  for (int s = 0; s < steps; ++s)
+    for (int k = 0; k < N_BENCH; ++k)
+      sim_step_rider(&riders[k], &envs[k], dt, NULL);
+  double t_scalar = now_seconds() - t0;
+
+  t0 = now_seconds();
+  for (int s = 0; s < steps; ++s)
+    sim_step_riders(&b, &eb, dt);
+  double t_batch = now_seconds() - t0;
+
+  double per = 1e9 / ((double)steps * N_BENCH);
+  printf("      %d riders: scalar %.1f ns/rider-step, batch %.1f "
+         "ns/rider-step\n",
+         N_BENCH, t_scalar * per, t_batch * per);
+
+  rider_batch_free(&b);
+  env_batch_free(&eb);
+}
+
+int main(void) {
+  printf("=== Batched (SoA) step parity ===\n");
+  test_parity(0);
+  test_parity(1);
+  test_resident();
+  test_store_roundtrip();
+  test_edges();
+  bench();
+
+  if (tests_failed > 0) {
+    printf("=== %d check(s) FAILED ===\n", tests_failed);
+    return 1;
+  }
+  printf("=== all checks passed ===\n");
+  return 0;
+}
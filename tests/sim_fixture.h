@@ -0,0 +1,103 @@
+// sim_fixture.h — the test field shared by the saved-state tests
+// (checkpoint, fork, telemetry, trace replay, input journal, keyframes).
+//
+// Riders 1..n with FTPs spread over 230–302 W, staggered over three 60 m
+// blocks at steady efforts; a policy whose effort depends on how many
+// times it has decided, which is state a copy, restore or replay has to
+// carry; and a mid-race setup with everything else that is per-run state.
+
+#ifndef SIM_FIXTURE_H
+#define SIM_FIXTURE_H
+
+#include "checkpoint.h"
+#include "decision.h"
+#include "sim.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+inline RiderConfig fixture_rider(int id, TeamId team = kNoTeam) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     230.0 + (id % 7) * 12.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     team};
+}
+
+// Riders 1..n; odd ids ride for `odd`, even ones for `even`.
+inline std::vector<RiderConfig> fixture_field(int riders,
+                                              TeamId odd = kNoTeam,
+                                              TeamId even = kNoTeam) {
+  std::vector<RiderConfig> field;
+  for (int id = 1; id <= riders; ++id)
+    field.push_back(fixture_rider(id, id % 2 ? odd : even));
+  return field;
+}
+
+// Start positions, and efforts `effort + step x (id % 11)`, for riders
+// 1..n already added.
+inline void place_field(Simulation& sim, int riders, double effort = 0.65,
+                        double step = 0.01) {
+  for (const auto& [id, r] : sim.get_engine()->get_riders())
+    r->set_start_pos((id % 9) * 4.0 + (id % 3) * 60.0);
+  for (int id = 1; id <= riders; ++id)
+    sim.set_rider_effort(id, effort + step * (id % 11));
+}
+
+class CountingPolicy : public IRiderPolicy {
+public:
+  const char* name() const override { return "counting"; }
+  PolicyOutput decide(const DecisionContext&) override {
+    PolicyOutput out;
+    out.target_effort = 0.6 + 0.02 * (calls_++ % 10);
+    return out;
+  }
+  std::shared_ptr<IRiderPolicy> clone() const override {
+    return std::make_shared<CountingPolicy>(*this);
+  }
+  void save_state(CheckpointWriter& w) const override { w.pod(calls_); }
+  bool load_state(CheckpointReader& r) override { return r.pod(calls_); }
+  int calls() const { return calls_; }
+
+private:
+  int calls_ = 0;
+};
+
+// Group and draft phases off the 100 Hz step, so a save or fork mostly
+// lands mid-period.
+inline constexpr PhaseRates kSlowPhases{7.0, 13.0};
+
+// Two teams, a manual rotation, reconciled rotations, a follow target,
+// pacing policies, `counting` on rider 31, an effort schedule, a race plan
+// and slow phases.  At least 34 riders.
+inline void build_mid_race(Simulation& sim, int riders,
+                           const std::shared_ptr<IRiderPolicy>& counting) {
+  PhysicsEngine& eng = *sim.get_engine();
+  const TeamId alpha = eng.add_team("Alpha");
+  const TeamId beta = eng.add_team("Beta");
+  sim.add_riders(fixture_field(riders, alpha, beta));
+  place_field(sim, riders);
+  eng.set_phase_rates(kSlowPhases);
+
+  sim.set_paceline_rotation({{1, false}, {3, false}, {5, false}, {7, true}},
+                            RotationParams{});
+  sim.set_follow_target(10, 12);
+  WPrimePacingParams pace;
+  pace.role_decl = GroupRole::Paceline; // forms reconciled rotations
+  for (int id = 20; id < 30; ++id)
+    sim.set_rider_policy(id, std::make_shared<WPrimePacingPolicy>(pace));
+  sim.set_rider_policy(31, counting);
+  sim.set_effort_schedule(
+      33, std::make_shared<StepEffortSchedule>(std::vector<EffortBlock>{
+              {20.0, 0.7}, {20.0, 1.1}, {1000.0, 0.8}}));
+  RacePlan plan;
+  plan.leader = 2;
+  plan.assignments = {{4, Directive::Type::ProtectLeader}};
+  plan.chase_gap_max = 30.0;
+  sim.set_race_plan(beta, plan);
+}
+
+#endif
@@ -0,0 +1,227 @@
+// Tests for BatchRunner (batch_runner.h): draws are deterministic per seed,
+// summaries stream in run order and the statistics are identical for any
+// thread count and window, and perturbations (spread, wind) show up in the
+// results.  The benchmark prints what a 40 km race costs, and what
+// 10,000 of them would take.
+
+#include "batch_runner.h"
+
+#include "course.h"
+#include "sim.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     250.0 + id * 8.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     20000, Bike::create_road(),
+                     kNoTeam};
+}
+
+static std::vector<RiderConfig> field(int n) {
+  std::vector<RiderConfig> riders;
+  for (int id = 1; id <= n; ++id)
+    riders.push_back(cfg(id));
+  return riders;
+}
+
+// Everyone at threshold, except the last rider who rides above it and has
+// to dig into W′.
+static std::unique_ptr<Simulation>
+build(const Course& course, const std::vector<RiderConfig>& riders) {
+  auto sim = std::make_unique<Simulation>(&course);
+  sim->add_riders(riders);
+  const RiderId last = riders.back().rider_id;
+  for (const RiderConfig& c : riders)
+    sim->set_rider_effort(c.rider_id, c.rider_id == last ? 1.2 : 1.0);
+  return sim;
+}
+
+static std::vector<RunPerturbation> spread(int runs, double sd) {
+  std::vector<RunPerturbation> out;
+  for (int i = 0; i < runs; ++i) {
+    RunPerturbation p;
+    p.seed = 1000 + i;
+    p.ftp_sd = sd;
+    p.cda_sd = sd;
+    p.w_prime_sd = sd;
+    out.push_back(p);
+  }
+  return out;
+}
+
+static bool same_stat(const RunningStat& a, const RunningStat& b) {
+  return a.n == b.n && a.mean == b.mean && a.m2 == b.m2 && a.min == b.min &&
+         a.max == b.max;
+}
+
+static bool same_stats(const BatchStats& a, const BatchStats& b) {
+  if (a.runs != b.runs || a.riders.size() != b.riders.size() ||
+      !same_stat(a.winning_time, b.winning_time))
+    return false;
+  for (size_t i = 0; i < a.riders.size(); ++i) {
+    const RiderBatchStats& x = a.riders[i];
+    const RiderBatchStats& y = b.riders[i];
+    if (x.id != y.id || x.finishes != y.finishes || x.wins != y.wins ||
+        !same_stat(x.position, y.position) ||
+        !same_stat(x.finish_time, y.finish_time) || !same_stat(x.gap, y.gap) ||
+        !same_stat(x.w_prime_min, y.w_prime_min))
+      return false;
+  }
+  return true;
+}
+
+static void test_draws() {
+  Course course = Course::create_flat_short();
+  BatchRunner runner(course, field(6), build);
+
+  RunPerturbation p;
+  p.seed = 7;
+  p.ftp_sd = 0.05;
+  const auto a = runner.perturb_riders(p);
+  const auto b = runner.perturb_riders(p);
+  p.seed = 8;
+  const auto c = runner.perturb_riders(p);
+  bool same = true, differ = false, cda_kept = true;
+  for (size_t i = 0; i < a.size(); ++i) {
+    same = same && a[i].ftp_base == b[i].ftp_base;
+    differ = differ || a[i].ftp_base != c[i].ftp_base;
+    cda_kept = cda_kept && a[i].cda == field(6)[i].cda;
+  }
+  check(same && differ,
+        "draws: deterministic per seed, different across seeds");
+  check(cda_kept, "draws: a zero spread leaves the parameter alone");
+}
+
+static void test_order_and_determinism() {
+  Course course = Course::create_flat_short();
+  const auto runs = spread(24, 0.04);
+
+  auto batch = [&](int threads, size_t window, std::vector<size_t>& order) {
+    BatchParams params;
+    params.threads = threads;
+    params.window = window;
+    BatchRunner runner(course, field(6), build, params);
+    return runner.run(runs, [&order](const RunSummary& s) {
+      order.push_back(s.index);
+    });
+  };
+
+  std::vector<size_t> o1, o4, o4w;
+  const BatchStats s1 = batch(1, 0, o1);
+  const BatchStats s4 = batch(4, 0, o4);
+  const BatchStats s4w = batch(4, 2, o4w); // workers wait on the window
+
+  bool in_order = o1.size() == runs.size();
+  for (size_t i = 0; i < o1.size(); ++i)
+    in_order = in_order && o1[i] == i;
+  check(in_order && o4 == o1 && o4w == o1,
+        "every summary streamed once, in run order");
+  check(s1.runs == runs.size() && same_stats(s1, s4) && same_stats(s1, s4w),
+        "statistics identical for 1 and 4 threads, any window");
+
+  int wins = 0, finishes = 0;
+  for (const RiderBatchStats& r : s1.riders) {
+    wins += r.wins;
+    finishes += r.finishes;
+  }
+  check(wins == 24 && finishes == 24 * 6, "one winner per run; all finish");
+}
+
+static void test_perturbations_show() {
+  Course course = Course::create_flat_short();
+  BatchRunner runner(course, field(6), build);
+
+  const BatchStats flat = runner.run(spread(6, 0.0));
+  const BatchStats spread_out = runner.run(spread(6, 0.05));
+  check(flat.winning_time.sd() == 0.0 && spread_out.winning_time.sd() > 0.0,
+        "spread: no spread, same race every run; spread varies it");
+
+  std::vector<RunPerturbation> windy = spread(1, 0.0);
+  windy[0].wind = Wind{0.0, 8.0}; // from the riders' heading: full headwind
+  const BatchStats head = runner.run(windy);
+  check(head.winning_time.mean > flat.winning_time.mean + 10.0,
+        "wind: a headwind run is slower");
+  check(course.get_wind(0.0).speed == 0.0,
+        "wind: the base course is untouched");
+
+  RunSummary one = runner.run_one(0, spread(1, 0.0)[0]);
+  const RiderRunResult& winner = one.riders.front();
+  bool ordered = winner.gap == 0.0;
+  for (size_t i = 1; i < one.riders.size(); ++i)
+    ordered = ordered &&
+              one.riders[i].finish_time >= one.riders[i - 1].finish_time &&
+              one.riders[i].gap >= 0.0;
+  check(ordered, "summary: finish order with gaps to the winner");
+
+  bool dug_in = false, bounded = true;
+  for (const RiderRunResult& r : one.riders) {
+    bounded = bounded && r.w_prime_min <= 20000.0 + 1e-9;
+    if (r.id == 6)
+      dug_in = r.w_prime_min < 20000.0 * 0.9;
+  }
+  check(bounded && dug_in,
+        "summary: W' minima; the rider above threshold dug in");
+
+  BatchParams params;
+  params.time_limit = 30.0;
+  BatchRunner short_runner(course, field(6), build, params);
+  const RunSummary dnf = short_runner.run_one(0, spread(1, 0.0)[0]);
+  check(dnf.riders.front().finish_time < 0.0 && dnf.riders.front().gap < 0.0 &&
+            dnf.sim_seconds < 31.0,
+        "time limit: the field is DNF");
+}
+
+static void test_benchmark() {
+  Course course = Course::from_segments({{40000, 0, 0, 0, 8}});
+  const int threads = static_cast<int>(
+      std::max(1u, std::thread::hardware_concurrency()));
+  BatchParams params;
+  params.threads = threads;
+  BatchRunner runner(course, field(8), build, params);
+  const int runs = threads;
+
+  const BatchStats s = runner.run(spread(runs, 0.03));
+  const double per_run = s.wall_seconds * threads / runs; // s of one core
+  const double minutes_10k = per_run * 10000.0 / threads / 60.0;
+  std::cout << "  [bench] 40 km, 8 riders: " << per_run
+            << " s per run per core, " << threads
+            << " threads -> 10,000 runs in ~" << minutes_10k << " min ("
+            << minutes_10k * threads << " min on one core)\n";
+  check(s.runs == static_cast<size_t>(runs) &&
+            s.riders.front().finishes == runs,
+        "bench: every 40 km run finished");
+}
+
+int main() {
+  std::cout << "=== Batch runner tests ===\n";
+  test_draws();
+  test_order_and_determinism();
+  test_perturbations_show();
+  test_benchmark();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All batch runner tests passed\n";
+  return 0;
+}
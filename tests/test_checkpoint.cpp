@@ -0,0 +1,242 @@
+// Tests for simulation checkpoints (checkpoint.h): a run restored into a
+// freshly set-up Simulation continues bit-identically — rotations, follow
+// controllers, slow-phase ramps, policies and race plans included — a
+// checkpoint re-saves to the same bytes, and foreign / corrupt /
+// mismatched checkpoints are refused without touching the simulation.
+// Save and load times for 500 riders are printed, not checked.
+
+#include "checkpoint.h"
+
+#include "course.h"
+#include "decision.h"
+#include "sim.h"
+#include "sim_fixture.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+// Everything a scenario sets up; the same call on a fresh Simulation gives
+// the setup a checkpoint loads into.  CountingPolicy's calls are per-run
+// state the checkpoint must carry through save_state / load_state.
+struct Scenario {
+  std::shared_ptr<CountingPolicy> counting = std::make_shared<CountingPolicy>();
+
+  void build(Simulation& sim, int riders) {
+    build_mid_race(sim, riders, counting);
+  }
+};
+
+// Exact equality of everything the engine exposes per rider.
+static bool same_state(const Simulation& a, const Simulation& b) {
+  if (a.get_sim_seconds() != b.get_sim_seconds())
+    return false;
+  const PhysicsEngine& ea = *a.get_engine();
+  const PhysicsEngine& eb = *b.get_engine();
+  for (const auto& [id, ra] : ea.get_riders()) {
+    const Rider* rb = eb.get_riders().find(id);
+    if (!rb || ra->get_pos() != rb->get_pos() ||
+        ra->get_speed() != rb->get_speed() ||
+        ra->get_power() != rb->get_power() ||
+        ra->get_energy() != rb->get_energy() ||
+        ra->get_target_effort() != rb->get_target_effort() ||
+        ra->get_cda_factor() != rb->get_cda_factor() ||
+        ra->get_lat_pos() != rb->get_lat_pos() ||
+        ra->get_lat_vel() != rb->get_lat_vel() ||
+        ea.get_group_tracker().get_group_id(id) !=
+            eb.get_group_tracker().get_group_id(id))
+      return false;
+  }
+  return ea.auto_rotation_count() == eb.auto_rotation_count();
+}
+
+static void test_continue_identically() {
+  Course course = Course::create_endulating();
+  const double dt = 0.01;
+
+  Scenario sa;
+  Simulation a(&course);
+  sa.build(a, 40);
+  for (int i = 0; i < 4537; ++i) // ~45 s: rotations and groups formed
+    a.step_fixed(dt);
+  const std::vector<char> saved = a.save_checkpoint();
+
+  Scenario sb;
+  Simulation b(&course);
+  sb.build(b, 40);
+  b.step_fixed(dt); // drain setup commands: policies must be in place
+  check(b.load_checkpoint(saved), "checkpoint loads into the same setup");
+  check(same_state(a, b), "restored state equals the saved one");
+  check(b.save_checkpoint() == saved, "a restored run re-saves to the same bytes");
+  check(sb.counting->calls() == sa.counting->calls(),
+        "policy state restored through its hooks");
+
+  bool identical = true;
+  for (int i = 0; i < 6000 && identical; ++i) { // one more minute
+    a.step_fixed(dt);
+    b.step_fixed(dt);
+    identical = same_state(a, b);
+  }
+  check(identical, "restored run continues bit-identically");
+  check(a.save_checkpoint() == b.save_checkpoint(),
+        "and ends in the same state, byte for byte");
+  check(a.get_engine()->auto_rotation_count() > 0 &&
+            a.get_engine()->get_paceline_rotation() &&
+            a.get_engine()->has_follow_target(10),
+        "scenario exercised rotations and follow targets");
+
+  FramePair fa = a.acquire_frames(), fb = b.acquire_frames();
+  check(fa.curr().riders.size() == fb.curr().riders.size() &&
+            fa.curr().groups.size() == fb.curr().groups.size() &&
+            fb.curr().find(31) &&
+            fb.curr().str(fb.curr().find(31)->policy) == "counting",
+        "frames agree; interned policy names survive");
+
+  // Replaying from one checkpoint twice gives the same run again.
+  Scenario sc;
+  Simulation c(&course);
+  sc.build(c, 40);
+  c.step_fixed(dt);
+  c.load_checkpoint(saved);
+  for (int i = 0; i < 6000; ++i)
+    c.step_fixed(dt);
+  check(same_state(a, c), "a second restore replays the same run");
+}
+
+static void test_file_round_trip() {
+  Course course = Course::create_flat();
+  Scenario s1;
+  Simulation a(&course);
+  s1.build(a, 40);
+  for (int i = 0; i < 1000; ++i)
+    a.step_fixed(0.01);
+
+  const std::string path = "test_checkpoint.tmp";
+  check(a.save_checkpoint_file(path), "file save");
+  Scenario s2;
+  Simulation b(&course);
+  s2.build(b, 40);
+  b.step_fixed(0.01);
+  check(b.load_checkpoint_file(path) && same_state(a, b), "file load");
+  std::remove(path.c_str());
+  check(!b.load_checkpoint_file(path), "missing file refused");
+}
+
+static void test_refusals() {
+  Course course = Course::create_flat();
+  Scenario s0;
+  Simulation a(&course);
+  s0.build(a, 40);
+  for (int i = 0; i < 500; ++i)
+    a.step_fixed(0.01);
+  const std::vector<char> saved = a.save_checkpoint();
+
+  auto fresh = [&course](Simulation& sim, Scenario& s, int riders) {
+    s.build(sim, riders);
+    for (int i = 0; i < 10; ++i)
+      sim.step_fixed(0.01);
+  };
+
+  {
+    Scenario s;
+    Simulation b(&course);
+    fresh(b, s, 39);
+    const double t = b.get_sim_seconds();
+    check(!b.load_checkpoint(saved) && b.get_sim_seconds() == t,
+          "other roster: refused, nothing changed");
+  }
+  {
+    Scenario s;
+    Simulation b(&course);
+    fresh(b, s, 40);
+    b.clear_rider_policy(31);
+    b.step_fixed(0.01);
+    check(!b.load_checkpoint(saved), "other policy assignment: refused");
+  }
+  {
+    Course other = Course::create_flat_short();
+    Scenario s;
+    Simulation b(&other);
+    fresh(b, s, 40);
+    check(!b.load_checkpoint(saved), "other course: refused");
+  }
+  {
+    Scenario s;
+    Simulation b(&course);
+    fresh(b, s, 40);
+    std::vector<char> corrupt = saved;
+    corrupt[corrupt.size() / 2] ^= 0x10;
+    std::vector<char> truncated(saved.begin(), saved.end() - 9);
+    std::vector<char> foreign = saved;
+    foreign[0] = 'X';
+    // The version follows the magic; the hash covers the payload only.
+    std::vector<char> older = saved;
+    const std::uint32_t v1 = 1;
+    std::memcpy(older.data() + sizeof(kCheckpointMagic), &v1, sizeof(v1));
+    const double t = b.get_sim_seconds();
+    check(!b.load_checkpoint(corrupt) && !b.load_checkpoint(truncated) &&
+              !b.load_checkpoint(foreign) && !b.load_checkpoint({}),
+          "corrupt, truncated, foreign, empty: refused");
+    check(!b.load_checkpoint(older), "an older format version: refused");
+    check(b.get_sim_seconds() == t && b.load_checkpoint(saved),
+          "refusals left the simulation usable");
+  }
+}
+
+static void test_cost() {
+  Course course = Course::create_endulating();
+  Scenario s;
+  Simulation a(&course);
+  s.build(a, 500);
+  for (int i = 0; i < 3000; ++i)
+    a.step_fixed(0.01);
+
+  auto t0 = std::chrono::steady_clock::now();
+  const std::vector<char> saved = a.save_checkpoint();
+  const double t_save = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - t0)
+                            .count();
+
+  Scenario s2;
+  Simulation b(&course);
+  s2.build(b, 500);
+  b.step_fixed(0.01);
+  t0 = std::chrono::steady_clock::now();
+  const bool loaded = b.load_checkpoint(saved);
+  const double t_load = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - t0)
+                            .count();
+
+  std::cout << "  [cost] 500 riders: " << saved.size() / 1024
+            << " KiB, save " << t_save << " ms, load " << t_load << " ms\n";
+  check(loaded && same_state(a, b), "500 riders: round trip");
+}
+
+int main() {
+  std::cout << "=== Checkpoint tests ===\n";
+  test_continue_identically();
+  test_file_round_trip();
+  test_refusals();
+  test_cost();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All checkpoint tests passed\n";
+  return 0;
+}
@@ -0,0 +1,248 @@
+// Tests for the UI -> physics command queue (command_queue.h): the ring is
+// FIFO and drops (counted) when full, concurrent producers lose nothing and
+// keep their own order, Simulation coalesces runs of set_rider_effort per
+// rider without reordering around other commands, and pushing and draining
+// efforts allocates nothing.
+
+#include "command_queue.h"
+
+#include "course.h"
+#include "decision.h"
+#include "sim.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::atomic<bool> counting{false};
+static std::atomic<long> allocations{0};
+
+void* operator new(std::size_t n) {
+  if (counting.load(std::memory_order_relaxed))
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return ::operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     250.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+// Holds its effort: never touches the rider.
+class IdlePolicy : public IRiderPolicy {
+public:
+  const char* name() const override { return "idle"; }
+  PolicyOutput decide(const DecisionContext&) override {
+    return PolicyOutput{};
+  }
+};
+
+static void test_ring() {
+  MpscRing<SimCommand> ring(8);
+  SimCommand out;
+  check(!ring.pop(out) && ring.size() == 0, "empty ring: nothing to pop");
+
+  for (int i = 0; i < 10; ++i)
+    ring.push(SetRiderEffortCmd{i, 0.1 * i});
+  check(ring.size() == 8 && ring.dropped() == 2,
+        "full ring: pushes beyond capacity dropped and counted");
+
+  bool fifo = true;
+  for (int i = 0; i < 8; ++i) {
+    const bool got = ring.pop(out);
+    const auto* e = std::get_if<SetRiderEffortCmd>(&out);
+    fifo = fifo && got && e && e->rider == i;
+  }
+  check(fifo && !ring.pop(out), "records come out in push order");
+
+  ring.push(SetPacelineRotationCmd{{RotationMember{1}, RotationMember{2}}, {}});
+  ring.pop(out);
+  const auto* rot = std::get_if<SetPacelineRotationCmd>(&out);
+  check(rot && rot->roster.size() == 2 && ring.size() == 0,
+        "owned payloads move through; ring wraps");
+
+  MpscRing<SimCommand> odd(5), tiny(0);
+  int held = 0;
+  while (odd.push(SetRiderEffortCmd{held, 1.0}))
+    ++held;
+  check(odd.capacity() == 8 && held == 8 && tiny.capacity() == 2,
+        "capacity rounds up to a power of two, at least 2");
+}
+
+// Producers racing the consumer: every record arrives exactly once, and
+// each producer's records in its own order.
+static void test_concurrent() {
+  MpscRing<SimCommand> ring(64);
+  const int producers = 4, per = 50000;
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p)
+    threads.emplace_back([&ring, p] {
+      for (int i = 0; i < per; ++i) {
+        SimCommand c = SetRiderEffortCmd{p, static_cast<double>(i)};
+        while (!ring.push(std::move(c)))
+          std::this_thread::yield(); // full: retry (a drop leaves c intact)
+      }
+    });
+
+  std::vector<double> next(producers, 0.0);
+  long received = 0;
+  bool ordered = true;
+  SimCommand out;
+  while (received < producers * per) {
+    if (!ring.pop(out))
+      continue;
+    const auto& e = std::get<SetRiderEffortCmd>(out);
+    ordered = ordered && e.effort == next[e.rider];
+    next[e.rider] = e.effort + 1.0;
+    ++received;
+  }
+  for (std::thread& t : threads)
+    t.join();
+
+  std::cout << "  [race] " << received << " records, " << ring.dropped()
+            << " full-ring retries\n";
+  bool all = true;
+  for (double n : next)
+    all = all && n == per;
+  check(ordered, "race: per-producer order kept");
+  check(all && !ring.pop(out), "race: every record exactly once");
+}
+
+static void test_coalescing() {
+  Course course = Course::create_flat();
+  Simulation sim(&course);
+  sim.add_riders({cfg(1), cfg(2), cfg(3)});
+  const PhysicsEngine* eng = sim.get_engine();
+
+  // A slider drag: many efforts for two riders, interleaved.
+  for (int i = 1; i <= 100; ++i) {
+    sim.set_rider_effort(1, 0.005 * i);
+    sim.set_rider_effort(2, 0.004 * i);
+  }
+  check(sim.get_command_queue_depth() == 200, "depth counts queued commands");
+  sim.step_fixed(0.01);
+  check(sim.get_command_queue_depth() == 0, "a step drains the queue");
+  check(sim.get_coalesced_commands() == 198, "a run collapses to one per rider");
+  check(eng->get_rider_by_id(1)->get_target_effort() == 0.5 &&
+            eng->get_rider_by_id(2)->get_target_effort() == 0.4,
+        "the last effort per rider wins");
+
+  // Efforts either side of a mode change keep their own meaning: 0.9 lands
+  // while Manual, the policy then makes 0.3 a no-op.
+  const std::uint64_t before = sim.get_coalesced_commands();
+  sim.set_rider_effort(3, 0.9);
+  sim.set_rider_policy(3, std::make_shared<IdlePolicy>());
+  sim.set_rider_effort(3, 0.3);
+  sim.step_fixed(0.01);
+  check(sim.get_coalesced_commands() == before,
+        "no coalescing across another command");
+  check(eng->get_rider_by_id(3)->get_target_effort() == 0.9 &&
+            sim.get_effort_source(3) == EffortSource::Policy,
+        "commands apply in call order");
+
+  // A follow set and cleared between two efforts: both efforts apply.
+  sim.set_rider_effort(1, 0.6);
+  sim.set_follow_target(1, 2);
+  sim.clear_follow_target(1);
+  sim.set_rider_effort(1, 0.7);
+  sim.step_fixed(0.01);
+  check(eng->get_rider_by_id(1)->get_target_effort() == 0.7 &&
+            !eng->has_follow_target(1),
+        "follow set and cleared in one step");
+}
+
+static void test_drops_and_reset() {
+  Course course = Course::create_flat();
+  Simulation sim(&course);
+  sim.add_riders({cfg(1)});
+  const int cap = static_cast<int>(sim.get_command_queue_capacity());
+  for (int i = 0; i < cap + 100; ++i)
+    sim.set_rider_effort(1, 0.5);
+  check(sim.get_command_queue_depth() == static_cast<size_t>(cap) &&
+            sim.get_dropped_commands() == 100,
+        "full queue: overflow dropped and counted");
+
+  sim.reset();
+  check(sim.get_command_queue_depth() == 0, "reset discards queued commands");
+  sim.set_rider_effort(1, 0.8);
+  sim.step_fixed(0.01);
+  check(sim.get_engine()->get_rider_by_id(1)->get_target_effort() == 0.8,
+        "queue usable after reset");
+}
+
+static void test_no_allocation() {
+  Course course = Course::create_flat();
+  Simulation sim(&course);
+  std::vector<RiderConfig> field;
+  for (int id = 1; id <= 100; ++id)
+    field.push_back(cfg(id));
+  sim.add_riders(field);
+  for (int i = 0; i < 200; ++i)
+    sim.step_fixed(0.01);
+
+  allocations = 0;
+  counting = true;
+  for (int i = 0; i < 500; ++i)
+    sim.set_rider_effort(1 + i % 100, 0.6 + 0.0001 * i);
+  counting = false;
+  check(allocations.load() == 0, "pushing efforts allocates nothing");
+
+  // The drain itself: a step with 500 queued efforts costs no more
+  // allocations than an empty one.
+  allocations = 0;
+  counting = true;
+  sim.step_fixed(0.01);
+  counting = false;
+  const long with_commands = allocations.load();
+
+  allocations = 0;
+  counting = true;
+  sim.step_fixed(0.01);
+  counting = false;
+  std::cout << "  allocations: step with 500 efforts " << with_commands
+            << ", empty step " << allocations.load() << "\n";
+  check(with_commands <= allocations.load(), "draining efforts allocates nothing");
+}
+
+int main() {
+  std::cout << "=== Command queue tests ===\n";
+  test_ring();
+  test_concurrent();
+  test_coalescing();
+  test_drops_and_reset();
+  test_no_allocation();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All command queue tests passed\n";
+  return 0;
+}
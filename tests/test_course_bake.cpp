@@ -0,0 +1,228 @@
+// Tests for the baked per-segment environment (course.h SegmentEnv, the
+// SIM_ENV_* terms in sim_core.h): baked values equal the expressions they
+// replace, set_wind rebakes, a rider on a baked course steps bit-identically
+// to one on an unbaked view where altitude is flat and within a tight bound
+// on climbs (interpolated altitude factor).  The baked and derived core
+// steps are timed and printed.
+
+#include "course.h"
+#include "rider.h"
+#include "sim_core.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     250.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+// The same course through the getters only: ICourseView's default sample()
+// evaluates every derived term in place and reports no segment.
+class UnbakedView : public ICourseView {
+public:
+  explicit UnbakedView(const Course& c) : c_(c) {
+    total_length_ = c.get_total_length();
+  }
+  double get_slope(double pos) const override { return c_.get_slope(pos); }
+  double get_altitude(double pos) const override {
+    return c_.get_altitude(pos);
+  }
+  double get_crr(double pos) const override { return c_.get_crr(pos); }
+  double get_road_width(double pos) const override {
+    return c_.get_road_width(pos);
+  }
+  double get_heading(double pos) const override {
+    return c_.get_heading(pos);
+  }
+  Wind get_wind(double pos) const override { return c_.get_wind(pos); }
+
+private:
+  const Course& c_;
+};
+
+static Course make_gpx_like(int n_segments) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> len(2.0, 30.0), grade(-0.08, 0.08),
+      heading(-3.1, 3.1), width(5.0, 9.0);
+  std::vector<std::array<double, 5>> segs;
+  for (int i = 0; i < n_segments; ++i)
+    segs.push_back({len(rng), grade(rng), 0.004, heading(rng), width(rng)});
+  Course c = Course::from_segments(segs);
+  c.set_wind(Wind{1.0, 3.0});
+  return c;
+}
+
+static bool baked_terms_match(const Course& c, double pos,
+                              const CourseSample& s) {
+  const double slope = c.get_slope(pos), heading = c.get_heading(pos);
+  const Wind w = c.get_wind(pos);
+  return s.grav_sin == std::sin(std::atan(slope)) &&
+         s.headwind == w.speed * std::cos(w.heading - heading) &&
+         s.crosswind == w.speed * std::sin(w.heading - heading);
+}
+
+static void test_bake_values() {
+  Course c = make_gpx_like(500);
+  const double L = c.get_total_length();
+  check(c.get_segment_env().size() == c.get_segments().size(),
+        "one baked record per segment");
+
+  SegmentCursor cur;
+  bool same = true;
+  for (double pos = 0.0; pos < L; pos += 0.37)
+    same = same && baked_terms_match(c, pos, c.sample(pos, cur));
+  check(same, "baked terms == sin(atan), cos / sin wind projections");
+
+  c.set_wind(Wind{-2.0, 6.5});
+  cur = SegmentCursor{};
+  same = true;
+  for (double pos = 0.0; pos < L; pos += 0.37)
+    same = same && baked_terms_match(c, pos, c.sample(pos, cur));
+  check(same, "set_wind rebakes the projections");
+
+  const UnbakedView view(c);
+  bool views_agree = true;
+  for (double pos = 0.0; pos < L; pos += 1.3) {
+    const CourseSample a = c.sample(pos), b = view.sample(pos);
+    views_agree = views_agree && a.grav_sin == b.grav_sin &&
+                  a.headwind == b.headwind && a.crosswind == b.crosswind;
+  }
+  check(views_agree, "default sample() derives the same terms");
+  check(view.sample(10.0).segment == -1, "default sample() has no segment");
+
+  const double x3 = c.get_segments()[3].start_x;
+  const CourseSample s = c.sample(x3 + 1.0);
+  check(s.segment == 3 && s.seg_alt0 == c.get_altitude(x3),
+        "sample reports its segment and start altitude");
+}
+
+// Step one rider on the baked course and one on the unbaked view side by
+// side; returns the largest relative power difference seen.
+static double ride_pair(const Course& course, int ticks, bool* identical) {
+  const UnbakedView view(course);
+  Rider baked(cfg(1)), plain(cfg(2));
+  baked.set_course(&course);
+  plain.set_course(&view);
+  baked.set_effort(0.8);
+  plain.set_effort(0.8);
+
+  double worst = 0.0;
+  *identical = true;
+  for (int i = 0; i < ticks; ++i) {
+    baked.update(0.01);
+    plain.update(0.01);
+    const RiderSnapshot a = baked.snapshot(), b = plain.snapshot();
+    worst = std::max(worst, std::fabs(a.power - b.power) / b.power);
+    *identical = *identical && a.pos == b.pos && a.speed == b.speed &&
+                 a.power == b.power;
+  }
+  return worst;
+}
+
+static void test_rider_parity() {
+  Course flat = Course::from_segments(
+      {{3000, 0, 0, 0, 8}, {3000, 0, 0, 1.2, 8}, {3000, 0, 0.002, -0.4, 8}});
+  flat.set_wind(Wind{0.7, 4.0});
+  bool identical = false;
+  ride_pair(flat, 30000, &identical);
+  check(identical, "flat, windy course: baked rider bit-identical");
+
+  // A 1000 m start and 10 % ramps: the altitude factor is interpolated
+  // along each segment instead of evaluated exactly.
+  const Course hilly = Course::create_endulating();
+  const double worst = ride_pair(hilly, 60000, &identical);
+  std::cout << "  [climb] max relative power difference " << worst << "\n";
+  check(worst < 1e-4, "climbs: interpolated altitude factor within 1e-4");
+}
+
+static void test_core_cost() {
+  const int n = 2000000;
+  RiderInitParams p{};
+  p.ftp_base = 250;
+  p.w_prime = 24000;
+  p.max_effort = 2;
+  p.ftp_degrade_threshold = 6;
+  p.ftp_degrade_rate = 0.05;
+  p.max_drive_force = 700;
+  p.oxy_p50 = 3.5;
+  p.mass_rider = 65;
+  p.cda = 0.3;
+  p.mass_bike = 8;
+  p.wheel_i = 0.1;
+  p.wheel_r = 0.335;
+  p.wheel_drag_factor = 0.05;
+  p.drivetrain_loss = 0.03;
+
+  EnvState env{};
+  env.rho = 1.2234;
+  env.g = 9.80665;
+  env.slope = 0.06;
+  env.altitude = 1500.0;
+  env.bearing_c0 = 0.091;
+  env.bearing_c1 = 0.0087;
+
+  auto run = [&](const EnvState& e, double* pos) {
+    RiderState r;
+    rider_state_init(&r, &p);
+    r.solver = SIM_SOLVER_ACCEL_FORCE;
+    r.target_effort = 0.8;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i)
+      sim_step_rider(&r, &e, 0.01, nullptr);
+    *pos = r.pos;
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - t0)
+               .count() /
+           n;
+  };
+
+  double pos_plain = 0.0, pos_baked = 0.0;
+  const double t_plain = run(env, &pos_plain);
+
+  RiderState probe;
+  rider_state_init(&probe, &p);
+  EnvState baked = env;
+  baked.baked = SIM_ENV_GRAV_SIN | SIM_ENV_ALT_FACTOR;
+  baked.grav_sin = std::sin(std::atan(env.slope));
+  baked.alt_factor = altitude_ftp_factor(env.altitude, p.oxy_p50, &probe);
+  const double t_baked = run(baked, &pos_baked);
+
+  std::cout << "  [cost] sim_step_rider: derived " << t_plain
+            << " ns/step, baked " << t_baked << " ns/step\n";
+  check(pos_plain == pos_baked, "baked core step is bit-identical");
+}
+
+int main() {
+  std::cout << "=== Course bake tests ===\n";
+  test_bake_values();
+  test_rider_parity();
+  test_core_cost();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All course bake tests passed\n";
+  return 0;
+}
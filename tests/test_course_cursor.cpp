@@ -0,0 +1,130 @@
+// Tests for the course segment cursor (course.h): sample(pos, cursor) must
+// return exactly what the per-field getters return — walking forward like a
+// rider, at segment boundaries, past the finish, and after backward moves
+// and jumps.  Both paths are timed on a GPX-sized course and printed.
+
+#include "course.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+// GPX-like: many short segments of varying grade, heading and width.
+static Course make_gpx_like(int n_segments) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> len(2.0, 30.0), grade(-0.08, 0.08),
+      heading(-3.1, 3.1), width(5.0, 9.0);
+  std::vector<std::array<double, 5>> segs;
+  for (int i = 0; i < n_segments; ++i)
+    segs.push_back({len(rng), grade(rng), 0.004, heading(rng), width(rng)});
+  Course c = Course::from_segments(segs);
+  c.set_wind(Wind{1.0, 3.0});
+  return c;
+}
+
+static bool same_as_getters(const Course& c, double pos,
+                            const CourseSample& s) {
+  const Wind w = c.get_wind(pos);
+  return s.slope == c.get_slope(pos) && s.crr == c.get_crr(pos) &&
+         s.heading == c.get_heading(pos) &&
+         s.road_width == c.get_road_width(pos) &&
+         s.altitude == c.get_altitude(pos) && s.wind.heading == w.heading &&
+         s.wind.speed == w.speed;
+}
+
+static void test_matches_getters() {
+  const Course c = make_gpx_like(2000);
+  const double L = c.get_total_length();
+
+  // Forward at riding speed (0.1-0.2 m per step).
+  SegmentCursor cur;
+  bool fwd = true;
+  for (double pos = 0.0; pos < L; pos += 0.137)
+    fwd = fwd && same_as_getters(c, pos, c.sample(pos, cur));
+  check(fwd, "forward walk: sample == getters everywhere");
+
+  // Exactly on every segment start, then the finish and beyond.
+  cur = SegmentCursor{};
+  bool edges = true;
+  for (const Segment& s : c.get_segments())
+    edges = edges && same_as_getters(c, s.start_x, c.sample(s.start_x, cur));
+  edges = edges && same_as_getters(c, L, c.sample(L, cur));
+  edges = edges && same_as_getters(c, L + 50.0, c.sample(L + 50.0, cur));
+  check(edges, "segment starts, finish and past it");
+  check(cur.seg == static_cast<int>(c.get_segments().size()) - 1,
+        "cursor ends on the last segment");
+
+  // Backward moves and long jumps fall back to the search.
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> any(0.0, L);
+  bool jumps = true;
+  for (int i = 0; i < 5000; ++i) {
+    const double pos = any(rng);
+    jumps = jumps && same_as_getters(c, pos, c.sample(pos, cur));
+  }
+  check(jumps, "random jumps (backward included): sample == getters");
+
+  SegmentCursor stale{123456};
+  check(same_as_getters(c, 10.0, c.sample(10.0, stale)),
+        "an out-of-range cursor is still valid");
+  check(same_as_getters(c, 10.0, c.sample(10.0)), "cursor-less sample");
+}
+
+static void test_cost() {
+  const Course c = make_gpx_like(10000);
+  const double L = c.get_total_length();
+  const double step = 0.12; // ~12 m/s at 100 Hz
+  double sum_getters = 0.0, sum_cursor = 0.0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (double pos = 0.0; pos < L; pos += step) {
+    const ICourseView& v = c;
+    sum_getters += v.get_slope(pos) + v.get_crr(pos) + v.get_heading(pos) +
+                   v.get_altitude(pos) + v.get_wind(pos).speed;
+  }
+  const double t_getters = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - t0)
+                               .count();
+
+  SegmentCursor cur;
+  t0 = std::chrono::steady_clock::now();
+  for (double pos = 0.0; pos < L; pos += step) {
+    const ICourseView& v = c;
+    const CourseSample s = v.sample(pos, cur);
+    sum_cursor += s.slope + s.crr + s.heading + s.altitude + s.wind.speed;
+  }
+  const double t_cursor = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - t0)
+                              .count();
+
+  std::cout << "  [cost] 10000 segments, " << static_cast<int>(L / step)
+            << " steps: getters " << t_getters << " ms, cursor " << t_cursor
+            << " ms\n";
+  check(sum_cursor == sum_getters, "both paths read identical values");
+}
+
+int main() {
+  std::cout << "=== Course cursor tests ===\n";
+  test_matches_getters();
+  test_cost();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All course cursor tests passed\n";
+  return 0;
+}
@@ -258,8 +258,9 @@ static void test_decide_cadence() {
   // Snapshot carries the mode + policy name.
   FrameSnapshot prev, curr;
   sim.consume_latest_frame_pair(prev, curr);
-  check(curr.riders.at(1).effort_source == EffortSource::Policy &&
-            curr.riders.at(1).policy == "probe",
+  const RiderSnapshot* r1 = curr.find(1);
+  check(r1 && r1->effort_source == EffortSource::Policy &&
+            curr.str(r1->policy) == "probe",
         "cadence: snapshot stamped with source + policy name");
 }
 
@@ -8,8 +8,11 @@
 #include "rider.h"
 #include "sim.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -324,6 +327,129 @@ static void test_engine_integration() {
         "integration: drafting follower beats identical solo rider");
 }
 
+// Straight transcription of the original quadratic pass (every rider
+// scans every rider for followers and Body counts) — the reference the
+// restructured compute_draft_factors must match bit for bit.
+static std::vector<double> quadratic_reference(
+    const std::vector<DraftRiderState>& r, const DraftingParams& p) {
+  const int n = static_cast<int>(r.size());
+  constexpr int NT = sizeof(p.paceline_table) / sizeof(double);
+  constexpr int NB = sizeof(p.body_curve) / sizeof(double);
+  auto table = [&](double d) {
+    if (d >= NT - 1)
+      return p.paceline_table[NT - 1];
+    const int lo = static_cast<int>(d);
+    return p.paceline_table[lo] * (1.0 - (d - lo)) +
+           p.paceline_table[lo + 1] * (d - lo);
+  };
+  std::vector<int> order(n);
+  for (int i = 0; i < n; ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(),
+            [&](int a, int b) { return r[a].lon_pos > r[b].lon_pos; });
+
+  std::vector<int> leader_of(n, -1);
+  std::vector<double> link_s(n, 0.0), depth(n, 0.0), f(n, 1.0);
+  for (int k = 0; k < n; ++k) {
+    const int i = order[k];
+    int best = -1, evaluated = 0;
+    double best_b = 0.0, best_s = 0.0, best_d = 0.0;
+    for (int k2 = k - 1; k2 >= 0 && evaluated < p.link_candidates; --k2) {
+      const int j = order[k2];
+      const double lon_sep = r[j].lon_pos - r[i].lon_pos;
+      if (lon_sep <= 0.0)
+        continue;
+      const double gap = lon_sep - r[j].bike_len;
+      if (gap >= p.max_draft_gap)
+        continue;
+      ++evaluated;
+      const double off = r[i].lat_pos - wake_axis_lat(r[j], r[i].lon_pos);
+      const double cutoff = p.lat_cutoff_radii * r[j].radius;
+      const double align =
+          cutoff <= 0.0 ? 0.0 : std::max(0.0, 1.0 - std::fabs(off) / cutoff);
+      const double s_ = draft_gap_falloff(gap, p) * align;
+      if (s_ <= 0.0)
+        continue;
+      const double d = 1.0 + link_s[j] * depth[j];
+      const double b = (1.0 - table(d)) * s_;
+      if (b > best_b) {
+        best = j;
+        best_b = b;
+        best_s = s_;
+        best_d = d;
+      }
+    }
+    if (best >= 0) {
+      leader_of[i] = best;
+      link_s[i] = best_s;
+      depth[i] = best_d;
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    if (r[i].role == GroupRole::Body) {
+      int ahead = 0;
+      for (int j = 0; j < n; ++j) {
+        const double d = r[j].lon_pos - r[i].lon_pos;
+        if (j != i && r[j].group_id == r[i].group_id && d > 0.0 &&
+            d <= p.body_window)
+          ++ahead;
+      }
+      f[i] = p.body_curve[std::min(ahead, NB - 1)];
+      continue;
+    }
+    double fs = 0.0;
+    for (int j = 0; j < n; ++j)
+      if (leader_of[j] == i)
+        fs = std::max(fs, link_s[j]);
+    const double ahead =
+        leader_of[i] >= 0 ? (1.0 - table(depth[i])) * link_s[i] : 0.0;
+    f[i] = 1.0 - ahead - (1.0 - p.paceline_table[0]) * fs * (1.0 - link_s[i]);
+  }
+  return f;
+}
+
+// Mixed roles, several groups, ties, crosswind: the accumulated follower
+// strengths and the sliding Body window reproduce the quadratic pass.
+static void test_matches_quadratic_reference() {
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  const DraftingParams p{};
+  bool same = true;
+  for (int trial = 0; trial < 50; ++trial) {
+    std::vector<DraftRiderState> field;
+    for (int i = 0; i < 120; ++i) {
+      DraftRiderState d = ds(i, 0.0, (u(rng) - 0.5) * 2.0);
+      d.group_id = static_cast<GroupId>(u(rng) * 3);
+      d.lon_pos = 60.0 * d.group_id + 25.0 * u(rng);
+      if (i % 9 == 0 && i > 0)
+        d.lon_pos = field[i - 1].lon_pos; // exact ties
+      d.role = u(rng) < 0.4 ? GroupRole::Body : GroupRole::Unassigned;
+      d.bike_len = 1.4 + 0.3 * u(rng);
+      d.crosswind = trial % 2 ? 3.0 : 0.0;
+      field.push_back(d);
+    }
+    same = same && compute_draft_factors(field, p) ==
+                       quadratic_reference(field, p);
+  }
+  check(same, "50 random fields: factors == quadratic reference");
+
+  // Timing: one 3000-rider Body blob, the case policies are about to create.
+  std::vector<DraftRiderState> blob;
+  for (int i = 0; i < 3000; ++i) {
+    DraftRiderState d = ds(i, 0.05 * i, (u(rng) - 0.5) * 4.0);
+    d.group_id = 0;
+    d.role = GroupRole::Body;
+    blob.push_back(d);
+  }
+  const auto t0 = std::chrono::steady_clock::now();
+  const std::vector<double> f = compute_draft_factors(blob, p);
+  const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - t0)
+                        .count();
+  std::cout << "  [blob] 3000 Body riders: " << ms << " ms\n";
+  check(f == quadratic_reference(blob, p), "3000-rider blob == reference");
+}
+
 int main() {
   test_gap_falloff();
   test_lone_and_pair();
@@ -338,6 +464,7 @@ int main() {
   test_link_switch_continuity();
   test_link_candidate_cap();
   test_body_role();
+  test_matches_quadratic_reference();
   test_engine_integration();
 
   if (checks_failed) {
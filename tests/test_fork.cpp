@@ -0,0 +1,137 @@
+// Tests for Simulation::fork (sim.h): a fork is the original's state
+// exactly (checked against a checkpoint, byte for byte), steps on
+// identically, stays independent when changed or stepped on another
+// thread, and clones stateful policies.  The benchmark forks a 200-rider
+// mid-race state and steps 10 s of sim time; it prints the timings and
+// does not gate on them.
+
+#include "checkpoint.h"
+
+#include "course.h"
+#include "decision.h"
+#include "sim.h"
+#include "sim_fixture.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static void step(Simulation& sim, int n) {
+  for (int i = 0; i < n; ++i)
+    sim.step_fixed(0.01);
+}
+
+static void test_identical_and_independent() {
+  Course course = Course::create_endulating();
+  // Stateful: a fork sharing it would see the original's decisions.
+  auto counting = std::make_shared<CountingPolicy>();
+  Simulation sim(&course);
+  build_mid_race(sim, 40, counting);
+  step(sim, 1537);
+
+  std::unique_ptr<Simulation> f = sim.fork();
+  check(f->save_checkpoint() == sim.save_checkpoint(),
+        "a fork is the original's state, byte for byte");
+
+  step(sim, 1000);
+  step(*f, 1000);
+  check(f->save_checkpoint() == sim.save_checkpoint(),
+        "and steps on identically");
+
+  // What if rider 3 attacks now?
+  const std::vector<char> before = sim.save_checkpoint();
+  const int calls = counting->calls();
+  std::unique_ptr<Simulation> what_if = sim.fork();
+  what_if->clear_paceline_rotation();
+  what_if->set_rider_effort(3, 1.6);
+  step(*what_if, 2000);
+  check(sim.save_checkpoint() == before && counting->calls() == calls,
+        "changing and stepping a fork leaves the original untouched");
+  check(what_if->get_engine()->get_rider_by_id(3)->get_pos() >
+            sim.get_engine()->get_rider_by_id(3)->get_pos() + 100.0,
+        "the fork ran its own race");
+}
+
+// A fork stepped on another thread while the original steps on this one
+// ends where a serially-stepped fork does.
+static void test_threads() {
+  Course course = Course::create_endulating();
+  Simulation sim(&course);
+  build_mid_race(sim, 40, std::make_shared<CountingPolicy>());
+  step(sim, 1000);
+
+  std::unique_ptr<Simulation> serial = sim.fork();
+  std::unique_ptr<Simulation> threaded = sim.fork();
+  std::thread worker([&threaded] { step(*threaded, 2000); });
+  step(sim, 2000);
+  worker.join();
+  step(*serial, 2000);
+
+  check(threaded->save_checkpoint() == serial->save_checkpoint(),
+        "a fork stepped on another thread matches a serial one");
+  check(sim.save_checkpoint() == serial->save_checkpoint(),
+        "... and the original it was forked from");
+}
+
+static void test_benchmark() {
+  Course course = Course::create_endulating();
+  Simulation sim(&course);
+  build_mid_race(sim, 200, std::make_shared<CountingPolicy>());
+  step(sim, 3000); // 30 s: the field strung out
+
+  const int forks = 200;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < forks; ++i) {
+    std::unique_ptr<Simulation> f = sim.fork();
+  }
+  const double t_fork = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - t0)
+                            .count() /
+                        forks;
+
+  t0 = std::chrono::steady_clock::now();
+  const std::vector<char> bytes = sim.save_checkpoint();
+  const double t_save = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - t0)
+                            .count();
+
+  std::unique_ptr<Simulation> f = sim.fork();
+  t0 = std::chrono::steady_clock::now();
+  step(*f, 1000);
+  const double t_run = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - t0)
+                           .count();
+
+  std::cout << "  [bench] 200 riders mid-race: fork " << t_fork
+            << " us (checkpoint save " << t_save << " us), 10 s lookahead "
+            << t_run << " ms\n";
+  check(f->get_sim_seconds() > sim.get_sim_seconds() + 9.9,
+        "bench: the fork ran 10 s ahead");
+}
+
+int main() {
+  std::cout << "=== Fork tests ===\n";
+  test_identical_and_independent();
+  test_threads();
+  test_benchmark();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All fork tests passed\n";
+  return 0;
+}
@@ -0,0 +1,214 @@
+// Tests for frame publication (frame_channel.h): pairs pin published
+// frames so later publishes never touch them, clear() and dropped frames
+// behave, a reader racing the writer only ever sees whole, ordered frames,
+// and Simulation hands the renderer its pair without copying.
+
+#include "frame_channel.h"
+
+#include "course.h"
+#include "sim.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static void publish_frame(FrameChannel& ch, double t) {
+  FrameSnapshot* f = ch.begin();
+  if (!f)
+    return;
+  f->sim_time = t;
+  f->sim_dt = 2.0 * t;
+  f->real_time = t + 1.0;
+  ch.publish();
+}
+
+static void test_publish_and_pin() {
+  FrameChannel ch;
+  check(!ch.acquire(), "nothing published: empty pair");
+
+  publish_frame(ch, 1.0);
+  {
+    const FramePair p = ch.acquire();
+    check(p && p.curr().sim_time == 1.0, "first publish is current");
+    check(p.prev().sim_time == -1.0, "no previous yet: sentinel frame");
+  }
+
+  publish_frame(ch, 2.0);
+  const FramePair held = ch.acquire();
+  check(held.prev().sim_time == 1.0 && held.curr().sim_time == 2.0,
+        "second publish: (prev, curr) = (1, 2)");
+
+  for (int i = 3; i < 100; ++i)
+    publish_frame(ch, i);
+  check(held.prev().sim_time == 1.0 && held.curr().sim_time == 2.0 &&
+            held.curr().sim_dt == 4.0,
+        "a held pair is untouched by later publishes");
+  check(ch.acquire().curr().sim_time == 99.0, "a new pair sees the latest");
+  check(ch.dropped() == 0, "one reader: no drops");
+
+  ch.clear();
+  check(!ch.acquire(), "clear: nothing published");
+  check(held.curr().sim_time == 2.0, "clear: held pairs stay valid");
+
+  FramePair moved = ch.acquire();
+  publish_frame(ch, 5.0);
+  moved = ch.acquire();
+  FramePair other = std::move(moved);
+  check(!moved && other.curr().sim_time == 5.0, "pairs move");
+}
+
+// Readers pinning every spare slot make the writer drop, never wait.
+static void test_drops() {
+  FrameChannel ch;
+  std::vector<FramePair> pins;
+  for (int i = 1; i <= 2 * FrameChannel::kSlots; ++i) {
+    publish_frame(ch, i);
+    pins.push_back(ch.acquire());
+  }
+  check(ch.dropped() > 0, "all slots pinned: frames dropped");
+  check(ch.begin() == nullptr, "all slots pinned: begin() gives nothing");
+
+  pins.clear();
+  const std::uint64_t before = ch.dropped();
+  publish_frame(ch, 1000.0);
+  check(ch.dropped() == before && ch.acquire().curr().sim_time == 1000.0,
+        "released: publishing resumes");
+}
+
+// A writer publishing back to back against a reader: every pair it pins
+// is internally consistent (fields written together), ordered, and stays
+// put while held.
+static void test_concurrent() {
+  FrameChannel ch;
+  std::atomic<bool> done{false};
+  const int frames = 4000; // plenty of interleavings, quick on any core count
+
+  std::thread writer([&] {
+    for (int i = 1; i <= frames; ++i) {
+      publish_frame(ch, i);
+      std::this_thread::yield(); // let the reader interleave
+    }
+    done = true;
+  });
+
+  long pairs = 0;
+  bool consistent = true, ordered = true, stable = true;
+  double last = 0.0;
+  while (!done.load()) {
+    const FramePair p = ch.acquire();
+    if (!p)
+      continue;
+    ++pairs;
+    const FrameSnapshot& c = p.curr();
+    const double t = c.sim_time;
+    consistent = consistent && c.sim_dt == 2.0 * t && c.real_time == t + 1.0;
+    ordered = ordered && p.prev().sim_time < t;
+    ordered = ordered && t >= last;
+    last = t;
+    std::this_thread::yield();
+    stable = stable && c.sim_time == t && c.sim_dt == 2.0 * t;
+  }
+  writer.join();
+
+  std::cout << "  [race] " << pairs << " pairs read, " << ch.dropped()
+            << " frames dropped\n";
+  check(consistent, "race: every pinned frame is whole");
+  check(ordered, "race: prev precedes curr; curr never goes back");
+  check(stable, "race: a pinned frame does not change while held");
+  check(ch.acquire().curr().sim_time == frames, "race: last frame published");
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     250.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+static void test_simulation() {
+  Course course = Course::create_flat();
+  Simulation sim(&course);
+  std::vector<RiderConfig> field;
+  for (int id = 1; id <= 500; ++id)
+    field.push_back(cfg(id));
+  sim.add_riders(field);
+
+  check(!sim.acquire_frames(), "sim: nothing before the first step");
+  for (int i = 0; i < 10; ++i)
+    sim.step_fixed(0.01);
+
+  const FramePair held = sim.acquire_frames();
+  check(held && held.curr().riders.size() == 500, "sim: pair published");
+  check(held.curr().sim_time == sim.get_sim_seconds() &&
+            held.prev().sim_time < held.curr().sim_time,
+        "sim: pair is the last two steps");
+
+  const double t_held = held.curr().sim_time;
+  const double pos_held = held.curr().find(1)->pos;
+  for (int i = 0; i < 100; ++i)
+    sim.step_fixed(0.01);
+  check(held.curr().sim_time == t_held &&
+            held.curr().find(1)->pos == pos_held,
+        "sim: a held pair survives later steps");
+
+  const int reads = 2000;
+  auto t0 = std::chrono::steady_clock::now();
+  FrameSnapshot prev, curr;
+  for (int i = 0; i < reads; ++i)
+    sim.consume_latest_frame_pair(prev, curr);
+  const double t_copy = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - t0)
+                            .count() /
+                        reads;
+
+  t0 = std::chrono::steady_clock::now();
+  bool latest = true;
+  for (int i = 0; i < reads; ++i) {
+    const FramePair p = sim.acquire_frames();
+    latest = latest && p.curr().sim_time == sim.get_sim_seconds();
+  }
+  const double t_pin = std::chrono::duration<double, std::micro>(
+                           std::chrono::steady_clock::now() - t0)
+                           .count() /
+                       reads;
+
+  std::cout << "  [cost] 500 riders: copy pair " << t_copy
+            << " us, pin pair " << t_pin << " us\n";
+  check(latest, "sim: every pinned read is the latest frame");
+
+  sim.reset();
+  check(!sim.acquire_frames(), "sim: reset unpublishes");
+  check(held.curr().sim_time == t_held, "sim: held pair outlives reset");
+}
+
+int main() {
+  std::cout << "=== Frame channel tests ===\n";
+  test_publish_and_pin();
+  test_drops();
+  test_concurrent();
+  test_simulation();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All frame channel tests passed\n";
+  return 0;
+}
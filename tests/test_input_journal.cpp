@@ -0,0 +1,253 @@
+// Tests for input journaling (input_journal.h): a session's commands are
+// journaled at the steps they were applied at, and it re-runs offline from
+// its journal to the same state, byte for byte, as often as it is replayed
+// — also when RealtimeSimRunner drove it while commands arrived from
+// another thread at arbitrary times; stateful policies in the journal
+// start fresh on every replay; reset() and load_checkpoint() end
+// journaling; and a journal refuses to replay into a scenario set up
+// differently.
+
+#include "input_journal.h"
+
+#include "analysis.h"
+#include "checkpoint.h"
+#include "course.h"
+#include "decision.h"
+#include "realtime_runner.h"
+#include "sim.h"
+#include "sim_fixture.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+// The setup a journal starts from; the same call gives the same scenario.
+// CountingPolicy's effort depends on how many times it has decided: a
+// replay that reused the live instance would not follow the live run.
+static std::unique_ptr<Simulation> scenario(const Course* course,
+                                            int riders) {
+  auto sim = std::make_unique<Simulation>(course);
+  sim->set_dt(0.01);
+  const TeamId team = sim->get_engine()->add_team("Alpha");
+  sim->add_riders(fixture_field(riders, team, team));
+  place_field(*sim, riders);
+  sim->set_rider_policy(riders, std::make_shared<CountingPolicy>());
+  sim->step_fixed(sim->get_dt()); // setup applied before the journal starts
+  return sim;
+}
+
+// What the UI does during the session, one call at a time.
+static void ui_command(Simulation& sim, int i) {
+  const RiderId id = 1 + (i * 7) % 29;
+  switch (i % 8) {
+  case 0:
+  case 1:
+  case 2: // the slider, dragged: several coalesce into one step
+    for (int k = 0; k < 3; ++k)
+      sim.set_rider_effort(id, 0.6 + 0.05 * ((i + k) % 9));
+    break;
+  case 3: {
+    WPrimePacingParams pace;
+    sim.set_rider_policy(id, std::make_shared<WPrimePacingPolicy>(pace));
+    break;
+  }
+  case 4:
+    sim.set_effort_schedule(
+        id, std::make_shared<StepEffortSchedule>(std::vector<EffortBlock>{
+                {5.0, 1.1}, {1000.0, 0.75}}));
+    break;
+  case 5:
+    sim.set_follow_target(id, 1 + (id + 3) % 29);
+    break;
+  case 6:
+    sim.set_paceline_rotation({{2, false}, {4, false}, {6, true}},
+                              RotationParams{});
+    break;
+  case 7:
+    sim.clear_rider_policy(id);
+    break;
+  }
+}
+
+// Keeps the state the run ended in.
+class FinalState : public SimulationObserver {
+public:
+  void on_step(const Simulation&) override {}
+  void on_finish(const Simulation& sim) override {
+    state = sim.save_checkpoint();
+    seconds = sim.get_sim_seconds();
+  }
+  std::vector<char> state;
+  double seconds = -1.0;
+};
+
+// Entries in step order, each before the last journaled step.
+static bool ordered(const InputJournal& journal) {
+  const std::vector<JournalEntry>& e = journal.entries();
+  for (size_t i = 0; i < e.size(); ++i)
+    if ((i > 0 && e[i - 1].step > e[i].step) || e[i].step >= journal.steps())
+      return false;
+  return true;
+}
+
+// Commands issued between steps the test drives itself: each one lands in
+// a known step's drain.
+static void test_replay_identically() {
+  Course course = Course::create_endulating();
+  std::unique_ptr<Simulation> live = scenario(&course, 30);
+  InputJournal journal;
+  live->start_journal(&journal);
+
+  const int commands = 40;
+  std::vector<std::uint64_t> at;
+  std::uint64_t steps = 0;
+  for (int i = 0; i < commands; ++i) {
+    for (int k = 13 + (i * 11) % 29; k > 0; --k, ++steps)
+      live->step_fixed(live->get_dt());
+    ui_command(*live, i);
+    at.push_back(steps); // applied by the next step's drain
+  }
+  for (int k = 0; k < 50; ++k, ++steps)
+    live->step_fixed(live->get_dt());
+  live->stop_journal();
+  const std::vector<char> want = live->save_checkpoint();
+
+  bool where = journal.entries().size() == at.size();
+  for (size_t i = 0; where && i < at.size(); ++i)
+    where = journal.entries()[i].step == at[i];
+  check(journal.steps() == steps && where,
+        "every step and command journaled, at the step it was applied");
+  check(ordered(journal), "entries carry the steps they were applied at");
+
+  FinalState first;
+  const bool ran = replay_journal(journal, scenario(&course, 30), {&first});
+  check(ran && first.seconds == live->get_sim_seconds(),
+        "the replay takes the journaled steps");
+  check(first.state == want, "and ends in the live state, byte for byte");
+
+  FinalState second;
+  replay_journal(journal, scenario(&course, 30), {&second});
+  check(second.state == want, "a second replay gives the same run again");
+}
+
+// A live session: RealtimeSimRunner paces the steps, and commands arrive
+// from this thread whenever it wakes up.  How many steps run, and how the
+// efforts coalesce, depends on the machine; the replay must match anyway.
+static void test_replay_realtime() {
+  Course course = Course::create_endulating();
+  std::unique_ptr<Simulation> live = scenario(&course, 30);
+  live->set_time_factor(20.0);
+  InputJournal journal;
+  live->start_journal(&journal);
+
+  RealtimeSimRunner runner(live.get());
+  const auto t0 = std::chrono::steady_clock::now();
+  runner.start();
+  for (int i = 0; i < 40; ++i) {
+    const int ms = 13 + (i * 11) % 29;
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    ui_command(*live, i);
+  }
+  runner.stop();
+  const double t_live = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - t0)
+                            .count();
+  live->stop_journal();
+  const std::vector<char> want = live->save_checkpoint();
+
+  check(!journal.entries().empty() && ordered(journal),
+        "realtime: the session was journaled, in step order");
+
+  FinalState replayed;
+  const auto t1 = std::chrono::steady_clock::now();
+  const bool ran =
+      replay_journal(journal, scenario(&course, 30), {&replayed});
+  const double t_replay = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - t1)
+                              .count();
+  check(ran && replayed.state == want,
+        "realtime: the replay ends in the live state, byte for byte");
+
+  std::cout << "  [cost] " << journal.steps() << " steps: live " << t_live
+            << " s, replay " << t_replay << " s\n";
+}
+
+static void test_journal_ends() {
+  Course course = Course::create_flat();
+  std::unique_ptr<Simulation> sim = scenario(&course, 10);
+  const std::vector<char> saved = sim->save_checkpoint();
+
+  InputJournal journal;
+  sim->start_journal(&journal);
+  sim->set_rider_effort(3, 0.9);
+  sim->step_fixed(0.01);
+  sim->step_fixed(0.01);
+  check(journal.steps() == 2 && journal.entries().size() == 1 &&
+            journal.entries()[0].step == 0,
+        "a command queued before a step is applied at it");
+
+  sim->load_checkpoint(saved);
+  sim->step_fixed(0.01);
+  check(journal.steps() == 2, "load_checkpoint() ends journaling");
+
+  sim->start_journal(&journal);
+  check(journal.steps() == 0 && journal.entries().empty(),
+        "a restarted journal starts empty");
+  sim->reset();
+  sim->step_fixed(0.01);
+  check(journal.steps() == 0, "reset() ends journaling");
+
+  InputJournal idle;
+  std::unique_ptr<Simulation> other = scenario(&course, 10);
+  other->start_journal(&idle);
+  FinalState end;
+  check(replay_journal(idle, scenario(&course, 10), {&end}) &&
+            end.state == other->save_checkpoint(),
+        "an empty journal replays to its start");
+}
+
+static void test_refusals() {
+  Course course = Course::create_flat();
+  std::unique_ptr<Simulation> sim = scenario(&course, 10);
+  InputJournal journal;
+  sim->start_journal(&journal);
+  for (int i = 0; i < 100; ++i)
+    sim->step_fixed(0.01);
+
+  FinalState end;
+  check(!replay_journal(journal, scenario(&course, 9), {&end}) &&
+            end.seconds < 0.0,
+        "another roster: refused, nothing run");
+  Course other = Course::create_flat_short();
+  check(!replay_journal(journal, scenario(&other, 10), {&end}),
+        "another course: refused");
+}
+
+int main() {
+  std::cout << "=== Input journal tests ===\n";
+  test_replay_identically();
+  test_replay_realtime();
+  test_journal_ends();
+  test_refusals();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All input journal tests passed\n";
+  return 0;
+}
@@ -0,0 +1,239 @@
+// Tests for keyframe rewind (keyframes.h): rewinding a session lands on the
+// state it was in at that time, byte for byte — commands and policy or
+// schedule changes made since included — and the session carries on from
+// there; the ring stays within its memory cap; it starts over after
+// reset(); and RealtimeSimRunner serves rewind_to() while paused.  What
+// taking a keyframe of a 200-rider field costs is printed.
+
+#include "keyframes.h"
+
+#include "checkpoint.h"
+#include "course.h"
+#include "decision.h"
+#include "realtime_runner.h"
+#include "sim.h"
+#include "sim_fixture.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+// CountingPolicy's calls are per-run state a rewind must put back.
+static void build(Simulation& sim, int riders) {
+  sim.set_dt(0.01);
+  const TeamId team = sim.get_engine()->add_team("Alpha");
+  sim.add_riders(fixture_field(riders, team, team));
+  place_field(sim, riders);
+  sim.set_rider_policy(riders, std::make_shared<CountingPolicy>());
+}
+
+// What the UI does at step k of the session, if anything.
+static void ui_command(Simulation& sim, int k) {
+  switch (k) {
+  case 300:
+    sim.set_rider_effort(3, 1.1);
+    break;
+  case 900:
+    sim.set_follow_target(5, 8);
+    break;
+  case 1500: // setup changes: a checkpoint before them would not load
+    sim.set_rider_policy(12, std::make_shared<CountingPolicy>());
+    sim.set_effort_schedule(
+        14, std::make_shared<StepEffortSchedule>(std::vector<EffortBlock>{
+                {5.0, 1.1}, {1000.0, 0.75}}));
+    break;
+  case 2100:
+    sim.set_paceline_rotation({{2, false}, {4, false}, {6, true}},
+                              RotationParams{});
+    sim.clear_rider_policy(30);
+    break;
+  case 2600:
+    sim.set_rider_effort(7, 0.5);
+    break;
+  }
+}
+
+static void test_rewind() {
+  Course course = Course::create_endulating();
+  Simulation sim(&course);
+  build(sim, 30);
+  KeyframeParams params;
+  params.interval = 5.0;
+  KeyframeRing ring(params);
+
+  const std::vector<int> keep = {1234, 1777, 2777};
+  std::map<int, std::pair<double, std::vector<char>>> saved;
+  for (int k = 0; k < 3000; ++k) {
+    ui_command(sim, k);
+    sim.step_fixed(sim.get_dt());
+    ring.on_step(sim);
+    for (int want : keep)
+      if (want == k)
+        saved[k] = {sim.get_sim_seconds(), sim.save_checkpoint()};
+  }
+  check(ring.size() == 6 && ring.earliest() == 0.01,
+        "a keyframe every interval");
+
+  check(ring.rewind(sim, saved[2777].first) &&
+            sim.save_checkpoint() == saved[2777].second,
+        "rewinds to the state at that time, byte for byte");
+  check(ring.rewind(sim, saved[1234].first) &&
+            sim.save_checkpoint() == saved[1234].second,
+        "across setup changes");
+  check(!sim.get_decision().get_policy(12) &&
+            sim.get_decision().get_policy(30) &&
+            sim.get_effort_source(14) != EffortSource::Schedule,
+        "policies and schedules as they were then");
+  check(ring.size() == 3, "the abandoned future is dropped");
+
+  // The session carries on, and what it did since rewinds too.
+  for (int k = 1235; k <= 1777; ++k) {
+    ui_command(sim, k);
+    sim.step_fixed(sim.get_dt());
+    ring.on_step(sim);
+  }
+  check(sim.save_checkpoint() == saved[1777].second,
+        "carrying on retraces the session");
+  for (int k = 0; k < 200; ++k) {
+    sim.step_fixed(sim.get_dt());
+    ring.on_step(sim);
+  }
+  check(ring.rewind(sim, saved[1777].first) &&
+            sim.save_checkpoint() == saved[1777].second,
+        "rewinds into the new timeline");
+
+  check(ring.rewind(sim, -5.0) &&
+            std::abs(sim.get_sim_seconds() - ring.earliest()) < 1e-9,
+        "clamps to the earliest keyframe");
+}
+
+static void test_memory_cap() {
+  Course course = Course::create_flat();
+  Simulation sim(&course);
+  build(sim, 50);
+  sim.step_fixed(sim.get_dt());
+  const std::size_t one = sim.save_checkpoint().size();
+
+  KeyframeParams params;
+  params.interval = 1.0;
+  params.max_bytes = 4 * one + one / 2;
+  KeyframeRing ring(params);
+  bool capped = true;
+  for (int k = 0; k < 2000; ++k) {
+    sim.step_fixed(sim.get_dt());
+    ring.on_step(sim);
+    capped = capped && ring.bytes() <= params.max_bytes;
+  }
+  check(capped && ring.size() == 4, "memory stays within the cap");
+  check(ring.earliest() > 16.0 && ring.earliest() < 17.5,
+        "the oldest keyframes go first");
+}
+
+static void test_starts_over() {
+  Course course = Course::create_flat();
+  Simulation sim(&course);
+  build(sim, 10);
+  KeyframeRing ring;
+  check(!ring.rewind(sim, 0.0), "nothing to rewind to");
+  for (int k = 0; k < 2500; ++k) {
+    sim.step_fixed(sim.get_dt());
+    ring.on_step(sim);
+  }
+  check(ring.size() == 3, "keyframes taken");
+
+  sim.reset();
+  sim.step_fixed(sim.get_dt());
+  ring.on_step(sim);
+  check(ring.size() == 1 && ring.earliest() == sim.get_sim_seconds(),
+        "reset() starts the keyframes over");
+  ring.clear(sim);
+  check(ring.size() == 0 && ring.earliest() < 0.0 && !sim.get_journal(),
+        "clear() drops them and stops journaling");
+}
+
+static void test_runner() {
+  Course course = Course::create_endulating();
+  Simulation sim(&course);
+  build(sim, 20);
+  sim.set_time_factor(20.0);
+  RealtimeSimRunner runner(&sim);
+  check(runner.get_rewind_limit() < 0.0, "keyframes are off by default");
+  KeyframeParams params;
+  params.interval = 2.0;
+  runner.enable_keyframes(params);
+  runner.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  runner.pause();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  const double now = sim.get_sim_seconds();
+
+  runner.rewind_to(now - 5.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  const double back = sim.get_sim_seconds();
+  runner.stop();
+  check(runner.get_rewind_limit() > 0.0 && now > 8.0 &&
+            std::abs(back - (now - 5.0)) < 0.006 && runner.is_paused(),
+        "rewind_to() is served while paused");
+}
+
+static void test_cost() {
+  Course course = Course::create_endulating();
+  Simulation sim(&course);
+  build(sim, 200);
+  KeyframeParams params;
+  params.interval = 2.0;
+  KeyframeRing ring(params);
+
+  double worst = 0.0;
+  for (int k = 0; k < 1200; ++k) {
+    sim.step_fixed(sim.get_dt());
+    const auto t0 = std::chrono::steady_clock::now();
+    ring.on_step(sim);
+    worst = std::max(worst, std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - t0)
+                                .count());
+  }
+  const auto t0 = std::chrono::steady_clock::now();
+  const bool back = ring.rewind(sim, 11.99);
+  const double t_rewind = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - t0)
+                              .count();
+
+  std::cout << "  [cost] 200 riders: keyframe " << ring.bytes() / 1024 /
+                                                        ring.size()
+            << " KiB, worst capture " << worst << " ms, rewind 2 s "
+            << t_rewind << " ms\n";
+  check(back && ring.size() == 6, "cost: 200 riders keyframed");
+}
+
+int main() {
+  std::cout << "=== Keyframe tests ===\n";
+  test_rewind();
+  test_memory_cap();
+  test_starts_over();
+  test_runner();
+  test_cost();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All keyframe tests passed\n";
+  return 0;
+}
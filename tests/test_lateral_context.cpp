@@ -0,0 +1,123 @@
+// Tests for the engine's lateral behaviour contexts: build_context() walking
+// the shared order must return exactly what a scan of every lat_states_
+// entry returns.  The tick cost of a 200-rider bunch with a behaviour on
+// every rider is printed, not checked.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define private public
+#include "sim.h"
+#undef private
+
+#include "course.h"
+#include "lateral_behavior.h"
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     230.0 + (id % 7) * 10.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+// The pre-index reference: every other rider, in slot order.
+static std::vector<NearbyRider> scan_all(const PhysicsEngine& eng, int slot) {
+  const LateralRiderState& own = eng.lat_states_[slot];
+  std::vector<NearbyRider> out;
+  for (int i = 0; i < static_cast<int>(eng.lat_states_.size()); ++i) {
+    if (i == slot)
+      continue;
+    const LateralRiderState& s = eng.lat_states_[i];
+    const double lon_offset = s.lon_pos - own.lon_pos;
+    if (std::fabs(lon_offset) <= s.bike_length)
+      out.push_back(NearbyRider{.lon_offset = lon_offset,
+                                .lat_pos = s.lat_pos,
+                                .speed = s.speed,
+                                .w_prime_frac = s.w_prime_frac});
+  }
+  return out;
+}
+
+static bool same(const std::vector<NearbyRider>& a,
+                 const std::vector<NearbyRider>& b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i)
+    if (a[i].lon_offset != b[i].lon_offset || a[i].lat_pos != b[i].lat_pos ||
+        a[i].speed != b[i].speed || a[i].w_prime_frac != b[i].w_prime_frac)
+      return false;
+  return true;
+}
+
+static void test_bunch() {
+  const int n = 200;
+  Course course = Course::create_flat();
+  PhysicsEngine eng(&course);
+  auto block = std::make_shared<BlockBehavior>();
+  auto overtake =
+      std::make_shared<OvertakeBehavior>(OvertakeBehavior::Side::Left);
+  for (int id = 1; id <= n; ++id) {
+    eng.add_rider(cfg(id));
+    eng.set_rider_effort(id, 0.7 + 0.02 * (id % 9));
+    if (id % 2)
+      eng.set_rider_behavior(id, block);
+    else
+      eng.set_rider_behavior(id, overtake);
+  }
+
+  for (int i = 0; i < 300; ++i) // let the bunch string out a little
+    eng.update(0.01);
+
+  bool all_same = true;
+  int nonempty = 0;
+  for (int slot = 0; slot < n; ++slot) {
+    const LateralContext ctx = eng.build_context(slot);
+    all_same = all_same && same(ctx.nearby, scan_all(eng, slot));
+    nonempty += ctx.nearby.empty() ? 0 : 1;
+  }
+  std::cout << "  [bunch] riders with neighbours: " << nonempty << "\n";
+  check(all_same, "build_context == full scan for all 200 riders");
+  check(nonempty > 0, "the bunch has neighbours to find");
+
+  const int ticks = 500;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < ticks; ++i)
+    eng.update(0.01);
+  const double ms =
+      std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - t0)
+          .count() /
+      ticks;
+  std::cout << "  [bunch] " << ms << " ms/tick, 200 riders, all behaviours\n";
+}
+
+int main() {
+  std::cout << "=== Lateral context tests ===\n";
+  test_bunch();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All lateral context tests passed\n";
+  return 0;
+}
@@ -0,0 +1,229 @@
+// Tests for the shared longitudinal order (lon_order.h): repair against a
+// from-scratch sort, repair cost, that the order-taking overloads of
+// compute_draft_factors / GroupTracker::update / LateralSolver::solve agree
+// with their self-sorting originals, and the per-group run split.  Pure — no
+// SDL, no PhysicsEngine.
+
+#include "lon_order.h"
+
+#include "drafting.h"
+#include "group.h"
+#include "lateral_solver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+// Reference: full sort under LonOrder's total order.
+static std::vector<int> reference_order(const std::vector<double>& pos) {
+  std::vector<int> o(pos.size());
+  std::iota(o.begin(), o.end(), 0);
+  std::sort(o.begin(), o.end(), [&](int a, int b) {
+    return pos[a] > pos[b] || (pos[a] == pos[b] && a < b);
+  });
+  return o;
+}
+
+static void test_repair_matches_sort() {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> start(0.0, 200.0);
+  std::uniform_real_distribution<double> speed(9.0, 11.0);
+
+  const int n = 300;
+  std::vector<double> pos(n), v(n);
+  for (int i = 0; i < n; ++i) {
+    pos[i] = start(rng);
+    v[i] = speed(rng);
+  }
+  pos[5] = pos[6] = pos[7]; // exact ties resolve by slot
+
+  LonOrder order;
+  order.repair(n, [&](int i) { return pos[i]; });
+  bool all_match = order.front_to_back() == reference_order(pos);
+
+  long total_moves = 0;
+  for (int step = 0; step < 1000; ++step) {
+    for (int i = 0; i < n; ++i)
+      pos[i] += v[i] * 0.01;
+    order.repair(n, [&](int i) { return pos[i]; });
+    total_moves += order.last_repair_moves();
+    all_match = all_match && order.front_to_back() == reference_order(pos);
+  }
+  check(all_match, "repair == full sort after every tick (300 riders)");
+
+  bool rank_ok = true;
+  for (int k = 0; k < n; ++k)
+    rank_ok = rank_ok && order.rank_of(order.front_to_back()[k]) == k;
+  check(rank_ok, "rank_of inverts front_to_back");
+
+  // 10 s of a 2 m/s speed spread over a 200 m field reorders a handful of
+  // riders per tick at most — nowhere near N^2.
+  std::cout << "  [repair] mean shifts/tick: " << total_moves / 1000.0
+            << "\n";
+  check(total_moves / 1000.0 < n, "repair cost per tick below N shifts");
+
+  order.repair(n, [&](int i) { return pos[i]; });
+  check(order.last_repair_moves() == 0, "no movement: no shifts");
+
+  pos.push_back(1000.0);
+  order.repair(n + 1, [&](int i) { return pos[i]; });
+  check(order.front_to_back().front() == n, "size change rebuilds");
+}
+
+static std::vector<int> order_of(const std::vector<double>& pos) {
+  LonOrder o;
+  o.repair(static_cast<int>(pos.size()),
+           [&](int i) { return pos[i]; });
+  return o.front_to_back();
+}
+
+static void test_consumers_agree() {
+  // A shuffled 3-group field, some Body riders, some lateral overlap.
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+  std::vector<double> pos;
+  for (int i = 0; i < 40; ++i)
+    pos.push_back((i < 15 ? 0.0 : i < 30 ? 40.0 : 90.0) + 1.8 * (i % 15) +
+                  jitter(rng));
+  std::shuffle(pos.begin(), pos.end(), rng);
+  const std::vector<int> order = order_of(pos);
+
+  std::vector<DraftRiderState> draft;
+  std::vector<GroupMember> members;
+  std::vector<LateralRiderState> lat;
+  for (int i = 0; i < static_cast<int>(pos.size()); ++i) {
+    DraftRiderState d;
+    d.id = i;
+    d.group_id = 0;
+    d.role = (i % 4 == 0) ? GroupRole::Body : GroupRole::Unassigned;
+    d.lon_pos = pos[i];
+    d.lat_pos = 0.2 * jitter(rng);
+    d.speed = 11.0;
+    draft.push_back(d);
+
+    members.push_back(GroupMember{i, pos[i], 11.0, GroupRole::Unassigned});
+
+    lat.push_back(LateralRiderState{.id = i,
+                                    .lon_pos = pos[i],
+                                    .speed = 11.0,
+                                    .lat_pos = d.lat_pos,
+                                    .lat_vel = 0.0,
+                                    .lat_target = std::nullopt,
+                                    .w_prime_frac = 1.0,
+                                    .surplus_power = 50.0,
+                                    .mass = 72.0,
+                                    .rider_radius = 0.5,
+                                    .bike_length = 1.7,
+                                    .road_width = 6.0});
+  }
+
+  const DraftingParams dp{};
+  check(compute_draft_factors(draft, order, dp) ==
+            compute_draft_factors(draft, dp),
+        "drafting: shared order == internal sort");
+
+  GroupTracker a(GroupingParams{}), b(GroupingParams{});
+  a.update(members);
+  b.update(members, order);
+  bool same_groups = a.get_snapshot().size() == b.get_snapshot().size();
+  for (int i = 0; i < static_cast<int>(members.size()); ++i)
+    same_groups = same_groups && a.get_group_id(i) == b.get_group_id(i);
+  check(same_groups && a.get_snapshot().size() == 3,
+        "groups: shared order == internal sort (3 groups)");
+
+  LateralSolver solver{CollisionParams{}};
+  const auto ua = solver.solve(lat, 0.01);
+  const auto ub = solver.solve(lat, order, 0.01);
+  bool same_lat = ua.size() == ub.size();
+  for (size_t i = 0; same_lat && i < ua.size(); ++i)
+    same_lat = ua[i].new_lat_pos == ub[i].new_lat_pos &&
+               ua[i].new_lat_vel == ub[i].new_lat_vel &&
+               ua[i].speed_penalty == ub[i].speed_penalty;
+  check(same_lat, "lateral: shared order == internal sort");
+}
+
+// split() at gap_threshold reproduces GroupTracker's groups, and drafting
+// solved run by run (the engine's per-group tasks) equals the whole field.
+static void test_split_runs() {
+  std::vector<double> pos;
+  for (int i = 0; i < 30; ++i)
+    pos.push_back((i < 5 ? 300.0 : i < 12 ? 250.0 : 0.0) + 1.9 * (i % 7));
+  std::mt19937 rng(5);
+  std::shuffle(pos.begin(), pos.end(), rng);
+  const int n = static_cast<int>(pos.size());
+
+  LonOrder order;
+  order.repair(n, [&](int i) { return pos[i]; });
+  std::vector<LonOrder::Run> runs;
+  const GroupingParams gp{};
+  order.split(gp.gap_threshold, runs);
+
+  std::vector<GroupMember> members;
+  for (int i = 0; i < n; ++i)
+    members.push_back(GroupMember{i, pos[i], 11.0, GroupRole::Unassigned});
+  GroupTracker tracker(gp);
+  tracker.update(members, order.front_to_back());
+
+  bool same = runs.size() == tracker.get_snapshot().size();
+  for (size_t r = 0; same && r < runs.size(); ++r)
+    for (int k = runs[r].begin; k < runs[r].end; ++k)
+      same = same && tracker.get_group_id(order.front_to_back()[k]) ==
+                         static_cast<GroupId>(r);
+  check(same && runs.size() == 3, "split(gap_threshold) == GroupTracker groups");
+
+  std::vector<DraftRiderState> draft(n);
+  for (int i = 0; i < n; ++i) {
+    draft[i].id = i;
+    draft[i].lon_pos = pos[i];
+    draft[i].speed = 11.0;
+  }
+  const DraftingParams dp{};
+  const std::vector<double> whole =
+      compute_draft_factors(draft, order.front_to_back(), dp);
+  bool same_draft = true;
+  for (const LonOrder::Run& run : runs) {
+    std::vector<DraftRiderState> sub;
+    for (int k = run.begin; k < run.end; ++k)
+      sub.push_back(draft[order.front_to_back()[k]]);
+    std::vector<int> local(sub.size());
+    std::iota(local.begin(), local.end(), 0);
+    const std::vector<double> part = compute_draft_factors(sub, local, dp);
+    for (int k = run.begin; k < run.end; ++k)
+      same_draft = same_draft &&
+                   part[k - run.begin] == whole[order.front_to_back()[k]];
+  }
+  check(same_draft, "drafting per run == whole field (bit-identical)");
+
+  order.split(1e9, runs);
+  check(runs.size() == 1 && runs[0].begin == 0 && runs[0].end == n,
+        "split beyond the field: one run");
+}
+
+int main() {
+  std::cout << "=== LonOrder tests ===\n";
+  test_repair_matches_sort();
+  test_consumers_agree();
+  test_split_runs();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All lon order tests passed\n";
+  return 0;
+}
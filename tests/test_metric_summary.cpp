@@ -0,0 +1,190 @@
+// Tests for metric summaries (metric_summary.h): short series are kept
+// sample for sample; long ones stay within fixed memory with every level's
+// buckets exact about their samples (count, extremes, means, bounds) and
+// lone spikes carried up as representatives; views serve any zoom within
+// the point budget, finer as the range narrows; and the observer samples
+// a run.  The cost of adding and viewing is printed.
+
+#include "metric_summary.h"
+
+#include "analysis.h"
+#include "course.h"
+#include "sim.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+// A wavy series with one spike.
+static double wave(long i) {
+  return i == 123457 ? 50.0 : std::sin(i * 1e-3) + 0.1 * std::sin(i * 0.37);
+}
+
+static void test_short_series() {
+  MetricSummary s(64);
+  for (int i = 0; i < 50; ++i)
+    s.add(i * 0.1, wave(i));
+  const std::vector<MetricBucket>& l0 = s.level(0);
+  bool exact = l0.size() == 50 && s.bucket_width() == 1;
+  for (int i = 0; exact && i < 50; ++i)
+    exact = l0[i].n == 1 && l0[i].x == i * 0.1 && l0[i].mean == wave(i) &&
+            l0[i].min == wave(i) && l0[i].max == wave(i) &&
+            l0[i].rep_y == wave(i);
+  check(exact, "short series: one bucket per sample");
+  check(s.level(1).size() == 25 && s.level(1)[3].n == 2 &&
+            s.level(1)[3].x0 == l0[6].x0 && s.level(1)[3].x1 == l0[7].x1,
+        "levels pair up the buckets below");
+}
+
+// Every bucket of every level against the raw series it summarises.
+static bool buckets_exact(const MetricSummary& s, long n, double dx) {
+  for (int k = 0; k < s.levels(); ++k) {
+    long i = 0; // first sample of the bucket
+    for (const MetricBucket& b : s.level(k)) {
+      double lo = 1e300, hi = -1e300, sum = 0.0;
+      for (std::uint64_t j = 0; j < b.n; ++j) {
+        const double y = wave(i + j);
+        lo = std::min(lo, y);
+        hi = std::max(hi, y);
+        sum += y;
+      }
+      const bool rep_is_sample =
+          std::abs(b.rep_y - wave(std::lround(b.rep_x / dx))) < 1e-12;
+      if (b.min != lo || b.max != hi ||
+          std::abs(b.mean - sum / b.n) > 1e-9 || b.x0 != i * dx ||
+          b.x1 != (i + long(b.n) - 1) * dx || !rep_is_sample ||
+          b.rep_x < b.x0 || b.rep_x > b.x1)
+        return false;
+      i += b.n;
+    }
+    if (k == 0 && i != n)
+      return false;
+  }
+  return true;
+}
+
+static void test_long_series() {
+  // Ten hours at 100 Hz, in a 4096-bucket summary.
+  const long n = 3600000;
+  const double dx = 0.01;
+  MetricSummary s(4096);
+  for (long i = 0; i < n; ++i)
+    s.add(i * dx, wave(i));
+
+  std::cout << "  [memory] " << n << " samples: " << s.memory_bytes() / 1024
+            << " KiB, " << s.level(0).size() << " buckets of "
+            << s.bucket_width() << ", " << s.levels() << " levels\n";
+  check(s.count() == n && s.level(0).size() <= 4096 &&
+            s.level(0).size() > 2048,
+        "level 0 covers the series in at most capacity buckets");
+  check(s.memory_bytes() < 2 * 1024 * 1024, "memory stays fixed, under 2 MB");
+  check(buckets_exact(s, n, dx), "every bucket exact about its samples");
+
+  const MetricBucket& top = s.level(s.levels() - 1).front();
+  check(top.max == 50.0 && top.rep_y == 50.0 &&
+            std::abs(top.rep_x - 123457 * dx) < 1e-9,
+        "a lone spike survives as the representative");
+}
+
+static void test_views() {
+  const long n = 1000000;
+  MetricSummary s(4096);
+  for (long i = 0; i < n; ++i)
+    s.add(i * 0.1, wave(i));
+
+  const MetricSummary::View all = s.view(s.min_x(), s.max_x(), 800);
+  check(all.count > 200 && all.count <= 802 && all.level > 0 &&
+            all.data[0].x0 == s.min_x(),
+        "the whole run within the point budget");
+  bool spike = false;
+  for (int i = 0; i < all.count; ++i)
+    spike = spike || all.data[i].rep_y == 50.0;
+  check(spike, "the spike is in the whole-run view");
+
+  const double x0 = 42000.0, x1 = 42500.0;
+  const MetricSummary::View zoom = s.view(x0, x1, 800);
+  check(zoom.level == 0 && zoom.count <= 802 &&
+            zoom.data[0].x1 < x0 && zoom.data[zoom.count - 1].x0 > x1,
+        "a zoomed range at the finest level, one bucket past each end");
+  bool sorted = true;
+  for (int i = 1; i < zoom.count; ++i)
+    sorted = sorted && zoom.data[i - 1].x1 < zoom.data[i].x0;
+  check(sorted, "in order, no overlap");
+
+  check(s.view(-1e9, -1e8, 800).count == 1 &&
+            MetricSummary(16).view(0.0, 1.0, 800).count == 0,
+        "out of range, and empty");
+}
+
+static void test_observer() {
+  Course course = Course::create_flat_short();
+  auto sim = std::make_unique<Simulation>(&course);
+  sim->set_dt(0.1);
+  sim->add_riders({RiderConfig{1, "R1", 300, 6, 2, 0.05, 700, 3.5, 70, 0.3,
+                               24000, Bike::create_road(), kNoTeam}});
+  sim->set_rider_effort(1, 0.9);
+  MetricSummaryObserver speed([](const Simulation& s) {
+    return s.get_engine()->get_rider_by_id(1)->get_speed();
+  });
+  OfflineSimulationRunner runner(std::move(sim));
+  runner.add_observer(&speed);
+  runner.set_end_condition(std::make_unique<FinishLineCondition>());
+  runner.run();
+  const MetricSummary& s = speed.summary();
+  check(s.count() > 100 && std::abs(s.min_x() - 0.1) < 1e-9 &&
+            s.level(s.levels() - 1).front().max > 8.0,
+        "the observer summarises a run");
+}
+
+static void test_cost() {
+  const long n = 10000000;
+  MetricSummary s(4096);
+  const auto t0 = std::chrono::steady_clock::now();
+  for (long i = 0; i < n; ++i)
+    s.add(i * 0.01, double(i % 1000));
+  const double ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - t0)
+                        .count() /
+                    n;
+  const auto t1 = std::chrono::steady_clock::now();
+  int points = 0;
+  for (int i = 0; i < 1000; ++i)
+    points += s.view(i * 90.0, i * 90.0 + 5000.0, 800).count;
+  const double us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - t1)
+                        .count() /
+                    1000;
+
+  std::cout << "  [cost] add " << ns << " ns/sample, view " << us
+            << " us\n";
+  check(points > 0, "cost: views served");
+}
+
+int main() {
+  std::cout << "=== Metric summary tests ===\n";
+  test_short_series();
+  test_long_series();
+  test_views();
+  test_observer();
+  test_cost();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All metric summary tests passed\n";
+  return 0;
+}
@@ -0,0 +1,210 @@
+// Tests for the multi-rate phase schedule (phase_schedule.h): period and
+// offset arithmetic, that rate 0 (the default) is the single-rate engine,
+// that draft factors ramp between refreshes instead of stepping, that a
+// reset run replays a fresh one, and (printed only) the tick cost on a large
+// field.
+
+#include "phase_schedule.h"
+
+#include "course.h"
+#include "sim.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static void test_period_and_due() {
+  check(phase_period(10.0, 0.01) == 10, "10 Hz at 100 Hz: every 10 ticks");
+  check(phase_period(20.0, 0.01) == 5, "20 Hz at 100 Hz: every 5 ticks");
+  check(phase_period(0.0, 0.01) == 1, "0 Hz: every tick");
+  check(phase_period(500.0, 0.01) == 1, "above the physics rate: every tick");
+
+  std::vector<int> due;
+  for (int t = 0; t < 12; ++t)
+    if (phase_due(t, 5, 1))
+      due.push_back(t);
+  check(due == std::vector<int>{1, 6, 11}, "period 5, offset 1: ticks 1, 6, 11");
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     240.0 + (id % 5) * 10.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+static void add_field(PhysicsEngine& eng, int n) {
+  for (int id = 1; id <= n; ++id) {
+    eng.add_rider(cfg(id));
+    eng.set_rider_effort(id, 0.7 + 0.03 * (id % 7));
+  }
+}
+
+// Slower group and draft rates, opted into.
+static const PhaseRates kMultiRate{.group_hz = 10.0, .draft_hz = 20.0};
+
+// Rate 0 everywhere — the default — reproduces an engine stepped at the
+// physics rate, and slower rates stay close to it on a settled formation:
+// draft links and groups move on second timescales.
+static void test_rates_vs_single_rate() {
+  Course course = Course::create_flat();
+  PhysicsEngine single(&course), multi(&course), zero(&course);
+  single.set_phase_rates(PhaseRates{.group_hz = 0.0, .draft_hz = 0.0});
+  multi.set_phase_rates(kMultiRate);
+  check(zero.get_phase_rates().group_hz == 0.0 &&
+            zero.get_phase_rates().draft_hz == 0.0,
+        "the default is single-rate");
+  for (PhysicsEngine* e : {&single, &multi, &zero}) {
+    add_field(*e, 2);
+    e->set_rider_effort(1, 0.85);
+    e->set_follow_target(2, 1); // a settled wheel-sucker: steady shelter
+  }
+
+  double max_dpos = 0.0;
+  bool zero_same = true;
+  for (int i = 0; i < 6000; ++i) {
+    single.update(0.01);
+    multi.update(0.01);
+    zero.update(0.01);
+  }
+  for (int id = 1; id <= 2; ++id) {
+    const double p = single.get_rider_by_id(id)->get_pos();
+    max_dpos = std::max(max_dpos,
+                        std::fabs(multi.get_rider_by_id(id)->get_pos() - p));
+    zero_same = zero_same && zero.get_rider_by_id(id)->get_pos() == p;
+  }
+  std::cout << "  [rates] 60 s follow pair: max |dpos| 10/20 Hz vs single "
+            << max_dpos << " m\n";
+  check(zero_same, "default rates: identical to an explicit single-rate one");
+  check(max_dpos < 0.5, "10/20 Hz: within 0.5 m of single-rate");
+}
+
+// Between refreshes the factor ramps linearly toward the new link factor:
+// equal per-tick increments inside each draft period, no step.
+static void test_draft_ramp() {
+  Course course = Course::create_flat();
+  PhysicsEngine eng(&course);
+  const PhaseRates rates{.group_hz = 10.0, .draft_hz = 10.0};
+  eng.set_phase_rates(rates);
+  add_field(eng, 2);
+  eng.set_rider_effort(1, 0.9);
+  eng.set_rider_effort(2, 0.6); // 2 falls off 1's wheel: its factor rises
+
+  std::vector<double> f;
+  for (int tick = 0; tick < 3000; ++tick) {
+    eng.update(0.01);
+    f.push_back(eng.get_rider_by_id(2)->get_draft_factor());
+  }
+
+  // Refreshes land on ticks with tick % 10 == draft_offset; every other tick
+  // continues the same ramp.
+  bool linear = true, moved = false;
+  for (int tick = 2; tick < static_cast<int>(f.size()); ++tick) {
+    const double d = f[tick] - f[tick - 1];
+    moved = moved || d != 0.0;
+    if (tick % 10 != rates.draft_offset)
+      linear = linear && std::fabs(d - (f[tick - 1] - f[tick - 2])) < 1e-12;
+  }
+  check(moved, "ramp: the factor does change");
+  check(linear, "ramp: equal increments within each draft period");
+  check(std::fabs(f.back() - 1.0) < 1e-12,
+        "ramp: dropped rider ends exactly unsheltered");
+}
+
+// reset() puts the scheduler back where a new Simulation starts — tick
+// count, draft ramp, forced first refresh — so the same setup replays the
+// same run, whatever the rates.
+static void test_reset_matches_fresh() {
+  Course course = Course::create_flat();
+  for (const PhaseRates& rates : {PhaseRates{}, kMultiRate}) {
+    auto setup = [&](Simulation& sim) {
+      for (int id = 1; id <= 20; ++id)
+        sim.set_rider_effort(id, 0.7 + 0.03 * (id % 7));
+      sim.set_follow_target(4, 2);
+    };
+    Simulation fresh(&course), reused(&course);
+    for (Simulation* sim : {&fresh, &reused}) {
+      sim->set_dt(0.01);
+      sim->get_engine()->set_phase_rates(rates);
+      std::vector<RiderConfig> field;
+      for (int id = 1; id <= 20; ++id)
+        field.push_back(cfg(id));
+      sim->add_riders(field);
+    }
+    setup(reused);
+    for (int i = 0; i < 777; ++i)
+      reused.step_fixed(0.01);
+    reused.reset();
+
+    setup(fresh);
+    setup(reused);
+    bool same = true;
+    for (int i = 0; i < 500 && same; ++i) {
+      fresh.step_fixed(0.01);
+      reused.step_fixed(0.01);
+      for (int id = 1; id <= 20; ++id)
+        same = same && fresh.get_engine()->get_rider_by_id(id)->get_pos() ==
+                           reused.get_engine()->get_rider_by_id(id)->get_pos();
+    }
+    check(same, rates.group_hz == 0.0
+                    ? "reset: replays a fresh run exactly (single-rate)"
+                    : "reset: replays a fresh run exactly (10/20 Hz)");
+  }
+}
+
+static double ms_per_tick(PhysicsEngine& eng, int ticks) {
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < ticks; ++i)
+    eng.update(0.01);
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - t0)
+             .count() /
+         ticks;
+}
+
+static void test_tick_cost() {
+  Course course = Course::create_flat();
+  PhysicsEngine single(&course), multi(&course);
+  multi.set_phase_rates(kMultiRate);
+  add_field(single, 400);
+  add_field(multi, 400);
+  single.update(0.01);
+  multi.update(0.01);
+
+  const double t_single = ms_per_tick(single, 500);
+  const double t_multi = ms_per_tick(multi, 500);
+  std::cout << "  [cost] 400 riders: single-rate " << t_single
+            << " ms/tick, 10/20 Hz " << t_multi << " ms/tick\n";
+}
+
+int main() {
+  std::cout << "=== Phase schedule tests ===\n";
+  test_period_and_due();
+  test_rates_vs_single_rate();
+  test_draft_ramp();
+  test_reset_matches_fresh();
+  test_tick_cost();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All phase schedule tests passed\n";
+  return 0;
+}
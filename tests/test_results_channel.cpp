@@ -0,0 +1,230 @@
+// Tests for streaming offline results (results_channel.h): the channel
+// hands over the latest partial only, with progress that never goes back;
+// a time trial run with one publishes its leaderboard early in the race,
+// progress climbing towards 1, and still returns exactly the result it
+// returns without one; cancelling stops it short of the finish; and
+// ProgressObserver's expected time is close to the real one early on.
+// How soon the first partial comes and the run stops are printed.
+
+#include "results_channel.h"
+
+#include "analysis.h"
+#include "course.h"
+#include "sim.h"
+#include "timetrial.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     250.0 + id * 8.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     20000, Bike::create_road(),
+                     kNoTeam};
+}
+
+static std::vector<RiderConfig> field(int n) {
+  std::vector<RiderConfig> riders;
+  for (int id = 1; id <= n; ++id)
+    riders.push_back(cfg(id));
+  return riders;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+      .count();
+}
+
+static bool same(const TimeTrialResult& a, const TimeTrialResult& b) {
+  if (a.riders.size() != b.riders.size() || a.sim_time != b.sim_time)
+    return false;
+  for (std::size_t i = 0; i < a.riders.size(); ++i) {
+    const RiderTimeTrialResult &x = a.riders[i], &y = b.riders[i];
+    if (x.rider_id != y.rider_id || x.timeline.size() != y.timeline.size() ||
+        x.distance != y.distance)
+      return false;
+    for (std::size_t k = 0; k < x.timeline.size(); ++k)
+      if (x.timeline[k].race_time != y.timeline[k].race_time)
+        return false;
+  }
+  return true;
+}
+
+static void test_channel() {
+  ResultsChannel<std::vector<int>> ch;
+  std::vector<int> out;
+  check(!ch.take(out) && ch.progress() == 0.0, "nothing published yet");
+
+  ch.publish({1}, 0.2);
+  ch.publish({1, 2}, 0.4);
+  check(ch.take(out) && out == std::vector<int>{1, 2} && !ch.take(out) &&
+            ch.published() == 2,
+        "take() gets the latest partial, once");
+
+  ch.publish({3}, 0.3);
+  const double back = ch.progress();
+  ch.publish({4}, 1.7);
+  check(back == 0.4 && ch.progress() == 1.0,
+        "progress never goes back, and stops at 1");
+
+  check(!ch.cancelled(), "not cancelled");
+  ch.cancel();
+  check(ch.cancelled() && ch.cancel_flag()->load(), "cancel() sets the flag");
+}
+
+// A short race, publishing every few milliseconds so it still streams a
+// handful of partials.
+static constexpr double kInterval = 0.002;
+
+static void test_streaming() {
+  const Course course = Course::create_flat_short();
+  const std::vector<RiderConfig> riders = field(12);
+
+  auto t0 = std::chrono::steady_clock::now();
+  const TimeTrialResult plain = run_time_trial(course, riders, 20.0);
+  const double t_plain = seconds_since(t0);
+
+  ResultsChannel<TimeTrialResult> channel(kInterval);
+  t0 = std::chrono::steady_clock::now();
+  std::future<TimeTrialResult> future =
+      std::async(std::launch::async, run_time_trial, std::cref(course),
+                 std::cref(riders), 20.0, &channel);
+
+  double first = -1.0;
+  std::vector<double> progress, sim_times;
+  bool ranked = true;
+  TimeTrialResult partial;
+  while (future.wait_for(std::chrono::milliseconds(1)) !=
+         std::future_status::ready) {
+    if (!channel.take(partial))
+      continue;
+    if (first < 0.0)
+      first = seconds_since(t0);
+    progress.push_back(channel.progress());
+    sim_times.push_back(partial.sim_time);
+    // Same checkpoint count: faster there first.
+    for (std::size_t i = 1; i < partial.riders.size(); ++i) {
+      const auto &a = partial.riders[i - 1], &b = partial.riders[i];
+      ranked = ranked && a.timeline.size() >= b.timeline.size();
+      if (a.timeline.size() == b.timeline.size() && !a.timeline.empty())
+        ranked = ranked &&
+                 a.timeline.back().race_time <= b.timeline.back().race_time;
+    }
+  }
+  const TimeTrialResult streamed = future.get();
+
+  bool climbing = progress.size() >= 3;
+  for (std::size_t i = 1; i < progress.size(); ++i)
+    climbing = climbing && progress[i] >= progress[i - 1] &&
+               sim_times[i] > sim_times[i - 1];
+
+  std::cout << "  [stream] run " << t_plain << " s, first partial after "
+            << first << " s, " << channel.published() << " partials, last at "
+            << (progress.empty() ? 0.0 : progress.back()) << "\n";
+  check(first > 0.0, "a leaderboard while the race runs");
+  check(climbing && progress.front() < 0.5 && progress.back() > 0.8,
+        "progress climbs towards 1 with sim time");
+  check(ranked, "partial leaderboards are ranked");
+  check(same(streamed, plain), "the final result is the same as without");
+  check(!streamed.riders.empty() &&
+            streamed.riders.front().timeline.size() == 4 &&
+            streamed.riders.back().timeline.size() == 4,
+        "everyone finished");
+}
+
+static void test_cancel() {
+  const Course course = Course::create_flat_short();
+  const std::vector<RiderConfig> riders = field(12);
+
+  ResultsChannel<TimeTrialResult> channel(kInterval);
+  std::future<TimeTrialResult> future =
+      std::async(std::launch::async, run_time_trial, std::cref(course),
+                 std::cref(riders), 20.0, &channel);
+  TimeTrialResult partial;
+  while (!channel.take(partial) &&
+         future.wait_for(std::chrono::milliseconds(1)) !=
+             std::future_status::ready)
+    ;
+
+  const auto t0 = std::chrono::steady_clock::now();
+  channel.cancel();
+  const TimeTrialResult stopped = future.get();
+  const double t_stop = seconds_since(t0);
+
+  std::cout << "  [cancel] stopped after " << t_stop * 1000.0 << " ms at "
+            << stopped.sim_time << " s sim time\n";
+  check(stopped.sim_time >= partial.sim_time && partial.sim_time > 0.0 &&
+            stopped.riders.size() == riders.size() &&
+            stopped.riders.back().timeline.size() < 4,
+        "the result is the leaderboard where it stopped");
+}
+
+// Replays the time trial step by step: the expected time a fifth of the
+// way in against when the last rider actually finished.  On the long flat
+// course: over 1 km the standing starts still dominate a fifth of the way.
+static void test_expected_time() {
+  const Course course = Course::create_flat();
+  const std::vector<RiderConfig> riders = field(12);
+  const auto offsets = build_start_offsets(riders, 30.0);
+
+  Simulation sim(&course);
+  sim.set_dt(0.1);
+  sim.add_riders(riders);
+  setup_tt_schedules(&sim, riders, offsets);
+  ProgressObserver obs([](const Simulation&, double) {}, offsets);
+  obs.on_start(sim);
+
+  std::vector<std::pair<double, double>> estimates; // (t, expected)
+  FinishLineCondition finished;
+  int k = 0;
+  do {
+    sim.step_fixed(sim.get_dt());
+    if (++k % 500 == 0)
+      estimates.push_back({sim.get_sim_seconds(), obs.expected_time(sim)});
+  } while (!finished.should_stop(sim));
+  const double t_end = sim.get_sim_seconds();
+
+  double worst = 0.0;
+  for (const auto& [t, expected] : estimates)
+    if (t > 0.2 * t_end)
+      worst = std::max(worst, std::abs(expected - t_end) / t_end);
+  std::cout << "  [estimate] finish " << t_end << " s, worst error past 20%: "
+            << worst * 100.0 << "%\n";
+  check(!estimates.empty() && estimates.front().second > 0.5 * t_end,
+        "the first estimate is in the right range");
+  check(worst < 0.05, "expected time within 5% past a fifth of the race");
+}
+
+int main() {
+  std::cout << "=== Results channel tests ===\n";
+  test_channel();
+  test_streaming();
+  test_cancel();
+  test_expected_time();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All results channel tests passed\n";
+  return 0;
+}
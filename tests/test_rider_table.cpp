@@ -0,0 +1,156 @@
+// Tests for the dense rider table (rider_table.h) — table semantics first,
+// then engine-level checks that the slot-parallel phase write-back (draft
+// factors, lateral updates) lands on the right rider when ids are sparse and
+// added out of order.
+
+#include "rider_table.h"
+
+#include "course.h"
+#include "rider.h"
+#include "sim.h"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,    "R" + std::to_string(id),
+                     250,   6,
+                     2,     0.05,
+                     700,   3.5,
+                     65,    0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+// --- Table ---
+
+static void test_table_basics() {
+  RiderTable t;
+  check(t.empty() && t.size() == 0, "table: starts empty");
+
+  check(t.add(Rider(cfg(42))), "table: add 42");
+  check(t.add(Rider(cfg(7))), "table: add 7");
+  check(t.add(Rider(cfg(19))), "table: add 19");
+  check(!t.add(Rider(cfg(7))), "table: duplicate id rejected");
+  check(t.size() == 3, "table: size 3 after rejected duplicate");
+
+  check(t.slot_of(42) == 0 && t.slot_of(7) == 1 && t.slot_of(19) == 2,
+        "table: slots follow insertion order");
+  check(t.slot_of(5) == -1, "table: unknown id has no slot");
+  check(t.id_at(1) == 7 && t[1].get_id() == 7, "table: slot 1 is rider 7");
+  check(t.find(19) == &t[2], "table: find returns the slot's rider");
+  check(t.find(5) == nullptr, "table: find unknown -> nullptr");
+  check(t.count(42) == 1 && t.count(5) == 0, "table: count");
+
+  bool threw = false;
+  try {
+    t.at(5);
+  } catch (const std::out_of_range&) {
+    threw = true;
+  }
+  check(threw, "table: at(unknown) throws out_of_range");
+
+  std::vector<RiderId> seen;
+  for (const auto& [id, r] : t) {
+    if (r->get_id() != id)
+      seen.push_back(-1);
+    seen.push_back(id);
+  }
+  check(seen == std::vector<RiderId>{42, 7, 19},
+        "table: iteration yields (id, rider) in slot order");
+}
+
+// A const table still hands out mutable riders — the old map of unique_ptrs
+// did, and Simulation::reset / the decision layer rely on it.
+static void test_const_table_mutable_riders() {
+  RiderTable t;
+  t.add(Rider(cfg(1)));
+  const RiderTable& ct = t;
+  ct.at(1)->set_start_pos(12.5);
+  check(t[0].get_pos() == 12.5, "const table: rider mutable through at()");
+}
+
+// --- Engine ---
+
+// Sparse ids added back-to-front: the follower (id 3) is slot 0, its leader
+// (id 100) slot 1.  The draft factor must land on the follower, not on
+// whoever sits in the leader's slot.
+static void test_engine_draft_writeback() {
+  const double dt = 0.01;
+  Course course = Course::create_flat();
+  PhysicsEngine eng(&course);
+  eng.add_rider(cfg(3));
+  eng.add_rider(cfg(100));
+  eng.get_riders().at(100)->set_start_pos(2.0);
+  eng.set_rider_effort(3, 0.8);
+  eng.set_rider_effort(100, 0.8);
+
+  for (int i = 0; i < 200; ++i)
+    eng.update(dt);
+
+  check(eng.get_rider_by_id(3)->get_cda_factor() < 0.9,
+        "engine: follower (slot 0) sheltered");
+  check(eng.get_rider_by_id(100)->get_cda_factor() > 0.9,
+        "engine: leader (slot 1) unsheltered");
+}
+
+// Lateral write-back by slot: a behavior steering one rider must move that
+// rider only.
+class SteerTo : public ILateralBehavior {
+public:
+  explicit SteerTo(double lat) : lat_(lat) {}
+  std::optional<double>
+  compute_lat_target(const LateralContext&) const override {
+    return lat_;
+  }
+
+private:
+  double lat_;
+};
+
+static void test_engine_lateral_writeback() {
+  const double dt = 0.01;
+  Course course = Course::create_flat();
+  PhysicsEngine eng(&course);
+  eng.add_rider(cfg(9));
+  eng.add_rider(cfg(2));
+  eng.get_riders().at(9)->set_start_pos(50.0); // far apart: no contact
+  eng.set_rider_behavior(2, std::make_shared<SteerTo>(1.5));
+
+  for (int i = 0; i < 500; ++i)
+    eng.update(dt);
+
+  check(std::fabs(eng.get_rider_by_id(2)->get_lat_pos() - 1.5) < 0.2,
+        "engine: steered rider (slot 1) reached its line");
+  check(std::fabs(eng.get_rider_by_id(9)->get_lat_pos()) < 1e-9,
+        "engine: other rider (slot 0) untouched");
+}
+
+int main() {
+  std::cout << "=== RiderTable tests ===\n";
+  test_table_basics();
+  test_const_table_mutable_riders();
+  test_engine_draft_writeback();
+  test_engine_lateral_writeback();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All rider table tests passed\n";
+  return 0;
+}
@@ -0,0 +1,200 @@
+// Tests for scenario files (scenario.h): every directive and rider key
+// parses into the spec, bad lines are refused, the built-in scenarios load,
+// a built Simulation carries the teams, starts and efforts, and a scenario
+// runs through BatchRunner with checkpoint splits and time-trial starts
+// taken off the clock.
+
+#include "scenario.h"
+
+#include "batch_runner.h"
+#include "sim.h"
+
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static bool parse(const std::string& text, ScenarioSpec& out) {
+  std::istringstream in(text);
+  return parse_scenario(in, "test", out);
+}
+
+static void test_parse() {
+  ScenarioSpec s;
+  check(parse("segment 3000 0 0 0 8\n"
+              "segment 2000 0.06 0.005 0.5 6   # the climb\n"
+              "altitude 400\n"
+              "wind 1.5 4\n"
+              "checkpoint 3000 Foot of the climb\n"
+              "team Alpha\n"
+              "team Beta\n"
+              "rider 4 Ann ftp=280 mass=60 cda=0.3 w_prime=18000 bike=tt "
+              "team=Beta effort=0.9 start=12\n"
+              "rider 2 Bo\n"
+              "time_limit 600\n",
+              s),
+        "a full scenario parses");
+  check(s.segments.size() == 2 && s.segments[1][1] == 0.06 &&
+            s.altitude == 400.0 && s.wind.heading == 1.5 &&
+            s.wind.speed == 4.0 && s.time_limit == 600.0,
+        "course, wind and limits");
+  check(s.checkpoints.size() == 1 &&
+            s.checkpoints[0].label == "Foot of the climb",
+        "checkpoint labels run to the end of the line");
+  check(s.teams.size() == 2 && s.riders.size() == 2, "teams and riders");
+  const RiderConfig& ann = s.riders[0];
+  check(ann.rider_id == 4 && ann.name == "Ann" && ann.ftp_base == 280.0 &&
+            ann.mass == 60.0 && ann.cda == 0.3 && ann.w_prime_base == 18000 &&
+            ann.bike.type == BikeType::TT && ann.team_id == 1 &&
+            s.efforts.at(4) == 0.9 && s.starts.at(4) == 12.0,
+        "rider keys");
+  const RiderConfig& bo = s.riders[1];
+  check(bo.ftp_base == 300.0 && bo.bike.type == BikeType::Road &&
+            bo.team_id == kNoTeam && s.efforts.at(2) == 1.0 &&
+            !s.starts.count(2),
+        "rider defaults");
+
+  Course c = s.make_course();
+  check(c.get_total_length() == 5000.0 && c.get_wind(0.0).speed == 4.0 &&
+            c.get_checkpoints().size() == 2 &&
+            c.get_altitude(0.0) == 400.0,
+        "make_course: segments, wind, checkpoint plus the finish");
+
+  ScenarioSpec past, at, before;
+  check(!parse("course flat_short\ncheckpoint 1500 Past\nrider 1 A\n",
+               past) &&
+            !parse("course flat_short\ncheckpoint 1000 At\nrider 1 A\n",
+                   at) &&
+            parse("course flat_short\ncheckpoint 999 Before\nrider 1 A\n",
+                  before),
+        "checkpoints at or past the finish are refused");
+  ScenarioSpec coded = before;
+  coded.checkpoints.push_back({2000.0, "Coded"});
+  const Course cc = coded.make_course();
+  check(cc.get_checkpoints().size() == 2 &&
+            cc.get_checkpoints().back().label == "Finish",
+        "make_course leaves out a checkpoint past the finish");
+
+  const char* bad[] = {
+      "rider 1 A\nrider 1 B\n",        "rider 1 A team=Nobody\n",
+      "rider 1 A ftp=fast\n",          "rider 1 A colour=red\n",
+      "course moon\nrider 1 A\n",      "segment 100 0\nrider 1 A\n",
+      "checkpoint 500\nrider 1 A\n",   "sprint 3\nrider 1 A\n",
+      "# nobody rides\ncourse flat\n",  "rider 1 A bike=penny\n",
+      "team Two Words\n",
+  };
+  bool refused = true;
+  for (const char* text : bad) {
+    ScenarioSpec b;
+    refused = refused && !parse(text, b);
+  }
+  check(refused, "bad lines and empty rosters are refused");
+
+  ScenarioSpec missing;
+  check(!load_scenario_file("no_such_scenario.scn", missing),
+        "missing file refused");
+}
+
+static void test_builtin_and_build() {
+  ScenarioSpec demo, tt, none;
+  check(builtin_scenario("demo", demo) && builtin_scenario("tt", tt) &&
+            !builtin_scenario("giro", none),
+        "built-in scenarios by name");
+  check(demo.riders.size() == 8 && demo.teams.size() == 1 &&
+            demo.starts.at(0) == 48.0 && !demo.starts.count(7) &&
+            demo.wind.speed == 3.5,
+        "demo: the app's race");
+
+  Course course = demo.make_course();
+  std::unique_ptr<Simulation> sim = demo.build(course, demo.riders);
+  const PhysicsEngine& eng = *sim->get_engine();
+  check(eng.get_riders().size() == 8 && eng.get_teams().team_count() == 1 &&
+            eng.get_teams().team_of(3) == 0,
+        "build: riders and teams");
+  check(eng.get_rider_by_id(0)->get_pos() == 48.0 &&
+            eng.get_rider_by_id(7)->get_pos() == 0.0,
+        "build: start positions");
+}
+
+static void test_batch() {
+  ScenarioSpec s;
+  check(parse("segment 2000 0 0 0 8\n"
+              "checkpoint 1000 Half\n"
+              "tt_gap 30\n"
+              "rider 1 A ftp=300\n"
+              "rider 2 B ftp=300\n"
+              "rider 3 C ftp=360\n",
+              s),
+        "time-trial scenario parses");
+  Course course = s.make_course();
+  BatchParams params;
+  params.threads = 1;
+  params.start_offsets = {{1, 0.0}, {2, 30.0}, {3, 60.0}};
+  BatchRunner runner(
+      course, s.riders,
+      [&s](const Course& c, const std::vector<RiderConfig>& riders) {
+        return s.build(c, riders);
+      },
+      params);
+  const RunSummary r = runner.run_one(0, RunPerturbation{});
+
+  bool splits = r.riders.size() == 3;
+  for (const RiderRunResult& rr : r.riders)
+    splits = splits && rr.splits.size() == 2 && rr.splits[0] > 0.0 &&
+             rr.splits[0] < rr.splits[1] && rr.splits[1] == rr.finish_time;
+  check(splits, "splits: every checkpoint, the finish last");
+
+  // A and B ride identically 30 s apart: equal ride times.
+  double t_a = -1.0, t_b = -1.0;
+  for (const RiderRunResult& rr : r.riders) {
+    if (rr.id == 1)
+      t_a = rr.finish_time;
+    if (rr.id == 2)
+      t_b = rr.finish_time;
+  }
+  check(r.riders.front().id == 3 && t_a > 0.0 &&
+            std::abs(t_a - t_b) < 0.5,
+        "time trial: start offsets come off the clock; the strongest wins");
+
+  // A checkpoint added past the finish in code: the finish is found by
+  // position, not taken from the last split.
+  Course beyond = course;
+  beyond.add_checkpoint(3000.0, "Beyond");
+  BatchRunner past(
+      beyond, s.riders,
+      [&s](const Course& c, const std::vector<RiderConfig>& riders) {
+        return s.build(c, riders);
+      },
+      params);
+  const RunSummary rb = past.run_one(0, RunPerturbation{});
+  bool finished = rb.riders.size() == 3;
+  for (const RiderRunResult& rr : rb.riders)
+    finished = finished && rr.splits.size() == 3 && rr.splits[2] < 0.0 &&
+               rr.finish_time == rr.splits[1] && rr.finish_time > 0.0;
+  check(finished, "finish time: the finish split, wherever it sits");
+}
+
+int main() {
+  std::cout << "=== Scenario tests ===\n";
+  test_parse();
+  test_builtin_and_build();
+  test_batch();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All scenario tests passed\n";
+  return 0;
+}
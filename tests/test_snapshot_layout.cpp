@@ -0,0 +1,208 @@
+// Tests for the flat FrameSnapshot (snapshot.h, string_table.h): rider
+// records come front to back, find() resolves every id, names and policy
+// names and group labels go through the shared string table — which is
+// only replaced when a new string appears — groups carry their members as
+// ranges of one array, and a steady-state step_and_snapshot allocates
+// nothing.
+
+#include "snapshot.h"
+
+#include "course.h"
+#include "decision.h"
+#include "sim.h"
+#include "string_table.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<bool> counting{false};
+static std::atomic<long> allocations{0};
+
+void* operator new(std::size_t n) {
+  if (counting.load(std::memory_order_relaxed))
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return ::operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static RiderConfig cfg(int id, double ftp = 250.0) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     ftp, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+// Holds its effort; named so the stamp can be checked.
+class NamedPolicy : public IRiderPolicy {
+public:
+  explicit NamedPolicy(const char* name) : name_(name) {}
+  const char* name() const override { return name_; }
+  PolicyOutput decide(const DecisionContext&) override {
+    return PolicyOutput{};
+  }
+
+private:
+  const char* name_;
+};
+
+static void test_interner() {
+  StringInterner in;
+  const auto t0 = in.table();
+  check(in.intern("") == kNoString, "empty string is kNoString");
+  const StringId a = in.intern("alpha");
+  const auto t1 = in.table();
+  check(t1 != t0 && t1->at(a) == "alpha", "new string: new table");
+  check(in.intern(std::string("alpha")) == a && in.table() == t1,
+        "known string: same id, same table");
+  check(t0->strings.size() == 1, "old tables are never modified");
+  check(t1->at(999).empty() && t1->at(kNoString).empty(),
+        "unknown ids read empty");
+}
+
+static void test_layout() {
+  Course course = Course::create_flat();
+  Simulation sim(&course);
+  std::vector<RiderConfig> field;
+  // Ids out of order and with gaps; FTPs spread so the field strings out.
+  for (int k = 0; k < 300; ++k) {
+    const int id = (k * 37) % 300 * 2 + 1;
+    field.push_back(cfg(id, 200.0 + (k % 13) * 10.0));
+  }
+  sim.add_riders(field);
+  for (const RiderConfig& c : field)
+    sim.set_rider_effort(c.rider_id, 0.8);
+  for (int i = 0; i < 3000; ++i)
+    sim.step_fixed(0.01);
+
+  FrameSnapshot prev, curr;
+  sim.consume_latest_frame_pair(prev, curr);
+  check(curr.riders.size() == field.size(), "one record per rider");
+
+  bool sorted = true;
+  for (size_t k = 1; k < curr.riders.size(); ++k)
+    sorted = sorted && curr.riders[k - 1].pos >= curr.riders[k].pos;
+  check(sorted, "records run front to back");
+
+  bool found = true, named = true;
+  for (const RiderConfig& c : field) {
+    const RiderSnapshot* r = curr.find(c.rider_id);
+    found = found && r && r->id == c.rider_id;
+    named = named && r && curr.str(r->name) == c.name;
+  }
+  check(found, "find() resolves every id");
+  check(named, "names resolve through the string table");
+  check(!curr.find(0) && !curr.find(2) && !curr.find(100000),
+        "find() misses unknown ids");
+  const RiderSnapshot* r = curr.find(1);
+  check(r->pos2d() == Vector2d(r->pos, course.get_altitude(r->pos)),
+        "pos2d rebuilt from pos / altitude");
+
+  // Groups: labels through the same table, members as ranges of one array.
+  bool labelled = !curr.groups.empty(), ranges = true;
+  int in_groups = 0;
+  for (size_t g = 0; g < curr.groups.size(); ++g) {
+    const FrameGroup& grp = curr.groups[g];
+    labelled = labelled && grp.ordinal == int(g) &&
+               curr.str(grp.label) == "Group " + std::to_string(g + 1);
+    ranges = ranges && grp.first == in_groups && grp.paceline <= grp.count;
+    const GroupMember* m = curr.members(grp);
+    for (int k = 0; k < grp.count; ++k) {
+      const RiderSnapshot* rs = curr.find(m[k].id);
+      ranges = ranges && rs && rs->group_id == grp.id &&
+               (k < grp.paceline) == (rs->group_role == GroupRole::Paceline);
+    }
+    in_groups += grp.count;
+  }
+  check(labelled, "group labels resolve through the string table");
+  check(ranges && in_groups == int(curr.group_members.size()) &&
+            in_groups == int(curr.riders.size()),
+        "group members: one range per group, paceline first, every rider once");
+
+  const auto table = curr.strings;
+  sim.step_fixed(0.01);
+  sim.consume_latest_frame_pair(prev, curr);
+  check(curr.strings == table, "no new string: the table is not re-sent");
+
+  sim.set_rider_policy(1, std::make_shared<NamedPolicy>("probe"));
+  sim.set_rider_policy(3, std::make_shared<NamedPolicy>("probe"));
+  sim.step_fixed(0.01);
+  sim.consume_latest_frame_pair(prev, curr);
+  const RiderSnapshot* r1 = curr.find(1);
+  const RiderSnapshot* r3 = curr.find(3);
+  check(curr.strings != table, "new policy name: new table");
+  check(r1 && r3 && r1->policy == r3->policy &&
+            curr.str(r1->policy) == "probe",
+        "policy stamped as one interned id");
+  check(curr.find(5)->policy == kNoString, "no policy: kNoString");
+}
+
+static void test_no_allocation() {
+  Course course = Course::create_flat();
+  PhysicsEngine eng(&course);
+  for (int id = 1; id <= 200; ++id) {
+    eng.add_rider(cfg(id));
+    eng.set_rider_effort(id, 0.75);
+  }
+  FrameSnapshot frame;
+  for (int i = 0; i < 2000; ++i)
+    eng.step_and_snapshot(0.01, frame);
+
+  allocations = 0;
+  counting = true;
+  for (int i = 0; i < 500; ++i)
+    eng.step_and_snapshot(0.01, frame);
+  counting = false;
+  std::cout << "  allocations in 500 step_and_snapshot: " << allocations.load()
+            << "\n";
+  check(allocations.load() == 0, "steady-state snapshot allocates nothing");
+
+  FrameSnapshot copy = frame;
+  counting = true;
+  allocations = 0;
+  copy.riders = frame.riders;
+  copy.by_id = frame.by_id;
+  copy.strings = frame.strings;
+  copy.groups = frame.groups;
+  copy.group_members = frame.group_members;
+  counting = false;
+  check(allocations.load() == 0 && copy.find(7)->pos == frame.find(7)->pos,
+        "re-copying a frame's riders and groups reuses the buffers");
+}
+
+int main() {
+  std::cout << "=== Snapshot layout tests ===\n";
+  test_interner();
+  test_layout();
+  test_no_allocation();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All snapshot layout tests passed\n";
+  return 0;
+}
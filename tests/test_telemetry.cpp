@@ -0,0 +1,241 @@
+// Tests for the telemetry recorder (telemetry.h): a recorded race reads
+// back every rider's state within the fixed-point resolution, raw and
+// delta-coded traces decode to the same values (delta much smaller),
+// and unfinished, foreign and corrupt traces are refused.  What recording
+// a 200-rider field at 100 Hz costs the physics thread is printed.
+
+#include "telemetry.h"
+
+#include "course.h"
+#include "sim.h"
+#include "sim_fixture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static void build(Simulation& sim, int riders) {
+  sim.add_riders(fixture_field(riders));
+  place_field(sim, riders, 0.8, 0.03);
+}
+
+struct Sample {
+  double t, pos, speed, power, wbal, lat;
+  int group;
+  GroupRole role;
+};
+
+// Records `steps` ticks of a 40-rider race, keeping rider slot 5's state
+// alongside for comparison.
+static std::vector<Sample> record(const std::string& path,
+                                  TelemetryOptions opts, int steps) {
+  Course course = Course::create_endulating();
+  Simulation sim(&course);
+  sim.set_dt(0.01);
+  build(sim, 40);
+  TelemetryRecorder rec(path, opts);
+  std::vector<Sample> ref;
+  rec.on_start(sim);
+  for (int i = 0; i < steps; ++i) {
+    sim.step_fixed(sim.get_dt());
+    rec.on_step(sim);
+    const PhysicsEngine& eng = *sim.get_engine();
+    const Rider& r = eng.get_riders()[5];
+    const GroupTracker& groups = eng.get_group_tracker();
+    ref.push_back({sim.get_sim_seconds(), r.get_pos(), r.get_speed(),
+                   r.get_power(), r.get_energy(), r.get_lat_pos(),
+                   groups.get_group_id(r.get_id()),
+                   groups.get_role(r.get_id())});
+  }
+  rec.on_finish(sim);
+  check(rec.ok() && rec.ticks() == static_cast<std::uint64_t>(steps) &&
+            rec.dropped_chunks() == 0,
+        std::string("recorded ") + (opts.delta ? "delta" : "raw"));
+  return ref;
+}
+
+static bool near(double a, double b, int column) {
+  return std::abs(a - b) <= 0.5 * kTelemetryScale[column] + 1e-9;
+}
+
+static void test_round_trip() {
+  const int steps = 3000; // 46 chunks of 64 and a partial one
+  TelemetryOptions opts;
+  opts.chunk_ticks = 64;
+  opts.delta = false;
+  const std::vector<Sample> ref = record("telemetry_raw.tmp", opts, steps);
+  opts.delta = true;
+  record("telemetry_delta.tmp", opts, steps);
+
+  TelemetryReader raw, delta;
+  check(raw.open("telemetry_raw.tmp") && delta.open("telemetry_delta.tmp"),
+        "both traces open");
+  check(raw.ticks() == steps && raw.riders().size() == 40 &&
+            raw.riders()[5].id == 6 && std::string(raw.riders()[5].name) ==
+                                           "R6" &&
+            raw.riders()[5].w_prime == 24000.0 && raw.header().dt == 0.01,
+        "header and roster");
+
+  bool values = true, same = true, groups = false;
+  const TelemetryColumn cols[] = {TelemetryColumn::Pos, TelemetryColumn::Speed,
+                                  TelemetryColumn::Power,
+                                  TelemetryColumn::WBal,
+                                  TelemetryColumn::LatPos};
+  for (int k = 0; k < steps; ++k) {
+    const Sample& s = ref[k];
+    const double want[] = {s.pos, s.speed, s.power, s.wbal, s.lat};
+    values = values && raw.time(k) == s.t &&
+             raw.value(k, 5, TelemetryColumn::GroupId) == s.group &&
+             raw.value(k, 5, TelemetryColumn::GroupRole) ==
+                 static_cast<int>(s.role);
+    for (int i = 0; i < 5; ++i)
+      values = values && near(raw.value(k, 5, cols[i]), want[i],
+                              static_cast<int>(cols[i]));
+    // Spot every rider and column on a stride (decodes every chunk).
+    if (k % 7 == 0)
+      for (int slot = 0; slot < 40; ++slot) {
+        groups = groups || raw.value(k, slot, TelemetryColumn::GroupId) !=
+                               kNoGroup;
+        for (int c = 0; c < kTelemetryColumns; ++c)
+          same = same &&
+                 raw.value(k, slot, TelemetryColumn(c)) ==
+                     delta.value(k, slot, TelemetryColumn(c)) &&
+                 raw.time(k) == delta.time(k);
+      }
+  }
+  check(values, "values within the fixed-point resolution");
+  check(groups, "group ids recorded");
+  check(same, "raw and delta traces decode identically");
+
+  std::ifstream a("telemetry_raw.tmp", std::ios::ate | std::ios::binary);
+  std::ifstream b("telemetry_delta.tmp", std::ios::ate | std::ios::binary);
+  const double ratio = double(b.tellg()) / double(a.tellg());
+  std::cout << "  [size] delta / raw = " << ratio << "\n";
+  check(ratio < 0.5, "delta coding at least halves the trace");
+}
+
+static void test_refusals() {
+  TelemetryReader r;
+  check(!r.open("no_such_trace.tmp"), "missing trace refused");
+
+  std::vector<char> bytes;
+  {
+    std::ifstream in("telemetry_delta.tmp", std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  auto write = [](const std::vector<char>& b) {
+    std::ofstream out("telemetry_bad.tmp", std::ios::binary);
+    out.write(b.data(), static_cast<std::streamsize>(b.size()));
+  };
+
+  std::vector<char> foreign = bytes;
+  foreign[0] = 'X';
+  write(foreign);
+  check(!r.open("telemetry_bad.tmp"), "foreign trace refused");
+
+  std::vector<char> unfinished = bytes;
+  std::uint64_t zero = 0;
+  std::memcpy(unfinished.data() + offsetof(TelemetryFileHeader, index_offset),
+              &zero, sizeof(zero));
+  write(unfinished);
+  check(!r.open("telemetry_bad.tmp"), "unfinished trace refused");
+
+  write(std::vector<char>(bytes.begin(), bytes.begin() + bytes.size() / 2));
+  check(!r.open("telemetry_bad.tmp"), "truncated trace refused");
+
+  // A flipped bit in a chunk: decoding fails (or reads garbage the varint
+  // framing catches) rather than crash.
+  std::vector<char> corrupt = bytes;
+  const size_t body = sizeof(TelemetryFileHeader) +
+                      40 * sizeof(TelemetryRiderInfo) +
+                      sizeof(TelemetryChunkHeader) + 64 * sizeof(double);
+  for (size_t i = body; i < body + 64; ++i)
+    corrupt[i] = static_cast<char>(0xFF);
+  write(corrupt);
+  check(r.open("telemetry_bad.tmp") &&
+            std::isnan(r.value(0, 0, TelemetryColumn::Pos)),
+        "corrupt chunk refused at decode");
+
+  for (const char* p : {"telemetry_raw.tmp", "telemetry_delta.tmp",
+                        "telemetry_bad.tmp"})
+    std::remove(p);
+}
+
+static void test_cost() {
+  const int riders = 200, steps = 6000; // 60 s at 100 Hz
+  Course course = Course::create_endulating();
+  Simulation sim(&course);
+  sim.set_dt(0.01);
+  build(sim, riders);
+  // One peloton, the shape of most of a long race, rather than a field
+  // spreading out by FTP.
+  for (int id = 1; id <= riders; ++id)
+    sim.set_rider_effort(id, 0.75 * 300.0 / (230.0 + (id % 7) * 12.0));
+  const TelemetryOptions opts;
+  TelemetryRecorder rec("telemetry_cost.tmp", opts);
+  rec.on_start(sim);
+
+  // Per tick, compared by median: on a machine with fewer cores than
+  // threads the writer's time slices land inside whichever call is running,
+  // which says nothing about the physics thread's own cost.
+  std::vector<double> t_step(steps), t_rec(steps);
+  for (int i = 0; i < steps; ++i) {
+    auto t0 = std::chrono::steady_clock::now();
+    sim.step_fixed(sim.get_dt());
+    auto t1 = std::chrono::steady_clock::now();
+    rec.on_step(sim);
+    auto t2 = std::chrono::steady_clock::now();
+    t_step[i] = std::chrono::duration<double>(t1 - t0).count();
+    t_rec[i] = std::chrono::duration<double>(t2 - t1).count();
+  }
+  rec.on_finish(sim);
+  std::remove("telemetry_cost.tmp");
+
+  auto median = [](std::vector<double>& v) {
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+  };
+  const double tick = median(t_step), cost = median(t_rec);
+  const double share = cost / tick;
+  const double per_hour_mb = rec.bytes_written() * 60.0 / (1024.0 * 1024.0);
+  std::cout << "  [cost] 200 riders at 100 Hz: tick " << tick * 1e6
+            << " us, recording " << cost * 1e6 << " us ("
+            << share * 100.0 << " %), " << per_hour_mb * 3.0
+            << " MiB per 3 h\n";
+  check(rec.ok() &&
+            rec.ticks() + rec.dropped_chunks() * opts.chunk_ticks == steps,
+        "cost: every tick recorded or counted as dropped");
+}
+
+int main() {
+  std::cout << "=== Telemetry tests ===\n";
+  test_round_trip();
+  test_refusals();
+  test_cost();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All telemetry tests passed\n";
+  return 0;
+}
@@ -0,0 +1,137 @@
+// Steady-state allocation test: once a field has settled, PhysicsEngine::
+// update() must not touch the heap — every per-tick buffer is reused
+// scratch or comes from the tick arena (tick_arena.h).  Counted by
+// replacing the global operator new for this executable.
+
+#include "course.h"
+#include "lateral_behavior.h"
+#include "sim.h"
+#include "tick_arena.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<bool> counting{false};
+static std::atomic<long> allocations{0};
+
+void* operator new(std::size_t n) {
+  if (counting.load(std::memory_order_relaxed))
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return ::operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     250.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+// Heap allocations made by `ticks` updates, after `warmup` updates.
+static long allocations_per_run(PhysicsEngine& eng, int warmup, int ticks) {
+  for (int i = 0; i < warmup; ++i)
+    eng.update(0.01);
+  allocations = 0;
+  counting = true;
+  for (int i = 0; i < ticks; ++i)
+    eng.update(0.01);
+  counting = false;
+  return allocations.load();
+}
+
+// Every hot path at once — drafting with Body riders, lateral contact,
+// behaviours, follow controllers and a paceline rotation — on identical riders at one effort,
+// so the bunch settles: regrouping (a new group, a bigger run) legitimately
+// grows buffers once, and is not steady state.  Enough riders for the pool
+// to split every pass into several 32-rider chunks.
+static void setup_field(PhysicsEngine& eng) {
+  const int n = 96;
+  auto block = std::make_shared<BlockBehavior>();
+  for (int id = 1; id <= n; ++id) {
+    eng.add_rider(cfg(id));
+    eng.set_rider_effort(id, 0.75);
+    if (id % 3 == 0)
+      eng.set_rider_behavior(id, block);
+    if (id % 5 == 0)
+      eng.get_riders().at(id)->set_group_role(GroupRole::Body);
+  }
+  for (int id = 60; id < 80; ++id)
+    eng.set_follow_target(id, id - 1);
+  std::vector<RotationMember> roster;
+  for (int id = 10; id < 14; ++id)
+    roster.push_back(RotationMember{id});
+  eng.set_paceline_rotation(roster, RotationParams{});
+}
+
+static void test_steady_state(int threads) {
+  Course course = Course::create_flat();
+  PhysicsEngine eng(&course);
+  eng.set_thread_count(threads);
+  setup_field(eng);
+  const long n = allocations_per_run(eng, 1000, 200);
+  std::cout << "  [" << threads << " thread(s)] allocations in 200 ticks: " << n
+            << "\n";
+  check(n == 0, std::to_string(threads) +
+                    " thread(s): steady-state tick allocates nothing");
+}
+
+// The arena grows to what a tick needed and then stops allocating.
+static void test_arena() {
+  TickArena arena(64);
+  for (int tick = 0; tick < 3; ++tick) {
+    arena.reset();
+    std::pmr::vector<double> v(arena.resource());
+    v.resize(1000);
+  }
+  allocations = 0;
+  counting = true;
+  for (int tick = 0; tick < 10; ++tick) {
+    arena.reset();
+    std::pmr::vector<double> v(arena.resource());
+    v.resize(1000);
+  }
+  counting = false;
+  check(arena.capacity() >= 1000 * sizeof(double),
+        "arena: block grew to the tick's need");
+  check(allocations.load() == 0, "arena: no heap use once grown");
+}
+
+int main() {
+  std::cout << "=== Tick allocation tests ===\n";
+  test_arena();
+  test_steady_state(1);
+  test_steady_state(4);
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All tick allocation tests passed\n";
+  return 0;
+}
@@ -0,0 +1,290 @@
+// Tests for trace replay (trace_replay.h): a recorded race plays back as the
+// frames the live sim published, within the trace's fixed-point resolution;
+// seeking lands on the recorded tick at or before the target; playback
+// moves the playhead at the set speed and stamps the pair so the
+// renderer's interpolation lands on it; the time controls reach it through
+// SimControlSwitch while it is shown; and a trace from another course is
+// refused.  Opening a 200-rider trace decodes no chunk, and a seek with
+// its frame pair at most two; the times are printed.
+
+#include "trace_replay.h"
+
+#include "course.h"
+#include "sim.h"
+#include "sim_fixture.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+// The shared field, every fifth rider on a TT bike.
+static void build(Simulation& sim, int riders) {
+  std::vector<RiderConfig> field = fixture_field(riders);
+  for (RiderConfig& cfg : field)
+    if (cfg.rider_id % 5 == 0)
+      cfg.bike = Bike::create_tt();
+  sim.add_riders(field);
+  place_field(sim, riders, 0.8, 0.03);
+}
+
+// Records `steps` ticks, keeping the published frame at the given ticks.
+static std::map<int, FrameSnapshot> record(const std::string& path,
+                                           const Course& course, int riders,
+                                           int steps,
+                                           const std::vector<int>& keep) {
+  Simulation sim(&course);
+  sim.set_dt(0.01);
+  build(sim, riders);
+  TelemetryRecorder rec(path);
+  std::map<int, FrameSnapshot> frames;
+  rec.on_start(sim);
+  for (int k = 0; k < steps; ++k) {
+    sim.step_fixed(sim.get_dt());
+    rec.on_step(sim);
+    for (int want : keep)
+      if (want == k)
+        frames[k] = sim.acquire_frames().curr();
+  }
+  rec.on_finish(sim);
+  return frames;
+}
+
+static bool near(double a, double b, TelemetryColumn c) {
+  return std::abs(a - b) <=
+         0.5 * kTelemetryScale[static_cast<int>(c)] + 1e-9;
+}
+
+// The replayed frame against the live one, record by record.
+static bool same_frame(const FrameSnapshot& replay, const FrameSnapshot& live,
+                       const TelemetryRiderInfo& w) {
+  bool ok = replay.sim_time == live.sim_time &&
+            replay.riders.size() == live.riders.size() &&
+            replay.groups.size() == live.groups.size();
+  for (size_t i = 1; ok && i < replay.riders.size(); ++i)
+    ok = replay.riders[i - 1].pos >= replay.riders[i].pos;
+  for (const RiderSnapshot& want : live.riders) {
+    const RiderSnapshot* got = replay.find(want.id);
+    ok = ok && got && replay.str(got->name) == live.str(want.name) &&
+         near(got->pos, want.pos, TelemetryColumn::Pos) &&
+         near(got->speed, want.speed, TelemetryColumn::Speed) &&
+         near(got->power, want.power, TelemetryColumn::Power) &&
+         near(got->lat_pos, want.lat_pos, TelemetryColumn::LatPos) &&
+         std::abs(got->wbal_fraction - want.wbal_fraction) <=
+             0.05 / w.w_prime + 1e-9 &&
+         std::abs(got->altitude - want.altitude) < 0.01 &&
+         got->group_id == want.group_id &&
+         got->group_role == want.group_role &&
+         got->visual_type == want.visual_type &&
+         got->max_effort == want.max_effort;
+  }
+  for (size_t g = 0; ok && g < live.groups.size(); ++g) {
+    const FrameGroup &a = replay.groups[g], &b = live.groups[g];
+    ok = a.size() == b.size() && a.paceline == b.paceline &&
+         replay.str(a.label) == live.str(b.label);
+    const GroupMember *ma = replay.members(a), *mb = live.members(b);
+    for (int k = 0; ok && k < a.count; ++k)
+      ok = ma[k].id == mb[k].id;
+  }
+  return ok;
+}
+
+static void test_frames() {
+  Course course = Course::create_endulating();
+  const std::vector<int> keep = {0, 700, 1234, 2999};
+  std::map<int, FrameSnapshot> live =
+      record("replay.tmp", course, 40, 3000, keep);
+
+  Course other = Course::create_flat();
+  TraceReplay wrong;
+  check(!wrong.open("replay.tmp", &other), "a trace from another course");
+
+  TraceReplay replay;
+  check(replay.open("replay.tmp", &course), "opens");
+  check(replay.start_time() == live[0].sim_time &&
+            std::abs(replay.end_time() - live[2999].sim_time) < 1e-6 &&
+            replay.is_paused() && replay.get_time() == replay.start_time(),
+        "starts paused at the first tick");
+
+  const TelemetryRiderInfo& info = replay.reader().riders()[0];
+  bool frames = true;
+  FrameSnapshot prev, curr;
+  for (int k : keep) {
+    // Halfway to the next tick: lands on k.
+    replay.seek(live[k].sim_time + 0.005);
+    frames = frames && replay.consume_latest_frame_pair(prev, curr) &&
+             same_frame(curr, live[k], info) && prev.sim_time == curr.sim_time;
+  }
+  check(frames, "paused frames match the live ones at any seek");
+  check(std::string(curr.str(curr.find(1)->name)) == "R1" &&
+            curr.find(5)->visual_type == BikeType::TT &&
+            !curr.groups.empty(),
+        "names, bikes and groups");
+
+  replay.seek(-100.0);
+  const double t0 = replay.get_time();
+  replay.seek(1e9);
+  check(t0 == replay.start_time() && replay.get_time() == replay.end_time(),
+        "seeks clamp to the trace");
+}
+
+static void test_playback() {
+  Course course = Course::create_endulating();
+  record("replay.tmp", course, 10, 2000, {});
+  TraceReplay replay;
+  replay.open("replay.tmp", &course);
+
+  replay.seek(5.0);
+  replay.set_speed(2.0);
+  replay.set_paused(false);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  FrameSnapshot prev, curr;
+  const bool got = replay.consume_latest_frame_pair(prev, curr);
+  const double t = replay.get_time();
+  check(got && t > 5.09 && t < 5.5 && prev.sim_time < curr.sim_time &&
+            curr.sim_time - prev.sim_time < 0.011,
+        "plays at the set speed");
+
+  // The renderer's blend (SimulationRenderer::render_frame) at the same
+  // instant lands on the playhead.
+  const double now = frame_clock_seconds();
+  const double alpha = (now - curr.real_time) * curr.time_factor /
+                       (curr.sim_time - prev.sim_time);
+  const double shown =
+      prev.sim_time + alpha * (curr.sim_time - prev.sim_time);
+  check(alpha >= 0.0 && alpha <= 1.05 &&
+            std::abs(shown - replay.get_time()) < 0.005,
+        "the pair is stamped for the renderer's interpolation");
+
+  replay.set_paused(true);
+  const double held = replay.get_time();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  check(replay.get_time() == held, "pause holds the playhead");
+  replay.set_paused(false);
+  replay.seek(replay.end_time() - 0.001);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  check(replay.consume_latest_frame_pair(prev, curr) &&
+            replay.get_time() == replay.end_time() &&
+            prev.sim_time == curr.sim_time,
+        "stops at the end");
+  std::remove("replay.tmp");
+}
+
+// Records what the screen's widgets asked of the live runner.
+struct LiveControl : ISimControl {
+  int calls = 0;
+  bool paused = false;
+  void set_rider_effort(RiderId, double) override { ++calls; }
+  void set_time_factor(double) override { ++calls; }
+  void pause() override {
+    ++calls;
+    paused = true;
+  }
+  void resume() override {
+    ++calls;
+    paused = false;
+  }
+  bool is_paused() const override { return paused; }
+  void rewind_to(double) override { ++calls; }
+};
+
+static void test_controls() {
+  Course course = Course::create_endulating();
+  record("replay.tmp", course, 10, 2000, {});
+  TraceReplay replay;
+  replay.open("replay.tmp", &course);
+
+  LiveControl live;
+  SimControlSwitch controls(&live);
+  controls.set_replay(&replay);
+  controls.set_time_factor(4.0);
+  controls.resume();
+  const bool playing = !controls.is_paused() && !replay.is_paused();
+  controls.pause();
+  controls.rewind_to(replay.start_time() + 3.0);
+  controls.set_rider_effort(0, 1.5);
+  check(playing && replay.get_speed() == 4.0 && replay.is_paused() &&
+            std::abs(replay.get_time() - replay.start_time() - 3.0) < 1e-9 &&
+            live.calls == 0,
+        "controls: speed, pause and rewind drive the replay, not the sim");
+
+  controls.set_replay(nullptr);
+  controls.pause();
+  controls.set_time_factor(1.0);
+  check(live.calls == 2 && controls.is_paused() && replay.get_speed() == 4.0,
+        "controls: back to live");
+  std::remove("replay.tmp");
+}
+
+static void test_cost() {
+  // Two minutes of a 200-rider race: 12 000 ticks, 47 chunks.
+  Course course = Course::create_endulating();
+  record("replay.tmp", course, 200, 12000, {});
+
+  auto t0 = std::chrono::steady_clock::now();
+  TraceReplay replay;
+  const bool opened = replay.open("replay.tmp", &course);
+  const double t_open = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - t0)
+                            .count();
+
+  const std::uint64_t at_open = replay.reader().chunk_loads();
+
+  // Scrubbing: every seek lands in a chunk not decoded yet.
+  double worst = 0.0;
+  std::uint64_t most_loads = 0;
+  FrameSnapshot prev, curr;
+  bool ok = opened;
+  for (int i = 0; i < 60; ++i) {
+    const double t = replay.start_time() +
+                     (replay.end_time() - replay.start_time()) *
+                         ((i * 37) % 60) / 60.0;
+    const std::uint64_t loads = replay.reader().chunk_loads();
+    t0 = std::chrono::steady_clock::now();
+    replay.seek(t);
+    ok = ok && replay.consume_latest_frame_pair(prev, curr) &&
+         curr.riders.size() == 200;
+    worst = std::max(worst, std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - t0)
+                                .count());
+    most_loads = std::max(most_loads, replay.reader().chunk_loads() - loads);
+  }
+  std::remove("replay.tmp");
+
+  std::cout << "  [cost] 200 riders, 2 min: open " << t_open
+            << " ms, worst seek + frame pair " << worst << " ms\n";
+  check(ok, "cost: every seek serves a frame pair");
+  check(opened && at_open == 0, "cost: opening decodes no chunk");
+  check(most_loads >= 1 && most_loads <= 2,
+        "cost: a seek and its frame pair decode at most two chunks");
+}
+
+int main() {
+  std::cout << "=== Trace replay tests ===\n";
+  test_frames();
+  test_playback();
+  test_controls();
+  test_cost();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All trace replay tests passed\n";
+  return 0;
+}
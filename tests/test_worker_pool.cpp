@@ -0,0 +1,142 @@
+// Tests for the engine's worker pool (worker_pool.h): every index is run
+// exactly once whatever the thread count, chunk size or load imbalance, and
+// a PhysicsEngine stepped on 1 vs 4 threads stays bit-identical.
+
+#include "worker_pool.h"
+
+#include "course.h"
+#include "sim.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int checks_failed = 0;
+
+static void check(bool ok, const std::string& label) {
+  if (ok) {
+    std::cout << "  ok: " << label << "\n";
+  } else {
+    std::cout << "FAIL: " << label << "\n";
+    ++checks_failed;
+  }
+}
+
+// Each index visited exactly once, for a spread of (threads, n, grain).
+static void test_coverage() {
+  bool all_once = true;
+  for (int threads : {1, 2, 4, 7}) {
+    WorkerPool pool(threads);
+    for (int n : {0, 1, 31, 32, 33, 1000}) {
+      for (int grain : {1, 8, 32, 5000}) {
+        std::vector<std::atomic<int>> hits(n);
+        pool.parallel_for(n, grain, [&](int lo, int hi) {
+          for (int i = lo; i < hi; ++i)
+            hits[i].fetch_add(1);
+        });
+        for (int i = 0; i < n; ++i)
+          all_once = all_once && hits[i].load() == 1;
+      }
+    }
+  }
+  check(all_once, "every index run exactly once (1/2/4/7 threads)");
+
+  WorkerPool pool(0);
+  check(pool.thread_count() == 1, "thread count clamped to >= 1");
+}
+
+// One block of chunks is slow: the other participants must steal from it.
+static void test_stealing() {
+  WorkerPool pool(4);
+  const int n = 64;
+  std::vector<int> out(n, 0);
+  pool.parallel_for(n, 1, [&](int lo, int hi) {
+    for (int i = lo; i < hi; ++i) {
+      if (i < n / 4) // participant 0's block
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      out[i] = i * i;
+    }
+  });
+  bool ok = true;
+  for (int i = 0; i < n; ++i)
+    ok = ok && out[i] == i * i;
+  check(ok, "uneven load: all results written");
+  std::cout << "  [stealing] chunks stolen: " << pool.last_steals() << "\n";
+  check(pool.last_steals() > 0, "uneven load: idle participants steal");
+
+  // Back-to-back jobs reuse the same workers.
+  long sum = 0;
+  for (int rep = 0; rep < 200; ++rep) {
+    std::vector<int> v(100, 0);
+    pool.parallel_for(100, 7, [&](int lo, int hi) {
+      for (int i = lo; i < hi; ++i)
+        v[i] = 1;
+    });
+    for (int x : v)
+      sum += x;
+  }
+  check(sum == 200 * 100, "200 consecutive jobs complete");
+}
+
+static RiderConfig cfg(int id) {
+  return RiderConfig{id,  "R" + std::to_string(id),
+                     230.0 + (id % 9) * 10.0, 6,
+                     2,   0.05,
+                     700, 3.5,
+                     65,  0.3,
+                     24000, Bike::create_road(),
+                     kNoTeam};
+}
+
+static void run(PhysicsEngine& eng, int n_riders, int steps) {
+  for (int id = 1; id <= n_riders; ++id) {
+    eng.add_rider(cfg(id));
+    eng.set_rider_effort(id, 0.6 + 0.03 * (id % 11));
+  }
+  for (int i = 0; i < steps; ++i)
+    eng.update(0.01);
+}
+
+// The pool decides who runs a chunk, never what it computes: a bunch with
+// drafting and lateral contact must match the serial engine bit for bit.
+static void test_engine_bit_identical() {
+  const int n = 200, steps = 1500;
+  Course course = Course::create_flat();
+
+  PhysicsEngine serial(&course);
+  check(serial.get_thread_count() == 1, "engine defaults to one thread");
+  run(serial, n, steps);
+
+  PhysicsEngine threaded(&course);
+  threaded.set_thread_count(4);
+  check(threaded.get_thread_count() == 4, "set_thread_count(4)");
+  run(threaded, n, steps);
+
+  bool same = true;
+  for (int id = 1; id <= n; ++id) {
+    const Rider* a = serial.get_rider_by_id(id);
+    const Rider* b = threaded.get_rider_by_id(id);
+    same = same && a->get_pos() == b->get_pos() &&
+           a->get_speed() == b->get_speed() &&
+           a->get_lat_pos() == b->get_lat_pos() &&
+           a->get_cda_factor() == b->get_cda_factor();
+  }
+  check(same, "200 riders, 15 s: 4 threads == 1 thread (bit-identical)");
+}
+
+int main() {
+  std::cout << "=== WorkerPool tests ===\n";
+  test_coverage();
+  test_stealing();
+  test_engine_bit_identical();
+
+  if (checks_failed) {
+    std::cout << checks_failed << " check(s) FAILED\n";
+    return 1;
+  }
+  std::cout << "All worker pool tests passed\n";
+  return 0;
+}